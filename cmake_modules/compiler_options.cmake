@@ -46,6 +46,9 @@ option(USE_SYSTEM_LIBUSB "Enable this option here or in cmake call if you want t
 option(USE_SYSTEM_GTEST "Enable this option here or in cmake call if you want to use system's Gtest." OFF)
 option(USE_SYSTEM_LIBINDI "Enable this option here or in cmake call if you want to use system's libindi." OFF)
 
+# per-frame latency tracing, started at runtime with the set_frame_trace event server method
+option(PHD2_FRAME_TRACE "Compile in per-frame latency tracing." ON)
+
 # build type, by default to release (with optimisations)
 if(NOT CMAKE_BUILD_TYPE AND NOT CMAKE_CONFIGURATION_TYPES)
   message(STATUS "Setting build type to 'Release' as none was specified.")
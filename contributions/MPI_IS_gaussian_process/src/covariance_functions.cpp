@@ -47,6 +47,60 @@
 namespace covariance_functions
 {
 
+namespace
+{
+/*!
+ * Evaluates a stationary kernel k(x - y) column by column. The kernel functor
+ * receives a segment of differences and writes the covariances into an
+ * output segment of the same length, so that exp and sin run over whole
+ * columns and are vectorized by Eigen.
+ *
+ * The kernels used here are even in the difference. For the Gram case (x and
+ * y are the same locations) only the lower triangle is evaluated and then
+ * mirrored, which halves the number of transcendental function calls and
+ * keeps the result exactly symmetric.
+ */
+template<typename Kernel>
+Eigen::MatrixXd evaluateStationary(const Eigen::VectorXd& x, const Eigen::VectorXd& y, const Kernel& kernel)
+{
+    const int rows = x.rows();
+    const int cols = y.rows();
+    const bool symmetric = &x == &y || (rows == cols && x == y);
+
+    Eigen::MatrixXd K(rows, cols);
+    Eigen::ArrayXd distance(rows);
+    Eigen::ArrayXd covariance(rows);
+
+    for (int j = 0; j < cols; ++j)
+    {
+        const int first = symmetric ? j : 0;
+        const int count = rows - first;
+
+        distance.head(count) = x.segment(first, count).array() - y(j);
+        kernel(distance.head(count), covariance.head(count));
+        K.col(j).segment(first, count) = covariance.head(count).matrix();
+    }
+
+    if (symmetric)
+    {
+        for (int j = 0; j < cols - 1; ++j)
+        {
+            K.row(j).tail(cols - j - 1) = K.col(j).tail(rows - j - 1).transpose();
+        }
+    }
+
+    return K;
+}
+
+/*!
+ * Differences x_i - x_j of all pairs of locations.
+ */
+Eigen::ArrayXXd pairwiseDifferences(const Eigen::VectorXd& x)
+{
+    return x.replicate(1, x.rows()).array() - x.transpose().replicate(x.rows(), 1).array();
+}
+} // namespace
+
 /* PeriodicSquareExponential */
 PeriodicSquareExponential::PeriodicSquareExponential()
     : hyperParameters(Eigen::VectorXd::Zero(4)), extraParameters(Eigen::VectorXd::Ones(1) * std::numeric_limits<double>::max())
@@ -68,16 +122,15 @@ Eigen::MatrixXd PeriodicSquareExponential::evaluate(const Eigen::VectorXd& x, co
 
     double plP = exp(extraParameters(0));
 
-    // Work with arrays internally, convert to matrix for return value.
-    // This is because all the operations act elementwise, and Eigen::Arrays
-    // do so, too.
+    const double scaleSE0 = -0.5 / std::pow(lsSE0, 2);
+    const double scaleP = -2 / std::pow(lsP, 2);
+    const double frequencyP = M_PI / plP;
 
-    // Compute Distances
-    Eigen::ArrayXXd squareDistanceXY = math_tools::squareDistance(x.transpose(), y.transpose());
-
-    // fast version
-    return svSE0 * ((-0.5 / std::pow(lsSE0, 2)) * squareDistanceXY).exp() +
-        svP * (-2 * (((M_PI / plP) * squareDistanceXY.sqrt()).sin() / lsP).square()).exp();
+    // The periodic component only depends on the square of the sine, so the
+    // signed difference can be used directly instead of sqrt(distance^2).
+    return evaluateStationary(x, y, [=](const auto& d, auto k) {
+        k = svSE0 * (scaleSE0 * d.square()).exp() + svP * (scaleP * (frequencyP * d).sin().square()).exp();
+    });
 
     /* // verbose version
     // Square Exponential Kernel
@@ -95,6 +148,35 @@ Eigen::MatrixXd PeriodicSquareExponential::evaluate(const Eigen::VectorXd& x, co
     */
 }
 
+std::vector<Eigen::MatrixXd> PeriodicSquareExponential::evaluateDerivatives(const Eigen::VectorXd& x)
+{
+    double lsSE0 = exp(hyperParameters(0));
+    double svSE0 = exp(2 * hyperParameters(1));
+    double lsP = exp(hyperParameters(2));
+    double svP = exp(2 * hyperParameters(3));
+
+    double plP = exp(extraParameters(0));
+
+    const double scaleSE0 = -0.5 / std::pow(lsSE0, 2);
+    const double scaleP = -2 / std::pow(lsP, 2);
+
+    const Eigen::ArrayXXd d = pairwiseDifferences(x);
+    const Eigen::ArrayXXd d2 = d.square();
+    const Eigen::ArrayXXd u = (M_PI / plP) * d;
+    const Eigen::ArrayXXd sin2 = u.sin().square();
+
+    const Eigen::ArrayXXd kSE0 = svSE0 * (scaleSE0 * d2).exp();
+    const Eigen::ArrayXXd kP = svP * (scaleP * sin2).exp();
+
+    std::vector<Eigen::MatrixXd> derivatives(5);
+    derivatives[0] = (kSE0 * d2 / std::pow(lsSE0, 2)).matrix(); // length scale SE0
+    derivatives[1] = (2 * kSE0).matrix(); // signal variance SE0
+    derivatives[2] = (4 * kP * sin2 / std::pow(lsP, 2)).matrix(); // length scale P
+    derivatives[3] = (2 * kP).matrix(); // signal variance P
+    derivatives[4] = (-scaleP * kP * u * (2 * u).sin()).matrix(); // period length
+    return derivatives;
+}
+
 void PeriodicSquareExponential::setParameters(const Eigen::VectorXd& params)
 {
     this->hyperParameters = params;
@@ -148,17 +230,15 @@ Eigen::MatrixXd PeriodicSquareExponential2::evaluate(const Eigen::VectorXd& x, c
 
     double plP = exp(extraParameters(0));
 
-    // Work with arrays internally, convert to matrix for return value.
-    // This is because all the operations act elementwise, and Eigen::Arrays
-    // do so, too.
+    const double scaleSE0 = -0.5 / std::pow(lsSE0, 2);
+    const double scaleP = -2 / std::pow(lsP, 2);
+    const double frequencyP = M_PI / plP;
+    const double scaleSE1 = -0.5 / std::pow(lsSE1, 2);
 
-    // Compute Distances
-    Eigen::ArrayXXd squareDistanceXY = math_tools::squareDistance(x.transpose(), y.transpose());
-
-    // fast version
-    return svSE0 * ((-0.5 / std::pow(lsSE0, 2)) * squareDistanceXY).exp() +
-        svP * (-2 * (((M_PI / plP) * squareDistanceXY.sqrt()).sin() / lsP).square()).exp() +
-        svSE1 * ((-0.5 / std::pow(lsSE1, 2)) * squareDistanceXY).exp();
+    return evaluateStationary(x, y, [=](const auto& d, auto k) {
+        k = svSE0 * (scaleSE0 * d.square()).exp() + svP * (scaleP * (frequencyP * d).sin().square()).exp() +
+            svSE1 * (scaleSE1 * d.square()).exp();
+    });
 
     /* // verbose version
     // Square Exponential Kernel
@@ -180,6 +260,41 @@ Eigen::MatrixXd PeriodicSquareExponential2::evaluate(const Eigen::VectorXd& x, c
     */
 }
 
+std::vector<Eigen::MatrixXd> PeriodicSquareExponential2::evaluateDerivatives(const Eigen::VectorXd& x)
+{
+    double lsSE0 = exp(hyperParameters(0));
+    double svSE0 = exp(2 * hyperParameters(1));
+    double lsP = exp(hyperParameters(2));
+    double svP = exp(2 * hyperParameters(3));
+    double lsSE1 = exp(hyperParameters(4));
+    double svSE1 = exp(2 * hyperParameters(5));
+
+    double plP = exp(extraParameters(0));
+
+    const double scaleSE0 = -0.5 / std::pow(lsSE0, 2);
+    const double scaleP = -2 / std::pow(lsP, 2);
+    const double scaleSE1 = -0.5 / std::pow(lsSE1, 2);
+
+    const Eigen::ArrayXXd d = pairwiseDifferences(x);
+    const Eigen::ArrayXXd d2 = d.square();
+    const Eigen::ArrayXXd u = (M_PI / plP) * d;
+    const Eigen::ArrayXXd sin2 = u.sin().square();
+
+    const Eigen::ArrayXXd kSE0 = svSE0 * (scaleSE0 * d2).exp();
+    const Eigen::ArrayXXd kP = svP * (scaleP * sin2).exp();
+    const Eigen::ArrayXXd kSE1 = svSE1 * (scaleSE1 * d2).exp();
+
+    std::vector<Eigen::MatrixXd> derivatives(7);
+    derivatives[0] = (kSE0 * d2 / std::pow(lsSE0, 2)).matrix(); // length scale SE0
+    derivatives[1] = (2 * kSE0).matrix(); // signal variance SE0
+    derivatives[2] = (4 * kP * sin2 / std::pow(lsP, 2)).matrix(); // length scale P
+    derivatives[3] = (2 * kP).matrix(); // signal variance P
+    derivatives[4] = (kSE1 * d2 / std::pow(lsSE1, 2)).matrix(); // length scale SE1
+    derivatives[5] = (2 * kSE1).matrix(); // signal variance SE1
+    derivatives[6] = (-scaleP * kP * u * (2 * u).sin()).matrix(); // period length
+    return derivatives;
+}
+
 void PeriodicSquareExponential2::setParameters(const Eigen::VectorXd& params)
 {
     this->hyperParameters = params;
@@ -66,6 +66,14 @@ public:
      */
     virtual Eigen::MatrixXd evaluate(const Eigen::VectorXd& x1, const Eigen::VectorXd& x2) = 0;
 
+    /*!
+     * Evaluates the derivatives of the covariance matrix of the locations x
+     * with respect to each hyper-parameter: the parameters first, followed by
+     * the extra parameters, all in the log space they are stored in. Used for
+     * the gradient of the marginal likelihood.
+     */
+    virtual std::vector<Eigen::MatrixXd> evaluateDerivatives(const Eigen::VectorXd& x) = 0;
+
     //! Method to set the hyper-parameters.
     virtual void setParameters(const Eigen::VectorXd& params) = 0;
     virtual void setExtraParameters(const Eigen::VectorXd& params) = 0;
@@ -128,6 +136,9 @@ public:
      */
     Eigen::MatrixXd evaluate(const Eigen::VectorXd& x1, const Eigen::VectorXd& x2);
 
+    //! Derivatives of the covariance matrix, see CovFunc::evaluateDerivatives.
+    std::vector<Eigen::MatrixXd> evaluateDerivatives(const Eigen::VectorXd& x);
+
     //! Method to set the hyper-parameters.
     void setParameters(const Eigen::VectorXd& params);
     void setExtraParameters(const Eigen::VectorXd& params);
@@ -190,6 +201,9 @@ public:
 
     Eigen::MatrixXd evaluate(const Eigen::VectorXd& x1, const Eigen::VectorXd& x2);
 
+    //! Derivatives of the covariance matrix, see CovFunc::evaluateDerivatives.
+    std::vector<Eigen::MatrixXd> evaluateDerivatives(const Eigen::VectorXd& x);
+
     //! Method to set the hyper-parameters.
     void setParameters(const Eigen::VectorXd& params);
     void setExtraParameters(const Eigen::VectorXd& params);
@@ -43,6 +43,8 @@
 
 #include <cstdint>
 #include <cassert>
+#include <algorithm>
+#include <limits>
 
 #include "gaussian_process.h"
 #include "math_tools.h"
@@ -96,10 +98,12 @@ GP::GP(const GP& that)
       data_loc_(that.data_loc_), data_out_(that.data_out_), data_var_(that.data_var_), gram_matrix_(that.gram_matrix_),
       alpha_(that.alpha_), chol_gram_matrix_(that.chol_gram_matrix_), log_noise_sd_(that.log_noise_sd_),
       use_explicit_trend_(that.use_explicit_trend_), feature_vectors_(that.feature_vectors_),
-      feature_matrix_(that.feature_matrix_), chol_feature_matrix_(that.chol_feature_matrix_), beta_(that.beta_)
+      feature_matrix_(that.feature_matrix_), chol_feature_matrix_(that.chol_feature_matrix_), beta_(that.beta_),
+      cov_cache_loc_(that.cov_cache_loc_), cov_cache_(that.cov_cache_), inducing_loc_(that.inducing_loc_),
+      chol_inducing_matrix_(that.chol_inducing_matrix_)
 {
     covFunc_ = that.covFunc_->clone();
-    covFuncProj_ = that.covFuncProj_->clone();
+    covFuncProj_ = that.covFuncProj_ ? that.covFuncProj_->clone() : nullptr; // the projection is optional
 }
 
 bool GP::setCovarianceFunction(const covariance_functions::CovFunc& covFunc)
@@ -109,6 +113,7 @@ bool GP::setCovarianceFunction(const covariance_functions::CovFunc& covFunc)
         return false;
     delete covFunc_; // initialized to zero, so delete is safe
     covFunc_ = covFunc.clone();
+    clearCovarianceCache();
 
     return true;
 }
@@ -141,6 +146,10 @@ GP& GP::operator=(const GP& that)
         alpha_ = that.alpha_;
         chol_gram_matrix_ = that.chol_gram_matrix_;
         log_noise_sd_ = that.log_noise_sd_;
+        cov_cache_loc_ = that.cov_cache_loc_;
+        cov_cache_ = that.cov_cache_;
+        inducing_loc_ = that.inducing_loc_;
+        chol_inducing_matrix_ = that.chol_inducing_matrix_;
     }
     return *this;
 }
@@ -165,6 +174,15 @@ Eigen::VectorXd GP::drawSample(const Eigen::VectorXd& locations, const Eigen::Ve
     {
         kernel_matrix = prior_covariance + JITTER * Eigen::MatrixXd::Identity(prior_covariance.rows(), prior_covariance.cols());
     }
+    else if (isSparse())
+    {
+        // whitened covariance to the inducing points
+        Eigen::MatrixXd w = chol_inducing_matrix_.matrixL().solve(covFunc_->evaluate(inducing_loc_, locations));
+        Eigen::MatrixXd posterior_covariance;
+        posterior_covariance = prior_covariance - w.transpose() * w + w.transpose() * chol_gram_matrix_.solve(w);
+        kernel_matrix =
+            posterior_covariance + JITTER * Eigen::MatrixXd::Identity(posterior_covariance.rows(), posterior_covariance.cols());
+    }
     else // we have some data
     {
         Eigen::MatrixXd mixed_covariance;
@@ -187,11 +205,16 @@ void GP::infer()
 {
     assert(data_loc_.rows() > 0 && "Error: the GP is not yet initialized!");
 
-    // The data covariance matrix
-    Eigen::MatrixXd data_cov = covFunc_->evaluate(data_loc_, data_loc_);
+    if (isSparse())
+    {
+        inferSparse();
+        return;
+    }
+
+    // The data covariance matrix, reusing what is known from the last inference
+    updateCovarianceCache();
 
-    // swapping in the Gram matrix is faster than directly assigning it
-    gram_matrix_.swap(data_cov); // store the new data_cov as gram matrix
+    gram_matrix_ = cov_cache_; // the cache has to stay noise-free
     if (data_var_.rows() == 0) // homoscedastic
     {
         gram_matrix_ +=
@@ -231,9 +254,94 @@ void GP::infer(const Eigen::VectorXd& data_loc, const Eigen::VectorXd& data_out,
     {
         data_var_ = data_var;
     }
+    inducing_loc_ = Eigen::VectorXd(); // back to the full GP
     infer(); // updates the Gram matrix and its Cholesky decomposition
 }
 
+void GP::inferSparse(const Eigen::VectorXd& data_loc, const Eigen::VectorXd& data_out, const Eigen::VectorXd& inducing_loc,
+                     const Eigen::VectorXd& data_var /* = EigenVectorXd() */)
+{
+    assert(inducing_loc.rows() > 0 && "Error: the sparse GP needs inducing points!");
+
+    data_loc_ = data_loc;
+    data_out_ = data_out;
+    if (data_var.rows() > 0)
+    {
+        data_var_ = data_var;
+    }
+    inducing_loc_ = inducing_loc;
+    infer();
+}
+
+void GP::inferSparse()
+{
+    const int n = data_loc_.rows();
+    const int m = inducing_loc_.rows();
+
+    // Cholesky factor L of the inducing point covariance K_mm. Closely spaced
+    // inducing points make K_mm ill-conditioned, raise the jitter until the
+    // decomposition succeeds.
+    Eigen::MatrixXd inducing_cov = covFunc_->evaluate(inducing_loc_, inducing_loc_);
+    double jitter = JITTER;
+    do
+    {
+        chol_inducing_matrix_ = (inducing_cov + jitter * Eigen::MatrixXd::Identity(m, m)).llt();
+        jitter *= 10;
+    } while (chol_inducing_matrix_.info() != Eigen::Success && jitter < inducing_cov.diagonal().maxCoeff());
+
+    // whitened cross-covariance V = L^{-1} K_mn, so that Q_nn = V^T V is the
+    // low-rank approximation of the data covariance
+    Eigen::MatrixXd V = covFunc_->evaluate(inducing_loc_, data_loc_);
+    chol_inducing_matrix_.matrixL().solveInPlace(V);
+
+    // FITC keeps the exact prior variance: the part of the diagonal that the
+    // inducing points do not explain is treated as independent noise. For a
+    // stationary kernel the prior variance is the same at every location.
+    double prior_variance = covFunc_->evaluate(data_loc_.head(1), data_loc_.head(1))(0, 0);
+    Eigen::ArrayXd lambda = (prior_variance - V.colwise().squaredNorm().transpose().array()).max(0.0);
+    if (data_var_.rows() == 0) // homoscedastic
+    {
+        lambda += std::exp(2 * log_noise_sd_) + JITTER;
+    }
+    else // heteroscedastic
+    {
+        lambda += data_var_.array();
+    }
+    Eigen::ArrayXd lambda_inv = lambda.inverse();
+
+    // With Lambda as above, the approximate data covariance is V^T V + Lambda.
+    // By the Woodbury identity, everything needed for prediction can be
+    // expressed with the m x m matrix A = I + V Lambda^{-1} V^T, which takes
+    // the place of the Gram matrix.
+    Eigen::MatrixXd V_scaled = V * lambda_inv.sqrt().matrix().asDiagonal();
+    Eigen::MatrixXd gram = Eigen::MatrixXd::Identity(m, m);
+    gram.selfadjointView<Eigen::Lower>().rankUpdate(V_scaled); // only the lower triangle, this is the O(n m^2) part
+    gram_matrix_ = gram.selfadjointView<Eigen::Lower>();
+    chol_gram_matrix_ = gram_matrix_.ldlt();
+
+    // alpha = A^{-1} V Lambda^{-1} y, the mean is then w^T alpha for the
+    // whitened covariance w = L^{-1} k(Z, x) of a test point
+    alpha_ = chol_gram_matrix_.solve(V * (lambda_inv * data_out_.array()).matrix());
+
+    if (use_explicit_trend_)
+    {
+        Eigen::MatrixXd features(2, n);
+        features.row(0) = Eigen::MatrixXd::Ones(1, n); // instead of pow(0)
+        features.row(1) = data_loc_.array(); // instead of pow(1)
+        Eigen::MatrixXd features_scaled = features * lambda_inv.matrix().asDiagonal();
+
+        // the feature vectors are stored projected into the whitened inducing
+        // space, then predict() can treat them the same way as in the full GP
+        feature_vectors_ = features_scaled * V.transpose();
+
+        feature_matrix_ =
+            features_scaled * features.transpose() - feature_vectors_ * chol_gram_matrix_.solve(feature_vectors_.transpose());
+        chol_feature_matrix_ = feature_matrix_.ldlt();
+
+        beta_ = chol_feature_matrix_.solve(features_scaled * data_out_ - feature_vectors_ * alpha_);
+    }
+}
+
 void GP::inferSD(const Eigen::VectorXd& data_loc, const Eigen::VectorXd& data_out, const int n,
                  const Eigen::VectorXd& data_var /* = EigenVectorXd() */,
                  const double prediction_point /*= std::numeric_limits<double>::quiet_NaN()*/)
@@ -266,6 +374,8 @@ void GP::inferSD(const Eigen::VectorXd& data_loc, const Eigen::VectorXd& data_ou
 
     bool use_var = data_var.rows() > 0; // true means heteroscedastic noise
 
+    inducing_loc_ = Eigen::VectorXd(); // back to the full GP
+
     if (n < data_loc.rows())
     {
         std::vector<double> loc_arr(n);
@@ -307,6 +417,98 @@ void GP::clearData()
     chol_gram_matrix_ = Eigen::LDLT<Eigen::MatrixXd>();
     data_loc_ = Eigen::VectorXd();
     data_out_ = Eigen::VectorXd();
+    inducing_loc_ = Eigen::VectorXd();
+    clearCovarianceCache();
+}
+
+void GP::updateCovarianceCache()
+{
+    const int n = data_loc_.rows();
+    const int m = cov_cache_loc_.rows();
+
+    // position of each data location in the cache, -1 if it is new
+    std::vector<int> cached_index(n, -1);
+    int fresh_count = n;
+
+    if (m > 0)
+    {
+        // the data is not necessarily ordered (see inferSD), so look the
+        // locations up in a sorted index of the cache
+        std::vector<int> order(m);
+        for (int i = 0; i < m; ++i)
+        {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [this](int a, int b) { return cov_cache_loc_[a] < cov_cache_loc_[b]; });
+
+        for (int i = 0; i < n; ++i)
+        {
+            std::vector<int>::const_iterator it = std::lower_bound(
+                order.begin(), order.end(), data_loc_[i], [this](int a, double loc) { return cov_cache_loc_[a] < loc; });
+            if (it != order.end() && cov_cache_loc_[*it] == data_loc_[i])
+            {
+                cached_index[i] = *it;
+                --fresh_count;
+            }
+        }
+    }
+
+    // The full symmetric evaluation costs n(n+1)/2 kernel evaluations, the
+    // update fresh_count * n. Beyond half of the points being new, or
+    // without cache, evaluating everything is cheaper.
+    if (2 * fresh_count > n)
+    {
+        cov_cache_ = covFunc_->evaluate(data_loc_, data_loc_);
+        cov_cache_loc_ = data_loc_;
+        return;
+    }
+
+    Eigen::MatrixXd data_cov(n, n);
+
+    for (int j = 0; j < n; ++j)
+    {
+        if (cached_index[j] < 0)
+            continue;
+        for (int i = 0; i < n; ++i)
+        {
+            if (cached_index[i] >= 0)
+            {
+                data_cov(i, j) = cov_cache_(cached_index[i], cached_index[j]);
+            }
+        }
+    }
+
+    if (fresh_count > 0)
+    {
+        std::vector<int> fresh_index;
+        fresh_index.reserve(fresh_count);
+        Eigen::VectorXd fresh_loc(fresh_count);
+        for (int i = 0; i < n; ++i)
+        {
+            if (cached_index[i] < 0)
+            {
+                fresh_loc[fresh_index.size()] = data_loc_[i];
+                fresh_index.push_back(i);
+            }
+        }
+
+        // rows of the new locations against all data, mirrored into the columns
+        Eigen::MatrixXd fresh_cov = covFunc_->evaluate(fresh_loc, data_loc_);
+        for (int k = 0; k < fresh_count; ++k)
+        {
+            data_cov.row(fresh_index[k]) = fresh_cov.row(k);
+            data_cov.col(fresh_index[k]) = fresh_cov.row(k).transpose();
+        }
+    }
+
+    cov_cache_.swap(data_cov);
+    cov_cache_loc_ = data_loc_;
+}
+
+void GP::clearCovarianceCache()
+{
+    cov_cache_loc_ = Eigen::VectorXd();
+    cov_cache_ = Eigen::MatrixXd();
 }
 
 Eigen::VectorXd GP::predict(const Eigen::VectorXd& locations, Eigen::VectorXd *variances /*=nullptr*/) const
@@ -325,7 +527,7 @@ Eigen::VectorXd GP::predict(const Eigen::VectorXd& locations, Eigen::VectorXd *v
     else
     {
         // Calculate mixed covariance matrix (test and data points)
-        Eigen::MatrixXd mixed_cov = covFunc_->evaluate(locations, data_loc_);
+        Eigen::MatrixXd mixed_cov = covFunc_->evaluate(locations, isSparse() ? inducing_loc_ : data_loc_);
 
         // Calculate feature matrix for linear feature
         Eigen::MatrixXd phi(2, locations.rows());
@@ -370,7 +572,7 @@ Eigen::VectorXd GP::predictProjected(const Eigen::VectorXd& locations, Eigen::Ve
     else
     {
         // The mixed covariance matrix (test and data points)
-        Eigen::MatrixXd mixed_cov = covFunc->evaluate(locations, data_loc_);
+        Eigen::MatrixXd mixed_cov = covFunc->evaluate(locations, isSparse() ? inducing_loc_ : data_loc_);
 
         Eigen::MatrixXd phi(2, locations.rows());
         if (use_explicit_trend_)
@@ -388,12 +590,20 @@ Eigen::VectorXd GP::predictProjected(const Eigen::VectorXd& locations, Eigen::Ve
 Eigen::VectorXd GP::predict(const Eigen::MatrixXd& prior_cov, const Eigen::MatrixXd& mixed_cov,
                             const Eigen::MatrixXd& phi /*=Eigen::MatrixXd()*/, Eigen::VectorXd *variances /*=nullptr*/) const
 {
+    // In sparse mode, the mixed covariance is taken to the whitened inducing
+    // space, where alpha, the Gram matrix and the feature vectors are stored.
+    Eigen::MatrixXd whitened_cov;
+    if (isSparse())
+    {
+        whitened_cov = chol_inducing_matrix_.matrixL().solve(mixed_cov.transpose()).transpose();
+    }
+    const Eigen::MatrixXd& cov = isSparse() ? whitened_cov : mixed_cov;
 
     // calculate GP mean from precomputed alpha vector
-    Eigen::VectorXd m = mixed_cov * alpha_;
+    Eigen::VectorXd m = cov * alpha_;
 
     // precompute K^{-1} * mixed_cov
-    Eigen::MatrixXd gamma = chol_gram_matrix_.solve(mixed_cov.transpose());
+    Eigen::MatrixXd gamma = chol_gram_matrix_.solve(cov.transpose());
 
     Eigen::MatrixXd R;
 
@@ -408,7 +618,16 @@ Eigen::VectorXd GP::predict(const Eigen::MatrixXd& prior_cov, const Eigen::Matri
     if (variances != nullptr)
     {
         // calculate GP variance
-        Eigen::MatrixXd v = prior_cov - mixed_cov * gamma;
+        Eigen::MatrixXd v;
+        if (isSparse())
+        {
+            // k(x, x) - w^T w + w^T A^{-1} w
+            v = prior_cov - cov * cov.transpose() + cov * gamma;
+        }
+        else
+        {
+            v = prior_cov - mixed_cov * gamma;
+        }
 
         // include fixed-features in the calculations
         if (use_explicit_trend_)
@@ -427,6 +646,14 @@ void GP::setHyperParameters(const Eigen::VectorXd& hyperParameters)
     assert(hyperParameters.rows() == covFunc_->getParameterCount() + covFunc_->getExtraParameterCount() + 1 &&
            "Wrong number of hyperparameters supplied to setHyperParameters()!");
     log_noise_sd_ = hyperParameters[0];
+
+    // the noise is not part of the cached covariance, only kernel parameters invalidate it
+    if (hyperParameters.segment(1, covFunc_->getParameterCount()) != covFunc_->getParameters() ||
+        hyperParameters.tail(covFunc_->getExtraParameterCount()) != covFunc_->getExtraParameters())
+    {
+        clearCovarianceCache();
+    }
+
     covFunc_->setParameters(hyperParameters.segment(1, covFunc_->getParameterCount()));
     covFunc_->setExtraParameters(hyperParameters.tail(covFunc_->getExtraParameterCount()));
     if (data_loc_.rows() > 0)
@@ -449,6 +676,42 @@ Eigen::VectorXd GP::getHyperParameters() const
     return hyperParameters;
 }
 
+double GP::negativeLogLikelihood(Eigen::VectorXd *gradient) const
+{
+    assert(data_loc_.rows() > 0 && !isSparse() && "Error: the likelihood needs a full GP inference!");
+
+    const int n = data_loc_.rows();
+    const Eigen::VectorXd D = chol_gram_matrix_.vectorD();
+
+    if (chol_gram_matrix_.info() != Eigen::Success || (D.array() <= 0.0).any())
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    // log|K| is the sum over the log-diagonal of the factorization
+    double nll = 0.5 * data_out_.dot(alpha_) + 0.5 * D.array().log().sum() + 0.5 * n * std::log(2 * M_PI);
+
+    if (gradient != nullptr)
+    {
+        // d nll / d theta = 0.5 * tr((K^-1 - alpha * alpha^T) * dK / d theta), using the
+        // factorization of the last inference
+        Eigen::MatrixXd W = chol_gram_matrix_.solve(Eigen::MatrixXd::Identity(n, n));
+        W -= alpha_ * alpha_.transpose();
+
+        std::vector<Eigen::MatrixXd> derivatives = covFunc_->evaluateDerivatives(data_loc_);
+
+        gradient->resize(derivatives.size() + 1);
+        // the noise parameter only enters the homoscedastic case, dK / d log_sd = 2 * sd^2 * I
+        (*gradient)(0) = data_var_.rows() == 0 ? std::exp(2 * log_noise_sd_) * W.trace() : 0.0;
+        for (size_t i = 0; i < derivatives.size(); ++i)
+        {
+            (*gradient)(i + 1) = 0.5 * W.cwiseProduct(derivatives[i]).sum();
+        }
+    }
+
+    return nll;
+}
+
 void GP::enableExplicitTrend()
 {
     use_explicit_trend_ = true;
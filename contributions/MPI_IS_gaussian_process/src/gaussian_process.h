@@ -77,6 +77,42 @@ private:
     Eigen::LDLT<Eigen::MatrixXd> chol_feature_matrix_;
     Eigen::VectorXd beta_;
 
+    // Noise-free covariance of the locations of the last inference. Kept so
+    // that the next Gram matrix only needs the rows and columns of locations
+    // that were not part of the previous data set.
+    Eigen::VectorXd cov_cache_loc_;
+    Eigen::MatrixXd cov_cache_;
+
+    // Sparse mode: locations of the inducing points and the Cholesky factor of
+    // their covariance. Empty when the full GP is used.
+    Eigen::VectorXd inducing_loc_;
+    Eigen::LLT<Eigen::MatrixXd> chol_inducing_matrix_;
+
+    /*!
+     * Brings cov_cache_ up to date with data_loc_. Entries between locations
+     * that were already cached are copied, the covariance function is only
+     * evaluated for rows and columns of new locations.
+     */
+    void updateCovarianceCache();
+
+    /*!
+     * Drops the covariance cache, needed whenever the covariance function or
+     * its parameters change.
+     */
+    void clearCovarianceCache();
+
+    /*!
+     * The sparse counterpart of infer(). In sparse mode the Gram matrix, alpha
+     * and the feature vectors live in the whitened inducing point space, see
+     * inferSparse().
+     */
+    void inferSparse();
+
+    /*!
+     * True if the GP currently holds a sparse approximation.
+     */
+    bool isSparse() const { return inducing_loc_.rows() > 0; }
+
 public:
     typedef std::pair<Eigen::VectorXd, Eigen::MatrixXd> VectorMatrixPair;
 
@@ -145,6 +181,19 @@ public:
                  const Eigen::VectorXd& data_var = Eigen::VectorXd(),
                  const double prediction_point = std::numeric_limits<double>::quiet_NaN());
 
+    /*!
+     * Calculates a sparse GP approximation based on inducing points (FITC,
+     * fully independent training conditional). All data points are used, but
+     * the inference costs O(n m^2) for n data points and m inducing points
+     * instead of O(n^3), and memory is O(n m). The covariance functions are
+     * assumed to be stationary.
+     *
+     * The sparse approximation stays active until infer() or inferSD() are
+     * called with new data.
+     */
+    void inferSparse(const Eigen::VectorXd& data_loc, const Eigen::VectorXd& data_out, const Eigen::VectorXd& inducing_loc,
+                     const Eigen::VectorXd& data_var = Eigen::VectorXd());
+
     /*!
      * Sets the GP back to the prior:
      * Removes datapoints, empties the Gram matrix.
@@ -186,6 +235,16 @@ public:
      */
     Eigen::VectorXd getHyperParameters() const;
 
+    /*!
+     * Returns the negative log marginal likelihood of the data of the last
+     * (full, not sparse) inference under the current hyperparameters, and
+     * optionally its gradient with respect to the hyperparameters in the
+     * order of getHyperParameters(). The explicit trend is not part of the
+     * likelihood. The Cholesky factorization of the inference is reused, so
+     * the gradient costs one more O(n^3) solve.
+     */
+    double negativeLogLikelihood(Eigen::VectorXd *gradient = nullptr) const;
+
     /*!
      * Enables the use of a explicit linear basis function.
      */
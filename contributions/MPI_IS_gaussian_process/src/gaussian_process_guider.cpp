@@ -40,6 +40,7 @@
  */
 
 #include "gaussian_process_guider.h"
+#include "hyperparameter_optimizer.h"
 
 #include <cmath>
 #include <ctime>
@@ -54,17 +55,21 @@
 #define REGULAR_BUFFER_SIZE 2048 // for the regularized data storage
 #define FFT_SIZE 4096 // for zero-padding the FFT, >= REGULAR_BUFFER_SIZE!
 #define GRID_INTERVAL 5.0
+#define SPARSE_HISTORY_PERIODS 2 // history used by the sparse GP, in worm periods
 #define MAX_DITHER_STEPS 10 // for our fallback dithering
 
 #define DEFAULT_LEARNING_RATE 0.01 // for a smooth parameter adaptation
 
 #define HYSTERESIS 0.1 // for the hybrid mode
 
+#define MIN_POINTS_FOR_OPTIMIZATION 20 // regularized points needed to fit the hyperparameters
+#define MAX_POINTS_FOR_OPTIMIZATION 400 // most recent regularized points used for the fit
+
 GaussianProcessGuider::GaussianProcessGuider(guide_parameters parameters)
-    : start_time_(clock::now()), last_time_(clock::now()), control_signal_(0), prediction_(0), last_prediction_end_(0),
+    : now_(&clock::now), start_time_(now_()), last_time_(now_()), control_signal_(0), prediction_(0), last_prediction_end_(0),
       dither_steps_(0), dithering_active_(false), dither_offset_(0.0), circular_buffer_data_(CIRCULAR_BUFFER_SIZE),
       covariance_function_(), output_covariance_function_(), gp_(covariance_function_), learning_rate_(DEFAULT_LEARNING_RATE),
-      parameters(parameters)
+      optimization_requested_(false), cancel_optimization_(false), parameters(parameters)
 {
     circular_buffer_data_.push_front(data_point()); // add first point
     circular_buffer_data_[0].control = 0; // set first control to zero
@@ -82,11 +87,26 @@ GaussianProcessGuider::GaussianProcessGuider(guide_parameters parameters)
     SetGPHyperparameters(hyperparameters);
 }
 
-GaussianProcessGuider::~GaussianProcessGuider() { }
+GaussianProcessGuider::~GaussianProcessGuider()
+{
+    CancelHyperparameterOptimization();
+}
+
+void GaussianProcessGuider::CancelHyperparameterOptimization()
+{
+    // the background optimization refers to our cancel flag, wait for it to stop
+    cancel_optimization_ = true;
+    if (optimization_.valid())
+    {
+        optimization_.wait();
+        optimization_ = std::future<HyperparameterOptimizer::Result>();
+    }
+    optimization_requested_ = false;
+}
 
 void GaussianProcessGuider::SetTimestamp()
 {
-    auto current_time = clock::now();
+    auto current_time = now_();
     double delta_measurement_time = std::chrono::duration<double>(current_time - last_time_).count();
     last_time_ = current_time;
     get_last_point().timestamp = std::chrono::duration<double>(current_time - start_time_).count() -
@@ -196,6 +216,11 @@ void GaussianProcessGuider::UpdateGP(double prediction_point /*= std::numeric_li
     // subtract polynomial fit from the data points
     Eigen::VectorXd gear_error_detrend = gear_error - linear_fit;
 
+    if (optimization_requested_)
+    {
+        LaunchHyperparameterOptimization(timestamps, gear_error_detrend, variances);
+    }
+
 #if PRINT_TIMINGS_
     end = std::clock();
     double time_detrend = double(end - begin) / CLOCKS_PER_SEC;
@@ -221,8 +246,31 @@ void GaussianProcessGuider::UpdateGP(double prediction_point /*= std::numeric_li
     begin = std::clock();
 #endif
 
-    // inference of the GP with the new points, maximum accuracy should be reached around current time
-    gp_.inferSD(timestamps, gear_error, parameters.points_for_approximation_, variances, prediction_point);
+    if (parameters.inducing_points_ > 0)
+    {
+        // sparse inference with the inducing points spread evenly over the last
+        // worm period up to the prediction point
+        double end = math_tools::isNaN(prediction_point) ? timestamps(timestamps.rows() - 1) : prediction_point;
+        double spacing = GetGPHyperparameters()[PKPeriodLength] / parameters.inducing_points_;
+        Eigen::VectorXd inducing_locations(parameters.inducing_points_);
+        for (int i = 0; i < parameters.inducing_points_; ++i)
+        {
+            inducing_locations(i) = end - i * spacing;
+        }
+
+        // The cost of FITC grows with the number of data points, so it gets a
+        // bounded summary of the history: the points of the last few periods,
+        // averaged over one inducing interval each.
+        Eigen::MatrixXd binned = bin_dataset(timestamps, gear_error, variances, spacing,
+                                             SPARSE_HISTORY_PERIODS * parameters.inducing_points_);
+        gp_.inferSparse(binned.row(0).transpose(), binned.row(1).transpose(), inducing_locations,
+                        binned.row(2).transpose());
+    }
+    else
+    {
+        // inference of the GP with the new points, maximum accuracy should be reached around current time
+        gp_.inferSD(timestamps, gear_error, parameters.points_for_approximation_, variances, prediction_point);
+    }
 
 #if PRINT_TIMINGS_
     end = std::clock();
@@ -238,7 +286,7 @@ double GaussianProcessGuider::PredictGearError(double prediction_location)
     // in the first step of each sequence, use the current time stamp as last prediction end
     if (last_prediction_end_ < 0.0)
     {
-        last_prediction_end_ = std::chrono::duration<double>(clock::now() - start_time_).count();
+        last_prediction_end_ = std::chrono::duration<double>(now_() - start_time_).count();
     }
 
     // prediction from the last endpoint to the prediction point
@@ -296,7 +344,7 @@ double GaussianProcessGuider::result(double input, double SNR, double time_step,
     // the starting time is set at the first call of result after startup or reset
     if (get_number_of_measurements() == 1)
     {
-        start_time_ = clock::now();
+        start_time_ = now_();
         last_time_ = start_time_; // this is OK, since last_time_ only provides a minor correction
     }
 
@@ -325,7 +373,7 @@ double GaussianProcessGuider::result(double input, double SNR, double time_step,
     {
         if (prediction_point < 0.0)
         {
-            prediction_point = std::chrono::duration<double>(clock::now() - start_time_).count();
+            prediction_point = std::chrono::duration<double>(now_() - start_time_).count();
         }
         // the point of highest precision shoud be between now and the next step
         UpdateGP(prediction_point + 0.5 * time_step);
@@ -380,7 +428,7 @@ double GaussianProcessGuider::deduceResult(double time_step, double prediction_p
     {
         if (prediction_point < 0.0)
         {
-            prediction_point = std::chrono::duration<double>(clock::now() - start_time_).count();
+            prediction_point = std::chrono::duration<double>(now_() - start_time_).count();
         }
         // the point of highest precision should be between now and the next step
         UpdateGP(prediction_point + 0.5 * time_step);
@@ -407,6 +455,9 @@ double GaussianProcessGuider::deduceResult(double time_step, double prediction_p
 
 void GaussianProcessGuider::reset()
 {
+    // an optimization fitted to the old data must not be applied to the new session
+    CancelHyperparameterOptimization();
+
     circular_buffer_data_.clear();
     gp_.clearData();
 
@@ -416,8 +467,8 @@ void GaussianProcessGuider::reset()
     circular_buffer_data_[0].control = 0; // set first control to zero
 
     last_prediction_end_ = -1.0; // the negative value signals we didn't predict yet
-    start_time_ = clock::now();
-    last_time_ = clock::now();
+    start_time_ = now_();
+    last_time_ = now_();
 
     dither_offset_ = 0.0;
     dither_steps_ = 0;
@@ -472,9 +523,14 @@ bool GaussianProcessGuider::SetBoolComputePeriod(bool active)
 }
 
 std::vector<double> GaussianProcessGuider::GetGPHyperparameters() const
+{
+    return ToGuiderHyperparameters(gp_.getHyperParameters());
+}
+
+std::vector<double> GaussianProcessGuider::ToGuiderHyperparameters(const Eigen::VectorXd& log_hyperparameters)
 {
     // since the GP class works in log space, we have to exp() the parameters first.
-    Eigen::VectorXd hyperparameters_full = gp_.getHyperParameters().array().exp();
+    Eigen::VectorXd hyperparameters_full = log_hyperparameters.array().exp();
     // remove first parameter, which is unused here
     Eigen::VectorXd hyperparameters = hyperparameters_full.tail(NumParameters);
 
@@ -533,6 +589,17 @@ bool GaussianProcessGuider::SetNumPointsForApproximation(int num_points)
     return false;
 }
 
+int GaussianProcessGuider::GetNumInducingPoints() const
+{
+    return parameters.inducing_points_;
+}
+
+bool GaussianProcessGuider::SetNumInducingPoints(int num_points)
+{
+    parameters.inducing_points_ = num_points;
+    return false;
+}
+
 double GaussianProcessGuider::GetPeriodLengthsInference() const
 {
     return parameters.min_periods_for_inference_;
@@ -566,6 +633,99 @@ bool GaussianProcessGuider::SetPredictionGain(double prediction_gain)
     return false;
 }
 
+bool GaussianProcessGuider::StartHyperparameterOptimization()
+{
+    if (IsOptimizingHyperparameters())
+    {
+        return true;
+    }
+    if (get_number_of_measurements() < MIN_POINTS_FOR_OPTIMIZATION + 1)
+    {
+        return true;
+    }
+    optimization_requested_ = true;
+    return false;
+}
+
+bool GaussianProcessGuider::IsOptimizingHyperparameters() const
+{
+    return optimization_requested_ || optimization_.valid();
+}
+
+bool GaussianProcessGuider::TakeOptimizedHyperparameters(std::vector<double> *hyperparameters)
+{
+    if (!optimization_.valid() || optimization_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return false;
+    }
+
+    HyperparameterOptimizer::Result result = optimization_.get();
+    if (!std::isfinite(result.negative_log_likelihood))
+    {
+        // the starting point is returned when every start failed, applying it would revert
+        // any parameter changes made since the launch
+        GPDebug->Log("GP hyperparameter optimization failed, keeping the current hyperparameters");
+        return false;
+    }
+
+    *hyperparameters = ToGuiderHyperparameters(result.hyperparameters);
+
+    // the period length was not optimized, but the FFT may have updated it in the meantime
+    (*hyperparameters)[PKPeriodLength] = GetGPHyperparameters()[PKPeriodLength];
+    return true;
+}
+
+void GaussianProcessGuider::LaunchHyperparameterOptimization(const Eigen::VectorXd& timestamps,
+                                                             const Eigen::VectorXd& gear_error,
+                                                             const Eigen::VectorXd& variances)
+{
+    optimization_requested_ = false;
+
+    int num_points = std::min<int>(timestamps.rows(), MAX_POINTS_FOR_OPTIMIZATION);
+    if (num_points < MIN_POINTS_FOR_OPTIMIZATION)
+    {
+        GPDebug->Log("GP hyperparameter optimization skipped, only %d points", num_points);
+        return;
+    }
+
+    // the snapshot is copied into the task, the guider keeps running on the old parameters
+    Eigen::VectorXd data_loc = timestamps.tail(num_points);
+    Eigen::VectorXd data_out = gear_error.tail(num_points);
+    Eigen::VectorXd data_var = variances.tail(num_points);
+    Eigen::VectorXd initial = gp_.getHyperParameters();
+
+    // the GP vector starts with the noise, which is replaced by the measurement variances
+    std::vector<bool> active(initial.rows(), true);
+    active[0] = false;
+    active[PKPeriodLength + 1] = false; // the period length is the job of the FFT
+
+    Eigen::VectorXd lower = initial.array() - 3.0;
+    Eigen::VectorXd upper = initial.array() + 3.0;
+    // the periodic length-scale is stored as 4 * sin(pi * l / P), which has to stay below 4
+    upper(PKLengthScale + 1) = std::min(upper(PKLengthScale + 1), std::log(3.99));
+    // same minimal length-scales as in SetGPHyperparameters
+    double period_length = std::exp(initial(PKPeriodLength + 1));
+    lower(SE0KLengthScale + 1) = std::max(lower(SE0KLengthScale + 1), 0.0);
+    lower(SE1KLengthScale + 1) = std::max(lower(SE1KLengthScale + 1), 0.0);
+    lower(PKLengthScale + 1) = std::max(lower(PKLengthScale + 1), std::log(4 * std::sin(M_PI / period_length)));
+
+    GPDebug->Log("GP hyperparameter optimization started on %d points", num_points);
+
+    cancel_optimization_ = false;
+    const std::atomic<bool> *cancel = &cancel_optimization_;
+    optimization_ = std::async(std::launch::async, [=]() {
+        covariance_functions::PeriodicSquareExponential2 covariance_function;
+        HyperparameterOptimizer optimizer(covariance_function);
+        optimizer.setData(data_loc, data_out, data_var);
+        optimizer.setActive(active);
+        optimizer.setBounds(lower, upper);
+        HyperparameterOptimizer::Result result = optimizer.optimize(initial, cancel);
+        GPDebug->Log("GP hyperparameter optimization done, NLL %.2f after %d evaluations", result.negative_log_likelihood,
+                     result.evaluations);
+        return result;
+    });
+}
+
 void GaussianProcessGuider::inject_data_point(double timestamp, double input, double SNR, double control)
 {
     // collect data point content, except for the control signal
@@ -573,7 +733,7 @@ void GaussianProcessGuider::inject_data_point(double timestamp, double input, do
     last_prediction_end_ = timestamp;
     get_last_point().timestamp = timestamp; // overrides the usual HandleTimestamps();
 
-    start_time_ = clock::now() - std::chrono::seconds((int) timestamp);
+    start_time_ = now_() - std::chrono::seconds((int) timestamp);
 
     add_one_point(); // add new point here, since the control is for the next point in time
     HandleControls(control); // already store control signal
@@ -759,6 +919,37 @@ Eigen::MatrixXd GaussianProcessGuider::regularize_dataset(const Eigen::VectorXd&
     return result;
 }
 
+Eigen::MatrixXd GaussianProcessGuider::bin_dataset(const Eigen::VectorXd& timestamps, const Eigen::VectorXd& gear_error,
+                                                   const Eigen::VectorXd& variances, double bin_width, int max_bins)
+{
+    // walk back from the newest point, the bins are aligned to multiples of the bin
+    // width so that they stay put from one step to the next
+    Eigen::MatrixXd result(3, max_bins);
+    int j = max_bins;
+    int i = static_cast<int>(timestamps.rows()) - 1;
+    while (i >= 0 && j > 0)
+    {
+        double const bin_start = std::floor(timestamps(i) / bin_width) * bin_width;
+        double weight_sum = 0.0;
+        double timestamp_sum = 0.0;
+        double gear_error_sum = 0.0;
+        for (; i >= 0 && timestamps(i) >= bin_start; --i)
+        {
+            // inverse-variance weighted mean, the variance of the mean shrinks accordingly
+            double const weight = 1.0 / variances(i);
+            weight_sum += weight;
+            timestamp_sum += weight * timestamps(i);
+            gear_error_sum += weight * gear_error(i);
+        }
+        --j;
+        result(0, j) = timestamp_sum / weight_sum;
+        result(1, j) = gear_error_sum / weight_sum;
+        result(2, j) = 1.0 / weight_sum;
+    }
+
+    return result.rightCols(max_bins - j);
+}
+
 void GaussianProcessGuider::save_gp_data() const
 {
     // write the GP output to a file for easy analyzation
@@ -841,6 +1032,13 @@ void GaussianProcessGuider::SetLearningRate(double learning_rate)
     return;
 }
 
+void GaussianProcessGuider::SetTimeSource(const time_source& now)
+{
+    now_ = now;
+    start_time_ = now_();
+    last_time_ = start_time_;
+}
+
 // Debug Log interface ======
 
 class NullDebugLog : public GPDebug
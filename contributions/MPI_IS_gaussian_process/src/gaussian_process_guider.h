@@ -45,9 +45,13 @@
 #include "circbuf.h"
 #include "gaussian_process.h"
 #include "covariance_functions.h"
+#include "hyperparameter_optimizer.h"
 #include "math_tools.h"
 
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <future>
 
 enum Hyperparameters
 {
@@ -72,6 +76,7 @@ class GaussianProcessGuider
 {
 public:
     typedef std::chrono::steady_clock clock;
+    typedef std::function<clock::time_point()> time_source;
 
     struct data_point
     {
@@ -94,6 +99,7 @@ public:
         double min_periods_for_period_estimation_;
 
         int points_for_approximation_;
+        int inducing_points_; // sparse GP if > 0, subset of data approximation otherwise
 
         bool compute_period_;
 
@@ -107,7 +113,7 @@ public:
 
         guide_parameters()
             : control_gain_(0.0), min_move_(0.0), prediction_gain_(0.0), min_periods_for_inference_(0.0),
-              min_periods_for_period_estimation_(0.0), points_for_approximation_(0), compute_period_(false),
+              min_periods_for_period_estimation_(0.0), points_for_approximation_(0), inducing_points_(0), compute_period_(false),
               SE0KLengthScale_(0.0), SE0KSignalVariance_(0.0), PKLengthScale_(0.0), PKSignalVariance_(0.0),
               SE1KLengthScale_(0.0), SE1KSignalVariance_(0.0), PKPeriodLength_(0.0)
         {
@@ -115,6 +121,7 @@ public:
     };
 
 private:
+    time_source now_; // clock::now, unless replaced for offline replay
     clock::time_point start_time_; // reference time
     clock::time_point last_time_;
 
@@ -139,6 +146,14 @@ private:
      */
     double learning_rate_;
 
+    /**
+     * Background hyperparameter optimization. A requested optimization is
+     * started by the next UpdateGP on a snapshot of the preprocessed data.
+     */
+    bool optimization_requested_;
+    std::atomic<bool> cancel_optimization_;
+    std::future<HyperparameterOptimizer::Result> optimization_;
+
     /**
      * Guiding parameters of this instance.
      */
@@ -175,6 +190,25 @@ private:
      */
     double EstimatePeriodLength(const Eigen::VectorXd& time, const Eigen::VectorXd& data);
 
+    /**
+     * Starts the marginal likelihood optimization of the kernel hyperparameters
+     * on the given detrended data, in the background.
+     */
+    void LaunchHyperparameterOptimization(const Eigen::VectorXd& timestamps, const Eigen::VectorXd& gear_error,
+                                          const Eigen::VectorXd& variances);
+
+    /**
+     * Stops a running optimization, waiting for it, and drops its result as
+     * well as a pending request.
+     */
+    void CancelHyperparameterOptimization();
+
+    /**
+     * Converts the log-space hyperparameters of the GP to the natural units
+     * used by GetGPHyperparameters.
+     */
+    static std::vector<double> ToGuiderHyperparameters(const Eigen::VectorXd& log_hyperparameters);
+
     /**
      * Calculates the difference in gear error for the time between the last
      * prediction point and the current prediction point, which lies one
@@ -198,6 +232,9 @@ public:
     int GetNumPointsForApproximation() const;
     bool SetNumPointsForApproximation(int num_points);
 
+    int GetNumInducingPoints() const;
+    bool SetNumInducingPoints(int num_points);
+
     bool GetBoolComputePeriod() const;
     bool SetBoolComputePeriod(bool active);
 
@@ -207,6 +244,29 @@ public:
     double GetPredictionGain() const;
     bool SetPredictionGain(double);
 
+    /**
+     * Requests a fit of the kernel hyperparameters to the collected data by
+     * maximizing the marginal likelihood. The optimization runs on background
+     * threads, starting with the next GP update; the period length and the
+     * noise stay fixed. Returns true on error, i.e. if an optimization is
+     * already pending or there is too little data.
+     */
+    bool StartHyperparameterOptimization();
+
+    /**
+     * True while a requested optimization has not been taken yet.
+     */
+    bool IsOptimizingHyperparameters() const;
+
+    /**
+     * If the background optimization has finished, stores its result in the
+     * units of GetGPHyperparameters and returns true. The result is not
+     * applied; this is left to the caller, e.g. via SetGPHyperparameters.
+     * An optimization that found no finite likelihood is discarded, and
+     * false is returned.
+     */
+    bool TakeOptimizedHyperparameters(std::vector<double> *hyperparameters);
+
     GaussianProcessGuider(guide_parameters parameters);
     ~GaussianProcessGuider();
 
@@ -282,6 +342,14 @@ public:
     Eigen::MatrixXd regularize_dataset(const Eigen::VectorXd& timestamps, const Eigen::VectorXd& gear_error,
                                        const Eigen::VectorXd& variances);
 
+    /**
+     * Averages the most recent data points in bins of the given width, keeping at
+     * most max_bins bins. Returns timestamps, gear error and variances of the bin
+     * means in a matrix, like regularize_dataset.
+     */
+    Eigen::MatrixXd bin_dataset(const Eigen::VectorXd& timestamps, const Eigen::VectorXd& gear_error,
+                                const Eigen::VectorXd& variances, double bin_width, int max_bins);
+
     /**
      * Saves the GP data to a csv file for external analysis. Expensive!
      */
@@ -291,6 +359,12 @@ public:
      * Sets the learning rate. Useful for disabling it for testing.
      */
     void SetLearningRate(double learning_rate);
+
+    /**
+     * Replaces the clock used for time stamping the measurements. This allows
+     * replaying recorded guide logs on their frame times, faster than real time.
+     */
+    void SetTimeSource(const time_source& now);
 };
 
 //
@@ -0,0 +1,356 @@
+/*
+ * Copyright 2026, PHD2 Developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file
+ * @brief     Fits the hyperparameters of a GP by maximizing the marginal likelihood.
+ */
+
+#include "hyperparameter_optimizer.h"
+#include "gaussian_process.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <random>
+#include <thread>
+
+namespace
+{
+// history length of the L-BFGS approximation
+const size_t LBFGS_HISTORY = 7;
+// maximal number of step halvings in the line search
+const int MAX_LINE_SEARCH_STEPS = 20;
+// sufficient decrease constant of the Armijo condition
+const double ARMIJO_CONSTANT = 1e-4;
+
+/*!
+ * Negative log likelihood of the data as a function of the full hyperparameter
+ * vector. Every thread has its own instance, and with it its own GP.
+ */
+class LikelihoodObjective
+{
+    GP gp_;
+    const Eigen::VectorXd& data_loc_;
+    const Eigen::VectorXd& data_out_;
+    const Eigen::VectorXd& data_var_;
+    bool inferred_;
+
+public:
+    int evaluations;
+
+    LikelihoodObjective(const covariance_functions::CovFunc& covFunc, const Eigen::VectorXd& data_loc,
+                        const Eigen::VectorXd& data_out, const Eigen::VectorXd& data_var)
+        : gp_(covFunc), data_loc_(data_loc), data_out_(data_out), data_var_(data_var), inferred_(false), evaluations(0)
+    {
+    }
+
+    double operator()(const Eigen::VectorXd& hyperparameters, Eigen::VectorXd *gradient)
+    {
+        ++evaluations;
+
+        gp_.setHyperParameters(hyperparameters); // runs the inference once the GP has data
+        if (!inferred_)
+        {
+            gp_.infer(data_loc_, data_out_, data_var_);
+            inferred_ = true;
+        }
+
+        double nll = gp_.negativeLogLikelihood(gradient);
+        if (!std::isfinite(nll) || !gradient->allFinite())
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        return nll;
+    }
+};
+
+struct Bounds
+{
+    std::vector<int> active; // indices of the optimized hyperparameters
+    Eigen::VectorXd lower; // bounds of the active parameters
+    Eigen::VectorXd upper;
+
+    Eigen::VectorXd reduce(const Eigen::VectorXd& full) const
+    {
+        Eigen::VectorXd reduced(active.size());
+        for (size_t k = 0; k < active.size(); ++k)
+        {
+            reduced(k) = full(active[k]);
+        }
+        return reduced;
+    }
+
+    void expand(const Eigen::VectorXd& reduced, Eigen::VectorXd *full) const
+    {
+        for (size_t k = 0; k < active.size(); ++k)
+        {
+            (*full)(active[k]) = reduced(k);
+        }
+    }
+
+    Eigen::VectorXd clamp(const Eigen::VectorXd& reduced) const { return reduced.cwiseMax(lower).cwiseMin(upper); }
+};
+
+/*!
+ * Projected L-BFGS from a single starting point. Parameters sitting on a bound
+ * with the gradient pointing outwards are held fixed for the iteration.
+ */
+double minimize(LikelihoodObjective& objective, const Bounds& bounds, int max_iterations, double tolerance,
+                const std::atomic<bool> *cancel, Eigen::VectorXd *x)
+{
+    Eigen::VectorXd z = bounds.clamp(bounds.reduce(*x));
+    bounds.expand(z, x);
+
+    Eigen::VectorXd full_gradient;
+    double f = objective(*x, &full_gradient);
+    if (!std::isfinite(f))
+    {
+        return f;
+    }
+    Eigen::VectorXd g = bounds.reduce(full_gradient);
+
+    std::deque<Eigen::VectorXd> S, Y; // the L-BFGS history
+    const int n = z.rows();
+
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        if (cancel != nullptr && *cancel)
+        {
+            break;
+        }
+
+        // projected gradient
+        Eigen::VectorXd pg = g;
+        for (int k = 0; k < n; ++k)
+        {
+            if ((z(k) <= bounds.lower(k) && g(k) > 0) || (z(k) >= bounds.upper(k) && g(k) < 0))
+            {
+                pg(k) = 0;
+            }
+        }
+        if (pg.lpNorm<Eigen::Infinity>() < 1e-8)
+        {
+            break; // stationary point
+        }
+
+        // two-loop recursion for the quasi-Newton direction
+        Eigen::VectorXd q = pg;
+        std::vector<double> a(S.size());
+        for (int i = (int) S.size() - 1; i >= 0; --i)
+        {
+            a[i] = S[i].dot(q) / Y[i].dot(S[i]);
+            q -= a[i] * Y[i];
+        }
+        if (!S.empty())
+        {
+            q *= S.back().dot(Y.back()) / Y.back().squaredNorm();
+        }
+        for (size_t i = 0; i < S.size(); ++i)
+        {
+            double b = Y[i].dot(q) / Y[i].dot(S[i]);
+            q += (a[i] - b) * S[i];
+        }
+
+        Eigen::VectorXd d = -q;
+        for (int k = 0; k < n; ++k)
+        {
+            if (pg(k) == 0)
+            {
+                d(k) = 0;
+            }
+        }
+        if (d.dot(pg) >= 0)
+        {
+            // not a descent direction, restart from steepest descent
+            d = -pg;
+            S.clear();
+            Y.clear();
+        }
+
+        // without curvature information, limit the first step to one unit in log space
+        double step = S.empty() ? std::min(1.0, 1.0 / d.lpNorm<Eigen::Infinity>()) : 1.0;
+
+        Eigen::VectorXd z_new;
+        Eigen::VectorXd x_new = *x;
+        double f_new = std::numeric_limits<double>::infinity();
+        bool accepted = false;
+        for (int i = 0; i < MAX_LINE_SEARCH_STEPS; ++i)
+        {
+            z_new = bounds.clamp(z + step * d);
+            bounds.expand(z_new, &x_new);
+            f_new = objective(x_new, &full_gradient);
+            if (f_new <= f + ARMIJO_CONSTANT * g.dot(z_new - z))
+            {
+                accepted = true;
+                break;
+            }
+            step *= 0.5;
+        }
+        if (!accepted)
+        {
+            break; // no further progress possible
+        }
+
+        Eigen::VectorXd g_new = bounds.reduce(full_gradient);
+        Eigen::VectorXd s = z_new - z;
+        Eigen::VectorXd y = g_new - g;
+        if (s.dot(y) > 1e-10 * s.norm() * y.norm()) // keep the approximation positive definite
+        {
+            S.push_back(s);
+            Y.push_back(y);
+            if (S.size() > LBFGS_HISTORY)
+            {
+                S.pop_front();
+                Y.pop_front();
+            }
+        }
+
+        bool converged = std::abs(f - f_new) <= tolerance * std::max(1.0, std::abs(f));
+
+        z = z_new;
+        *x = x_new;
+        f = f_new;
+        g = g_new;
+
+        if (converged)
+        {
+            break;
+        }
+    }
+
+    return f;
+}
+} // namespace
+
+HyperparameterOptimizer::HyperparameterOptimizer(const covariance_functions::CovFunc& covFunc, const Options& options)
+    : covFunc_(covFunc.clone()), options_(options)
+{
+}
+
+void HyperparameterOptimizer::setData(const Eigen::VectorXd& data_loc, const Eigen::VectorXd& data_out,
+                                      const Eigen::VectorXd& data_var)
+{
+    data_loc_ = data_loc;
+    data_out_ = data_out;
+    data_var_ = data_var;
+}
+
+void HyperparameterOptimizer::setActive(const std::vector<bool>& active)
+{
+    active_ = active;
+}
+
+void HyperparameterOptimizer::setBounds(const Eigen::VectorXd& lower, const Eigen::VectorXd& upper)
+{
+    lower_ = lower;
+    upper_ = upper;
+}
+
+HyperparameterOptimizer::Result HyperparameterOptimizer::optimize(const Eigen::VectorXd& initial,
+                                                                  const std::atomic<bool> *cancel) const
+{
+    assert(data_loc_.rows() > 0 && "Error: no data to fit the hyperparameters to!");
+
+    const int count = initial.rows();
+
+    Bounds bounds;
+    for (int i = 0; i < count; ++i)
+    {
+        if (active_.empty() || (i < (int) active_.size() && active_[i]))
+        {
+            bounds.active.push_back(i);
+        }
+    }
+    Eigen::VectorXd lower = lower_.rows() == count ? lower_ : Eigen::VectorXd(initial.array() - 3.0);
+    Eigen::VectorXd upper = upper_.rows() == count ? upper_ : Eigen::VectorXd(initial.array() + 3.0);
+    bounds.lower = bounds.reduce(lower);
+    bounds.upper = bounds.reduce(upper);
+
+    const int starts = std::max(1, options_.starts);
+
+    // the starting points are fixed up front, so the result does not depend on the threading
+    std::vector<Eigen::VectorXd> points(starts, initial);
+    for (int s = 1; s < starts; ++s)
+    {
+        std::mt19937 generator(options_.seed + s);
+        std::uniform_real_distribution<double> perturbation(-options_.start_spread, options_.start_spread);
+        for (int i : bounds.active)
+        {
+            points[s](i) += perturbation(generator);
+        }
+    }
+    std::vector<double> values(starts, std::numeric_limits<double>::infinity());
+
+    std::atomic<int> next_start(0);
+    std::atomic<int> evaluations(0);
+
+    auto worker = [&]() {
+        LikelihoodObjective objective(*covFunc_, data_loc_, data_out_, data_var_);
+        int s;
+        while ((s = next_start++) < starts)
+        {
+            values[s] = minimize(objective, bounds, options_.max_iterations, options_.tolerance, cancel, &points[s]);
+        }
+        evaluations += objective.evaluations;
+    };
+
+    unsigned int threads = options_.threads > 0 ? options_.threads : std::max(1U, std::thread::hardware_concurrency());
+    threads = std::min<unsigned int>(threads, starts);
+
+    if (threads <= 1)
+    {
+        worker();
+    }
+    else
+    {
+        std::vector<std::thread> pool;
+        pool.reserve(threads);
+        for (unsigned int t = 0; t < threads; ++t)
+        {
+            pool.emplace_back(worker);
+        }
+        for (std::thread& th : pool)
+        {
+            th.join();
+        }
+    }
+
+    int best = (int) (std::min_element(values.begin(), values.end()) - values.begin());
+
+    Result result;
+    result.hyperparameters = points[best];
+    result.negative_log_likelihood = values[best];
+    result.evaluations = evaluations;
+    return result;
+}
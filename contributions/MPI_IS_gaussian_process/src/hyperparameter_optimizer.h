@@ -0,0 +1,121 @@
+/*
+ * Copyright 2026, PHD2 Developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * @file
+ * @brief     Fits the hyperparameters of a GP by maximizing the marginal likelihood.
+ */
+
+#ifndef HYPERPARAMETER_OPTIMIZER_H
+#define HYPERPARAMETER_OPTIMIZER_H
+
+#include <Eigen/Dense>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "covariance_functions.h"
+
+/*!
+ * Maximizes the marginal likelihood of a data set over the hyperparameters of
+ * a GP with a given covariance function.
+ *
+ * The hyperparameters are optimized in the log space the GP stores them in
+ * (see GP::getHyperParameters), within box bounds, with a limited-memory BFGS
+ * method on the analytic gradient of GP::negativeLogLikelihood. Since the
+ * likelihood is multi-modal in the periodic parameters, the optimization is
+ * restarted from several randomly perturbed starting points, which run in
+ * parallel on separate threads. The best local optimum wins.
+ */
+class HyperparameterOptimizer
+{
+public:
+    struct Options
+    {
+        int starts; // number of starting points, the first one is the initial guess
+        int threads; // 0 uses one thread per core
+        int max_iterations; // per start
+        double start_spread; // starting points are drawn uniformly within +-spread around the initial guess
+        double tolerance; // on the relative change of the objective
+        unsigned int seed;
+
+        Options() : starts(4), threads(0), max_iterations(60), start_spread(1.0), tolerance(1e-6), seed(1) { }
+    };
+
+    struct Result
+    {
+        Eigen::VectorXd hyperparameters; // in the log space of GP::getHyperParameters
+        double negative_log_likelihood;
+        int evaluations; // summed over all starts
+    };
+
+    explicit HyperparameterOptimizer(const covariance_functions::CovFunc& covFunc, const Options& options = Options());
+
+    /*!
+     * Sets the data to fit. The variances are the heteroscedastic measurement
+     * noise, if empty the noise hyperparameter is used.
+     */
+    void setData(const Eigen::VectorXd& data_loc, const Eigen::VectorXd& data_out,
+                 const Eigen::VectorXd& data_var = Eigen::VectorXd());
+
+    /*!
+     * Selects the hyperparameters to optimize; the others stay at their
+     * initial values. All of them are optimized by default.
+     */
+    void setActive(const std::vector<bool>& active);
+
+    /*!
+     * Sets box bounds in log space. Without bounds, each parameter may move
+     * by +-3 (a factor of 20) from the initial guess.
+     */
+    void setBounds(const Eigen::VectorXd& lower, const Eigen::VectorXd& upper);
+
+    /*!
+     * Runs the optimization from the given initial hyperparameters. If cancel
+     * is given and becomes true, the best point found so far is returned.
+     */
+    Result optimize(const Eigen::VectorXd& initial, const std::atomic<bool> *cancel = nullptr) const;
+
+private:
+    std::unique_ptr<covariance_functions::CovFunc> covFunc_;
+    Options options_;
+    Eigen::VectorXd data_loc_;
+    Eigen::VectorXd data_out_;
+    Eigen::VectorXd data_var_;
+    std::vector<bool> active_;
+    Eigen::VectorXd lower_;
+    Eigen::VectorXd upper_;
+
+    HyperparameterOptimizer(const HyperparameterOptimizer&) = delete;
+    HyperparameterOptimizer& operator=(const HyperparameterOptimizer&) = delete;
+};
+
+#endif // HYPERPARAMETER_OPTIMIZER_H
@@ -60,6 +60,12 @@ int main(int argc, char **argv)
     parameters.prediction_gain_ = std::stod(argv[14]);
     parameters.compute_period_ = true;
 
+    // optional: number of inducing points for the sparse approximation
+    if (argc > 15)
+    {
+        parameters.inducing_points_ = std::stoi(argv[15]);
+    }
+
     GPG = new GaussianProcessGuider(parameters);
 
     GAHysteresis GAH;
@@ -41,6 +41,7 @@
 #include "math_tools.h"
 #include "gaussian_process.h"
 #include "covariance_functions.h"
+#include "hyperparameter_optimizer.h"
 
 #include <fstream>
 
@@ -357,6 +358,265 @@ TEST_F(GPTest, CovarianceTest3)
     }
 }
 
+// The Gram case is filled from one triangle, it has to match the general case
+TEST_F(GPTest, covariance_symmetric_evaluation_test)
+{
+    Eigen::VectorXd hyperparameters(6);
+    hyperparameters << 1, 2, 1, 2, -1, 1;
+    covariance_functions::PeriodicSquareExponential2 covariance_function(hyperparameters);
+    covariance_function.setExtraParameters(extra_parameters_);
+
+    Eigen::VectorXd locations = math_tools::generate_normal_random_matrix(20, 1);
+    Eigen::MatrixXd gram = covariance_function.evaluate(locations, locations);
+
+    for (int col = 0; col < gram.cols(); col++)
+    {
+        Eigen::VectorXd single_location = locations.segment(col, 1);
+        Eigen::MatrixXd column = covariance_function.evaluate(locations, single_location);
+        for (int row = 0; row < gram.rows(); row++)
+        {
+            EXPECT_NEAR(gram(row, col), column(row, 0), 1e-12);
+            EXPECT_EQ(gram(row, col), gram(col, row));
+        }
+    }
+}
+
+// Inference on a sliding, reordered window reuses the covariance of the
+// previous step and has to give the same result as inference from scratch
+TEST_F(GPTest, covariance_cache_test)
+{
+    const int window = 30;
+    Eigen::VectorXd locations(window + 10);
+    for (int i = 0; i < locations.size(); i++)
+    {
+        locations[i] = 0.37 * i;
+    }
+    Eigen::VectorXd outputs = math_tools::generate_normal_random_matrix(locations.size(), 1);
+
+    Eigen::VectorXd prediction_locations(3);
+    prediction_locations << 3.3, 9.1, 15.2;
+
+    for (int step = 0; step <= 10; step++)
+    {
+        // drop the oldest point, append a new one and reverse the order every other step
+        Eigen::VectorXd data_loc = locations.segment(step, window);
+        Eigen::VectorXd data_out = outputs.segment(step, window);
+        if (step % 2 == 1)
+        {
+            data_loc.reverseInPlace();
+            data_out.reverseInPlace();
+        }
+
+        gp_.infer(data_loc, data_out);
+
+        GP reference_gp(covariance_function_);
+        reference_gp.infer(data_loc, data_out);
+
+        Eigen::VectorXd variances;
+        Eigen::VectorXd reference_variances;
+        Eigen::VectorXd prediction = gp_.predict(prediction_locations, &variances);
+        Eigen::VectorXd reference_prediction = reference_gp.predict(prediction_locations, &reference_variances);
+
+        for (int i = 0; i < prediction.size(); i++)
+        {
+            EXPECT_NEAR(prediction(i), reference_prediction(i), 1e-9);
+            EXPECT_NEAR(variances(i), reference_variances(i), 1e-9);
+        }
+    }
+
+    // changing the kernel parameters has to invalidate the cache
+    Eigen::VectorXd hyperparameters = gp_.getHyperParameters();
+    hyperparameters[2] += 0.5;
+    gp_.setHyperParameters(hyperparameters);
+
+    GP reference_gp(covariance_function_);
+    reference_gp.setHyperParameters(hyperparameters);
+    reference_gp.infer(locations.segment(10, window), outputs.segment(10, window));
+
+    Eigen::VectorXd prediction = gp_.predict(prediction_locations);
+    Eigen::VectorXd reference_prediction = reference_gp.predict(prediction_locations);
+    for (int i = 0; i < prediction.size(); i++)
+    {
+        EXPECT_NEAR(prediction(i), reference_prediction(i), 1e-9);
+    }
+}
+
+// With the data locations as inducing points, FITC is exact up to the jitter
+TEST_F(GPTest, sparse_inference_test)
+{
+    Eigen::VectorXd data_loc(15);
+    for (int i = 0; i < data_loc.size(); i++)
+    {
+        data_loc[i] = 0.3 * i;
+    }
+    Eigen::VectorXd data_out = math_tools::generate_normal_random_matrix(data_loc.size(), 1);
+    Eigen::VectorXd data_var = Eigen::VectorXd::Constant(data_loc.size(), 0.1);
+
+    Eigen::VectorXd prediction_locations(4);
+    prediction_locations << 0.5, 2.2, 4.6, 5.0;
+
+    for (int trend = 0; trend < 2; trend++)
+    {
+        GP sparse_gp(covariance_function_);
+        if (trend)
+        {
+            gp_.enableExplicitTrend();
+            sparse_gp.enableExplicitTrend();
+        }
+
+        gp_.infer(data_loc, data_out, data_var);
+        sparse_gp.inferSparse(data_loc, data_out, data_loc, data_var);
+
+        Eigen::VectorXd variances;
+        Eigen::VectorXd sparse_variances;
+        Eigen::VectorXd prediction = gp_.predict(prediction_locations, &variances);
+        Eigen::VectorXd sparse_prediction = sparse_gp.predict(prediction_locations, &sparse_variances);
+
+        for (int i = 0; i < prediction.size(); i++)
+        {
+            EXPECT_NEAR(prediction(i), sparse_prediction(i), 1e-3);
+            EXPECT_NEAR(variances(i), sparse_variances(i), 1e-3);
+        }
+    }
+}
+
+// Fewer inducing points still approximate a smooth function well
+TEST_F(GPTest, sparse_approximation_test)
+{
+    Eigen::VectorXd data_loc(200);
+    for (int i = 0; i < data_loc.size(); i++)
+    {
+        data_loc[i] = 0.05 * i;
+    }
+    Eigen::VectorXd data_out = (data_loc.array() * 2 * M_PI / 5).sin();
+
+    Eigen::VectorXd inducing_loc(20);
+    for (int i = 0; i < inducing_loc.size(); i++)
+    {
+        inducing_loc[i] = 0.5 * i;
+    }
+
+    GP sparse_gp(covariance_function_);
+    gp_.infer(data_loc, data_out);
+    sparse_gp.inferSparse(data_loc, data_out, inducing_loc);
+
+    Eigen::VectorXd prediction_locations(3);
+    prediction_locations << 1.33, 4.71, 8.02;
+    Eigen::VectorXd prediction = gp_.predict(prediction_locations);
+    Eigen::VectorXd sparse_prediction = sparse_gp.predict(prediction_locations);
+
+    for (int i = 0; i < prediction.size(); i++)
+    {
+        EXPECT_NEAR(prediction(i), sparse_prediction(i), 0.05);
+    }
+
+    // infer returns to the full GP
+    sparse_gp.infer(data_loc, data_out);
+    sparse_prediction = sparse_gp.predict(prediction_locations);
+    for (int i = 0; i < prediction.size(); i++)
+    {
+        EXPECT_NEAR(prediction(i), sparse_prediction(i), 1e-9);
+    }
+}
+
+// The analytic gradient of the likelihood matches finite differences
+TEST_F(GPTest, likelihood_gradient_test)
+{
+    Eigen::VectorXd data_loc(20);
+    for (int i = 0; i < data_loc.size(); i++)
+    {
+        data_loc[i] = 0.4 * i;
+    }
+    Eigen::VectorXd data_out = math_tools::generate_normal_random_matrix(data_loc.size(), 1);
+
+    Eigen::VectorXd hyper_parameters(6);
+    hyper_parameters << 1.0, 0.3, 0.5, -0.2, 0.1, -1.0;
+    Eigen::VectorXd extra_parameters(1);
+    extra_parameters << std::log(3.0);
+    covariance_functions::PeriodicSquareExponential2 covariance_function(hyper_parameters);
+    covariance_function.setExtraParameters(extra_parameters);
+
+    for (int heteroscedastic = 0; heteroscedastic < 2; heteroscedastic++)
+    {
+        Eigen::VectorXd data_var;
+        if (heteroscedastic)
+        {
+            data_var = Eigen::VectorXd::Constant(data_loc.size(), 0.2);
+        }
+
+        GP gp(covariance_function);
+        Eigen::VectorXd hyper = gp.getHyperParameters();
+        hyper(0) = std::log(0.5);
+        gp.setHyperParameters(hyper);
+        gp.infer(data_loc, data_out, data_var);
+
+        Eigen::VectorXd gradient;
+        double nll = gp.negativeLogLikelihood(&gradient);
+        ASSERT_TRUE(std::isfinite(nll));
+        ASSERT_EQ(gradient.size(), hyper.size());
+
+        const double eps = 1e-6;
+        for (int i = 0; i < hyper.size(); i++)
+        {
+            Eigen::VectorXd shifted = hyper;
+            shifted(i) += eps;
+            gp.setHyperParameters(shifted);
+            double nll_plus = gp.negativeLogLikelihood();
+            shifted(i) -= 2 * eps;
+            gp.setHyperParameters(shifted);
+            double nll_minus = gp.negativeLogLikelihood();
+
+            EXPECT_NEAR(gradient(i), (nll_plus - nll_minus) / (2 * eps), 1e-4 * std::max(1.0, std::abs(gradient(i))));
+        }
+        gp.setHyperParameters(hyper);
+    }
+}
+
+// The optimizer increases the likelihood of data drawn from a periodic process and
+// recovers its period length
+TEST_F(GPTest, hyperparameter_optimizer_test)
+{
+    Eigen::VectorXd data_loc(120);
+    for (int i = 0; i < data_loc.size(); i++)
+    {
+        data_loc[i] = 0.25 * i;
+    }
+    const double period = 7.0;
+    Eigen::VectorXd noise = 0.05 * math_tools::generate_normal_random_matrix(data_loc.size(), 1);
+    Eigen::VectorXd data_out = (2 * M_PI / period * data_loc.array()).sin().matrix() + noise;
+
+    GP gp(covariance_function_);
+    Eigen::VectorXd initial = gp.getHyperParameters();
+    initial << std::log(0.2), 1, 0, 1, 0, std::log(period * 1.15);
+
+    HyperparameterOptimizer::Options options;
+    options.starts = 3;
+    options.threads = 2;
+    HyperparameterOptimizer optimizer(covariance_function_, options);
+    optimizer.setData(data_loc, data_out);
+
+    gp.setHyperParameters(initial);
+    gp.infer(data_loc, data_out);
+    double initial_nll = gp.negativeLogLikelihood();
+
+    HyperparameterOptimizer::Result result = optimizer.optimize(initial);
+    EXPECT_LT(result.negative_log_likelihood, initial_nll - 10);
+    EXPECT_GT(result.evaluations, 0);
+    EXPECT_NEAR(std::exp(result.hyperparameters(5)), period, 0.3);
+
+    // the reported likelihood belongs to the returned parameters
+    gp.setHyperParameters(result.hyperparameters);
+    EXPECT_NEAR(gp.negativeLogLikelihood(), result.negative_log_likelihood, 1e-6);
+
+    // inactive parameters keep their initial values
+    std::vector<bool> active(initial.size(), true);
+    active[5] = false;
+    optimizer.setActive(active);
+    result = optimizer.optimize(initial);
+    EXPECT_EQ(result.hyperparameters(5), initial(5));
+    EXPECT_LT(result.negative_log_likelihood, initial_nll);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -581,6 +581,98 @@ TEST_F(GPGTest, real_data_test_nan_issue)
     GPG->save_gp_data();
 }
 
+// With a replaced time source, the measurements are time stamped on the supplied
+// frame times instead of the wall clock, as needed for replaying guide logs.
+TEST_F(GPGTest, time_source_test)
+{
+    double now = 0.0;
+    GPG->SetTimeSource([&now]() {
+        return GaussianProcessGuider::clock::time_point(
+            std::chrono::duration_cast<GaussianProcessGuider::clock::duration>(std::chrono::duration<double>(now)));
+    });
+
+    GPG->result(0.5, 20.0, 2.0);
+    EXPECT_NEAR(GPG->get_second_last_point().timestamp, 0.0, 1e-9);
+
+    now = 2.0;
+    GPG->result(0.4, 20.0, 2.0);
+    // the time stamp is the midpoint of the measurement interval
+    EXPECT_NEAR(GPG->get_second_last_point().timestamp, 1.0, 1e-9);
+
+    now = 6.0;
+    GPG->result(0.3, 20.0, 2.0);
+    EXPECT_NEAR(GPG->get_second_last_point().timestamp, 4.0, 1e-9);
+}
+
+TEST_F(GPGTest, hyperparameter_optimization_test)
+{
+    // not enough data yet
+    EXPECT_TRUE(GPG->StartHyperparameterOptimization());
+    EXPECT_FALSE(GPG->IsOptimizingHyperparameters());
+
+    double period_length = 300;
+    Eigen::VectorXd timestamps = Eigen::VectorXd::LinSpaced(201, 0, 1000);
+    Eigen::VectorXd measurements = 5 * (timestamps.array() * 2 * M_PI / period_length).sin();
+    for (int i = 0; i < timestamps.size(); ++i)
+    {
+        GPG->inject_data_point(timestamps[i], measurements[i], 100.0, 0.0);
+    }
+
+    EXPECT_FALSE(GPG->StartHyperparameterOptimization());
+    EXPECT_TRUE(GPG->IsOptimizingHyperparameters());
+    EXPECT_TRUE(GPG->StartHyperparameterOptimization()); // already pending
+
+    GPG->UpdateGP(); // launches the optimization
+
+    std::vector<double> hyperparameters;
+    for (int i = 0; i < 600 && !GPG->TakeOptimizedHyperparameters(&hyperparameters); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    ASSERT_EQ(hyperparameters.size(), static_cast<size_t>(NumParameters));
+    EXPECT_FALSE(GPG->IsOptimizingHyperparameters());
+
+    for (double value : hyperparameters)
+    {
+        EXPECT_TRUE(std::isfinite(value));
+        EXPECT_GT(value, 0.0);
+    }
+    EXPECT_DOUBLE_EQ(hyperparameters[PKPeriodLength], GPG->GetGPHyperparameters()[PKPeriodLength]);
+
+    EXPECT_FALSE(GPG->SetGPHyperparameters(hyperparameters));
+}
+
+TEST_F(GPGTest, reset_discards_hyperparameter_optimization)
+{
+    double period_length = 300;
+    Eigen::VectorXd timestamps = Eigen::VectorXd::LinSpaced(201, 0, 1000);
+    Eigen::VectorXd measurements = 5 * (timestamps.array() * 2 * M_PI / period_length).sin();
+    for (int i = 0; i < timestamps.size(); ++i)
+    {
+        GPG->inject_data_point(timestamps[i], measurements[i], 100.0, 0.0);
+    }
+
+    // a request that was not launched yet
+    EXPECT_FALSE(GPG->StartHyperparameterOptimization());
+    GPG->reset();
+    EXPECT_FALSE(GPG->IsOptimizingHyperparameters());
+
+    for (int i = 0; i < timestamps.size(); ++i)
+    {
+        GPG->inject_data_point(timestamps[i], measurements[i], 100.0, 0.0);
+    }
+
+    // a running optimization
+    EXPECT_FALSE(GPG->StartHyperparameterOptimization());
+    GPG->UpdateGP();
+    GPG->reset();
+    EXPECT_FALSE(GPG->IsOptimizingHyperparameters());
+
+    std::vector<double> hyperparameters;
+    EXPECT_FALSE(GPG->TakeOptimizedHyperparameters(&hyperparameters));
+    EXPECT_TRUE(hyperparameters.empty());
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
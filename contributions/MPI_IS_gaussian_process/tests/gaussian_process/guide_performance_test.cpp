@@ -43,6 +43,8 @@
 
 #include <fstream>
 #include <thread>
+#include <chrono>
+#include <iomanip>
 
 class GuidePerformanceTest : public ::testing::Test
 {
@@ -61,10 +63,12 @@ public:
 
     static const double DefaultPeriodLengthsPeriodEstimation; // minimal number of points for doing the period identification
     static const int DefaultNumPointsForApproximation; // number of points used in the GP approximation
+    static const int SparseNumInducingPoints[]; // inducing point counts for the sparse approximation report
     static const double DefaultPredictionGain; // amount of GP prediction to blend in
 
     static const bool DefaultComputePeriod;
 
+    GaussianProcessGuider::guide_parameters parameters;
     GaussianProcessGuider *GPG;
     GAHysteresis GAH;
     std::string filename;
@@ -72,7 +76,6 @@ public:
 
     GuidePerformanceTest() : GPG(0), improvement(0.0)
     {
-        GaussianProcessGuider::guide_parameters parameters;
         parameters.control_gain_ = DefaultControlGain;
         parameters.min_periods_for_inference_ = DefaultPeriodLengthsInference;
         parameters.min_move_ = DefaultMinMove;
@@ -108,6 +111,7 @@ const double GuidePerformanceTest::DefaultSignalVarianceSE1Ker = 10.0; // signal
 
 const double GuidePerformanceTest::DefaultPeriodLengthsPeriodEstimation = 2.0; // period lengths until FFT
 const int GuidePerformanceTest::DefaultNumPointsForApproximation = 100; // number of points used in the GP approximation
+const int GuidePerformanceTest::SparseNumInducingPoints[] = { 32, 64 };
 const double GuidePerformanceTest::DefaultPredictionGain = 0.5; // amount of GP prediction to blend in
 
 const bool GuidePerformanceTest::DefaultComputePeriod = true;
@@ -176,6 +180,61 @@ TEST_F(GuidePerformanceTest, performance_dataset08)
     EXPECT_GT(improvement, 0);
 }
 
+TEST_F(GuidePerformanceTest, performance_dataset07_sparse)
+{
+    filename = "performance_dataset07.txt";
+    GPG->SetNumInducingPoints(SparseNumInducingPoints[1]);
+    improvement = calculate_improvement(filename, GAH, GPG);
+    std::cout << "Improvement of sparse GPGuiding over Hysteresis: " << 100 * improvement << "%" << std::endl;
+    EXPECT_GT(improvement, 0);
+}
+
+// Compares the subset of data approximation with the sparse inducing point
+// approximation on all datasets, reporting improvement and CPU time. This takes
+// a few minutes, run it with --gtest_also_run_disabled_tests.
+TEST_F(GuidePerformanceTest, DISABLED_sparse_approximation_report)
+{
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "dataset   SD(" << DefaultNumPointsForApproximation << ") improvement / time";
+    for (int inducing_points : SparseNumInducingPoints)
+    {
+        std::cout << "   sparse(" << inducing_points << ") improvement / time";
+    }
+    std::cout << std::endl;
+
+    for (int dataset = 1; dataset <= 8; dataset++)
+    {
+        filename = "performance_dataset0" + std::to_string(dataset) + ".txt";
+        std::cout << "  " << dataset << "     ";
+        double sd_improvement = 0.0;
+
+        for (size_t run = 0; run <= sizeof(SparseNumInducingPoints) / sizeof(SparseNumInducingPoints[0]); run++)
+        {
+            GaussianProcessGuider::guide_parameters run_parameters = parameters;
+            run_parameters.inducing_points_ = run == 0 ? 0 : SparseNumInducingPoints[run - 1];
+            GaussianProcessGuider guider(run_parameters);
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            improvement = calculate_improvement(filename, GAH, &guider);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::cout << std::setw(12) << 100 * improvement << "% / " << std::setprecision(2) << seconds << "s"
+                      << std::setprecision(1) << "     ";
+
+            // the sparse approximation may trade some accuracy for its lower cost
+            if (run == 0)
+            {
+                sd_improvement = improvement;
+            }
+            else
+            {
+                EXPECT_GT(improvement, sd_improvement - 0.05);
+            }
+        }
+        std::cout << std::endl;
+    }
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,482 @@
+/*
+ *  background_mesh.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+
+#include <algorithm>
+#include <float.h>
+#include <string.h>
+#include <thread>
+
+// boxes with less of their area inside the measured region are left to the fill step
+static const double MIN_BOX_COVERAGE = 0.5;
+// boxes not measured within this many updates are not used for lookups
+static const unsigned int MAX_AGE = 2 * BackgroundMesh::REFRESH_FRAMES;
+
+struct BoxStats
+{
+    float level;
+    float rms;
+    bool ok;
+};
+
+// Sigma-clipped background statistics of n values. The clipping is centered on the median,
+// which is read from a histogram of the values in range and interpolated within its bin.
+static bool ClippedStats(const float *b, size_t n, float *level, float *rms)
+{
+    enum
+    {
+        BINS = 256
+    };
+
+    if (n < 16)
+        return false;
+
+    float lo = FLT_MAX, hi = -FLT_MAX;
+    double sum = 0., sum2 = 0.;
+    for (size_t i = 0; i < n; i++)
+    {
+        float const v = b[i];
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+        sum += v;
+        sum2 += (double) v * v;
+    }
+
+    double mean = sum / n;
+    double const sigma0 = sqrt(std::max(0., sum2 / n - mean * mean));
+    double sigma = sigma0;
+    double med = lo;
+    size_t prev = n;
+    unsigned int hist[BINS];
+
+    for (int iter = 0; iter < 10; iter++)
+    {
+        double const width = ((double) hi - lo) / BINS;
+        if (width <= 0.)
+            break;
+
+        memset(hist, 0, sizeof(hist));
+        sum = sum2 = 0.;
+        size_t cnt = 0;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            float const v = b[i];
+            if (v < lo || v > hi)
+                continue;
+            sum += v;
+            sum2 += (double) v * v;
+            ++cnt;
+            ++hist[std::min(BINS - 1, (int) ((v - lo) / width))];
+        }
+
+        if (cnt < 16)
+            return false;
+
+        mean = sum / cnt;
+        sigma = sqrt(std::max(0., sum2 / cnt - mean * mean));
+
+        double const half = 0.5 * cnt;
+        double cum = 0.;
+        int k = 0;
+        while (cum + hist[k] < half)
+            cum += hist[k++];
+        med = lo + width * (k + (half - cum) / hist[k]);
+
+        // stop when no more values are rejected
+        if (iter > 0 && cnt == prev)
+            break;
+        prev = cnt;
+
+        lo = (float) (med - 3.0 * sigma);
+        hi = (float) (med + 3.0 * sigma);
+    }
+
+    // a box whose spread shrank by more than 20% while clipping is crowded by stars; estimate
+    // the mode instead of using the clipped mean (Bertin & Arnouts 1996)
+    *level = (float) (sigma >= 0.8 * sigma0 ? mean : 2.5 * med - 1.5 * mean);
+    *rms = (float) sigma;
+
+    return true;
+}
+
+template<typename T>
+static void MeasureBoxes(const T *px, int rowsize, const std::vector<wxRect>& boxes, std::vector<BoxStats> *stats)
+{
+    stats->resize(boxes.size());
+
+    auto work = [&](size_t begin, size_t end) {
+        std::vector<float> buf;
+        for (size_t i = begin; i < end; i++)
+        {
+            const wxRect& r = boxes[i];
+            buf.clear();
+            buf.reserve(r.width * r.height);
+            for (int y = r.GetTop(); y <= r.GetBottom(); y++)
+            {
+                const T *row = px + (size_t) y * rowsize;
+                for (int x = r.GetLeft(); x <= r.GetRight(); x++)
+                    buf.push_back((float) row[x]);
+            }
+            BoxStats& s = (*stats)[i];
+            s.ok = ClippedStats(buf.data(), buf.size(), &s.level, &s.rms);
+        }
+    };
+
+    // one thread per 16 boxes, at most one per core; a guide star subframe is done inline
+    unsigned int nthreads = std::max(1U, std::thread::hardware_concurrency());
+    nthreads = std::min<unsigned int>(nthreads, (boxes.size() + 15) / 16);
+
+    if (nthreads <= 1)
+        work(0, boxes.size());
+    else
+    {
+        std::vector<std::thread> pool;
+        pool.reserve(nthreads);
+        for (unsigned int i = 0; i < nthreads; i++)
+            pool.emplace_back(work, boxes.size() * i / nthreads, boxes.size() * (i + 1) / nthreads);
+        for (std::thread& th : pool)
+            th.join();
+    }
+}
+
+static int Clamp(int v, int lo, int hi)
+{
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+// Value of node (i, j) of an nx x ny grid, extended linearly past the edges so that the median
+// filter and the interpolation follow a gradient all the way to the border
+static double NodeValue(const std::vector<float>& v, int nx, int ny, int i, int j)
+{
+    if ((i < 0 || i >= nx) && nx > 1)
+    {
+        int const e = i < 0 ? 0 : nx - 1;
+        int const inner = i < 0 ? 1 : nx - 2;
+        double const a = NodeValue(v, nx, ny, e, j);
+        return a + abs(i - e) * (a - NodeValue(v, nx, ny, inner, j));
+    }
+    if ((j < 0 || j >= ny) && ny > 1)
+    {
+        int const e = j < 0 ? 0 : ny - 1;
+        int const inner = j < 0 ? 1 : ny - 2;
+        double const a = NodeValue(v, nx, ny, Clamp(i, 0, nx - 1), e);
+        return a + abs(j - e) * (a - NodeValue(v, nx, ny, Clamp(i, 0, nx - 1), inner));
+    }
+    return v[Clamp(j, 0, ny - 1) * nx + Clamp(i, 0, nx - 1)];
+}
+
+// Catmull-Rom cubic weights for the nodes at -1, 0, 1, 2 around fraction t
+static void CubicWeights(double t, double w[4])
+{
+    double const t2 = t * t;
+    double const t3 = t2 * t;
+    w[0] = 0.5 * (-t3 + 2.0 * t2 - t);
+    w[1] = 0.5 * (3.0 * t3 - 5.0 * t2 + 2.0);
+    w[2] = 0.5 * (-3.0 * t3 + 4.0 * t2 + t);
+    w[3] = 0.5 * (t3 - t2);
+}
+
+BackgroundMesh::BackgroundMesh() : m_nx(0), m_ny(0), m_boxW(0.), m_boxH(0.), m_updates(0), m_frameNum(0) { }
+
+void BackgroundMesh::Reset()
+{
+    m_size = wxSize();
+    m_area = wxRect();
+    m_nx = m_ny = 0;
+    m_boxW = m_boxH = 0.;
+    m_updates = 0;
+    m_frameNum = 0;
+    m_nodes.clear();
+    m_level.clear();
+    m_rms.clear();
+}
+
+void BackgroundMesh::Init(const wxSize& size, const wxRect& area)
+{
+    Reset();
+
+    // boxes tile the area exactly, so none of them is a thin sliver at the edge
+    m_size = size;
+    m_area = area;
+    m_nx = std::max(1, (area.GetWidth() + BOX_SIZE / 2) / BOX_SIZE);
+    m_ny = std::max(1, (area.GetHeight() + BOX_SIZE / 2) / BOX_SIZE);
+    m_boxW = (double) area.GetWidth() / m_nx;
+    m_boxH = (double) area.GetHeight() / m_ny;
+
+    Node empty = { 0.f, 0.f, 0 };
+    m_nodes.assign(m_nx * m_ny, empty);
+    m_level.assign(m_nx * m_ny, 0.f);
+    m_rms.assign(m_nx * m_ny, 0.f);
+}
+
+wxRect BackgroundMesh::BoxRect(int i, int j) const
+{
+    int x0 = (int) ((long long) m_area.GetWidth() * i / m_nx);
+    int x1 = (int) ((long long) m_area.GetWidth() * (i + 1) / m_nx);
+    int y0 = (int) ((long long) m_area.GetHeight() * j / m_ny);
+    int y1 = (int) ((long long) m_area.GetHeight() * (j + 1) / m_ny);
+    return wxRect(m_area.x + x0, m_area.y + y0, x1 - x0, y1 - y0);
+}
+
+// true if the node was measured within the last MAX_AGE updates
+bool BackgroundMesh::Fresh(const Node& node) const
+{
+    return node.stamp != 0 && m_updates - node.stamp < MAX_AGE;
+}
+
+// measure the boxes in every slices'th row of boxes, starting at row slice, that are
+// sufficiently covered by rect; returns true if no box could be measured
+template<typename T> bool BackgroundMesh::Measure(const T *px, const wxRect& rect, int slice, int slices)
+{
+    ++m_updates;
+
+    std::vector<wxRect> boxes;
+    std::vector<int> index;
+
+    for (int j = slice; j < m_ny; j += slices)
+    {
+        for (int i = 0; i < m_nx; i++)
+        {
+            const wxRect box = BoxRect(i, j);
+            wxRect r = box.Intersect(rect);
+            if (r.IsEmpty() || r.width * r.height < MIN_BOX_COVERAGE * box.width * box.height)
+                continue;
+            boxes.push_back(r);
+            index.push_back(j * m_nx + i);
+        }
+    }
+
+    std::vector<BoxStats> stats;
+    MeasureBoxes(px, m_size.GetWidth(), boxes, &stats);
+
+    bool measured = false;
+    for (size_t k = 0; k < index.size(); k++)
+    {
+        if (!stats[k].ok)
+            continue;
+        Node& node = m_nodes[index[k]];
+        node.level = stats[k].level;
+        node.rms = stats[k].rms;
+        node.stamp = m_updates;
+        measured = true;
+    }
+
+    if (measured)
+        Finish();
+
+    return !measured;
+}
+
+// fill boxes that were not measured recently from their neighbors and median-filter the mesh
+void BackgroundMesh::Finish()
+{
+    int const n = m_nx * m_ny;
+    std::vector<float> level(n), rms(n);
+    std::vector<char> have(n);
+
+    bool any = false;
+    for (int k = 0; k < n; k++)
+    {
+        have[k] = Fresh(m_nodes[k]);
+        level[k] = m_nodes[k].level;
+        rms[k] = m_nodes[k].rms;
+        any = any || have[k];
+    }
+
+    if (!any)
+        return;
+
+    for (bool missing = true; missing;)
+    {
+        missing = false;
+        std::vector<char> next(have);
+
+        for (int j = 0; j < m_ny; j++)
+        {
+            for (int i = 0; i < m_nx; i++)
+            {
+                int const k = j * m_nx + i;
+                if (have[k])
+                    continue;
+
+                double l = 0., r = 0.;
+                int cnt = 0;
+                for (int jj = std::max(0, j - 1); jj <= std::min(m_ny - 1, j + 1); jj++)
+                    for (int ii = std::max(0, i - 1); ii <= std::min(m_nx - 1, i + 1); ii++)
+                        if (have[jj * m_nx + ii])
+                        {
+                            l += level[jj * m_nx + ii];
+                            r += rms[jj * m_nx + ii];
+                            ++cnt;
+                        }
+
+                if (cnt)
+                {
+                    level[k] = (float) (l / cnt);
+                    rms[k] = (float) (r / cnt);
+                    next[k] = 1;
+                }
+                else
+                    missing = true;
+            }
+        }
+
+        have.swap(next);
+    }
+
+    // a 3x3 median removes boxes dominated by a bright star or a satellite trail
+    float lv[9], rv[9];
+    for (int j = 0; j < m_ny; j++)
+    {
+        for (int i = 0; i < m_nx; i++)
+        {
+            int cnt = 0;
+            for (int jj = j - 1; jj <= j + 1; jj++)
+                for (int ii = i - 1; ii <= i + 1; ii++, cnt++)
+                {
+                    lv[cnt] = (float) NodeValue(level, m_nx, m_ny, ii, jj);
+                    rv[cnt] = (float) NodeValue(rms, m_nx, m_ny, ii, jj);
+                }
+            std::nth_element(lv, lv + 4, lv + 9);
+            std::nth_element(rv, rv + 4, rv + 9);
+            m_level[j * m_nx + i] = lv[4];
+            m_rms[j * m_nx + i] = rv[4];
+        }
+    }
+}
+
+bool BackgroundMesh::Build(const usImage& img)
+{
+    Init(img.Size, wxRect(img.Size));
+    m_frameNum = img.FrameNum;
+
+    wxRect rect(img.Size);
+    if (!img.Subframe.IsEmpty())
+        rect.Intersect(img.Subframe);
+
+    if (Measure(img.ImageData, rect, 0, 1))
+    {
+        Reset();
+        return true;
+    }
+
+    return false;
+}
+
+bool BackgroundMesh::Build(const float *px, const wxSize& size, const wxRect& rect)
+{
+    wxRect area = rect.Intersect(wxRect(size));
+    if (area.IsEmpty())
+        return true;
+
+    Init(size, area);
+
+    if (Measure(px, area, 0, 1))
+    {
+        Reset();
+        return true;
+    }
+
+    return false;
+}
+
+void BackgroundMesh::Update(const usImage& img)
+{
+    if (m_nodes.empty() || img.Size != m_size)
+    {
+        if (Build(img))
+            Debug.Write(wxString::Format("BackgroundMesh: frame %u too small for a background mesh\n", img.FrameNum));
+        return;
+    }
+
+    m_frameNum = img.FrameNum;
+
+    wxRect rect(img.Size);
+    if (!img.Subframe.IsEmpty())
+        rect.Intersect(img.Subframe);
+
+    Measure(img.ImageData, rect, m_updates % REFRESH_FRAMES, REFRESH_FRAMES);
+}
+
+bool BackgroundMesh::Covers(const usImage& img) const
+{
+    return !m_nodes.empty() && img.Size == m_size && img.FrameNum == m_frameNum;
+}
+
+bool BackgroundMesh::Lookup(double x, double y, double *level, double *rms) const
+{
+    if (m_nodes.empty())
+        return false;
+
+    // position in units of boxes relative to the first box center
+    double const gx = (x - m_area.x) / m_boxW - 0.5;
+    double const gy = (y - m_area.y) / m_boxH - 0.5;
+
+    int const ni = Clamp((int) floor(gx + 0.5), 0, m_nx - 1);
+    int const nj = Clamp((int) floor(gy + 0.5), 0, m_ny - 1);
+    if (!Fresh(m_nodes[nj * m_nx + ni]))
+        return false;
+
+    int const i0 = (int) floor(gx);
+    int const j0 = (int) floor(gy);
+    double wx[4], wy[4];
+    CubicWeights(gx - i0, wx);
+    CubicWeights(gy - j0, wy);
+
+    double l = 0., r = 0.;
+    for (int j = 0; j < 4; j++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            double const w = wy[j] * wx[i];
+            l += w * NodeValue(m_level, m_nx, m_ny, i0 - 1 + i, j0 - 1 + j);
+            r += w * NodeValue(m_rms, m_nx, m_ny, i0 - 1 + i, j0 - 1 + j);
+        }
+    }
+
+    // the cubic can overshoot next to a sharp step in the noise
+    if (r <= 0.)
+        r = m_rms[nj * m_nx + ni];
+
+    *level = l;
+    *rms = r;
+    return true;
+}
+
+unsigned int BackgroundMesh::SamplesPerBox() const
+{
+    return (unsigned int) (m_boxW * m_boxH);
+}
@@ -0,0 +1,109 @@
+/*
+ *  background_mesh.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BACKGROUND_MESH_H_INCLUDED
+#define BACKGROUND_MESH_H_INCLUDED
+
+// Coarse model of the sky background and its noise.
+//
+// The frame is divided into boxes of about BOX_SIZE x BOX_SIZE pixels. Each box is sigma-clipped at 3 sigma
+// around its median; the clipped mean (or 2.5 median - 1.5 mean when the box is crowded) is
+// the background level and the clipped standard deviation the RMS. The box values are
+// median-filtered over 3x3 boxes to suppress bright stars and interpolated bicubically between
+// box centers, so gradients from moonlight or amp glow are followed smoothly.
+//
+// During guiding the mesh is refreshed one slice of box rows per frame, so the whole mesh is
+// re-measured every REFRESH_FRAMES frames at a small fraction of the cost of a full build. Only
+// boxes covered by the frame (or its subframe) are measured. Boxes that have not been
+// measured recently, such as those outside a guiding subframe, are treated as never measured:
+// they are filled from their fresh neighbors and lookups in them fail.
+class BackgroundMesh
+{
+    struct Node
+    {
+        float level;
+        float rms;
+        unsigned int stamp; // update count when measured, 0 = never
+    };
+
+    wxSize m_size;
+    wxRect m_area; // the part of the frame covered by boxes
+    int m_nx;
+    int m_ny;
+    double m_boxW;
+    double m_boxH;
+    unsigned int m_updates;
+    unsigned int m_frameNum;
+    std::vector<Node> m_nodes; // measured values
+    std::vector<float> m_level; // filtered and filled values used for interpolation
+    std::vector<float> m_rms;
+
+    void Init(const wxSize& size, const wxRect& area);
+    wxRect BoxRect(int i, int j) const;
+    bool Fresh(const Node& node) const;
+    template<typename T> bool Measure(const T *px, const wxRect& rect, int slice, int slices);
+    void Finish();
+
+public:
+    enum
+    {
+        BOX_SIZE = 32,
+        REFRESH_FRAMES = 8,
+    };
+
+    BackgroundMesh();
+
+    void Reset();
+
+    // Measure every box covered by img (its subframe if it has one). Returns true on error.
+    bool Build(const usImage& img);
+    // Lay the mesh over rect of a float image of the given size and measure it. Returns true on
+    // error.
+    bool Build(const float *px, const wxSize& size, const wxRect& rect);
+
+    // Re-measure the next slice of boxes from a new frame, or build the mesh from scratch if
+    // the frame geometry changed.
+    void Update(const usImage& img);
+
+    // true if the mesh was last updated from img
+    bool Covers(const usImage& img) const;
+
+    // Interpolated background level and RMS at (x, y). Returns false if the box containing
+    // the point has not been measured recently.
+    bool Lookup(double x, double y, double *level, double *rms) const;
+
+    // number of pixels behind each box value, for noise estimates
+    unsigned int SamplesPerBox() const;
+};
+
+#endif
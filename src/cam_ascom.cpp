@@ -447,10 +447,8 @@ static wxString displayName(const wxString& ascomName)
     return ascomName + _T(" (ASCOM)");
 }
 
-// map descriptive name to progid
-static std::map<wxString, wxString> s_progid;
-
-wxArrayString ASCOMCameraFactory::EnumAscomCameras()
+// progids are keyed by descriptive name
+wxArrayString ASCOMCameraFactory::EnumAscomCameras(std::map<wxString, wxString> *progids)
 {
     wxArrayString list;
 
@@ -486,7 +484,7 @@ wxArrayString ASCOMCameraFactory::EnumAscomCameras()
                     wxString ascomName = vval.bstrVal;
                     wxString displName = displayName(ascomName);
                     wxString progid = vkey.bstrVal;
-                    s_progid[displName] = progid;
+                    (*progids)[displName] = progid;
                     list.Add(displName);
                 }
             }
@@ -509,9 +507,16 @@ bool CameraASCOM::Create(DispatchObj *obj, DispatchClass *cls)
         return true;
     }
 
-    Debug.Write(wxString::Format("Create ASCOM Camera: choice '%s' progid %s\n", m_choice, s_progid[m_choice]));
+    wxString id;
+    if (DeviceEnumerator::GetId(DeviceEnumerator::ASCOM_CAMERAS, m_choice, &id))
+    {
+        Debug.AddLine("ASCOM Camera: could not find the progid for camera " + m_choice);
+        return false;
+    }
+
+    Debug.Write(wxString::Format("Create ASCOM Camera: choice '%s' progid %s\n", m_choice, id));
 
-    wxBasicString progid(s_progid[m_choice]);
+    wxBasicString progid(id);
 
     if (!obj->Create(progid))
     {
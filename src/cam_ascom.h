@@ -39,7 +39,7 @@ class GuideCamera;
 class ASCOMCameraFactory
 {
 public:
-    static wxArrayString EnumAscomCameras();
+    static wxArrayString EnumAscomCameras(std::map<wxString, wxString> *progids);
     static GuideCamera *MakeASCOMCamera(const wxString& name);
 };
 
@@ -65,6 +65,8 @@ class PlayerOneCamera : public GuideCamera
     wxByte m_bpp; // bits per pixel: 8 or 16
     CaptureMode m_mode;
     bool m_capturing;
+    bool m_streaming; // streaming requested, use video capture regardless of m_mode
+    int m_sdkDroppedFrames; // POAGetDroppedImagesCount count already accounted for
     int m_cameraId;
     int m_minGain;
     int m_maxGain;
@@ -78,6 +80,10 @@ public:
     bool CanSelectCamera() const override { return true; }
     bool EnumCameras(wxArrayString& names, wxArrayString& ids) override;
     bool Capture(usImage& img, const CaptureParams& captureParams) override;
+    bool StartStream(const CaptureParams& captureParams) override;
+    void StopStream() override;
+    bool IsStreaming() const override { return m_streaming; }
+    bool GetLatestFrame(usImage& img, const CaptureParams& captureParams) override;
     bool Connect(const wxString& camId) override;
     bool Disconnect() override;
 
@@ -108,13 +114,14 @@ private:
     POAErrors SetConfig(int nCameraID, POAConfig confID, POABool isEnable);
 };
 
-PlayerOneCamera::PlayerOneCamera() : m_buffer(nullptr)
+PlayerOneCamera::PlayerOneCamera() : m_buffer(nullptr), m_capturing(false), m_streaming(false), m_sdkDroppedFrames(0)
 {
     Name = _T("Player One Camera");
     PropertyDialogType = PROPDLG_WHEN_DISCONNECTED;
     Connected = false;
     m_hasGuideOutput = true;
     HasSubframes = true;
+    HasStreaming = true;
     HasGainControl = true; // workaround: ok to set to false later, but brain dialog will crash if we start false then change to
                            // true later when the camera is connected
     m_defaultGainPct = GuideCamera::GetDefaultCameraGain();
@@ -587,6 +594,7 @@ bool PlayerOneCamera::StopExposure()
 bool PlayerOneCamera::Disconnect()
 {
     StopCapture();
+    m_streaming = false;
     POACloseCamera(m_cameraId);
 
     Connected = false;
@@ -686,7 +694,8 @@ inline static int round_up(int v, int m)
     return round_down(v + m - 1, m);
 }
 
-static void flush_buffered_image(int cameraId, void *buf, size_t size)
+// returns the number of frames discarded
+static unsigned int flush_buffered_image(int cameraId, void *buf, size_t size)
 {
     enum
     {
@@ -695,7 +704,8 @@ static void flush_buffered_image(int cameraId, void *buf, size_t size)
 
     // clear buffered frames if any
 
-    for (unsigned int num_cleared = 0; num_cleared < NUM_IMAGE_BUFFERS; num_cleared++)
+    unsigned int num_cleared;
+    for (num_cleared = 0; num_cleared < NUM_IMAGE_BUFFERS; num_cleared++)
     {
         POAErrors status = POAGetImageData(cameraId, (unsigned char *) buf, size, 0);
         if (status != POA_OK)
@@ -703,6 +713,8 @@ static void flush_buffered_image(int cameraId, void *buf, size_t size)
 
         Debug.Write(wxString::Format("Player One: getimagedata clearbuf %u ret %d\n", num_cleared + 1, status));
     }
+
+    return num_cleared;
 }
 
 bool PlayerOneCamera::Capture(usImage& img, const CaptureParams& captureParams)
@@ -802,19 +814,32 @@ bool PlayerOneCamera::Capture(usImage& img, const CaptureParams& captureParams)
 
     unsigned char *const buffer = m_bpp == 16 && !useSubframe ? (unsigned char *) img.ImageData : (unsigned char *) m_buffer;
 
-    if (m_mode == CM_VIDEO)
+    if (m_mode == CM_VIDEO || m_streaming)
     {
         // the camera and/or driver will buffer frames and return the oldest frame,
         // which could be quite stale. read out all buffered frames so the frame we
         // get is current
 
-        flush_buffered_image(m_cameraId, m_buffer, m_buffer_size);
+        unsigned int flushed = flush_buffered_image(m_cameraId, m_buffer, m_buffer_size);
 
         if (!m_capturing)
         {
             Debug.Write("Player One: startcapture\n");
             POAStartExposure(m_cameraId, POA_FALSE);
             m_capturing = true;
+            m_sdkDroppedFrames = 0; // the driver count restarts with each capture
+        }
+        else if (m_streaming)
+        {
+            // the flushed frames were only stale; frames lost because the driver's buffers were
+            // full are counted separately
+            AddStreamFramesSkipped(flushed);
+            int dropped;
+            if (POAGetDroppedImagesCount(m_cameraId, &dropped) == POA_OK && dropped > m_sdkDroppedFrames)
+            {
+                AddStreamFramesDropped(dropped - m_sdkDroppedFrames);
+                m_sdkDroppedFrames = dropped;
+            }
         }
 
         CameraWatchdog watchdog(duration, duration + GetTimeoutMs() + 10000); // total timeout is 2 * duration + 15s (typically)
@@ -967,6 +992,28 @@ bool PlayerOneCamera::Capture(usImage& img, const CaptureParams& captureParams)
     return false;
 }
 
+// Streaming uses the continuous (video) exposure mode for all cameras, including the USB3
+// cameras that otherwise take single frames; the capture itself starts with the first frame
+// requested.
+bool PlayerOneCamera::StartStream(const CaptureParams& captureParams)
+{
+    m_streaming = true;
+    return false;
+}
+
+void PlayerOneCamera::StopStream()
+{
+    m_streaming = false;
+    // video mode cameras keep capturing between frames as they always have
+    if (m_mode == CM_SNAP)
+        StopCapture();
+}
+
+bool PlayerOneCamera::GetLatestFrame(usImage& img, const CaptureParams& captureParams)
+{
+    return Capture(img, captureParams);
+}
+
 inline static POAConfig GetPOADirection(int direction)
 {
     switch (direction)
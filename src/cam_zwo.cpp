@@ -66,6 +66,8 @@ class Camera_ZWO : public GuideCamera
     wxByte m_bpp; // bits per pixel: 8 or 16
     CaptureMode m_mode;
     bool m_capturing;
+    bool m_streaming; // streaming requested, use video capture regardless of m_mode
+    int m_sdkDroppedFrames; // ASIGetDroppedFrames count already accounted for
     int m_cameraId;
     int m_minGain;
     int m_maxGain;
@@ -79,6 +81,10 @@ public:
     bool CanSelectCamera() const override { return true; }
     bool EnumCameras(wxArrayString& names, wxArrayString& ids) override;
     bool Capture(usImage& img, const CaptureParams& captureParams) override;
+    bool StartStream(const CaptureParams& captureParams) override;
+    void StopStream() override;
+    bool IsStreaming() const override { return m_streaming; }
+    bool GetLatestFrame(usImage& img, const CaptureParams& captureParams) override;
     bool Connect(const wxString& camId) override;
     bool Disconnect() override;
 
@@ -103,7 +109,7 @@ private:
     wxSize BinnedFrameSize(unsigned int binning);
 };
 
-Camera_ZWO::Camera_ZWO() : m_buffer(nullptr)
+Camera_ZWO::Camera_ZWO() : m_buffer(nullptr), m_capturing(false), m_streaming(false), m_sdkDroppedFrames(0)
 {
     Name = _T("ZWO ASI Camera");
     PropertyDialogType = PROPDLG_WHEN_DISCONNECTED;
@@ -111,6 +117,7 @@ Camera_ZWO::Camera_ZWO() : m_buffer(nullptr)
     m_hasGuideOutput = true;
     HasSubframes = true;
     HasFrameLimiting = true;
+    HasStreaming = true;
     HasGainControl = true; // workaround: ok to set to false later, but brain dialog will crash if we start false then change to
                            // true later when the camera is connected
     m_defaultGainPct = GuideCamera::GetDefaultCameraGain();
@@ -593,6 +600,7 @@ bool Camera_ZWO::StopExposure()
 bool Camera_ZWO::Disconnect()
 {
     StopCapture();
+    m_streaming = false;
     ASICloseCamera(m_cameraId);
 
     Connected = false;
@@ -706,7 +714,8 @@ inline static wxRect constrain_roi(const wxRect& requestedRoi)
     return roi;
 }
 
-static void flush_buffered_image(int cameraId, void *buf, size_t size)
+// returns the number of frames discarded
+static unsigned int flush_buffered_image(int cameraId, void *buf, size_t size)
 {
     enum
     {
@@ -715,7 +724,8 @@ static void flush_buffered_image(int cameraId, void *buf, size_t size)
 
     // clear buffered frames if any
 
-    for (unsigned int num_cleared = 0; num_cleared < NUM_IMAGE_BUFFERS; num_cleared++)
+    unsigned int num_cleared;
+    for (num_cleared = 0; num_cleared < NUM_IMAGE_BUFFERS; num_cleared++)
     {
         ASI_ERROR_CODE status = ASIGetVideoData(cameraId, (unsigned char *) buf, size, 0);
         if (status != ASI_SUCCESS)
@@ -723,6 +733,8 @@ static void flush_buffered_image(int cameraId, void *buf, size_t size)
 
         Debug.Write(wxString::Format("ZWO: getimagedata clearbuf %u ret %d\n", num_cleared + 1, status));
     }
+
+    return num_cleared;
 }
 
 inline static void copy_rect_8bit(usImage& img, const unsigned char *buffer, const wxRect& subframe, const wxPoint& subframePos,
@@ -867,19 +879,32 @@ bool Camera_ZWO::Capture(usImage& img, const CaptureParams& captureParams)
     bool const camera_data_straight_to_img = m_bpp == 16 && !useSubframe && limit_frame.IsEmpty();
     unsigned char *const buffer = camera_data_straight_to_img ? (unsigned char *) img.ImageData : (unsigned char *) m_buffer;
 
-    if (m_mode == CM_VIDEO)
+    if (m_mode == CM_VIDEO || m_streaming)
     {
         // the camera and/or driver will buffer frames and return the oldest frame,
         // which could be quite stale. read out all buffered frames so the frame we
         // get is current
 
-        flush_buffered_image(m_cameraId, m_buffer, m_buffer_size);
+        unsigned int flushed = flush_buffered_image(m_cameraId, m_buffer, m_buffer_size);
 
         if (!m_capturing)
         {
             Debug.Write("ZWO: startcapture\n");
             ASIStartVideoCapture(m_cameraId);
             m_capturing = true;
+            m_sdkDroppedFrames = 0; // the driver count restarts with each capture
+        }
+        else if (m_streaming)
+        {
+            // the flushed frames were only stale; frames lost because the driver's buffers were
+            // full are counted separately
+            AddStreamFramesSkipped(flushed);
+            int dropped;
+            if (ASIGetDroppedFrames(m_cameraId, &dropped) == ASI_SUCCESS && dropped > m_sdkDroppedFrames)
+            {
+                AddStreamFramesDropped(dropped - m_sdkDroppedFrames);
+                m_sdkDroppedFrames = dropped;
+            }
         }
 
         CameraWatchdog watchdog(duration, duration + GetTimeoutMs() + 10000); // total timeout is 2 * duration + 15s (typically)
@@ -1025,6 +1050,27 @@ bool Camera_ZWO::Capture(usImage& img, const CaptureParams& captureParams)
     return false;
 }
 
+// Streaming uses the video capture path for all cameras, including the USB3 cameras that
+// otherwise use snap mode; the capture itself starts with the first frame requested.
+bool Camera_ZWO::StartStream(const CaptureParams& captureParams)
+{
+    m_streaming = true;
+    return false;
+}
+
+void Camera_ZWO::StopStream()
+{
+    m_streaming = false;
+    // video mode cameras keep capturing between frames as they always have
+    if (m_mode == CM_SNAP)
+        StopCapture();
+}
+
+bool Camera_ZWO::GetLatestFrame(usImage& img, const CaptureParams& captureParams)
+{
+    return Capture(img, captureParams);
+}
+
 inline static ASI_GUIDE_DIRECTION GetASIDirection(int direction)
 {
     switch (direction)
@@ -222,6 +222,9 @@ void CamCalImportDialog::OnOk(wxCommandEvent& evt)
     {
         sourceName = MyFrame::DarkLibFileName(m_sourceDarksProfileId);
         destName = MyFrame::DarkLibFileName(m_thisProfileId);
+        // the library being replaced may be mapped by the camera
+        if (pCamera && pCamera->DetachDarkLibrary())
+            Debug.Write("Dark lib import: could not read all mapped darks before replacing the library\n");
         if (wxCopyFile(sourceName, destName, true))
         {
             Debug.Write(wxString::Format("Dark library imported from profile %d to profile %d\n", m_sourceDarksProfileId,
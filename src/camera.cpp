@@ -37,13 +37,18 @@
 #include "phd.h"
 
 #include "camera.h"
+#include "dark_library.h"
 #include "gear_simulator.h"
 
 #include <wx/stdpaths.h>
 
+#include <algorithm>
+
 static const int DefaultGuideCameraGain = 95;
 static const int DefaultGuideCameraTimeoutMs = 15000;
 static const bool DefaultUseSubframes = false;
+static const bool DefaultUseMultiROI = false;
+static const bool DefaultUseStreaming = false;
 
 const double GuideCamera::UnknownPixelSize = 0.0;
 
@@ -218,10 +223,15 @@ GuideCamera::GuideCamera()
     ShutterClosed = false;
     HasSubframes = false;
     HasFrameLimiting = false;
+    HasStreaming = false;
+    HasMultiROIReadout = false;
     HasCooler = false;
     HasBayer = false;
     FrameSize = UNDEFINED_FRAME_SIZE;
     UseSubframes = pConfig->Profile.GetBoolean("/camera/UseSubframes", DefaultUseSubframes);
+    UseMultiROI = pConfig->Profile.GetBoolean("/camera/UseMultiROI", DefaultUseMultiROI);
+    UseStreaming = pConfig->Profile.GetBoolean("/camera/UseStreaming", DefaultUseStreaming);
+    m_streamFramesDropped = 0;
     GuideCameraGain = pConfig->Profile.GetInt("/camera/gain", DefaultGuideCameraGain);
     m_timeoutMs = pConfig->Profile.GetInt("/camera/TimeoutMs", DefaultGuideCameraTimeoutMs);
     m_saturationADU = (unsigned short) wxMin(pConfig->Profile.GetInt("/camera/SaturationADU", 0), 65535);
@@ -232,12 +242,14 @@ GuideCamera::GuideCamera()
     SwBinning = wxClip(pConfig->Profile.GetInt("/camera/SoftwareBinning", 1), 1, (int) GuideCamera::MAX_SOFTWARE_BINNING);
     CurrentDarkFrame = nullptr;
     CurrentDefectMap = nullptr;
+    m_darkLibFile = new MappedDarkLibrary();
 }
 
 GuideCamera::~GuideCamera()
 {
     ClearDarks();
     ClearDefectMap();
+    delete m_darkLibFile;
 }
 
 static int CompareNoCase(const wxString& first, const wxString& second)
@@ -257,7 +269,7 @@ wxArrayString GuideCamera::GuideCameraList()
 
     CameraList.Add(_("None"));
 #if defined(ASCOM_CAMERA)
-    wxArrayString ascomCameras = ASCOMCameraFactory::EnumAscomCameras();
+    wxArrayString ascomCameras = DeviceEnumerator::List(DeviceEnumerator::ASCOM_CAMERAS);
     for (unsigned int i = 0; i < ascomCameras.Count(); i++)
         CameraList.Add(ascomCameras[i]);
 #endif
@@ -941,6 +953,8 @@ void CameraConfigDialogPane::LayoutControls(GuideCamera *pCamera, BrainCtrlIdMap
         pDetailsSizer->AddSpacer(20);
         pDetailsSizer->Add(GetSingleCtrl(CtrlMap, AD_cbUseSubFrames), wxSizerFlags(0).Border(wxTOP, 3));
         pDetailsSizer->Add(GetSizerCtrl(CtrlMap, AD_szCameraTimeout), wxSizerFlags(0).Border(wxLEFT, 20));
+        pDetailsSizer->Add(GetSingleCtrl(CtrlMap, AD_cbUseMultiROI), wxSizerFlags(0).Border(wxTOP, 3));
+        pDetailsSizer->Add(GetSingleCtrl(CtrlMap, AD_cbUseStreaming), wxSizerFlags(0).Border(wxTOP, 3));
         this->Layout();
     }
     else
@@ -967,7 +981,8 @@ CameraConfigDialogCtrlSet *GuideCamera::GetConfigDlgCtrlSet(wxWindow *pParent, G
 
 CameraConfigDialogCtrlSet::CameraConfigDialogCtrlSet(wxWindow *pParent, GuideCamera *pCamera, AdvancedDialog *pAdvancedDialog,
                                                      BrainCtrlIdMap& CtrlMap)
-    : ConfigDialogCtrlSet(pParent, pAdvancedDialog, CtrlMap), m_pUseSubframes(nullptr)
+    : ConfigDialogCtrlSet(pParent, pAdvancedDialog, CtrlMap), m_pUseSubframes(nullptr), m_pUseMultiROI(nullptr),
+      m_pUseStreaming(nullptr)
 {
     int textWidth = StringWidth(_T("0000"));
     assert(pCamera);
@@ -977,6 +992,15 @@ CameraConfigDialogCtrlSet::CameraConfigDialogCtrlSet(wxWindow *pParent, GuideCam
     m_pUseSubframes = new wxCheckBox(GetParentWindow(AD_cbUseSubFrames), wxID_ANY, _("Use Subframes"));
     AddCtrl(CtrlMap, AD_cbUseSubFrames, m_pUseSubframes,
             _("Check to only download subframes (ROIs). Sub-frame size is equal to search region size."));
+    m_pUseMultiROI = new wxCheckBox(GetParentWindow(AD_cbUseMultiROI), wxID_ANY, _("Multi-star subframes"));
+    AddCtrl(CtrlMap, AD_cbUseMultiROI, m_pUseMultiROI,
+            _("When subframes are used with multi-star guiding, download a subframe covering all the guide stars instead "
+              "of a single subframe around the primary star. A full frame is downloaded when the stars are spread over "
+              "much of the sensor"));
+    m_pUseStreaming = new wxCheckBox(GetParentWindow(AD_cbUseStreaming), wxID_ANY, _("Continuous capture"));
+    AddCtrl(CtrlMap, AD_cbUseStreaming, m_pUseStreaming,
+            _("Keep the camera exposing continuously and guide from the most recent frame instead of starting a new "
+              "exposure for each guide frame. Subframes are not used while capturing continuously."));
 
     // Pixel size
     m_pPixelSize = NewSpinnerDouble(GetParentWindow(AD_szPixelSize), textWidth, m_pCamera->GetCameraPixelSize(), 0.0, 99.9, 0.1,
@@ -1093,12 +1117,19 @@ void CameraConfigDialogCtrlSet::LoadValues()
     if (m_pCamera->HasSubframes)
     {
         m_pUseSubframes->SetValue(m_pCamera->UseSubframes);
+        m_pUseMultiROI->SetValue(m_pCamera->UseMultiROI);
     }
     else
     {
         m_pUseSubframes->Enable(false);
+        m_pUseMultiROI->Enable(false);
     }
 
+    if (m_pCamera->HasStreaming)
+        m_pUseStreaming->SetValue(m_pCamera->UseStreaming);
+    else
+        m_pUseStreaming->Enable(false);
+
     if (m_pCamera->HasGainControl)
     {
         m_pCameraGain->SetValue(m_pCamera->GetCameraGain());
@@ -1217,12 +1248,25 @@ void CameraConfigDialogCtrlSet::UnloadValues()
         bool newVal = m_pUseSubframes->GetValue();
         m_pCamera->UseSubframes = newVal;
         pConfig->Profile.SetBoolean("/camera/UseSubframes", newVal);
+        bool oldMulti = m_pCamera->UseMultiROI;
+        bool newMulti = m_pUseMultiROI->GetValue();
+        m_pCamera->UseMultiROI = newMulti;
+        pConfig->Profile.SetBoolean("/camera/UseMultiROI", newMulti);
         // MultiStar can't track secondary star locations during periods when subframes are used
-        if (oldVal && !newVal)
+        // without a window for each star
+        bool wasTracking = !oldVal || oldMulti;
+        bool tracking = !newVal || newMulti;
+        if (!wasTracking && tracking)
             if (pFrame->pGuider->GetMultiStarMode())
                 pFrame->pGuider->SetMultiStarMode(true); // Will force a refresh of secondary stars
     }
 
+    if (m_pCamera->HasStreaming)
+    {
+        m_pCamera->UseStreaming = m_pUseStreaming->GetValue();
+        pConfig->Profile.SetBoolean("/camera/UseStreaming", m_pCamera->UseStreaming);
+    }
+
     if (m_pCamera->HasGainControl)
     {
         m_pCamera->SetCameraGain(m_pCameraGain->GetValue());
@@ -1392,6 +1436,7 @@ void GuideCamera::AddDark(usImage *dark)
             usImage *prior = pos->second;
             if (prior == CurrentDarkFrame)
                 CurrentDarkFrame = dark;
+            m_darkLibFile->Forget(prior);
             delete prior;
         }
 
@@ -1400,6 +1445,68 @@ void GuideCamera::AddDark(usImage *dark)
     Darks[expdur] = dark;
 }
 
+// Map the dark library file instead of reading it. The darks are added to the library with
+// their metadata only; pixel data are paged in from the file when a dark is selected and
+// used. Returns true if the file cannot be mapped, in which case the caller should fall
+// back to reading it.
+bool GuideCamera::MapDarkLibrary(const wxString& fname)
+{
+    wxCriticalSectionLocker lck(DarkFrameLock);
+
+    // darks paged from a previous mapping are superseded by the file being loaded
+    for (ExposureImgMap::iterator it = Darks.begin(); it != Darks.end();)
+    {
+        if (m_darkLibFile->Owns(it->second))
+        {
+            if (it->second == CurrentDarkFrame)
+                CurrentDarkFrame = nullptr;
+            delete it->second;
+            it = Darks.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    if (m_darkLibFile->Open(fname))
+        return true;
+
+    std::vector<usImage *> darks(m_darkLibFile->TakeDarks());
+    for (usImage *dark : darks)
+    {
+        ExposureImgMap::iterator pos = Darks.find(dark->ImgExpDur);
+        if (pos != Darks.end())
+        {
+            if (pos->second == CurrentDarkFrame)
+                CurrentDarkFrame = dark;
+            delete pos->second;
+        }
+        Darks[dark->ImgExpDur] = dark;
+    }
+
+    return false;
+}
+
+// Read all mapped darks into memory and release the file mapping, for example before
+// the dark library file is rewritten. Returns true on error.
+bool GuideCamera::DetachDarkLibrary()
+{
+    wxCriticalSectionLocker lck(DarkFrameLock);
+
+    bool err = false;
+
+    if (m_darkLibFile->IsOpen())
+    {
+        for (ExposureImgMap::iterator it = Darks.begin(); it != Darks.end(); ++it)
+        {
+            if (m_darkLibFile->PageIn(*it->second, wxRect()))
+                err = true;
+        }
+        m_darkLibFile->Close();
+    }
+
+    return err;
+}
+
 void GuideCamera::SelectDark(int exposureDuration)
 {
     // select the dark frame with the smallest exposure >= the requested exposure.
@@ -1407,6 +1514,8 @@ void GuideCamera::SelectDark(int exposureDuration)
 
     wxCriticalSectionLocker lck(DarkFrameLock);
 
+    usImage *prev = CurrentDarkFrame;
+
     CurrentDarkFrame = 0;
     for (ExposureImgMap::const_iterator it = Darks.begin(); it != Darks.end(); ++it)
     {
@@ -1414,6 +1523,10 @@ void GuideCamera::SelectDark(int exposureDuration)
         if (it->first >= exposureDuration)
             break;
     }
+
+    // only the selected dark needs to stay resident
+    if (prev && prev != CurrentDarkFrame)
+        m_darkLibFile->PageOut(*prev);
 }
 
 void GuideCamera::GetDarkLibraryProperties(int *pNumDarks, double *pMinExp, double *pMaxExp)
@@ -1468,11 +1581,14 @@ void GuideCamera::ClearDarks()
         delete it->second;
         Darks.erase(it);
     }
+    m_darkLibFile->Close();
     CurrentDarkFrame = nullptr;
 }
 
 void GuideCamera::SubtractDark(usImage& img)
 {
+    FRAME_TRACE_SPAN("GuideCamera::SubtractDark");
+
     // dark subtraction is done in the camera worker thread, so we need to acquire the
     // DarkFrameLock to protect against the dark frame disappearing when the main
     // thread does "Load Darks" or "Clear Darks"
@@ -1485,6 +1601,22 @@ void GuideCamera::SubtractDark(usImage& img)
     }
     else if (CurrentDarkFrame)
     {
+        // page in just the part of a mapped dark that the light frame covers
+        wxRect roi;
+        if (!img.Subframe.IsEmpty())
+        {
+            roi = img.Subframe;
+            roi.Offset(img.LimitFrame.GetLeftTop());
+        }
+        else if (!img.LimitFrame.IsEmpty())
+            roi = img.LimitFrame;
+
+        if (m_darkLibFile->PageIn(*CurrentDarkFrame, roi))
+        {
+            Debug.Write("SubtractDark: could not page in dark frame\n");
+            return;
+        }
+
         Subtract(img, *CurrentDarkFrame);
     }
 }
@@ -1572,13 +1704,59 @@ inline static wxRect binned_rect(const wxRect& unbinnedRect, int binning)
     return wxRect(x, y, width, heigth);
 }
 
-inline static wxSize binned_size(const wxSize& unbinnedSize, int binning)
+// Keep only the multi-ROI windows of a subframe capture; the rest of the subframe is
+// cleared and the windows are recorded in img.ROIs
+static void CropToROIs(usImage& img, const std::vector<wxRect>& rois)
+{
+    const wxRect& subframe = img.Subframe;
+
+    for (const wxRect& roi : rois)
+    {
+        wxRect r(roi);
+        r.Intersect(subframe);
+        if (!r.IsEmpty())
+            img.ROIs.push_back(r);
+    }
+
+    if (img.ROIs.empty())
+        return;
+
+    int const W = img.Size.GetWidth();
+    std::vector<std::pair<int, int>> spans;
+
+    for (int y = subframe.GetTop(); y <= subframe.GetBottom(); y++)
+    {
+        spans.clear();
+        for (const wxRect& r : img.ROIs)
+            if (y >= r.GetTop() && y <= r.GetBottom())
+                spans.push_back(std::make_pair(r.GetLeft(), r.GetRight() + 1));
+        std::sort(spans.begin(), spans.end());
+
+        unsigned short *row = img.ImageData + y * W;
+        int x = subframe.GetLeft();
+        for (const auto& span : spans)
+        {
+            if (span.first > x)
+                std::fill(row + x, row + span.first, 0);
+            x = std::max(x, span.second);
+        }
+        if (x <= subframe.GetRight())
+            std::fill(row + x, row + subframe.GetRight() + 1, 0);
+    }
+}
+
+// the stream must be restarted when any of the parameters that determine its frames change
+static bool StreamParamsChanged(const CaptureParams& a, const CaptureParams& b)
 {
-    return wxSize(unbinnedSize.x / binning, unbinnedSize.y / binning);
+    return a.duration != b.duration || a.gain != b.gain || a.hwBinning != b.hwBinning || a.bpp != b.bpp ||
+        a.limitFrame != b.limitFrame ||
+        (a.captureOptions & CAPTURE_IGNORE_FRAME_LIMIT) != (b.captureOptions & CAPTURE_IGNORE_FRAME_LIMIT);
 }
 
 bool GuideCamera::Capture(GuideCamera *camera, usImage& img, const CaptureParams& captureParams)
 {
+    FRAME_TRACE_SPAN("GuideCamera::Capture");
+
     // The subframe and LimitFrame are in software-binned coordinates, but the camera
     // subclass Capture methods work with hardware coordinates.
     int swBinning = captureParams.swBinning;
@@ -1587,6 +1765,8 @@ bool GuideCamera::Capture(GuideCamera *camera, usImage& img, const CaptureParams
     {
         cameraParams.limitFrame = unbinned_rect(captureParams.limitFrame, swBinning);
         cameraParams.subframe = unbinned_rect(captureParams.subframe, swBinning);
+        for (wxRect& roi : cameraParams.rois)
+            roi = unbinned_rect(roi, swBinning);
     }
 
     img.InitImgStartTime();
@@ -1596,31 +1776,103 @@ bool GuideCamera::Capture(GuideCamera *camera, usImage& img, const CaptureParams
     img.Gain = captureParams.gain;
     img.ImgExpDur = captureParams.duration;
 
-    bool err = camera->Capture(img, cameraParams);
+    wxStopWatch swatch;
+
+    bool err;
+
+    // darks are taken with single exposures so that cameras with a shutter can close it
+    if (camera->UseStreaming && camera->HasStreaming && !camera->ShutterClosed)
+    {
+        // streams always deliver the full frame
+        CaptureParams streamParams(cameraParams);
+        streamParams.subframe = wxRect();
+        streamParams.rois.clear();
+
+        if (camera->IsStreaming() && StreamParamsChanged(camera->m_streamParams, streamParams))
+        {
+            Debug.Write("Camera: capture parameters changed, restarting stream\n");
+            camera->StopStream();
+        }
+
+        err = false;
+        if (!camera->IsStreaming())
+        {
+            Debug.Write(wxString::Format("Camera: start stream, exp = %d, bin = %d\n", streamParams.duration,
+                                         streamParams.hwBinning));
+            err = camera->StartStream(streamParams);
+            if (!err)
+                camera->m_streamParams = streamParams;
+        }
+
+        if (!err)
+            err = camera->GetLatestFrame(img, streamParams);
+    }
+    else
+    {
+        if (camera->IsStreaming())
+            camera->StopStream();
+
+        err = camera->Capture(img, cameraParams);
+    }
+
     if (err)
         return err;
 
+    double captureSecs = swatch.Time() / 1000.;
+    double exposureSecs = captureParams.duration / 1000.;
+    Metrics.captureSeconds.Observe(captureSecs);
+    Metrics.downloadSeconds.Observe(std::max(0., captureSecs - exposureSecs));
+    Metrics.exposureSeconds.Set(exposureSecs);
+
     // perform software binning if needed
     if (swBinning > 1)
     {
-        usImage binnedImage;
-        if (binnedImage.Init(binned_size(img.Size, swBinning)))
-        {
-            camera->DisconnectWithAlert(CAPT_FAIL_MEMORY);
-            return true;
-        }
-        BinPixels(binnedImage.ImageData, img.ImageData, img.Size, swBinning);
-        img.SwapImageData(binnedImage);
-        img.Size = binnedImage.Size;
-        img.NPixels = binnedImage.NPixels;
+        BinPixelsInPlace(img, swBinning);
         img.Binning *= swBinning;
         // scale the subframe from camera coords to binned coords
         img.Subframe = binned_rect(img.Subframe, swBinning);
     }
 
+    if (captureParams.rois.size() > 1 && !img.Subframe.IsEmpty())
+        CropToROIs(img, captureParams.rois);
+
     return err;
 }
 
+bool GuideCamera::StartStream(const CaptureParams& captureParams)
+{
+    // should never be called for cameras without HasStreaming
+
+    assert(false);
+    return true;
+}
+
+void GuideCamera::StopStream() { }
+
+bool GuideCamera::GetLatestFrame(usImage& img, const CaptureParams& captureParams)
+{
+    // should never be called for cameras without HasStreaming
+
+    assert(false);
+    return true;
+}
+
+void GuideCamera::AddStreamFramesDropped(unsigned int count)
+{
+    if (count)
+    {
+        m_streamFramesDropped += count;
+        Metrics.streamFramesDropped.Add(count);
+        Debug.Write(wxString::Format("Camera: %u stream frame(s) dropped, %u total\n", count, m_streamFramesDropped));
+    }
+}
+
+void GuideCamera::AddStreamFramesSkipped(unsigned int count)
+{
+    if (count)
+        Metrics.streamFramesSkipped.Add(count);
+}
+
 bool GuideCamera::ST4HasGuideOutput()
 {
     return m_hasGuideOutput;
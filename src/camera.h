@@ -37,6 +37,7 @@
 
 typedef std::map<int, usImage *> ExposureImgMap; // map exposure to image
 class DefectMap;
+class MappedDarkLibrary;
 
 enum PropDlgType
 {
@@ -65,6 +66,8 @@ class CameraConfigDialogCtrlSet : public ConfigDialogCtrlSet
 {
     GuideCamera *m_pCamera;
     wxCheckBox *m_pUseSubframes;
+    wxCheckBox *m_pUseMultiROI;
+    wxCheckBox *m_pUseStreaming;
     wxSpinCtrl *m_pCameraGain;
     wxButton *m_resetGain;
     wxSpinCtrl *m_timeoutVal;
@@ -109,6 +112,10 @@ enum CaptureOptionBits
 struct CaptureParams
 {
     wxRect subframe;
+    // Multi-ROI capture: windows around the guide stars, with subframe set to their
+    // bounding box. Only set for cameras with HasMultiROIReadout; any pixels the camera
+    // returns outside the windows are discarded by GuideCamera::Capture.
+    std::vector<wxRect> rois;
     wxRect limitFrame;
     int duration;
     int gain;
@@ -130,6 +137,9 @@ class GuideCamera : public wxMessageBoxProxy, public OnboardST4
     friend class CameraConfigDialogCtrlSet;
 
     double m_pixelSize;
+    MappedDarkLibrary *m_darkLibFile; // memory-mapped dark library backing some of the entries in Darks
+    CaptureParams m_streamParams; // parameters the running stream was started with
+    unsigned int m_streamFramesDropped;
 
 protected:
     bool m_hasGuideOutput;
@@ -162,11 +172,15 @@ public:
     bool HasShutter;
     bool HasSubframes;
     bool HasFrameLimiting;
+    bool HasStreaming; // camera can expose continuously, see StartStream()
+    bool HasMultiROIReadout; // camera can read several windows in one exposure, see CaptureParams::rois
     wxByte MaxHwBinning; // max hardware binning level
     wxByte HwBinning; // hardware binning level
     wxByte SwBinning; // software binning level
     bool ShutterClosed; // false=light, true=dark
     bool UseSubframes;
+    bool UseMultiROI; // with multi-star guiding, use a subframe window around each guide star
+    bool UseStreaming; // capture from a continuous stream when the camera supports it
     bool HasCooler;
     bool HasBayer; // true for color camera
     wxRect LimitFrame; // limit full frames to this region of interest (ROI). An empty rect for no limit.
@@ -239,6 +253,8 @@ public:
 
     virtual wxString GetSettingsSummary();
     void AddDark(usImage *dark);
+    bool MapDarkLibrary(const wxString& fname);
+    bool DetachDarkLibrary();
     void SelectDark(int exposureDuration);
     void SetDefectMap(DefectMap *newMap);
     void ClearDefectMap();
@@ -262,7 +278,25 @@ public:
 
     virtual bool Capture(usImage& img, const CaptureParams& captureParams) = 0;
 
+    // Streaming capture, for cameras that set HasStreaming. StartStream() starts back-to-back
+    // exposures of the full frame (or LimitFrame) with the given parameters. GetLatestFrame()
+    // discards any frames that completed before the call, counting them as dropped, and
+    // returns the next frame to complete, so a frame never started more than one exposure
+    // before it was requested. StartStream() and GetLatestFrame() return true on error.
+    // GuideCamera::Capture uses the stream when UseStreaming is set, and restarts it when the
+    // capture parameters change.
+    virtual bool StartStream(const CaptureParams& captureParams);
+    virtual void StopStream();
+    virtual bool IsStreaming() const { return false; }
+    virtual bool GetLatestFrame(usImage& img, const CaptureParams& captureParams);
+    unsigned int StreamFramesDropped() const { return m_streamFramesDropped; }
+
 protected:
+    // frames the driver reports lost, e.g. because its buffers were full
+    void AddStreamFramesDropped(unsigned int count);
+    // frames read out and discarded so the next one is fresh; expected on every capture
+    void AddStreamFramesSkipped(unsigned int count);
+
     int GetTimeoutMs() const;
     void SetTimeoutMs(int timeoutMs);
 
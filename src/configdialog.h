@@ -61,6 +61,8 @@ enum BRAIN_CTRL_IDS
     AD_GLOBAL_TAB_BOUNDARY, //-----end of global tab controls
 
     AD_cbUseSubFrames,
+    AD_cbUseMultiROI,
+    AD_cbUseStreaming,
     AD_szNoiseReduction,
     AD_szAutoExposure,
     AD_szVariableExposureDelay,
@@ -86,6 +88,8 @@ enum BRAIN_CTRL_IDS
     AD_cbSlewDetection,
     AD_cbUseDecComp,
     AD_cbBeepForLostStar,
+    AD_cbPhaseCorrelation,
+    AD_cbLearnDefects,
     AD_GUIDER_TAB_BOUNDARY, // --------------- end of guiding tab controls
 
     AD_szBLCompCtrls,
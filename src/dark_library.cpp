@@ -0,0 +1,433 @@
+/*
+ *  dark_library.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "phd.h"
+#include "dark_library.h"
+
+#ifdef __WINDOWS__
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+void ReadDarkFrameKeys(fitsfile *fptr, usImage *img)
+{
+    int status = 0;
+
+    char keyname[] = "EXPOSURE";
+    float exposure;
+    if (fits_read_key(fptr, TFLOAT, keyname, &exposure, nullptr, &status))
+    {
+        exposure = (float) pFrame->RequestedExposureDuration() / 1000.0;
+        Debug.Write(wxString::Format("missing EXPOSURE value, assume %.3f\n", exposure));
+        status = 0;
+    }
+    img->ImgExpDur = ROUNDF(exposure * 1000.0);
+
+    char binning_key[] = "XBINNING";
+    int binning = 1;
+    fits_read_key(fptr, TINT, binning_key, &binning, nullptr, &status);
+    img->Binning = wxMax(binning, 1);
+    status = 0;
+
+    char saturate_key[] = "SATURATE";
+    int saturate = 65535;
+    fits_read_key(fptr, TINT, saturate_key, &saturate, nullptr, &status);
+    img->BitsPerPixel = saturate >= 256 ? 16 : 8;
+    status = 0;
+
+    char gain_key[] = "GAIN";
+    int gain = 0;
+    fits_read_key(fptr, TINT, gain_key, &gain, nullptr, &status);
+    img->Gain = gain;
+}
+
+// read-only mapping of a whole file
+class FileMapping
+{
+    const unsigned char *m_base;
+    size_t m_size;
+#ifdef __WINDOWS__
+    HANDLE m_file;
+    HANDLE m_mapping;
+#endif
+
+public:
+    FileMapping()
+        : m_base(nullptr), m_size(0)
+#ifdef __WINDOWS__
+          ,
+          m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+#endif
+    {
+    }
+    ~FileMapping() { Unmap(); }
+
+    bool Map(const wxString& fname);
+    void Unmap();
+    const unsigned char *Base() const { return m_base; }
+    size_t Size() const { return m_size; }
+};
+
+bool FileMapping::Map(const wxString& fname)
+{
+    Unmap();
+
+#ifdef __WINDOWS__
+
+    m_file = CreateFileW(fname.wc_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return true;
+
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(m_file, &sz) || sz.QuadPart == 0 || (unsigned long long) sz.QuadPart > (size_t) -1)
+    {
+        Unmap();
+        return true;
+    }
+    m_size = (size_t) sz.QuadPart;
+
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping)
+    {
+        Unmap();
+        return true;
+    }
+
+    m_base = static_cast<const unsigned char *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_base)
+    {
+        Unmap();
+        return true;
+    }
+
+#else // __WINDOWS__
+
+    int fd = open(fname.fn_str(), O_RDONLY);
+    if (fd == -1)
+        return true;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return true;
+    }
+    m_size = (size_t) st.st_size;
+
+    void *p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps its own reference to the file
+    if (p == MAP_FAILED)
+    {
+        m_size = 0;
+        return true;
+    }
+    m_base = static_cast<const unsigned char *>(p);
+
+#endif // __WINDOWS__
+
+    return false;
+}
+
+void FileMapping::Unmap()
+{
+#ifdef __WINDOWS__
+    if (m_base)
+        UnmapViewOfFile(m_base);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if (m_base)
+        munmap(const_cast<unsigned char *>(m_base), m_size);
+#endif
+    m_base = nullptr;
+    m_size = 0;
+}
+
+struct MappedDark
+{
+    wxSize size;
+    size_t dataOffset; // byte offset of the first pixel in the file
+    std::vector<bool> rowValid;
+    bool statsValid;
+};
+
+typedef std::map<const usImage *, MappedDark> MappedDarkMap;
+
+struct MappedDarkLibraryImpl
+{
+    wxString fname;
+    FileMapping map;
+    MappedDarkMap darks;
+    std::vector<usImage *> placeholders;
+
+    void Clear()
+    {
+        for (usImage *img : placeholders)
+            delete img;
+        placeholders.clear();
+        darks.clear();
+        map.Unmap();
+        fname.clear();
+    }
+};
+
+MappedDarkLibrary::MappedDarkLibrary() : m_impl(new MappedDarkLibraryImpl()) { }
+
+MappedDarkLibrary::~MappedDarkLibrary()
+{
+    delete m_impl;
+}
+
+bool MappedDarkLibrary::IsOpen() const
+{
+    return m_impl->map.Base() != nullptr;
+}
+
+void MappedDarkLibrary::Close()
+{
+    if (IsOpen())
+        Debug.Write(wxString::Format("MappedDarkLibrary: close %s\n", m_impl->fname));
+    m_impl->Clear();
+}
+
+bool MappedDarkLibrary::Open(const wxString& fname)
+{
+    Close();
+
+    // index the HDUs with CFITSIO
+
+    fitsfile *fptr = nullptr;
+    int status = 0; // CFITSIO status value MUST be initialized to zero!
+
+    if (PHD_fits_open_diskfile(&fptr, fname, READONLY, &status) != 0)
+        return true;
+
+    bool err = false;
+    int nhdus = 0;
+    fits_get_num_hdus(fptr, &nhdus, &status);
+
+    wxSize frameSize;
+    std::vector<std::pair<usImage *, MappedDark>> found;
+
+    for (int hdu = 1; hdu <= nhdus && !err; hdu++)
+    {
+        int hdutype;
+        if (fits_movabs_hdu(fptr, hdu, &hdutype, &status) || hdutype != IMAGE_HDU || fits_is_compressed_image(fptr, &status))
+        {
+            err = true;
+            break;
+        }
+
+        int bitpix = 0, naxis = 0;
+        long fsize[2];
+        fits_get_img_type(fptr, &bitpix, &status);
+        fits_get_img_dim(fptr, &naxis, &status);
+        fits_get_img_size(fptr, 2, fsize, &status);
+
+        double bzero = 0.0, bscale = 1.0;
+        int keystat = 0;
+        char bzero_key[] = "BZERO";
+        fits_read_key(fptr, TDOUBLE, bzero_key, &bzero, nullptr, &keystat);
+        keystat = 0;
+        char bscale_key[] = "BSCALE";
+        fits_read_key(fptr, TDOUBLE, bscale_key, &bscale, nullptr, &keystat);
+
+        LONGLONG headstart, datastart, dataend;
+        fits_get_hduaddrll(fptr, &headstart, &datastart, &dataend, &status);
+
+        if (status || bitpix != SHORT_IMG || naxis != 2 || bzero != 32768.0 || bscale != 1.0)
+        {
+            Debug.Write(wxString::Format("MappedDarkLibrary: HDU %d cannot be mapped (bitpix %d naxis %d bzero %g bscale %g "
+                                         "status %d)\n",
+                                         hdu, bitpix, naxis, bzero, bscale, status));
+            err = true;
+            break;
+        }
+
+        wxSize sz((int) fsize[0], (int) fsize[1]);
+        if (hdu > 1 && sz != frameSize)
+        {
+            err = true; // let the CFITSIO loader report the incompatibility
+            break;
+        }
+        frameSize = sz;
+
+        usImage *img = new usImage();
+        img->Size = sz;
+        ReadDarkFrameKeys(fptr, img);
+
+        MappedDark md;
+        md.size = sz;
+        md.dataOffset = (size_t) datastart;
+        md.rowValid.assign(sz.GetHeight(), false);
+        md.statsValid = false;
+
+        found.push_back(std::make_pair(img, md));
+    }
+
+    PHD_fits_close_file(fptr);
+
+    if (!err && !found.empty() && m_impl->map.Map(fname))
+    {
+        Debug.Write(wxString::Format("MappedDarkLibrary: could not map %s\n", fname));
+        err = true;
+    }
+
+    if (!err)
+    {
+        // make sure the mapping covers the data of every HDU
+        for (const auto& p : found)
+        {
+            size_t const bytes = (size_t) p.second.size.GetWidth() * p.second.size.GetHeight() * 2;
+            if (p.second.dataOffset + bytes > m_impl->map.Size())
+            {
+                Debug.Write("MappedDarkLibrary: truncated file\n");
+                err = true;
+                break;
+            }
+        }
+    }
+
+    if (err || found.empty())
+    {
+        for (auto& p : found)
+            delete p.first;
+        m_impl->Clear();
+        return true;
+    }
+
+    m_impl->fname = fname;
+    for (auto& p : found)
+    {
+        m_impl->placeholders.push_back(p.first);
+        m_impl->darks[p.first] = p.second;
+        Debug.Write(wxString::Format("mapped dark frame exposure = %d, %dx%d bin %d, bpp = %d, gain = %d\n",
+                                     p.first->ImgExpDur, p.first->Size.x, p.first->Size.y, p.first->Binning,
+                                     p.first->BitsPerPixel, p.first->Gain));
+    }
+
+    return false;
+}
+
+std::vector<usImage *> MappedDarkLibrary::TakeDarks()
+{
+    std::vector<usImage *> v;
+    v.swap(m_impl->placeholders);
+    return v;
+}
+
+bool MappedDarkLibrary::Owns(const usImage *dark) const
+{
+    return m_impl->darks.find(dark) != m_impl->darks.end();
+}
+
+void MappedDarkLibrary::Forget(const usImage *dark)
+{
+    m_impl->darks.erase(dark);
+}
+
+// BITPIX=16 with BZERO=32768: big-endian signed values offset by 32768, which is the
+// unsigned value with the sign bit flipped
+inline static void convert_row(unsigned short *dst, const unsigned char *src, int width)
+{
+    for (int x = 0; x < width; x++, src += 2)
+        dst[x] = (unsigned short) (((src[0] << 8) | src[1]) ^ 0x8000);
+}
+
+bool MappedDarkLibrary::PageIn(usImage& dark, const wxRect& roi)
+{
+    MappedDarkMap::iterator it = m_impl->darks.find(&dark);
+    if (it == m_impl->darks.end())
+        return false; // an ordinary in-memory dark
+
+    MappedDark& md = it->second;
+
+    if (!dark.ImageData)
+    {
+        // the buffer is allocated but not touched, so rows that are never paged in do not
+        // consume physical memory
+        if (dark.Init(md.size))
+            return true;
+        md.rowValid.assign(md.size.GetHeight(), false);
+        md.statsValid = false;
+    }
+
+    bool const fullFrame = roi.IsEmpty();
+    wxRect r = fullFrame ? wxRect(md.size) : roi.Intersect(wxRect(md.size));
+
+    int const W = md.size.GetWidth();
+    size_t const rowBytes = (size_t) W * 2;
+    const unsigned char *data = m_impl->map.Base() + md.dataOffset;
+
+    unsigned int cnt = 0;
+    for (int y = r.GetTop(); y <= r.GetBottom(); y++)
+    {
+        if (md.rowValid[y])
+            continue;
+        convert_row(&dark.ImageData[y * W], data + y * rowBytes, W);
+        md.rowValid[y] = true;
+        ++cnt;
+    }
+
+    if (cnt)
+        Debug.Write(wxString::Format("MappedDarkLibrary: exp %d paged in %u rows\n", dark.ImgExpDur, cnt));
+
+    if (fullFrame && !md.statsValid)
+    {
+        dark.CalcStats();
+        md.statsValid = true;
+    }
+
+    return false;
+}
+
+void MappedDarkLibrary::PageOut(usImage& dark)
+{
+    MappedDarkMap::iterator it = m_impl->darks.find(&dark);
+    if (it == m_impl->darks.end() || !dark.ImageData)
+        return;
+
+    delete[] dark.ImageData;
+    dark.ImageData = nullptr;
+    dark.NPixels = 0;
+    dark.Capacity = 0;
+    it->second.statsValid = false;
+}
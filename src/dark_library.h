@@ -0,0 +1,87 @@
+/*
+ *  dark_library.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef DARK_LIBRARY_H_INCLUDED
+#define DARK_LIBRARY_H_INCLUDED
+
+struct MappedDarkLibraryImpl;
+
+// Read the PHD2 dark frame keywords (EXPOSURE, XBINNING, SATURATE, GAIN) from the
+// current HDU into img
+extern void ReadDarkFrameKeys(fitsfile *fptr, usImage *img);
+
+// A dark library FITS file mapped read-only into memory.
+//
+// Opening the library only indexes the HDU headers. Each dark is handed out as a usImage
+// with its metadata filled in but no pixel buffer; PageIn() converts the FITS data of the
+// requested rows into the image on first use, so only the selected exposure, and with
+// subframes only the rows around the guide star, become resident. PageOut() releases the
+// pixel buffer again.
+//
+// Only uncompressed 16-bit HDUs (BITPIX=16, BZERO=32768, BSCALE=1 as written by
+// save_multi_darks) can be mapped; Open() fails for anything else and the caller falls
+// back to reading the file with CFITSIO.
+//
+// Callers are expected to serialize access with GuideCamera::DarkFrameLock.
+class MappedDarkLibrary
+{
+    MappedDarkLibraryImpl *m_impl;
+
+    MappedDarkLibrary(const MappedDarkLibrary&) = delete;
+    MappedDarkLibrary& operator=(const MappedDarkLibrary&) = delete;
+
+public:
+    MappedDarkLibrary();
+    ~MappedDarkLibrary();
+
+    // returns true on error
+    bool Open(const wxString& fname);
+    void Close();
+    bool IsOpen() const;
+
+    // the placeholder darks created by Open(); ownership passes to the caller
+    std::vector<usImage *> TakeDarks();
+
+    // true if dark is a placeholder created by this library
+    bool Owns(const usImage *dark) const;
+    // stop tracking dark, which is about to be deleted by its owner
+    void Forget(const usImage *dark);
+
+    // Make the pixels in roi (full frame if roi is empty) available in dark. For a
+    // full-frame page-in the image statistics are computed as well. Returns true on error.
+    bool PageIn(usImage& dark, const wxRect& roi);
+    // release the pixel buffer of dark
+    void PageOut(usImage& dark);
+};
+
+#endif
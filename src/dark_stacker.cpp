@@ -0,0 +1,523 @@
+/*
+ *  dark_stacker.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "phd.h"
+#include "dark_stacker.h"
+
+#include <wx/filename.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// upper bound on the size of the band buffer used for the median combine
+static const size_t MEDIAN_BAND_BYTES = 32 * 1024 * 1024;
+
+// Run fn(y0, y1) over [0, rows) split into contiguous row slices, one per core
+template<typename F>
+static void ParallelRows(int rows, const F& fn)
+{
+    unsigned int nthreads = std::max(1U, std::thread::hardware_concurrency());
+    nthreads = std::min<unsigned int>(nthreads, std::max(1, rows / 16));
+    if (nthreads <= 1)
+    {
+        fn(0, rows);
+        return;
+    }
+
+    std::vector<std::thread> pool;
+    pool.reserve(nthreads);
+    for (unsigned int t = 0; t < nthreads; t++)
+    {
+        int y0 = (int) ((long long) rows * t / nthreads);
+        int y1 = (int) ((long long) rows * (t + 1) / nthreads);
+        pool.emplace_back([&fn, y0, y1]() { fn(y0, y1); });
+    }
+    for (std::thread& th : pool)
+        th.join();
+}
+
+struct DarkStackerImpl
+{
+    DarkCombineMode mode;
+    double clipSigma;
+    DarkStacker::FrameHook hook;
+
+    wxSize size;
+    unsigned int npixels;
+    int nframes; // frames accumulated so far
+    bool err; // written by the background thread with lock held
+
+    // DARK_COMBINE_MEAN
+    std::vector<unsigned int> sum;
+
+    // DARK_COMBINE_SIGMA_CLIP - per-pixel Welford state
+    std::vector<float> mean;
+    std::vector<float> m2;
+    std::vector<unsigned short> minv;
+    std::vector<unsigned short> maxv;
+
+    // DARK_COMBINE_MEDIAN - spill file holding the raw frames back to back
+    wxString spillPath;
+    wxFile spill;
+
+    std::mutex lock;
+    std::condition_variable cond;
+    std::deque<usImage *> pending;
+    std::vector<usImage *> spare;
+    bool stopping;
+    bool busy;
+    std::thread thread;
+
+    DarkStackerImpl(DarkCombineMode mode_, double clipSigma_)
+        : mode(mode_), clipSigma(clipSigma_), npixels(0), nframes(0), err(false), stopping(false), busy(false)
+    {
+        thread = std::thread(&DarkStackerImpl::Run, this);
+    }
+
+    ~DarkStackerImpl()
+    {
+        {
+            std::unique_lock<std::mutex> lck(lock);
+            stopping = true;
+        }
+        cond.notify_all();
+        thread.join();
+
+        for (usImage *img : pending)
+            delete img;
+        for (usImage *img : spare)
+            delete img;
+
+        if (spill.IsOpened())
+            spill.Close();
+        if (!spillPath.empty())
+            wxRemoveFile(spillPath);
+    }
+
+    bool Alloc(const wxSize& sz);
+    bool Accumulate(const usImage& img);
+    void Run();
+    bool CombineMean(unsigned short *dst);
+    bool CombineSigmaClip(unsigned short *dst);
+    bool CombineMedian(unsigned short *dst);
+};
+
+bool DarkStackerImpl::Alloc(const wxSize& sz)
+{
+    size = sz;
+    npixels = sz.GetWidth() * sz.GetHeight();
+
+    try
+    {
+        switch (mode)
+        {
+        case DARK_COMBINE_MEAN:
+            sum.assign(npixels, 0);
+            break;
+        case DARK_COMBINE_SIGMA_CLIP:
+            mean.assign(npixels, 0.f);
+            m2.assign(npixels, 0.f);
+            minv.assign(npixels, 65535);
+            maxv.assign(npixels, 0);
+            break;
+        case DARK_COMBINE_MEDIAN:
+            spillPath = wxFileName::CreateTempFileName("phd2dark", &spill);
+            if (spillPath.empty() || !spill.IsOpened())
+            {
+                Debug.AddLine("DarkStacker: could not create spill file for median combine");
+                return true;
+            }
+            break;
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        Debug.AddLine(wxString::Format("DarkStacker: memory allocation failure for %u pixels", npixels));
+        return true;
+    }
+
+    return false;
+}
+
+bool DarkStackerImpl::Accumulate(const usImage& img)
+{
+    const unsigned short *src = img.ImageData;
+
+    switch (mode)
+    {
+    case DARK_COMBINE_MEAN: {
+        unsigned int *acc = &sum[0];
+        for (unsigned int i = 0; i < npixels; i++)
+            acc[i] += src[i];
+        break;
+    }
+    case DARK_COMBINE_SIGMA_CLIP: {
+        float const invk = 1.0f / (float) (nframes + 1);
+        float *pm = &mean[0];
+        float *pq = &m2[0];
+        unsigned short *pmin = &minv[0];
+        unsigned short *pmax = &maxv[0];
+        for (unsigned int i = 0; i < npixels; i++)
+        {
+            unsigned short const v = src[i];
+            float const x = (float) v;
+            float const delta = x - pm[i];
+            pm[i] += delta * invk;
+            pq[i] += delta * (x - pm[i]);
+            if (v < pmin[i])
+                pmin[i] = v;
+            if (v > pmax[i])
+                pmax[i] = v;
+        }
+        break;
+    }
+    case DARK_COMBINE_MEDIAN: {
+        size_t const nbytes = npixels * sizeof(unsigned short);
+        if (spill.Write(src, nbytes) != nbytes)
+        {
+            Debug.AddLine("DarkStacker: error writing spill file");
+            return true;
+        }
+        break;
+    }
+    }
+
+    return false;
+}
+
+void DarkStackerImpl::Run()
+{
+    while (true)
+    {
+        usImage *img;
+        DarkStacker::FrameHook frameHook;
+
+        {
+            std::unique_lock<std::mutex> lck(lock);
+            cond.wait(lck, [this]() { return stopping || !pending.empty(); });
+            if (stopping)
+                return;
+            img = pending.front();
+            pending.pop_front();
+            frameHook = hook;
+            busy = true;
+        }
+
+        if (frameHook)
+            frameHook(*img, nframes + 1);
+
+        bool fail = err;
+
+        if (!fail)
+        {
+            if (nframes == 0)
+                fail = Alloc(img->Size);
+            else if (img->Size != size)
+            {
+                Debug.AddLine(wxString::Format("DarkStacker: frame size changed from %dx%d to %dx%d", size.x, size.y,
+                                               img->Size.x, img->Size.y));
+                fail = true;
+            }
+        }
+
+        if (!fail)
+            fail = Accumulate(*img);
+
+        {
+            std::unique_lock<std::mutex> lck(lock);
+            if (fail)
+                err = true;
+            else
+                ++nframes;
+            spare.push_back(img);
+            busy = false;
+        }
+        cond.notify_all();
+    }
+}
+
+bool DarkStackerImpl::CombineMean(unsigned short *dst)
+{
+    const unsigned int *acc = &sum[0];
+    unsigned int const n = nframes;
+    for (unsigned int i = 0; i < npixels; i++)
+        dst[i] = (unsigned short) (acc[i] / n);
+    return false;
+}
+
+// remove one sample x from a (n, mean, m2) Welford state
+inline static void welford_remove(double& n, double& mean, double& m2, double x)
+{
+    double const mean0 = mean;
+    mean = (n * mean - x) / (n - 1.0);
+    m2 -= (x - mean0) * (x - mean);
+    if (m2 < 0.0)
+        m2 = 0.0;
+    n -= 1.0;
+}
+
+// Test whether sample x is an outlier relative to the remaining samples of (n, mean, m2).
+// The leave-one-out statistics are used so that a single large outlier cannot inflate
+// the dispersion used to judge it.
+inline static bool is_outlier(double n, double mean, double m2, double x, double kappa)
+{
+    if (n < 3.0)
+        return false;
+    double n1 = n, mean1 = mean, m21 = m2;
+    welford_remove(n1, mean1, m21, x);
+    double sd = sqrt(m21 / (n1 - 1.0));
+    if (sd < 0.5)
+        sd = 0.5; // quantization floor so that a 1 ADU wobble on a quiet pixel is not treated as an outlier
+    return fabs(x - mean1) > kappa * sd;
+}
+
+bool DarkStackerImpl::CombineSigmaClip(unsigned short *dst)
+{
+    double const kappa = clipSigma;
+    double const n0 = (double) nframes;
+    int const W = size.GetWidth();
+
+    unsigned int rejectedHi = 0, rejectedLo = 0;
+    std::mutex cntLock;
+
+    ParallelRows(size.GetHeight(),
+                 [&](int y0, int y1)
+                 {
+                     unsigned int hi = 0, lo = 0;
+                     for (unsigned int i = y0 * W; i < (unsigned int) (y1 * W); i++)
+                     {
+                         double n = n0;
+                         double m = mean[i];
+                         double q = m2[i];
+
+                         double const xmax = maxv[i];
+                         if (is_outlier(n, m, q, xmax, kappa))
+                         {
+                             welford_remove(n, m, q, xmax);
+                             ++hi;
+                         }
+
+                         double const xmin = minv[i];
+                         if (is_outlier(n, m, q, xmin, kappa))
+                         {
+                             welford_remove(n, m, q, xmin);
+                             ++lo;
+                         }
+
+                         double v = floor(m + 0.5);
+                         dst[i] = (unsigned short) std::max(0.0, std::min(65535.0, v));
+                     }
+                     std::unique_lock<std::mutex> lck(cntLock);
+                     rejectedHi += hi;
+                     rejectedLo += lo;
+                 });
+
+    Debug.Write(wxString::Format("DarkStacker: sigma clip %.1f rejected %u high, %u low samples\n", kappa, rejectedHi,
+                                 rejectedLo));
+    return false;
+}
+
+bool DarkStackerImpl::CombineMedian(unsigned short *dst)
+{
+    int const W = size.GetWidth();
+    int const H = size.GetHeight();
+    unsigned int const n = nframes;
+    size_t const rowBytes = W * sizeof(unsigned short);
+    size_t const frameBytes = npixels * sizeof(unsigned short);
+
+    int bandRows = (int) std::max<size_t>(1, MEDIAN_BAND_BYTES / (rowBytes * n));
+    bandRows = std::min(bandRows, H);
+
+    // the spill file was created write-only
+    spill.Close();
+    if (!spill.Open(spillPath, wxFile::read))
+    {
+        Debug.AddLine("DarkStacker: could not re-open spill file " + spillPath);
+        return true;
+    }
+
+    // band buffer holds bandRows rows of each frame, frame-major
+    std::vector<unsigned short> band;
+    try
+    {
+        band.resize((size_t) bandRows * W * n);
+    }
+    catch (const std::bad_alloc&)
+    {
+        Debug.AddLine("DarkStacker: memory allocation failure for median band buffer");
+        return true;
+    }
+
+    for (int by = 0; by < H; by += bandRows)
+    {
+        int const rows = std::min(bandRows, H - by);
+        size_t const bytes = rows * rowBytes;
+        size_t const bandStride = (size_t) bandRows * W;
+
+        for (unsigned int f = 0; f < n; f++)
+        {
+            wxFileOffset ofs = (wxFileOffset) f * frameBytes + (wxFileOffset) by * rowBytes;
+            if (spill.Seek(ofs) != ofs || spill.Read(&band[f * bandStride], bytes) != (ssize_t) bytes)
+            {
+                Debug.AddLine("DarkStacker: error reading spill file");
+                return true;
+            }
+        }
+
+        ParallelRows(rows,
+                     [&](int y0, int y1)
+                     {
+                         std::vector<unsigned short> v(n);
+                         for (int y = y0; y < y1; y++)
+                         {
+                             unsigned short *d = dst + (size_t) (by + y) * W;
+                             for (int x = 0; x < W; x++)
+                             {
+                                 size_t const ofs = (size_t) y * W + x;
+                                 for (unsigned int f = 0; f < n; f++)
+                                     v[f] = band[f * bandStride + ofs];
+                                 std::nth_element(v.begin(), v.begin() + n / 2, v.end());
+                                 unsigned int med = v[n / 2];
+                                 if ((n & 1) == 0)
+                                 {
+                                     // even count: average the two middle samples
+                                     unsigned int lo = *std::max_element(v.begin(), v.begin() + n / 2);
+                                     med = (med + lo) / 2;
+                                 }
+                                 d[x] = (unsigned short) med;
+                             }
+                         }
+                     });
+    }
+
+    return false;
+}
+
+DarkStacker::DarkStacker(DarkCombineMode mode, double clipSigma) : m_impl(new DarkStackerImpl(mode, clipSigma)) { }
+
+DarkStacker::~DarkStacker()
+{
+    delete m_impl;
+}
+
+void DarkStacker::SetFrameHook(const FrameHook& hook)
+{
+    std::unique_lock<std::mutex> lck(m_impl->lock);
+    m_impl->hook = hook;
+}
+
+bool DarkStacker::Add(usImage& frame)
+{
+    if (!frame.ImageData)
+        return true;
+
+    usImage *img = nullptr;
+    {
+        std::unique_lock<std::mutex> lck(m_impl->lock);
+        if (m_impl->err)
+            return true;
+        if (!m_impl->spare.empty())
+        {
+            img = m_impl->spare.back();
+            m_impl->spare.pop_back();
+        }
+    }
+    if (!img)
+        img = new usImage();
+
+    if (img->Init(frame.Size))
+    {
+        delete img;
+        return true;
+    }
+
+    // hand the captured pixels to the stacker and give the caller the recycled buffer
+    img->SwapImageData(frame);
+    img->Subframe = frame.Subframe;
+    img->ImgExpDur = frame.ImgExpDur;
+    img->BitsPerPixel = frame.BitsPerPixel;
+
+    {
+        std::unique_lock<std::mutex> lck(m_impl->lock);
+        m_impl->pending.push_back(img);
+    }
+    m_impl->cond.notify_all();
+
+    return false;
+}
+
+bool DarkStacker::Finish(usImage& result)
+{
+    {
+        std::unique_lock<std::mutex> lck(m_impl->lock);
+        m_impl->cond.wait(lck, [this]() { return m_impl->pending.empty() && !m_impl->busy; });
+    }
+
+    if (m_impl->err || m_impl->nframes == 0)
+        return true;
+
+    if (result.Init(m_impl->size))
+        return true;
+
+    Debug.Write(wxString::Format("DarkStacker: combining %d frames, mode = %s\n", m_impl->nframes,
+                                 CombineModeName(m_impl->mode)));
+
+    switch (m_impl->mode)
+    {
+    case DARK_COMBINE_MEAN:
+        return m_impl->CombineMean(result.ImageData);
+    case DARK_COMBINE_SIGMA_CLIP:
+        return m_impl->CombineSigmaClip(result.ImageData);
+    case DARK_COMBINE_MEDIAN:
+        return m_impl->CombineMedian(result.ImageData);
+    }
+
+    return true;
+}
+
+wxString DarkStacker::CombineModeName(DarkCombineMode mode)
+{
+    switch (mode)
+    {
+    case DARK_COMBINE_MEAN:
+        return _("Average");
+    case DARK_COMBINE_SIGMA_CLIP:
+        return _("Sigma-clipped average");
+    case DARK_COMBINE_MEDIAN:
+        return _("Median");
+    }
+    return wxEmptyString;
+}
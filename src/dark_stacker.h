@@ -0,0 +1,86 @@
+/*
+ *  dark_stacker.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef DARK_STACKER_H_INCLUDED
+#define DARK_STACKER_H_INCLUDED
+
+enum DarkCombineMode
+{
+    DARK_COMBINE_MEAN = 0,
+    DARK_COMBINE_SIGMA_CLIP = 1,
+    DARK_COMBINE_MEDIAN = 2,
+};
+
+struct DarkStackerImpl;
+
+// Streaming master dark combiner. Frames handed to Add() are accumulated on a
+// background thread so that accumulation overlaps the next dark exposure.
+//
+//   DARK_COMBINE_MEAN        plain average (the historical behavior)
+//   DARK_COMBINE_SIGMA_CLIP  per-pixel Welford mean/variance plus min/max; at the end the
+//                            extreme samples are rejected when they lie more than ClipSigma
+//                            standard deviations from the mean of the remaining samples
+//   DARK_COMBINE_MEDIAN      frames are spilled to a temporary file and the per-pixel
+//                            median is computed band by band
+//
+// Memory use is bounded: 4 bytes/pixel for mean, 12 bytes/pixel for sigma clip, and a fixed
+// band buffer for median, independent of the number of frames.
+class DarkStacker
+{
+    DarkStackerImpl *m_impl;
+
+    DarkStacker(const DarkStacker&) = delete;
+    DarkStacker& operator=(const DarkStacker&) = delete;
+
+public:
+    // called on the background thread for each frame before it is accumulated
+    typedef std::function<void(usImage&, int)> FrameHook;
+
+    DarkStacker(DarkCombineMode mode, double clipSigma = 3.0);
+    ~DarkStacker();
+
+    void SetFrameHook(const FrameHook& hook);
+
+    // Queue a frame for accumulation. The pixel buffer is taken over by the stacker and
+    // frame is given a recycled buffer of the same size, so the caller can capture the next
+    // frame into it without re-allocating. Returns true on error.
+    bool Add(usImage& frame);
+
+    // Wait for the queued frames to be accumulated and write the combined frame into
+    // result's pixel buffer. Returns true on error.
+    bool Finish(usImage& result);
+
+    static wxString CombineModeName(DarkCombineMode mode);
+};
+
+#endif
@@ -35,6 +35,7 @@
 
 #include "phd.h"
 #include "darks_dialog.h"
+#include "dark_stacker.h"
 #include <wx/valnum.h>
 
 #include <algorithm>
@@ -43,6 +44,7 @@
 static const int DefDarkCount = 5;
 static const int DefDMExpTime = 15;
 static const int DefDMCount = 25;
+static const int DefCombineMode = DARK_COMBINE_SIGMA_CLIP;
 
 static const int MaxNoteLength = 65; // For now
 
@@ -190,8 +192,25 @@ DarksDialog::DarksDialog(wxWindow *parent, bool darkLib)
         pvSizer->Add(pDMapGroup, wxSizerFlags().Border(wxALL, 10));
     }
 
-    // Controls for notes and status
+    // Frame combination method
     wxBoxSizer *phSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxArrayString combineModes;
+    combineModes.Add(DarkStacker::CombineModeName(DARK_COMBINE_MEAN));
+    combineModes.Add(DarkStacker::CombineModeName(DARK_COMBINE_SIGMA_CLIP));
+    combineModes.Add(DarkStacker::CombineModeName(DARK_COMBINE_MEDIAN));
+    m_pCombineMode = new wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, combineModes);
+    m_pCombineMode->SetToolTip(_("How the dark frames are combined into the master dark. Sigma-clipped average and median "
+                                 "reject cosmic ray hits and other transient outliers; average is the fastest."));
+    int combineMode = pConfig->Profile.GetInt("/camera/darks_combine_mode", DefCombineMode);
+    if (combineMode < DARK_COMBINE_MEAN || combineMode > DARK_COMBINE_MEDIAN)
+        combineMode = DefCombineMode;
+    m_pCombineMode->SetSelection(combineMode);
+    phSizer->Add(new wxStaticText(this, wxID_ANY, _("Combine method: ")), wxSizerFlags().Border(wxALL, 5).Center());
+    phSizer->Add(m_pCombineMode, wxSizerFlags().Border(wxALL, 5));
+    pvSizer->Add(phSizer, wxSizerFlags().Border(wxALL, 5));
+
+    // Controls for notes and status
+    phSizer = new wxBoxSizer(wxHORIZONTAL);
     wxStaticText *pNoteLabel = new wxStaticText(this, wxID_ANY, _("Notes: "), wxPoint(-1, -1), wxSize(-1, -1));
     wxSize sz(38 * StringWidth(this, "M"), -1);
     m_pNotes = new wxTextCtrl(this, wxID_ANY, _T(""), wxDefaultPosition, sz);
@@ -416,6 +435,7 @@ void DarksDialog::OnReset(wxCommandEvent& evt)
         m_pNumDefExposures->SetValue(DefDMCount);
         m_pNotes->SetValue("");
     }
+    m_pCombineMode->SetSelection(DefCombineMode);
 }
 
 void DarksDialog::ShowStatus(const wxString msg, bool appending)
@@ -445,6 +465,7 @@ void DarksDialog::SaveProfileInfo()
         pConfig->Profile.SetInt("/camera/dmap_num_frames", m_pNumDefExposures->GetValue());
     }
     pConfig->Profile.SetString("/camera/darks_note", m_pNotes->GetValue());
+    pConfig->Profile.SetInt("/camera/darks_combine_mode", m_pCombineMode->GetSelection());
 }
 
 struct Histogram
@@ -503,7 +524,21 @@ bool DarksDialog::CreateMasterDarkFrame(usImage& darkFrame, int expTime, int fra
     darkFrame.ImgExpDur = expTime;
     darkFrame.ImgStackCnt = frameCount;
 
-    unsigned int *avgimg = 0;
+    // Frames are accumulated on the stacker's background thread while the next
+    // frame is exposing
+    DarkStacker stacker(static_cast<DarkCombineMode>(m_pCombineMode->GetSelection()));
+    stacker.SetFrameHook(
+        [frameCount](usImage& frame, int frameNum)
+        {
+            frame.CalcStats();
+
+            Debug.Write(wxString::Format("dark frame %d/%d stats: bpp %u min %u max %u med %u filtmin %u filtmax %u\n",
+                                         frameNum, frameCount, frame.BitsPerPixel, frame.MinADU, frame.MaxADU,
+                                         frame.MedianADU, frame.FiltMin, frame.FiltMax));
+
+            Histogram h(frame);
+            h.Dump();
+        });
 
     for (int j = 1; j <= frameCount; j++)
     {
@@ -534,42 +569,32 @@ bool DarksDialog::CreateMasterDarkFrame(usImage& darkFrame, int expTime, int fra
         m_pProgress->SetValue(m_pProgress->GetValue() + expTime);
         wxYield();
 
-        darkFrame.CalcStats();
-
-        Debug.Write(wxString::Format("dark frame stats: bpp %u min %u max %u med %u filtmin %u filtmax %u\n",
-                                     darkFrame.BitsPerPixel, darkFrame.MinADU, darkFrame.MaxADU, darkFrame.MedianADU,
-                                     darkFrame.FiltMin, darkFrame.FiltMax));
-
-        Histogram h(darkFrame);
-        h.Dump();
-        wxYield();
-
-        if (!avgimg)
+        err = stacker.Add(darkFrame);
+        if (err)
         {
-            avgimg = new unsigned int[darkFrame.NPixels];
-            memset(avgimg, 0, darkFrame.NPixels * sizeof(*avgimg));
+            ShowStatus(_("Dark frame combine FAILED"), true);
+            break;
         }
-
-        unsigned int *iptr = avgimg;
-        const unsigned short *usptr = darkFrame.ImageData;
-        for (unsigned int i = 0; i < darkFrame.NPixels; i++)
-            *iptr++ += *usptr++;
     }
 
     if (!m_cancelling && !err)
     {
-        ShowStatus(_("Dark frames complete"), true);
-        const unsigned int *iptr = avgimg;
-        unsigned short *usptr = darkFrame.ImageData;
-        for (unsigned int i = 0; i < darkFrame.NPixels; i++)
-            *usptr++ = (unsigned short) (*iptr++ / frameCount);
+        ShowStatus(_("Combining dark frames"), true);
+        wxYield();
+
+        err = stacker.Finish(darkFrame);
+        if (err)
+            ShowStatus(_("Dark frame combine FAILED"), true);
+        else
+        {
+            darkFrame.CalcStats();
+            ShowStatus(_("Dark frames complete"), true);
+        }
     }
 
     m_pProgress->SetValue(m_pProgress->GetValue() + expTime);
     wxYield();
 
-    delete[] avgimg;
-
     return err;
 }
 
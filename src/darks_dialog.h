@@ -49,6 +49,7 @@ private:
     wxSpinCtrl *m_pNumDefExposures;
     wxRadioButton *m_rbModifyDarkLib;
     wxRadioButton *m_rbNewDarkLib;
+    wxChoice *m_pCombineMode;
     wxTextCtrl *m_pNotes;
     wxGauge *m_pProgress;
     wxButton *m_pStartBtn;
@@ -0,0 +1,214 @@
+/*
+ *  defect_learner.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+
+#include <algorithm>
+
+// threshold for an outlier, and the band around the background level the neighbors of an
+// outlier must lie in
+static const double OUTLIER_SIGMA = 5.0;
+static const double NEIGHBOR_SIGMA = 3.0;
+
+DefectLearner::DefectLearner()
+{
+    Reset();
+}
+
+void DefectLearner::Reset()
+{
+    m_size = wxSize();
+    m_offset = wxPoint();
+    m_candidates.clear();
+    m_outliers.clear();
+}
+
+static bool IsMasked(const std::vector<wxRect>& masks, int x, int y)
+{
+    for (const wxRect& r : masks)
+        if (r.Contains(x, y))
+            return true;
+    return false;
+}
+
+// Scan rect (which must leave a 1-pixel margin inside the frame) in tiles the size of a mesh
+// box, with the outlier threshold taken from the background RMS at the tile center. Pixels
+// standing out from their left and right neighbors are picked out first; only those are
+// compared with all 8 neighbors.
+void DefectLearner::FindOutliers(const usImage& img, const BackgroundMesh& mesh, const wxRect& rect,
+                                 const std::vector<wxRect>& masks)
+{
+    int const W = img.Size.GetWidth();
+    int const TILE = BackgroundMesh::BOX_SIZE;
+
+    for (int ty = rect.GetTop(); ty <= rect.GetBottom(); ty += TILE)
+    {
+        int const th = std::min(TILE, rect.GetBottom() + 1 - ty);
+
+        for (int tx = rect.GetLeft(); tx <= rect.GetRight(); tx += TILE)
+        {
+            int const tw = std::min(TILE, rect.GetRight() + 1 - tx);
+
+            double level, rms;
+            if (!mesh.Lookup(tx + tw / 2, ty + th / 2, &level, &rms))
+                continue;
+
+            int const thresh = std::max(2, (int) ceil(OUTLIER_SIGMA * rms));
+            int const lo = (int) floor(level - NEIGHBOR_SIGMA * rms);
+            int const hi = (int) ceil(level + NEIGHBOR_SIGMA * rms);
+
+            for (int y = ty; y < ty + th; y++)
+            {
+                const unsigned short *row = img.ImageData + y * W;
+
+                for (int x = tx; x < tx + tw; x++)
+                {
+                    int const v = row[x];
+                    int const l = row[x - 1];
+                    int const r = row[x + 1];
+
+                    bool hot = v > l + thresh && v > r + thresh;
+                    bool cold = v + thresh < l && v + thresh < r;
+                    if (!hot && !cold)
+                        continue;
+
+                    int nmin = std::min(l, r);
+                    int nmax = std::max(l, r);
+                    for (int dx = -1; dx <= 1; dx++)
+                    {
+                        int const a = row[x + dx - W];
+                        int const b = row[x + dx + W];
+                        nmin = std::min(nmin, std::min(a, b));
+                        nmax = std::max(nmax, std::max(a, b));
+                    }
+
+                    if (nmin < lo || nmax > hi)
+                        continue; // not on plain background
+                    if (hot ? v <= nmax + thresh : v + thresh >= nmin)
+                        continue;
+                    if (IsMasked(masks, x, y))
+                        continue;
+
+                    m_outliers.push_back(y * W + x);
+                }
+            }
+        }
+    }
+}
+
+void DefectLearner::Update(const usImage& img, const BackgroundMesh& mesh, const std::vector<wxRect>& masks,
+                           std::vector<wxPoint> *defects)
+{
+    if (!img.ImageData || !mesh.Covers(img))
+        return;
+
+    wxPoint const offset = img.LimitFrame.GetLeftTop();
+    if (img.Size != m_size || offset != m_offset)
+    {
+        if (!m_candidates.empty())
+            Debug.Write("DefectLearner: frame geometry changed, candidates discarded\n");
+        Reset();
+        m_size = img.Size;
+        m_offset = offset;
+    }
+
+    // the parts of the frame holding valid data, less a 1-pixel border so that every examined
+    // pixel has all of its neighbors
+    std::vector<wxRect> rects;
+    if (!img.ROIs.empty())
+        rects = img.ROIs;
+    else
+        rects.push_back(img.Subframe.IsEmpty() ? wxRect(img.Size) : img.Subframe);
+
+    wxRect const inner = wxRect(img.Size).Deflate(1);
+    for (wxRect& r : rects)
+        r = r.Deflate(1).Intersect(inner);
+
+    m_outliers.clear();
+    for (const wxRect& r : rects)
+        if (!r.IsEmpty())
+            FindOutliers(img, mesh, r, masks);
+    std::sort(m_outliers.begin(), m_outliers.end());
+
+    for (unsigned int idx : m_outliers)
+    {
+        if (m_candidates.size() >= MAX_CANDIDATES)
+            break;
+        Candidate c = { 0, 0 };
+        m_candidates.insert(std::make_pair(idx, c));
+    }
+
+    int const W = img.Size.GetWidth();
+
+    for (auto it = m_candidates.begin(); it != m_candidates.end();)
+    {
+        int const x = it->first % W;
+        int const y = it->first / W;
+
+        bool examined = !IsMasked(masks, x, y);
+        if (examined)
+        {
+            examined = false;
+            for (const wxRect& r : rects)
+            {
+                if (r.Contains(x, y))
+                {
+                    examined = true;
+                    break;
+                }
+            }
+        }
+
+        if (!examined)
+        {
+            ++it;
+            continue;
+        }
+
+        Candidate& c = it->second;
+        ++c.looks;
+        if (std::binary_search(m_outliers.begin(), m_outliers.end(), it->first))
+            ++c.hits;
+
+        if (c.looks - c.hits > MAX_MISSES)
+            it = m_candidates.erase(it);
+        else if (c.looks >= LEARN_FRAMES)
+        {
+            defects->push_back(wxPoint(x + m_offset.x, y + m_offset.y));
+            it = m_candidates.erase(it);
+        }
+        else
+            ++it;
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ *  defect_learner.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef DEFECT_LEARNER_H_INCLUDED
+#define DEFECT_LEARNER_H_INCLUDED
+
+// Finds hot and cold pixels in ordinary guide frames, so a bad-pixel map can be built up while
+// guiding instead of in a separate dark session with the scope capped.
+//
+// A pixel is an outlier in a frame when it is more than OUTLIER_SIGMA background RMS above (hot)
+// or below (cold) all 8 of its neighbors while the neighbors themselves are at the background
+// level. A star spreads its light over several pixels, so stars fail the test; the guide star
+// search regions are masked out as well. Each outlier becomes a candidate that is checked again
+// in every following frame. A candidate that is still an outlier after LEARN_FRAMES frames, with
+// no more than MAX_MISSES misses, is reported as a defect; one that misses more often is
+// dropped, so noise spikes and cosmic-ray hits do not make it into the map.
+class DefectLearner
+{
+    struct Candidate
+    {
+        unsigned short looks; // frames the pixel was examined in
+        unsigned short hits; // frames it was an outlier in
+    };
+
+    wxSize m_size;
+    wxPoint m_offset; // position of the frame on the sensor (the LimitFrame offset)
+    std::map<unsigned int, Candidate> m_candidates; // keyed by pixel index in the frame
+    std::vector<unsigned int> m_outliers;
+
+    void FindOutliers(const usImage& img, const BackgroundMesh& mesh, const wxRect& rect, const std::vector<wxRect>& masks);
+
+public:
+    enum
+    {
+        LEARN_FRAMES = 30,
+        MAX_MISSES = 3,
+        MAX_CANDIDATES = 4096,
+    };
+
+    DefectLearner();
+
+    void Reset();
+
+    // Examine a new frame. mesh must have been updated from img. Pixels inside any of the masks
+    // are not examined. Pixels confirmed as defects by this frame are appended to defects in
+    // sensor coordinates, the frame coordinates plus the LimitFrame offset, as used by DefectMap.
+    void Update(const usImage& img, const BackgroundMesh& mesh, const std::vector<wxRect>& masks,
+                std::vector<wxPoint> *defects);
+
+    unsigned int CandidateCount() const;
+};
+
+inline unsigned int DefectLearner::CandidateCount() const
+{
+    return m_candidates.size();
+}
+
+#endif
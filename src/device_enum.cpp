@@ -0,0 +1,308 @@
+/*
+ *  device_enum.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+
+#if defined(ASCOM_CAMERA)
+# include "cam_ascom.h"
+#endif
+#if defined(GUIDE_ASCOM)
+# include "scope_ascom.h"
+#endif
+#if defined(ROTATOR_ASCOM)
+# include "rotator_ascom.h"
+#endif
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+struct EnumSource
+{
+    const char *key; // profile key of the cached list
+    wxArrayString (*func)(DeviceEnumerator::IdMap *ids);
+    int timeoutMs;
+};
+
+enum
+{
+    ASCOM_ENUM_TIMEOUT_MS = 15000,
+};
+
+static const EnumSource s_sources[DeviceEnumerator::NUM_SOURCES] = {
+#if defined(ASCOM_CAMERA)
+    { "/DeviceCache/ASCOMCameras", &ASCOMCameraFactory::EnumAscomCameras, ASCOM_ENUM_TIMEOUT_MS },
+#else
+    { "/DeviceCache/ASCOMCameras", nullptr, 0 },
+#endif
+#if defined(GUIDE_ASCOM)
+    { "/DeviceCache/ASCOMScopes", &ScopeASCOM::EnumAscomScopes, ASCOM_ENUM_TIMEOUT_MS },
+#else
+    { "/DeviceCache/ASCOMScopes", nullptr, 0 },
+#endif
+#if defined(ROTATOR_ASCOM)
+    { "/DeviceCache/ASCOMRotators", &RotatorAscom::EnumAscomRotators, ASCOM_ENUM_TIMEOUT_MS },
+#else
+    { "/DeviceCache/ASCOMRotators", nullptr, 0 },
+#endif
+};
+
+// Shared with the enumeration threads, which hold a reference of their own: a thread that
+// outlives its timeout keeps running, and one still running at shutdown is detached and
+// may outlive the statics in this file.
+struct EnumState
+{
+    std::mutex lock;
+    std::condition_variable cond;
+    bool running;
+    bool done; // an enumeration finished since the last Refresh()
+    bool shutdown;
+    wxArrayString result;
+    DeviceEnumerator::IdMap ids;
+    std::thread thread;
+
+    EnumState() : running(false), done(false), shutdown(false) { }
+};
+
+static std::shared_ptr<EnumState> s_state[DeviceEnumerator::NUM_SOURCES] = {
+    std::make_shared<EnumState>(),
+    std::make_shared<EnumState>(),
+    std::make_shared<EnumState>(),
+};
+
+// main thread only
+static wxArrayString s_handedOut[DeviceEnumerator::NUM_SOURCES];
+static bool s_listed[DeviceEnumerator::NUM_SOURCES];
+static std::function<void()> s_changeHandler;
+
+static void EnumFinished(DeviceEnumerator::Source src)
+{
+    EnumState& st = *s_state[src];
+
+    wxArrayString list;
+    {
+        std::lock_guard<std::mutex> lck(st.lock);
+        if (!st.done || st.shutdown)
+            return;
+        list = st.result;
+    }
+
+    pConfig->Profile.SetString(s_sources[src].key, wxJoin(list, '\t'));
+
+    if (s_listed[src] && list != s_handedOut[src])
+    {
+        Debug.Write(wxString::Format("DeviceEnum: %s changed\n", s_sources[src].key));
+        if (s_changeHandler)
+            s_changeHandler();
+    }
+}
+
+static void RunEnum(DeviceEnumerator::Source src, std::shared_ptr<EnumState> state)
+{
+#ifdef __WINDOWS__
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+#endif
+
+    wxStopWatch swatch;
+    DeviceEnumerator::IdMap ids;
+    wxArrayString list = s_sources[src].func(&ids);
+    long elapsed = swatch.Time();
+
+#ifdef __WINDOWS__
+    if (SUCCEEDED(hr))
+        CoUninitialize();
+#endif
+
+    EnumState& st = *state;
+    {
+        std::lock_guard<std::mutex> lck(st.lock);
+        st.running = false;
+        // after shutdown the logger and the app may be gone
+        if (!st.shutdown)
+        {
+            st.result = list;
+            st.ids.swap(ids);
+            st.done = true;
+            Debug.Write(wxString::Format("DeviceEnum: %s found %u device(s) in %ld ms\n", s_sources[src].key,
+                                         (unsigned int) list.size(), elapsed));
+            if (wxTheApp)
+                wxTheApp->CallAfter([src]() { EnumFinished(src); });
+        }
+    }
+    st.cond.notify_all();
+}
+
+static void StartEnum(DeviceEnumerator::Source src)
+{
+    if (!s_sources[src].func)
+        return;
+
+    EnumState& st = *s_state[src];
+    std::lock_guard<std::mutex> lck(st.lock);
+    if (st.running || st.shutdown)
+        return;
+    // the previous enumeration has finished and no longer takes the lock
+    if (st.thread.joinable())
+        st.thread.join();
+    st.running = true;
+    st.done = false;
+    st.thread = std::thread(RunEnum, src, s_state[src]);
+}
+
+void DeviceEnumerator::Refresh()
+{
+    for (int i = 0; i < NUM_SOURCES; i++)
+        StartEnum(static_cast<Source>(i));
+}
+
+wxArrayString DeviceEnumerator::List(Source src)
+{
+    const EnumSource& source = s_sources[src];
+    if (!source.func)
+        return wxArrayString();
+
+    EnumState& st = *s_state[src];
+    bool have = false;
+    wxArrayString list;
+
+    {
+        std::lock_guard<std::mutex> lck(st.lock);
+        if (st.done)
+        {
+            list = st.result;
+            have = true;
+        }
+    }
+
+    if (!have)
+    {
+        StartEnum(src);
+
+        if (pConfig->Profile.HasEntry(source.key))
+        {
+            wxString cached = pConfig->Profile.GetString(source.key, wxEmptyString);
+            if (!cached.empty())
+                list = wxSplit(cached, '\t');
+        }
+        else
+        {
+            if (Wait(src))
+                Debug.Write(wxString::Format("DeviceEnum: %s timed out, no cached list\n", source.key));
+
+            std::lock_guard<std::mutex> lck(st.lock);
+            if (st.done)
+                list = st.result;
+        }
+    }
+
+    s_handedOut[src] = list;
+    s_listed[src] = true;
+
+    return list;
+}
+
+bool DeviceEnumerator::Wait(Source src)
+{
+    EnumState& st = *s_state[src];
+    std::unique_lock<std::mutex> lck(st.lock);
+    return !st.cond.wait_for(lck, std::chrono::milliseconds(s_sources[src].timeoutMs), [&st]() { return !st.running; });
+}
+
+bool DeviceEnumerator::GetId(Source src, const wxString& name, wxString *id)
+{
+    const EnumSource& source = s_sources[src];
+    if (!source.func)
+        return true;
+
+    EnumState& st = *s_state[src];
+
+    // the list the device was chosen from may have come from the profile cache before any
+    // enumeration finished
+    bool done;
+    {
+        std::lock_guard<std::mutex> lck(st.lock);
+        done = st.done;
+    }
+    if (!done)
+    {
+        StartEnum(src);
+        if (Wait(src))
+        {
+            Debug.Write(wxString::Format("DeviceEnum: %s timed out looking up '%s'\n", source.key, name));
+            return true;
+        }
+    }
+
+    std::lock_guard<std::mutex> lck(st.lock);
+    if (!st.done)
+        return true;
+    auto it = st.ids.find(name);
+    if (it == st.ids.end())
+    {
+        Debug.Write(wxString::Format("DeviceEnum: %s has no device '%s'\n", source.key, name));
+        return true;
+    }
+    *id = it->second;
+    return false;
+}
+
+void DeviceEnumerator::SetChangeHandler(const std::function<void()>& handler)
+{
+    s_changeHandler = handler;
+}
+
+void DeviceEnumerator::Shutdown()
+{
+    for (int i = 0; i < NUM_SOURCES; i++)
+    {
+        EnumState& st = *s_state[i];
+        std::thread thread;
+        bool running;
+        {
+            std::lock_guard<std::mutex> lck(st.lock);
+            st.shutdown = true;
+            running = st.running;
+            thread.swap(st.thread);
+        }
+        if (!thread.joinable())
+            continue;
+        // a hung driver must not hold up exit; the thread keeps its own reference to the
+        // state and touches nothing else once it sees the shutdown flag
+        if (running)
+            thread.detach();
+        else
+            thread.join();
+    }
+}
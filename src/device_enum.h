@@ -0,0 +1,77 @@
+/*
+ *  device_enum.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef DEVICE_ENUM_H_INCLUDED
+#define DEVICE_ENUM_H_INCLUDED
+
+// Background enumeration of the devices offered in the gear dialog.
+//
+// Some drivers, ASCOM in particular, take seconds to list their devices. Refresh() starts
+// all the enumerations at once, each on its own thread. List() returns the result of the
+// current enumeration if it has finished, else the list cached in the profile by the last
+// one; only when there is no cached list does it wait for the enumeration, for at most
+// that source's timeout. When an enumeration finishes with a different list than List()
+// handed out, the change handler is called on the main thread so the gear dialog can
+// reload its choices.
+//
+// Each enumeration also returns the ids (ASCOM progids) of the devices it listed, keyed
+// by the names in the list; drivers look up the id of the chosen device with GetId().
+class DeviceEnumerator
+{
+public:
+    typedef std::map<wxString, wxString> IdMap;
+
+    enum Source
+    {
+        ASCOM_CAMERAS,
+        ASCOM_SCOPES,
+        ASCOM_ROTATORS,
+        NUM_SOURCES
+    };
+
+    // start enumerating all sources that are not already being enumerated
+    static void Refresh();
+    static wxArrayString List(Source src);
+    // wait for a running enumeration of src, for at most its timeout. Returns true if it
+    // timed out.
+    static bool Wait(Source src);
+    // Look up the id of the device listed as name, enumerating src first if no
+    // enumeration has finished. Returns true on error: timeout or name not found.
+    static bool GetId(Source src, const wxString& name, wxString *id);
+    static void SetChangeHandler(const std::function<void()>& handler);
+    // stop delivering results; enumerations still running are abandoned
+    static void Shutdown();
+};
+
+#endif
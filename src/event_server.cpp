@@ -45,6 +45,8 @@ EventServer EvtServer;
 wxBEGIN_EVENT_TABLE(EventServer, wxEvtHandler)
     EVT_SOCKET(EVENT_SERVER_ID, EventServer::OnEventServerEvent)
     EVT_SOCKET(EVENT_SERVER_CLIENT_ID, EventServer::OnEventServerClientEvent)
+    EVT_SOCKET(METRICS_SERVER_ID, EventServer::OnMetricsServerEvent)
+    EVT_SOCKET(METRICS_SERVER_CLIENT_ID, EventServer::OnMetricsClientEvent)
 wxEND_EVENT_TABLE();
 // clang-format on
 
@@ -2351,6 +2353,77 @@ static void export_config_settings(JObj& response, const json_value *params)
     response << jrpc_result(rslt);
 }
 
+static void get_metrics(JObj& response, const json_value *params)
+{
+    response << jrpc_result(Metrics.FormatPrometheus());
+}
+
+static void get_frame_ring(JObj& response, const json_value *params)
+{
+    const FrameRing& ring = pFrame->pGuider->GetFrameRing();
+
+    JObj rslt;
+    rslt << NV("enabled", ring.IsEnabled()) << NV("name", ring.SegmentName()) << NV("slots", ring.SlotCount());
+
+    response << jrpc_result(rslt);
+}
+
+static void set_frame_trace(JObj& response, const json_value *params)
+{
+    Params p("enabled", params);
+    const json_value *val = p.param("enabled");
+    bool enable;
+    if (!val || !bool_param(val, &enable))
+    {
+        response << jrpc_error(JSONRPC_INVALID_PARAMS, "expected enabled boolean param");
+        return;
+    }
+
+    if (!FrameTrace::Available())
+    {
+        response << jrpc_error(1, "frame tracing is not available in this build");
+        return;
+    }
+
+    if (enable)
+        FrameTrace::Start();
+    else
+        FrameTrace::Stop();
+
+    response << jrpc_result(0);
+}
+
+static void export_frame_trace(JObj& response, const json_value *params)
+{
+    if (!FrameTrace::Available())
+    {
+        response << jrpc_error(1, "frame tracing is not available in this build");
+        return;
+    }
+
+    wxString filename(MyFrame::GetDefaultFileDir() + PATHSEPSTR + "phd2_frame_trace.json");
+    if (FrameTrace::WriteChromeTrace(filename))
+    {
+        response << jrpc_error(1, "export frame trace failed");
+        return;
+    }
+
+    JAry stages;
+    for (const FrameTraceStageStats& st : FrameTrace::GetStageStats())
+    {
+        JObj stage;
+        stage << NV("name", st.name) << NV("count", st.count) << NV("mean", st.mean, 3) << NV("p50", st.p50, 3)
+              << NV("p90", st.p90, 3) << NV("p99", st.p99, 3) << NV("max", st.max, 3) << NV("histogram", st.histogram);
+        stages << stage;
+    }
+
+    JObj rslt;
+    rslt << NV("filename", filename) << NV("running", FrameTrace::IsRunning()) << NV("frames", FrameTrace::Frames())
+         << NV("bucket_bounds", FrameTrace::HistogramBounds()) << NV("stages", stages);
+
+    response << jrpc_result(rslt);
+}
+
 struct JRpcCall
 {
     wxSocketClient *cli;
@@ -2461,6 +2534,10 @@ static bool handle_request(JRpcCall& call)
         { "set_cooler_state", &set_cooler_state },
         { "get_ccd_temperature", &get_sensor_temperature },
         { "export_config_settings", &export_config_settings },
+        { "get_metrics", &get_metrics },
+        { "get_frame_ring", &get_frame_ring },
+        { "set_frame_trace", &set_frame_trace },
+        { "export_frame_trace", &export_frame_trace },
         { "get_variable_delay_settings", &get_variable_delay_settings },
         { "set_variable_delay_settings", &set_variable_delay_settings },
         { "get_limit_frame", &get_limit_frame },
@@ -2603,7 +2680,7 @@ static void handle_cli_input(wxSocketClient *cli)
     }
 }
 
-EventServer::EventServer() : m_configEventDebouncer(nullptr) { }
+EventServer::EventServer() : m_metricsSocket(nullptr), m_configEventDebouncer(nullptr) { }
 
 EventServer::~EventServer() { }
 
@@ -2636,9 +2713,38 @@ bool EventServer::EventServerStart(unsigned int instanceId)
 
     Debug.Write(wxString::Format("event server started, listening on port %u\n", port));
 
+    StartMetricsServer(instanceId);
+
     return false;
 }
 
+void EventServer::StartMetricsServer(unsigned int instanceId)
+{
+    int basePort = pConfig->Global.GetInt("/MetricsServerPort", 0);
+    if (basePort <= 0)
+        return;
+
+    unsigned int port = basePort + instanceId - 1;
+    wxIPV4address addr;
+    addr.LocalHost();
+    addr.Service(port);
+    m_metricsSocket = new wxSocketServer(addr, wxSOCKET_REUSEADDR);
+
+    if (!m_metricsSocket->Ok())
+    {
+        Debug.Write(wxString::Format("Metrics server failed to start - Could not listen at port %u\n", port));
+        delete m_metricsSocket;
+        m_metricsSocket = nullptr;
+        return;
+    }
+
+    m_metricsSocket->SetEventHandler(*this, METRICS_SERVER_ID);
+    m_metricsSocket->SetNotify(wxSOCKET_CONNECTION_FLAG);
+    m_metricsSocket->Notify(true);
+
+    Debug.Write(wxString::Format("metrics server started, listening on localhost port %u\n", port));
+}
+
 void EventServer::EventServerStop()
 {
     if (!m_serverSocket)
@@ -2656,6 +2762,9 @@ void EventServer::EventServerStop()
     delete m_configEventDebouncer;
     m_configEventDebouncer = nullptr;
 
+    delete m_metricsSocket;
+    m_metricsSocket = nullptr;
+
     Debug.AddLine("event server stopped");
 }
 
@@ -2708,6 +2817,56 @@ void EventServer::OnEventServerClientEvent(wxSocketEvent& event)
     }
 }
 
+void EventServer::OnMetricsServerEvent(wxSocketEvent& event)
+{
+    wxSocketServer *server = static_cast<wxSocketServer *>(event.GetSocket());
+
+    if (event.GetSocketEvent() != wxSOCKET_CONNECTION)
+        return;
+
+    wxSocketBase *client = server->Accept(false);
+
+    if (!client)
+        return;
+
+    client->SetEventHandler(*this, METRICS_SERVER_CLIENT_ID);
+    client->SetNotify(wxSOCKET_LOST_FLAG | wxSOCKET_INPUT_FLAG);
+    client->SetFlags(wxSOCKET_NOWAIT);
+    client->Notify(true);
+}
+
+// Any request is answered with the metrics text and the connection is closed, which is all a
+// Prometheus scraper (or curl) needs.
+void EventServer::OnMetricsClientEvent(wxSocketEvent& event)
+{
+    wxSocketBase *cli = event.GetSocket();
+
+    if (event.GetSocketEvent() == wxSOCKET_INPUT)
+    {
+        // discard the request
+        char buf[1024];
+        do
+        {
+            cli->Read(buf, sizeof(buf));
+        } while (cli->LastReadCount() == sizeof(buf));
+
+        wxCharBuffer body = Metrics.FormatPrometheus().ToUTF8();
+        wxCharBuffer header = wxString::Format("HTTP/1.0 200 OK\r\n"
+                                               "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                                               "Content-Length: %u\r\n"
+                                               "Connection: close\r\n\r\n",
+                                               (unsigned int) body.length())
+                                  .ToUTF8();
+
+        cli->Notify(false);
+        cli->SetFlags(wxSOCKET_WAITALL);
+        cli->Write(header.data(), header.length());
+        cli->Write(body.data(), body.length());
+    }
+
+    cli->Destroy();
+}
+
 void EventServer::NotifyStartCalibration(const Mount *mount)
 {
     SIMPLE_NOTIFY_EV(ev_start_calibration(mount));
@@ -2877,6 +3036,8 @@ void EventServer::NotifyGuideStep(const GuideStepInfo& step)
     if (m_eventServerClients.empty())
         return;
 
+    FRAME_TRACE_SPAN("EventServer::NotifyGuideStep");
+
     Ev ev("GuideStep");
 
     ev << NV("Frame", step.frameNumber) << NV("Time", step.time, 3) << NVMount(step.mount) << NV("dx", step.cameraOffset.X, 3)
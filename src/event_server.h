@@ -46,6 +46,7 @@ public:
 private:
     wxSocketServer *m_serverSocket;
     CliSockSet m_eventServerClients;
+    wxSocketServer *m_metricsSocket;
     wxTimer *m_configEventDebouncer;
 
 public:
@@ -88,6 +89,9 @@ public:
 private:
     void OnEventServerEvent(wxSocketEvent& evt);
     void OnEventServerClientEvent(wxSocketEvent& evt);
+    void StartMetricsServer(unsigned int instanceId);
+    void OnMetricsServerEvent(wxSocketEvent& evt);
+    void OnMetricsClientEvent(wxSocketEvent& evt);
 
     wxDECLARE_EVENT_TABLE();
 };
@@ -0,0 +1,312 @@
+/*
+ *  frame_ring.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+
+#ifdef __WINDOWS__
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+static const unsigned int MAX_SLOTS = 64;
+
+static size_t AlignUp(size_t n)
+{
+    return (n + 63) & ~(size_t) 63;
+}
+
+struct FrameRingSegment
+{
+    wxString name;
+    unsigned char *base;
+    size_t size;
+#ifdef __WINDOWS__
+    HANDLE mapping;
+#endif
+
+    FrameRingSegment()
+        : base(nullptr), size(0)
+#ifdef __WINDOWS__
+          ,
+          mapping(nullptr)
+#endif
+    {
+    }
+
+    FrameRingHeader *Header() const { return reinterpret_cast<FrameRingHeader *>(base); }
+    FrameRingSlot *Slot(unsigned int i) const
+    {
+        const FrameRingHeader *hdr = Header();
+        return reinterpret_cast<FrameRingSlot *>(base + hdr->slotOffset + (size_t) i * hdr->slotBytes);
+    }
+    unsigned short *Pixels(FrameRingSlot *slot) const
+    {
+        return reinterpret_cast<unsigned short *>(reinterpret_cast<unsigned char *>(slot) + Header()->pixelOffset);
+    }
+
+    bool Map(size_t sz);
+    void Unmap();
+};
+
+bool FrameRingSegment::Map(size_t sz)
+{
+#ifdef __WINDOWS__
+
+    mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD) ((unsigned long long) sz >> 32),
+                                 (DWORD) (sz & 0xffffffff), name.wc_str());
+    if (!mapping)
+        return true;
+
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        // a reader still holds the previous segment, which may be too small
+        Debug.Write(wxString::Format("FrameRing: %s is still open in another process\n", name));
+        Unmap();
+        return true;
+    }
+
+    base = static_cast<unsigned char *>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sz));
+    if (!base)
+    {
+        Unmap();
+        return true;
+    }
+
+#else // __WINDOWS__
+
+    // replace any segment left behind by a previous run
+    shm_unlink(name.fn_str());
+
+    int fd = shm_open(name.fn_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1)
+        return true;
+
+    if (ftruncate(fd, (off_t) sz) != 0)
+    {
+        close(fd);
+        shm_unlink(name.fn_str());
+        return true;
+    }
+
+    void *p = mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps its own reference
+    if (p == MAP_FAILED)
+    {
+        shm_unlink(name.fn_str());
+        return true;
+    }
+    base = static_cast<unsigned char *>(p);
+
+#endif // __WINDOWS__
+
+    size = sz;
+    return false;
+}
+
+void FrameRingSegment::Unmap()
+{
+#ifdef __WINDOWS__
+    if (base)
+        UnmapViewOfFile(base);
+    if (mapping)
+        CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    if (base)
+    {
+        munmap(base, size);
+        shm_unlink(name.fn_str());
+    }
+#endif
+    base = nullptr;
+    size = 0;
+}
+
+FrameRing::FrameRing() : m_seg(nullptr), m_slots(0), m_seq(0), m_failed(false) { }
+
+FrameRing::~FrameRing()
+{
+    Close();
+}
+
+void FrameRing::LoadSettings()
+{
+    unsigned int slots = std::min((unsigned int) std::max(pConfig->Global.GetInt("/FrameRingSlots", 0), 0), MAX_SLOTS);
+    if (slots != m_slots)
+    {
+        Close();
+        m_slots = slots;
+        m_failed = false;
+    }
+}
+
+bool FrameRing::IsEnabled() const
+{
+    return m_slots > 0 && !m_failed;
+}
+
+wxString FrameRing::SegmentName() const
+{
+#ifdef __WINDOWS__
+    return wxString::Format("Local\\phd2_frames_%d", wxGetApp().GetInstanceNumber());
+#else
+    return wxString::Format("/phd2_frames_%d", wxGetApp().GetInstanceNumber());
+#endif
+}
+
+bool FrameRing::Create(unsigned int maxPixels)
+{
+    Close();
+
+    size_t const slotOffset = AlignUp(sizeof(FrameRingHeader));
+    size_t const pixelOffset = AlignUp(sizeof(FrameRingSlot));
+    size_t const slotBytes = AlignUp(pixelOffset + (size_t) maxPixels * sizeof(unsigned short));
+    size_t const size = slotOffset + m_slots * slotBytes;
+
+    if (slotBytes > 0xffffffffU)
+        return true;
+
+    FrameRingSegment *seg = new FrameRingSegment();
+    seg->name = SegmentName();
+    if (seg->Map(size))
+    {
+        Debug.Write(wxString::Format("FrameRing: could not create shared memory %s of %llu bytes\n", seg->name,
+                                     (unsigned long long) size));
+        delete seg;
+        return true;
+    }
+
+    FrameRingHeader *hdr = seg->Header();
+    hdr->magic = FRAME_RING_MAGIC;
+    hdr->version = FRAME_RING_VERSION;
+    hdr->slotCount = m_slots;
+    hdr->slotBytes = (uint32_t) slotBytes;
+    hdr->slotOffset = (uint32_t) slotOffset;
+    hdr->pixelOffset = (uint32_t) pixelOffset;
+    hdr->maxPixels = maxPixels;
+    hdr->latest.store(0, std::memory_order_relaxed);
+    hdr->valid.store(1, std::memory_order_release);
+
+    m_seg = seg;
+    m_seq = 0;
+
+    Debug.Write(wxString::Format("FrameRing: publishing frames to %s, %u slots of %u pixels\n", seg->name, m_slots, maxPixels));
+    return false;
+}
+
+void FrameRing::Close()
+{
+    if (!m_seg)
+        return;
+
+    m_seg->Header()->valid.store(0, std::memory_order_release);
+    m_seg->Unmap();
+    delete m_seg;
+    m_seg = nullptr;
+}
+
+void FrameRing::Publish(const usImage& img, int guiderState, const std::vector<const Star *>& stars, const PHD_Point& lockPos)
+{
+    if (!IsEnabled() || !img.ImageData)
+        return;
+
+    if (!m_seg || m_seg->Header()->maxPixels < img.NPixels)
+    {
+        // size the slots for the unbinned sensor, so that a binning change does not force
+        // readers to reopen the segment
+        unsigned int maxPixels = img.NPixels;
+        if (pCamera && pCamera->FrameSize.GetWidth() > 0 && pCamera->FrameSize.GetHeight() > 0)
+        {
+            unsigned int const b = pCamera->GetBinning();
+            maxPixels = std::max(maxPixels, pCamera->FrameSize.GetWidth() * b * pCamera->FrameSize.GetHeight() * b);
+        }
+
+        if (Create(maxPixels))
+        {
+            m_failed = true;
+            return;
+        }
+    }
+
+    FrameRingHeader *hdr = m_seg->Header();
+    uint32_t const seq = ++m_seq;
+    FrameRingSlot *slot = m_seg->Slot((seq - 1) % hdr->slotCount);
+
+    slot->seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->frameNum = img.FrameNum;
+    slot->startTime = img.ImgStartTime.IsValid() ? img.ImgStartTime.GetValue().GetValue() : 0;
+    slot->publishTime = wxGetUTCTimeMillis().GetValue();
+    slot->exposureMs = img.ImgExpDur;
+    slot->width = img.Size.GetWidth();
+    slot->height = img.Size.GetHeight();
+    slot->subframe[0] = img.Subframe.GetX();
+    slot->subframe[1] = img.Subframe.GetY();
+    slot->subframe[2] = img.Subframe.GetWidth();
+    slot->subframe[3] = img.Subframe.GetHeight();
+    slot->frameOrigin[0] = img.LimitFrame.GetX();
+    slot->frameOrigin[1] = img.LimitFrame.GetY();
+    slot->binning = img.Binning;
+    slot->bitsPerPixel = img.BitsPerPixel;
+    slot->gain = img.Gain;
+    slot->pedestal = img.Pedestal;
+    slot->guiderState = guiderState;
+    slot->lockValid = lockPos.IsValid();
+    slot->lockX = lockPos.IsValid() ? (float) lockPos.X : 0.f;
+    slot->lockY = lockPos.IsValid() ? (float) lockPos.Y : 0.f;
+
+    unsigned int n = 0;
+    for (const Star *star : stars)
+    {
+        if (n == FRAME_RING_MAX_STARS)
+            break;
+        FrameRingStar& s = slot->stars[n++];
+        s.x = (float) star->X;
+        s.y = (float) star->Y;
+        s.snr = (float) star->SNR;
+        s.hfd = (float) star->HFD;
+        s.mass = (float) star->Mass;
+    }
+    slot->starCount = n;
+
+    memcpy(m_seg->Pixels(slot), img.ImageData, img.NPixels * sizeof(unsigned short));
+
+    slot->seq.store(seq, std::memory_order_release);
+    hdr->latest.store(seq, std::memory_order_release);
+}
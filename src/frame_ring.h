@@ -0,0 +1,144 @@
+/*
+ *  frame_ring.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef FRAME_RING_H_INCLUDED
+#define FRAME_RING_H_INCLUDED
+
+#include <atomic>
+#include <stdint.h>
+
+// Publishes each processed frame to local readers through a shared memory ring buffer, so
+// tools on the same machine can follow the guide frames without saving and re-reading FITS
+// files.
+//
+// The segment is the POSIX shared memory object "/phd2_frames_<instance>" (on Windows, the named
+// mapping "Local\phd2_frames_<instance>"). It starts with a FrameRingHeader, followed by
+// slotCount slots of slotBytes each. A slot holds a FrameRingSlot followed by the frame's
+// 16-bit pixels, row by row.
+//
+// The writer never waits for readers. Before overwriting a slot it sets the slot's seq to 0,
+// and when the frame is complete it sets seq to the frame's sequence number (1, 2, 3, ...)
+// and then the header's latest. A reader loads latest, takes slot (latest - 1) % slotCount,
+// checks that the slot's seq equals latest, uses the frame in place, and then loads seq
+// again: if it has changed the slot was overwritten in the meantime and the frame must be
+// discarded. When the writer has to replace the segment (for a larger frame) or exits, it
+// clears the header's valid flag; readers should then close and reopen the segment.
+//
+// The ring is enabled by the global setting /FrameRingSlots (the number of slots, 0 = off).
+
+enum
+{
+    FRAME_RING_MAGIC = 0x52444850, // "PHDR"
+    FRAME_RING_VERSION = 1,
+    FRAME_RING_MAX_STARS = 16,
+};
+
+struct FrameRingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> valid;
+    std::atomic<uint32_t> latest; // sequence number of the newest complete frame, 0 = none yet
+    uint32_t slotCount;
+    uint32_t slotBytes; // distance between slots
+    uint32_t slotOffset; // offset of the first slot from the start of the segment
+    uint32_t pixelOffset; // offset of the pixels from the start of a slot
+    uint32_t maxPixels; // pixel capacity of a slot
+};
+
+struct FrameRingStar
+{
+    float x; // frame coordinates
+    float y;
+    float snr;
+    float hfd;
+    float mass;
+};
+
+struct FrameRingSlot
+{
+    std::atomic<uint32_t> seq; // 0 while the slot is being written
+    uint32_t frameNum;
+    int64_t startTime; // exposure start, milliseconds since the Unix epoch (UTC)
+    int64_t publishTime;
+    uint32_t exposureMs;
+    uint32_t width;
+    uint32_t height;
+    int32_t subframe[4]; // x, y, width, height; all 0 for a full frame
+    int32_t frameOrigin[2]; // position of the frame on the sensor (the frame limit offset)
+    uint32_t binning;
+    uint32_t bitsPerPixel;
+    uint32_t gain;
+    uint32_t pedestal;
+    uint32_t guiderState;
+    uint32_t lockValid;
+    float lockX;
+    float lockY;
+    uint32_t starCount; // stars found in the frame, primary star first
+    FrameRingStar stars[FRAME_RING_MAX_STARS];
+};
+
+struct FrameRingSegment;
+
+class FrameRing
+{
+    FrameRingSegment *m_seg;
+    unsigned int m_slots; // configured slot count
+    uint32_t m_seq;
+    bool m_failed;
+
+    bool Create(unsigned int maxPixels);
+    void Close();
+
+public:
+    FrameRing();
+    ~FrameRing();
+
+    // read the slot count from the settings; a change takes effect with the next frame
+    void LoadSettings();
+
+    bool IsEnabled() const;
+    wxString SegmentName() const;
+    unsigned int SlotCount() const;
+
+    // Copy a processed frame into the next slot, with the stars found in it and the lock
+    // position.
+    void Publish(const usImage& img, int guiderState, const std::vector<const Star *>& stars, const PHD_Point& lockPos);
+};
+
+inline unsigned int FrameRing::SlotCount() const
+{
+    return m_slots;
+}
+
+#endif
@@ -0,0 +1,290 @@
+/*
+ *  frame_trace.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// spans kept per thread; older spans are overwritten once the buffer is full
+static const size_t MAX_SPANS_PER_THREAD = 16384;
+
+struct TraceSpan
+{
+    const char *name;
+    long long start;
+    long long duration;
+    unsigned int frame;
+};
+
+struct TraceThreadBuffer
+{
+    std::mutex mutex;
+    int tid;
+    bool isMain;
+    std::vector<TraceSpan> spans;
+    size_t next;
+    bool wrapped;
+
+    TraceThreadBuffer(int tid_, bool isMain_) : tid(tid_), isMain(isMain_), spans(MAX_SPANS_PER_THREAD), next(0), wrapped(false)
+    {
+    }
+};
+
+std::atomic<bool> FrameTrace::s_running(false);
+
+static std::atomic<unsigned int> s_frame(0);
+static std::atomic<long long> s_startTime(0);
+
+// buffers are never freed so that spans recorded by threads that have since exited can
+// still be exported
+static std::mutex s_buffersMutex;
+static std::vector<std::unique_ptr<TraceThreadBuffer>> s_buffers;
+static thread_local TraceThreadBuffer *t_buffer;
+
+static TraceThreadBuffer *RegisterThread()
+{
+    std::lock_guard<std::mutex> lck(s_buffersMutex);
+    s_buffers.emplace_back(new TraceThreadBuffer(static_cast<int>(s_buffers.size()) + 1, wxThread::IsMain()));
+    return s_buffers.back().get();
+}
+
+bool FrameTrace::Available()
+{
+#ifdef PHD_FRAME_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FrameTrace::Start()
+{
+    std::lock_guard<std::mutex> lck(s_buffersMutex);
+
+    for (auto& buf : s_buffers)
+    {
+        std::lock_guard<std::mutex> lck2(buf->mutex);
+        buf->next = 0;
+        buf->wrapped = false;
+    }
+
+    s_frame = 0;
+    s_startTime = Now();
+    s_running = true;
+
+    Debug.Write("Frame trace started\n");
+}
+
+void FrameTrace::Stop()
+{
+    s_running = false;
+    Debug.Write(wxString::Format("Frame trace stopped after %u frames\n", Frames()));
+}
+
+void FrameTrace::NewFrame()
+{
+    if (IsRunning())
+        ++s_frame;
+}
+
+unsigned int FrameTrace::Frames()
+{
+    return s_frame;
+}
+
+long long FrameTrace::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FrameTrace::Record(const char *name, unsigned int frame, long long start, long long end)
+{
+    TraceThreadBuffer *buf = t_buffer;
+    if (!buf)
+        buf = t_buffer = RegisterThread();
+
+    // only contended while the trace is being exported
+    std::lock_guard<std::mutex> lck(buf->mutex);
+
+    TraceSpan& span = buf->spans[buf->next];
+    span.name = name;
+    span.start = start;
+    span.duration = end - start;
+    span.frame = frame;
+
+    if (++buf->next == buf->spans.size())
+    {
+        buf->next = 0;
+        buf->wrapped = true;
+    }
+}
+
+struct ThreadSpans
+{
+    int tid;
+    bool isMain;
+    std::vector<TraceSpan> spans;
+};
+
+static std::vector<ThreadSpans> Snapshot()
+{
+    std::vector<ThreadSpans> ret;
+    long long startTime = s_startTime;
+
+    std::lock_guard<std::mutex> lck(s_buffersMutex);
+
+    for (auto& buf : s_buffers)
+    {
+        std::lock_guard<std::mutex> lck2(buf->mutex);
+
+        ThreadSpans ts;
+        ts.tid = buf->tid;
+        ts.isMain = buf->isMain;
+
+        // oldest first
+        if (buf->wrapped)
+            ts.spans.insert(ts.spans.end(), buf->spans.begin() + buf->next, buf->spans.end());
+        ts.spans.insert(ts.spans.end(), buf->spans.begin(), buf->spans.begin() + buf->next);
+
+        // drop spans that began before the trace was (re)started
+        ts.spans.erase(std::remove_if(ts.spans.begin(), ts.spans.end(),
+                                      [startTime](const TraceSpan& s) { return s.start < startTime; }),
+                       ts.spans.end());
+
+        if (!ts.spans.empty())
+            ret.push_back(std::move(ts));
+    }
+
+    return ret;
+}
+
+bool FrameTrace::WriteChromeTrace(const wxString& filename)
+{
+    std::vector<ThreadSpans> threads = Snapshot();
+    long long startTime = s_startTime;
+
+    wxFFile file(filename, "w");
+    if (!file.IsOpened())
+    {
+        Debug.Write(wxString::Format("Frame trace: cannot open %s\n", filename));
+        return true;
+    }
+
+    file.Write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    bool first = true;
+    for (const ThreadSpans& ts : threads)
+    {
+        wxString threadName = ts.isMain ? wxString("main") : wxString::Format("worker %d", ts.tid);
+        file.Write(wxString::Format("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                                    first ? "" : ",\n", ts.tid, threadName));
+        first = false;
+
+        for (const TraceSpan& s : ts.spans)
+        {
+            file.Write(wxString::Format(",\n{\"name\":\"%s\",\"cat\":\"phd2\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,"
+                                        "\"tid\":%d,\"args\":{\"frame\":%u}}",
+                                        s.name, (s.start - startTime) / 1000.0, s.duration / 1000.0, ts.tid, s.frame));
+        }
+    }
+
+    file.Write("\n]}\n");
+
+    bool err = file.Error();
+    file.Close();
+
+    Debug.Write(wxString::Format("Frame trace written to %s\n", filename));
+
+    return err;
+}
+
+const std::vector<double>& FrameTrace::HistogramBounds()
+{
+    static const std::vector<double> bounds = { 0.1, 0.2, 0.5, 1., 2., 5., 10., 20., 50., 100., 200., 500., 1000., 2000., 5000. };
+    return bounds;
+}
+
+std::vector<FrameTraceStageStats> FrameTrace::GetStageStats()
+{
+    std::vector<ThreadSpans> threads = Snapshot();
+
+    // the same literal may have different addresses in different translation units
+    std::map<std::string, std::pair<const char *, std::vector<double>>> stages;
+    for (const ThreadSpans& ts : threads)
+    {
+        for (const TraceSpan& s : ts.spans)
+        {
+            auto& stage = stages[s.name];
+            stage.first = s.name;
+            stage.second.push_back(s.duration / 1e6);
+        }
+    }
+
+    const std::vector<double>& bounds = HistogramBounds();
+
+    std::vector<FrameTraceStageStats> ret;
+    for (auto& entry : stages)
+    {
+        std::vector<double>& ms = entry.second.second;
+        std::sort(ms.begin(), ms.end());
+
+        FrameTraceStageStats st;
+        st.name = entry.second.first;
+        st.count = ms.size();
+
+        double sum = 0.;
+        for (double v : ms)
+            sum += v;
+        st.mean = sum / ms.size();
+
+        auto pct = [&ms](double p) { return ms[std::min(ms.size() - 1, static_cast<size_t>(p * ms.size()))]; };
+        st.p50 = pct(0.50);
+        st.p90 = pct(0.90);
+        st.p99 = pct(0.99);
+        st.max = ms.back();
+
+        st.histogram.assign(bounds.size() + 1, 0);
+        for (double v : ms)
+            ++st.histogram[std::lower_bound(bounds.begin(), bounds.end(), v) - bounds.begin()];
+
+        ret.push_back(std::move(st));
+    }
+
+    return ret;
+}
@@ -0,0 +1,126 @@
+/*
+ *  frame_trace.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef FRAME_TRACE_H_INCLUDED
+#define FRAME_TRACE_H_INCLUDED
+
+#include <atomic>
+#include <vector>
+
+// Per-frame latency tracing.
+//
+// FRAME_TRACE_SPAN("name") records the time spent in the rest of the enclosing scope,
+// tagged with the number of the frame being processed. Spans are appended to a buffer owned
+// by the recording thread, so threads never contend with each other while recording; the
+// buffers are only walked when the trace is exported. When tracing is not running a span
+// costs one relaxed atomic load.
+//
+// Tracing is compiled in when PHD_FRAME_TRACE is defined (the PHD2_FRAME_TRACE cmake
+// option); otherwise the macros expand to nothing and Available() returns false.
+
+struct FrameTraceStageStats
+{
+    const char *name;
+    unsigned int count;
+    double mean; // milliseconds
+    double p50;
+    double p90;
+    double p99;
+    double max;
+    std::vector<unsigned int> histogram; // counts per HistogramBounds() bucket
+};
+
+class FrameTrace
+{
+    static std::atomic<bool> s_running;
+
+public:
+    static bool Available();
+    static bool IsRunning() { return s_running.load(std::memory_order_relaxed); }
+
+    // Start() discards previously recorded spans
+    static void Start();
+    static void Stop();
+
+    // called when the exposure of a new frame begins
+    static void NewFrame();
+    static unsigned int Frames();
+
+    static long long Now(); // nanoseconds, monotonic
+    // frame is the frame current when the span started, a span can end after the next frame began
+    static void Record(const char *name, unsigned int frame, long long start, long long end);
+
+    // Write the recorded spans in Chrome trace event format (loadable in Perfetto or
+    // chrome://tracing). Returns true on error.
+    static bool WriteChromeTrace(const wxString& filename);
+    static std::vector<FrameTraceStageStats> GetStageStats();
+    // upper bounds in milliseconds of the histogram buckets; the last bucket is unbounded
+    static const std::vector<double>& HistogramBounds();
+};
+
+class FrameTraceSpan
+{
+    const char *m_name;
+    unsigned int m_frame;
+    long long m_start;
+
+public:
+    explicit FrameTraceSpan(const char *name)
+        : m_name(name), m_frame(FrameTrace::Frames()), m_start(FrameTrace::IsRunning() ? FrameTrace::Now() : -1)
+    {
+    }
+    ~FrameTraceSpan()
+    {
+        if (m_start >= 0)
+            FrameTrace::Record(m_name, m_frame, m_start, FrameTrace::Now());
+    }
+};
+
+#ifdef PHD_FRAME_TRACE
+# define FRAME_TRACE_CONCAT2(a, b) a##b
+# define FRAME_TRACE_CONCAT(a, b) FRAME_TRACE_CONCAT2(a, b)
+# define FRAME_TRACE_SPAN(name) FrameTraceSpan FRAME_TRACE_CONCAT(frameTraceSpan_, __LINE__)(name)
+# define FRAME_TRACE_NEW_FRAME() FrameTrace::NewFrame()
+#else
+# define FRAME_TRACE_SPAN(name)                                                                                               \
+     do                                                                                                                        \
+     {                                                                                                                         \
+     } while (false)
+# define FRAME_TRACE_NEW_FRAME()                                                                                              \
+     do                                                                                                                        \
+     {                                                                                                                         \
+     } while (false)
+#endif
+
+#endif
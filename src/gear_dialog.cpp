@@ -171,6 +171,8 @@ GearDialog::~GearDialog()
     pRotator = nullptr;
 
     delete m_menuProfileManage;
+
+    DeviceEnumerator::SetChangeHandler(nullptr);
 }
 
 static wxToggleButton *MakeConnectBtn(wxWindow *parent, wxWindowID id)
@@ -366,6 +368,8 @@ void GearDialog::Initialize()
     // preselect the choices
     LoadGearChoices();
 
+    DeviceEnumerator::SetChangeHandler([this]() { ReloadDeviceChoices(); });
+
     m_showMoreGear = m_pStepGuider || m_pRotator;
     ShowMoreGear();
 
@@ -447,8 +451,33 @@ static wxString NewAoName(const wxString& oldname)
 }
 #endif
 
+static void ReloadChoices(wxChoice *ctl, void (*load)(wxChoice *))
+{
+    // keep the current selection even if its device was not found this time
+    wxString selection = ctl->GetStringSelection();
+    load(ctl);
+    if (selection.empty())
+        return;
+    SetMatchingSelection(ctl, selection);
+    if (ctl->GetSelection() == wxNOT_FOUND)
+        ctl->SetSelection(ctl->Append(selection));
+}
+
+// called when a background device enumeration found a different set of devices
+void GearDialog::ReloadDeviceChoices()
+{
+    ReloadChoices(m_pCameras, LoadCameras);
+    ReloadChoices(m_pScopes, LoadMounts);
+    ReloadChoices(m_pAuxScopes, LoadAuxMounts);
+    ReloadChoices(m_pRotators, LoadRotators);
+}
+
 void GearDialog::LoadGearChoices()
 {
+    // enumerate the slow drivers in parallel; until they finish, the lists cached in the
+    // profile are shown
+    DeviceEnumerator::Refresh();
+
     LoadCameras(m_pCameras);
     LoadMounts(m_pScopes);
     LoadAuxMounts(m_pAuxScopes);
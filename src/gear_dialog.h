@@ -114,6 +114,7 @@ public:
 
 private:
     void LoadGearChoices();
+    void ReloadDeviceChoices();
     void UpdateGearPointers();
 
     void UpdateCameraButtonState();
@@ -570,7 +570,7 @@ struct SimCamState
 # endif
 
     void Initialize();
-    void FillImage(usImage& img, const wxRect& subframe, int exptime, int gain, int offset);
+    void FillImage(usImage& img, const std::vector<wxRect>& windows, int exptime, int gain, int offset);
 };
 
 void SimCamState::Initialize()
@@ -1051,7 +1051,7 @@ void SimCamState::ReadDisplacements(double& incX, double& incY)
 }
 # endif
 
-void SimCamState::FillImage(usImage& img, const wxRect& subframe, int exptime, int gain, int offset)
+void SimCamState::FillImage(usImage& img, const std::vector<wxRect>& windows, int exptime, int gain, int offset)
 {
     unsigned int const nr_stars = stars.size();
 
@@ -1241,7 +1241,8 @@ void SimCamState::FillImage(usImage& img, const wxRect& subframe, int exptime, i
             double noise = (double) (rand() % (gain * 100));
             double inten = star + dark + noise;
 
-            render_star(img, binning, subframe, cc[i], inten);
+            for (const wxRect& subframe : windows)
+                render_star(img, binning, subframe, cc[i], inten);
         }
 
 # ifndef SIM_FILE_DISPLACEMENTS
@@ -1258,13 +1259,17 @@ void SimCamState::FillImage(usImage& img, const wxRect& subframe, int exptime, i
             double noise = (double) (rand() % (gain * 100));
             inten = star + dark + noise;
 
-            render_comet(img, binning, subframe, wxRealPoint(cx, cy), inten);
+            for (const wxRect& subframe : windows)
+                render_comet(img, binning, subframe, wxRealPoint(cx, cy), inten);
         }
 # endif
     }
 
     if (SimCamParams::clouds_opacity > 0)
-        render_clouds(img, subframe, exptime, gain, offset);
+    {
+        for (const wxRect& subframe : windows)
+            render_clouds(img, subframe, exptime, gain, offset);
+    }
 
     // render hot pixels
     for (unsigned int i = 0; i < hotpx.size(); i++)
@@ -1272,19 +1277,30 @@ void SimCamState::FillImage(usImage& img, const wxRect& subframe, int exptime, i
         wxPoint p(hotpx[i]);
         p.x /= binning;
         p.y /= binning;
-        if (subframe.Contains(p))
-            set_pixel(img, p.x, p.y, (unsigned short) -1);
+        for (const wxRect& subframe : windows)
+        {
+            if (subframe.Contains(p))
+                set_pixel(img, p.x, p.y, (unsigned short) -1);
+        }
     }
 }
 
 class CameraSimulator : public GuideCamera
 {
     SimCamState sim;
+    bool m_streaming;
+    wxStopWatch m_streamClock;
+    long m_streamPeriod; // ms between stream frames
+    long m_streamFrame; // number of the last stream frame delivered or dropped
 
 public:
     CameraSimulator();
     ~CameraSimulator();
     bool Capture(usImage& img, const CaptureParams& captureParams) override;
+    bool StartStream(const CaptureParams& captureParams) override;
+    void StopStream() override;
+    bool IsStreaming() const override { return m_streaming; }
+    bool GetLatestFrame(usImage& img, const CaptureParams& captureParams) override;
     bool Connect(const wxString& camId) override;
     bool Disconnect() override;
     void ShowPropertyDialog() override;
@@ -1299,6 +1315,9 @@ public:
     bool ST4PulseGuideScope(int direction, int duration) override;
     PierSide SideOfPier() const;
     void FlipPierSide();
+
+private:
+    bool RenderFrame(usImage& img, const CaptureParams& captureParams);
 };
 
 CameraSimulator::CameraSimulator()
@@ -1309,6 +1328,9 @@ CameraSimulator::CameraSimulator()
     HasShutter = true;
     HasGainControl = true;
     HasSubframes = true;
+    HasMultiROIReadout = true;
+    HasStreaming = true;
+    m_streaming = false;
     PropertyDialogType = PROPDLG_WHEN_CONNECTED;
     MaxHwBinning = 3;
     HasCooler = true;
@@ -1361,6 +1383,7 @@ bool CameraSimulator::Connect(const wxString& camId)
 
 bool CameraSimulator::Disconnect()
 {
+    m_streaming = false;
     Connected = false;
     return false;
 }
@@ -1430,9 +1453,7 @@ static void fill_noise(usImage& img, const wxRect& subframe, int exptime, int ga
 bool CameraSimulator::Capture(usImage& img, const CaptureParams& captureParams)
 {
     int duration = captureParams.duration;
-    int options = captureParams.captureOptions;
 
-    wxRect subframe(captureParams.subframe);
     CameraWatchdog watchdog(duration, GetTimeoutMs());
 
     // sleep before rendering the image so that any changes made in the middle of a long exposure (e.g. manual guide pulse)
@@ -1449,6 +1470,32 @@ bool CameraSimulator::Capture(usImage& img, const CaptureParams& captureParams)
         }
     }
 
+    if (RenderFrame(img, captureParams))
+        return true;
+
+    unsigned int tot_dur = duration + SimCamParams::frame_download_ms;
+    long elapsed = watchdog.Time();
+    if (elapsed < tot_dur)
+    {
+        if (WorkerThread::MilliSleep(tot_dur - elapsed, WorkerThread::INT_ANY))
+            return true;
+        if (watchdog.Expired())
+        {
+            DisconnectWithAlert(CAPT_FAIL_TIMEOUT);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CameraSimulator::RenderFrame(usImage& img, const CaptureParams& captureParams)
+{
+    int duration = captureParams.duration;
+    int options = captureParams.captureOptions;
+
+    wxRect subframe(captureParams.subframe);
+
 # if SIMMODE == 1
 
     if (!UseSubframes)
@@ -1481,12 +1528,28 @@ bool CameraSimulator::Capture(usImage& img, const CaptureParams& captureParams)
         return true;
     }
 
+    // with multi-ROI readout only the star windows are exposed, the rest of the subframe stays clear
+    std::vector<wxRect> windows;
+    if (usingSubframe)
+    {
+        for (const wxRect& roi : captureParams.rois)
+        {
+            wxRect r(roi);
+            r.Intersect(subframe);
+            if (!r.IsEmpty())
+                windows.push_back(r);
+        }
+    }
+    if (windows.empty())
+        windows.push_back(subframe);
+
     if (usingSubframe)
         img.Clear();
 
-    fill_noise(img, subframe, exptime, gain, offset);
+    for (const wxRect& window : windows)
+        fill_noise(img, window, exptime, gain, offset);
 
-    sim.FillImage(img, subframe, exptime, gain, offset);
+    sim.FillImage(img, windows, exptime, gain, offset);
 
     if (usingSubframe)
         img.Subframe = subframe;
@@ -1496,19 +1559,50 @@ bool CameraSimulator::Capture(usImage& img, const CaptureParams& captureParams)
 
 # endif // SIMMODE == 1
 
-    unsigned int tot_dur = duration + SimCamParams::frame_download_ms;
-    long elapsed = watchdog.Time();
-    if (elapsed < tot_dur)
-    {
-        if (WorkerThread::MilliSleep(tot_dur - elapsed, WorkerThread::INT_ANY))
-            return true;
-        if (watchdog.Expired())
-        {
-            DisconnectWithAlert(CAPT_FAIL_TIMEOUT);
-            return true;
-        }
-    }
+    return false;
+}
+
+// The simulated stream exposes back to back with the readout overlapping the next exposure,
+// so frame n completes at n * max(exposure, download time) after the stream starts.
+bool CameraSimulator::StartStream(const CaptureParams& captureParams)
+{
+    m_streamPeriod = std::max(captureParams.duration, (int) SimCamParams::frame_download_ms);
+    if (m_streamPeriod < 1)
+        m_streamPeriod = 1;
+    m_streamFrame = 0;
+    m_streamClock.Start();
+    m_streaming = true;
+    return false;
+}
+
+void CameraSimulator::StopStream()
+{
+    m_streaming = false;
+}
+
+bool CameraSimulator::GetLatestFrame(usImage& img, const CaptureParams& captureParams)
+{
+    long now = m_streamClock.Time();
+    long completed = now / m_streamPeriod;
+    // frames that completed since the last read are stale, the simulator never loses one
+    if (completed > m_streamFrame)
+        AddStreamFramesSkipped(completed - m_streamFrame);
+
+    long next = completed + 1;
+    long due = next * m_streamPeriod;
+
+    // render just before the frame completes so that guide pulses sent during the exposure show up in the image
+    if (due - 5 > now && WorkerThread::MilliSleep(due - 5 - now, WorkerThread::INT_ANY))
+        return true;
+
+    if (RenderFrame(img, captureParams))
+        return true;
+
+    long left = due - m_streamClock.Time();
+    if (left > 0 && WorkerThread::MilliSleep(left, WorkerThread::INT_ANY))
+        return true;
 
+    m_streamFrame = next;
     return false;
 }
 
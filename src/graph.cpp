@@ -765,7 +765,8 @@ wxEND_EVENT_TABLE();
 // clang-format on
 
 GraphLogClientWindow::GraphLogClientWindow(wxWindow *parent)
-    : wxWindow(parent, wxID_ANY, wxDefaultPosition, wxSize(401, 200), wxFULL_REPAINT_ON_RESIZE), m_line1(0), m_line2(0)
+    : wxWindow(parent, wxID_ANY, wxDefaultPosition, wxSize(401, 200), wxFULL_REPAINT_ON_RESIZE), m_line1(0), m_line2(0),
+      m_seq(0), m_maxDuration(1.0)
 {
     SetBackgroundStyle(wxBG_STYLE_PAINT);
 
@@ -830,6 +831,12 @@ static void reset_trend_accums(TrendLineAccum accums[4])
 void GraphLogClientWindow::ResetData()
 {
     m_history.clear();
+    m_seq = 0;
+    m_peakRa.Clear();
+    m_peakDec.Clear();
+    m_maxDuration.Clear();
+    m_maxStarMass.Clear();
+    m_maxStarSNR.Clear();
     reset_trend_accums(m_trendLineAccum);
     m_noDitherDec.ClearAll();
     m_noDitherRA.ClearAll();
@@ -887,11 +894,16 @@ bool GraphLogClientWindow::SetMaxLength(unsigned int maxLength)
 
     m_history.resize(maxLength);
 
+    for (int i = 0; i < NUM_SERIES; i++)
+        m_envelope[i].Resize(maxLength);
+    m_plotPoints.reserve(maxLength + 1);
+
+    // a decimated series has at most one point more than the history
     delete[] m_line1;
-    m_line1 = new wxPoint[maxLength];
+    m_line1 = new wxPoint[maxLength + 1];
 
     delete[] m_line2;
-    m_line2 = new wxPoint[maxLength];
+    m_line2 = new wxPoint[maxLength + 1];
 
     pConfig->Global.SetInt("/graph/maxLength", m_history.capacity());
 
@@ -1009,32 +1021,114 @@ void GraphLogClientWindow::UpdateStats(unsigned int nr, const S_HISTORY *cur)
     }
 }
 
-static double peak_ra(const circular_buffer<S_HISTORY>& history, unsigned int nr)
+void MinMaxPyramid::Resize(unsigned int capacity)
 {
-    double peak = 0.0;
-    const int end = history.size();
-    const int begin = end - nr;
-    for (int i = begin; i < end; i++)
+    m_levels.clear();
+    // each level keeps enough blocks to cover the whole history, plus the partial blocks at either end
+    for (unsigned int blockSize = 2; blockSize <= capacity; blockSize *= 2)
+        m_levels.push_back(std::vector<Bucket>(capacity / blockSize + 2));
+}
+
+void MinMaxPyramid::Add(unsigned long seq, double val)
+{
+    for (unsigned int k = 1; k <= m_levels.size(); k++)
     {
-        double val = fabs(history[i].ra);
-        if (val > peak)
-            peak = val;
+        Bucket& b = m_levels[k - 1][(seq >> k) % m_levels[k - 1].size()];
+        if ((seq & ((1UL << k) - 1)) == 0)
+        {
+            // first sample of a new block
+            b.min = b.max = val;
+            b.minFirst = true;
+        }
+        else if (val < b.min)
+        {
+            b.min = val;
+            b.minFirst = false;
+        }
+        else if (val > b.max)
+        {
+            b.max = val;
+            b.minFirst = true;
+        }
     }
-    return peak;
 }
 
-static double peak_dec(const circular_buffer<S_HISTORY>& history, unsigned int nr)
+void WindowMax::Add(unsigned long seq, double val, unsigned int window)
+{
+    // values that are not larger than the new one can never be the maximum again
+    while (!m_queue.empty() && m_queue.back().second <= val)
+        m_queue.pop_back();
+    m_queue.push_back(std::make_pair(seq, val));
+    while (m_queue.front().first + window <= seq)
+        m_queue.pop_front();
+}
+
+double GraphLogClientWindow::SeriesValue(const S_HISTORY& h, GRAPH_SERIES series)
 {
-    double peak = 0.0;
-    const int end = history.size();
-    const int begin = end - nr;
-    for (int i = begin; i < end; i++)
+    switch (series)
     {
-        double val = fabs(history[i].dec);
-        if (val > peak)
-            peak = val;
+    case SERIES_RA:
+        return h.ra;
+    case SERIES_DEC:
+        return h.dec;
+    case SERIES_DX:
+        return h.dx;
+    case SERIES_DY:
+        return h.dy;
+    case SERIES_RA_CORR:
+        return h.raDir == WEST ? -h.raDur : h.raDur; // West corrections => Up on graph
+    case SERIES_DEC_CORR:
+        return h.decDir == SOUTH ? h.decDur : -h.decDur; // North Corrections => Up on graph
+    case SERIES_STAR_MASS:
+        return h.starMass;
+    case SERIES_STAR_SNR:
+    default:
+        return h.starSNR;
+    }
+}
+
+void GraphLogClientWindow::UpdatePeaks(unsigned long seq, const S_HISTORY& h)
+{
+    m_peakRa.Add(seq, fabs(h.ra), m_length);
+    m_peakDec.Add(seq, fabs(h.dec), m_length);
+    m_maxDuration.Add(seq, std::max(abs(h.raDur), abs(h.decDur)), m_length);
+    m_maxStarMass.Add(seq, h.starMass, m_length);
+    m_maxStarSNR.Add(seq, h.starSNR, m_length);
+}
+
+// GetPlotPoints - collect the (x, value) pairs to draw for the last plot_length history entries
+// of a series into m_plotPoints. At level 0 each entry is a point. Otherwise entries are combined
+// in blocks of 2^level, each contributing its minimum and maximum in time order, so the number of
+// points depends on the width of the window rather than on the length of the history.
+//
+void GraphLogClientWindow::GetPlotPoints(GRAPH_SERIES series, unsigned int plot_length, int level)
+{
+    m_plotPoints.clear();
+
+    const unsigned int start_item = m_history.size() - plot_length;
+    const unsigned long first = m_seq - plot_length; // sequence number of the first plotted entry
+
+    if (level == 0)
+    {
+        for (unsigned int j = 0; j < plot_length; j++)
+            m_plotPoints.push_back(std::make_pair((double) j, SeriesValue(m_history[start_item + j], series)));
+        return;
+    }
+
+    const unsigned long blockSize = 1UL << level;
+    unsigned long seq = first;
+
+    // the entries before the first block boundary are drawn individually
+    for (; seq < m_seq && (seq & (blockSize - 1)) != 0; seq++)
+        m_plotPoints.push_back(std::make_pair((double) (seq - first), SeriesValue(m_history[start_item + seq - first], series)));
+
+    for (; seq < m_seq; seq += blockSize)
+    {
+        const MinMaxPyramid::Bucket& b = m_envelope[series].Get(level, seq >> level);
+        double x = (double) (seq - first) + 0.5 * (double) (std::min(blockSize, m_seq - seq) - 1);
+        m_plotPoints.push_back(std::make_pair(x, b.minFirst ? b.min : b.max));
+        m_plotPoints.push_back(std::make_pair(x, b.minFirst ? b.max : b.min));
     }
-    return peak;
 }
 
 void GraphLogClientWindow::AppendData(const GuideStepInfo& step)
@@ -1068,6 +1162,11 @@ void GraphLogClientWindow::AppendData(const GuideStepInfo& step)
     S_HISTORY cur(step);
     m_history.push_front(cur);
 
+    for (int i = 0; i < NUM_SERIES; i++)
+        m_envelope[i].Add(m_seq, SeriesValue(cur, (GRAPH_SERIES) i));
+    UpdatePeaks(m_seq, cur);
+    ++m_seq;
+
     if (m_ditherStarted)
         m_ditherStarted = false;
     else if (!PhdController::IsSettling())
@@ -1134,8 +1233,16 @@ void GraphLogClientWindow::RecalculateTrendLines()
         }
     }
 
-    m_stats.ra_peak = peak_ra(m_history, trend_items);
-    m_stats.dec_peak = peak_dec(m_history, trend_items);
+    m_peakRa.Clear();
+    m_peakDec.Clear();
+    m_maxDuration.Clear();
+    m_maxStarMass.Clear();
+    m_maxStarSNR.Clear();
+    for (unsigned int i = begin; i < m_history.size(); i++)
+        UpdatePeaks(m_seq - m_history.size() + i, m_history[i]);
+
+    m_stats.ra_peak = m_peakRa.Max();
+    m_stats.dec_peak = m_peakDec.Max();
 
     {
         unsigned int raLimitedCnt = 0;
@@ -1201,46 +1308,6 @@ static wxString rms_label(double rms, double sampling)
         return wxString::Format("%4.2f", rms);
 }
 
-static int GetMaxDuration(const circular_buffer<S_HISTORY>& history, int start_item)
-{
-    int maxdur = 1; // always return at least 1 to protect against divide-by-zero
-    for (unsigned int i = start_item; i < history.size(); i++)
-    {
-        const S_HISTORY& h = history[i];
-        int d = abs(h.raDur);
-        if (d > maxdur)
-            maxdur = d;
-        d = abs(h.decDur);
-        if (d > maxdur)
-            maxdur = d;
-    }
-    return maxdur;
-}
-
-static double GetMaxStarMass(const circular_buffer<S_HISTORY>& history, int start_item)
-{
-    double maxMass = 0.0;
-    for (unsigned int i = start_item; i < history.size(); i++)
-    {
-        const S_HISTORY& h = history[i];
-        if (h.starMass > maxMass)
-            maxMass = h.starMass;
-    }
-    return maxMass;
-}
-
-static double GetMaxStarSNR(const circular_buffer<S_HISTORY>& history, int start_item)
-{
-    double maxSNR = 0.0;
-    for (unsigned int i = start_item; i < history.size(); i++)
-    {
-        const S_HISTORY& h = history[i];
-        if (h.starSNR > maxSNR)
-            maxSNR = h.starSNR;
-    }
-    return maxSNR;
-}
-
 enum
 {
     GRAPH_BORDER = 5
@@ -1352,6 +1419,11 @@ void GraphLogClientWindow::OnPaint(wxPaintEvent& WXUNUSED(evt))
         unsigned int plot_length = GetItemCount();
         unsigned int start_item = m_history.size() - plot_length;
 
+        // with two or more entries per pixel column, draw the min/max envelope of blocks of entries
+        int level = 0;
+        while (level < m_envelope[0].Levels() && (double) (2UL << level) <= m_length / (double) size.x)
+            ++level;
+
         if (m_showCorrections)
         {
             double ymagc;
@@ -1361,8 +1433,8 @@ void GraphLogClientWindow::OnPaint(wxPaintEvent& WXUNUSED(evt))
             }
             else
             {
-                int maxDur = GetMaxDuration(m_history, start_item);
-                ymagc = (size.y - 10) * 0.5 / (double) maxDur;
+                double maxDur = std::max(1.0, m_maxDuration.Max()); // protect against divide-by-zero
+                ymagc = (size.y - 10) * 0.5 / maxDur;
             }
             ScaleAndTranslate sctr(xorig, yorig, xmag, ymagc);
 
@@ -1371,17 +1443,16 @@ void GraphLogClientWindow::OnPaint(wxPaintEvent& WXUNUSED(evt))
 
             double const xRate = pMount ? pMount->xRate() : 1.0;
 
-            for (unsigned int i = start_item, j = 0; i < m_history.size(); i++, j++)
+            GetPlotPoints(SERIES_RA_CORR, plot_length, level);
+            for (unsigned int k = 0; k < m_plotPoints.size(); k++)
             {
-                const S_HISTORY& h = m_history[i];
+                double raDur = m_plotPoints[k].second;
 
-                if (h.raDur != 0)
+                if (raDur != 0.0)
                 {
-                    // West corrections => Up on graph
-                    double raDur = h.raDir == WEST ? -h.raDur : h.raDur;
                     if (m_correctionsToScale)
                         raDur *= xRate;
-                    wxPoint pt(sctr.pt(j, raDur));
+                    wxPoint pt(sctr.pt(m_plotPoints[k].first, raDur));
                     if (raDur < 0)
                         dc.DrawRectangle(pt, wxSize(4, yorig - pt.y));
                     else
@@ -1393,17 +1464,16 @@ void GraphLogClientWindow::OnPaint(wxPaintEvent& WXUNUSED(evt))
 
             double const yRate = pMount ? pMount->yRate() : 1.0;
 
-            for (unsigned int i = start_item, j = 0; i < m_history.size(); i++, j++)
+            GetPlotPoints(SERIES_DEC_CORR, plot_length, level);
+            for (unsigned int k = 0; k < m_plotPoints.size(); k++)
             {
-                const S_HISTORY& h = m_history[i];
+                double decDur = m_plotPoints[k].second;
 
-                if (h.decDur != 0)
+                if (decDur != 0.0)
                 {
-                    // North Corrections => Up on graph
-                    double decDur = h.decDir == SOUTH ? h.decDur : -h.decDur;
                     if (m_correctionsToScale)
                         decDur *= yRate;
-                    wxPoint pt(sctr.pt(j, decDur));
+                    wxPoint pt(sctr.pt(m_plotPoints[k].first, decDur));
                     pt.x += 5;
                     if (decDur < 0)
                         dc.DrawRectangle(pt, wxSize(4, yorig - pt.y));
@@ -1415,77 +1485,77 @@ void GraphLogClientWindow::OnPaint(wxPaintEvent& WXUNUSED(evt))
 
         if (m_showStarMass)
         {
-            double maxMass = GetMaxStarMass(m_history, start_item);
+            double maxMass = m_maxStarMass.Max();
 
             const double ymag = (size.y - 10) * 0.5 / maxMass;
             ScaleAndTranslate sctr(xorig, yorig, xmag, -ymag);
 
-            for (unsigned int i = start_item, j = 0; i < m_history.size(); i++, j++)
-            {
-                const S_HISTORY& h = m_history[i];
-                m_line1[j] = sctr.pt(j, h.starMass);
-            }
+            GetPlotPoints(SERIES_STAR_MASS, plot_length, level);
+            for (unsigned int k = 0; k < m_plotPoints.size(); k++)
+                m_line1[k] = sctr.pt(m_plotPoints[k].first, m_plotPoints[k].second);
 
             dc.SetPen(*wxYELLOW_PEN);
-            dc.DrawLines(plot_length, m_line1);
+            dc.DrawLines(m_plotPoints.size(), m_line1);
         }
 
         if (m_showStarSNR)
         {
-            double maxSNR = GetMaxStarSNR(m_history, start_item);
+            double maxSNR = m_maxStarSNR.Max();
 
             const double ymag = (size.y - 10) * 0.5 / maxSNR;
             ScaleAndTranslate sctr(xorig, yorig, xmag, -ymag);
 
-            for (unsigned int i = start_item, j = 0; i < m_history.size(); i++, j++)
-            {
-                const S_HISTORY& h = m_history[i];
-                m_line1[j] = sctr.pt(j, h.starSNR);
-            }
+            GetPlotPoints(SERIES_STAR_SNR, plot_length, level);
+            for (unsigned int k = 0; k < m_plotPoints.size(); k++)
+                m_line1[k] = sctr.pt(m_plotPoints[k].first, m_plotPoints[k].second);
 
             dc.SetPen(*wxWHITE_PEN);
-            dc.DrawLines(plot_length, m_line1);
-        }
-
-        std::deque<DitherInfo>::const_iterator it = m_dithers.begin();
-        { // advance to the first dither that will show on the plot
-            const S_HISTORY& h = m_history[start_item];
-            while (it != m_dithers.end() && it->timestamp < h.timestamp)
-                ++it;
+            dc.DrawLines(m_plotPoints.size(), m_line1);
         }
 
-        for (unsigned int i = start_item, j = 0; i < m_history.size(); i++, j++)
+        // label each dither at the first entry following it
+        for (std::deque<DitherInfo>::const_iterator it = m_dithers.begin(); it != m_dithers.end(); ++it)
         {
-            const S_HISTORY& h = m_history[i];
+            if (it->timestamp < m_history[start_item].timestamp)
+                continue;
 
-            if (it != m_dithers.end() && it->timestamp < h.timestamp)
+            unsigned int lo = start_item, hi = m_history.size();
+            while (lo < hi)
             {
-                wxPoint pt(sctr.pt((double) j - 0.5, 0.0));
-                pt.y = topEdge + 6;
-                dc.DrawText(_("Dither"), pt);
-                ++it;
+                unsigned int mid = (lo + hi) / 2;
+                if (m_history[mid].timestamp > it->timestamp)
+                    hi = mid;
+                else
+                    lo = mid + 1;
             }
 
-            switch (m_mode)
+            if (lo < m_history.size())
             {
-            case MODE_RADEC:
-                m_line1[j] = sctr.pt(j, h.ra);
-                m_line2[j] = sctr.pt(j, -h.dec); // North corrections Up, North offsets down
-                break;
-            case MODE_DXDY:
-                m_line1[j] = sctr.pt(j, h.dx);
-                m_line2[j] = sctr.pt(j, h.dy);
-                break;
+                wxPoint pt(sctr.pt((double) (lo - start_item) - 0.5, 0.0));
+                pt.y = topEdge + 6;
+                dc.DrawText(_("Dither"), pt);
             }
         }
 
+        GetPlotPoints(m_mode == MODE_RADEC ? SERIES_RA : SERIES_DX, plot_length, level);
+        unsigned int nr1 = m_plotPoints.size();
+        for (unsigned int k = 0; k < nr1; k++)
+            m_line1[k] = sctr.pt(m_plotPoints[k].first, m_plotPoints[k].second);
+
+        // North corrections Up, North offsets down
+        const double sign2 = m_mode == MODE_RADEC ? -1.0 : 1.0;
+        GetPlotPoints(m_mode == MODE_RADEC ? SERIES_DEC : SERIES_DY, plot_length, level);
+        unsigned int nr2 = m_plotPoints.size();
+        for (unsigned int k = 0; k < nr2; k++)
+            m_line2[k] = sctr.pt(m_plotPoints[k].first, sign2 * m_plotPoints[k].second);
+
         wxPen raOrDxPen(m_raOrDxColor, 2);
         dc.SetPen(raOrDxPen);
-        dc.DrawLines(plot_length, m_line1);
+        dc.DrawLines(nr1, m_line1);
 
         wxPen decOrDyPen(m_decOrDyColor, 2);
         dc.SetPen(decOrDyPen);
-        dc.DrawLines(plot_length, m_line2);
+        dc.DrawLines(nr2, m_line2);
 
         // draw trend lines
         double polarAlignCircleRadius = 0.0;
@@ -36,6 +36,7 @@
 #define GRAPHCLASS
 
 #include <deque>
+#include <vector>
 #include "guiding_stats.h"
 
 class GraphControlPane;
@@ -54,6 +55,47 @@ struct TrendLineAccum
     double sum_y2;
 };
 
+// Min/max envelope of a graph series over aligned blocks of 2, 4, 8, ... samples, kept up to
+// date as samples are appended. Blocks are addressed by the sequence number of their first
+// sample, so a long history can be drawn with one min/max segment per pixel column.
+class MinMaxPyramid
+{
+public:
+    struct Bucket
+    {
+        double min;
+        double max;
+        bool minFirst; // the minimum occurred before the maximum
+    };
+
+private:
+    std::vector<std::vector<Bucket>> m_levels; // m_levels[k - 1] holds the blocks of 2^k samples
+
+public:
+    void Resize(unsigned int capacity);
+    void Add(unsigned long seq, double val);
+    int Levels() const { return m_levels.size(); }
+    // the block of 2^level samples starting at sample block << level
+    const Bucket& Get(int level, unsigned long block) const
+    {
+        const std::vector<Bucket>& buckets = m_levels[level - 1];
+        return buckets[block % buckets.size()];
+    }
+};
+
+// Maximum over the most recent samples, with amortized O(1) updates and O(1) queries
+class WindowMax
+{
+    std::deque<std::pair<unsigned long, double>> m_queue; // decreasing values
+    double m_default;
+
+public:
+    WindowMax(double dflt = 0.0) : m_default(dflt) { }
+    void Clear() { m_queue.clear(); }
+    void Add(unsigned long seq, double val, unsigned int window);
+    double Max() const { return m_queue.empty() ? m_default : m_queue.front().second; }
+};
+
 struct S_HISTORY
 {
     wxLongLong_t timestamp;
@@ -133,6 +175,30 @@ private:
     wxPoint *m_line1;
     wxPoint *m_line2;
 
+    enum GRAPH_SERIES
+    {
+        SERIES_RA,
+        SERIES_DEC,
+        SERIES_DX,
+        SERIES_DY,
+        SERIES_RA_CORR,
+        SERIES_DEC_CORR,
+        SERIES_STAR_MASS,
+        SERIES_STAR_SNR,
+        NUM_SERIES
+    };
+
+    unsigned long m_seq; // number of history entries appended since the last reset
+    MinMaxPyramid m_envelope[NUM_SERIES];
+    std::vector<std::pair<double, double>> m_plotPoints; // (x, value) pairs of the series being drawn
+
+    // maxima over the plotted window
+    WindowMax m_peakRa;
+    WindowMax m_peakDec;
+    WindowMax m_maxDuration;
+    WindowMax m_maxStarMass;
+    WindowMax m_maxStarSNR;
+
     TrendLineAccum m_trendLineAccum[4]; // dx, dy, ra, dec
     int m_raSameSides; // accumulator for RA osc index
     SummaryStats m_stats;
@@ -171,6 +237,9 @@ public:
 private:
     void RecalculateTrendLines();
     void UpdateStats(unsigned int nr, const S_HISTORY *cur);
+    void UpdatePeaks(unsigned long seq, const S_HISTORY& h);
+    static double SeriesValue(const S_HISTORY& h, GRAPH_SERIES series);
+    void GetPlotPoints(GRAPH_SERIES series, unsigned int plot_length, int level);
 
     void OnPaint(wxPaintEvent& evt);
     void OnLeftBtnDown(wxMouseEvent& evt);
@@ -41,8 +41,9 @@
 
 wxString GuideAlgorithm::GetConfigPath() const
 {
-    return "/" + m_pMount->GetMountClassName() + "/GuideAlgorithm/" + (m_guideAxis == GUIDE_X ? "X/" : "Y/") +
-        GetGuideAlgorithmClassName();
+    // algorithms created without a mount (guide log replay) keep their settings in a group of their own
+    wxString mountClass = m_pMount ? m_pMount->GetMountClassName() : wxString("replay");
+    return "/" + mountClass + "/GuideAlgorithm/" + (m_guideAxis == GUIDE_X ? "X/" : "Y/") + GetGuideAlgorithmClassName();
 }
 
 wxString GuideAlgorithm::GetAxis() const
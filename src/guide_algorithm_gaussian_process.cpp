@@ -66,6 +66,7 @@ static const double DefaultSignalVarianceSE1Ker = 10.0; // signal variance of th
 
 static const double DefaultPeriodLengthsForPeriodEstimation = 2.0; // minimal number of period lengths for PL estimation
 static const int DefaultNumPointsForApproximation = 100; // number of points used in the GP approximation
+static const int DefaultNumInducingPoints = 0; // inducing points of the sparse GP, 0 = use the approximation data points
 static const double DefaultPredictionGain = 0.5; // amount of GP prediction to blend in
 
 static const double DefaultNoresetMaxPctPeriod =
@@ -82,8 +83,8 @@ static void MakeBold(wxControl *ctrl)
 
 GuideAlgorithmGaussianProcess::GPExpertDialog::GPExpertDialog(wxWindow *Parent)
     : wxDialog(Parent, wxID_ANY, _("Expert Settings"), wxDefaultPosition, wxDefaultSize), m_pPeriodLengthsInference(0),
-      m_pPeriodLengthsPeriodEstimation(0), m_pNumPointsApproximation(0), m_pSE0KLengthScale(0), m_pSE0KSignalVariance(0),
-      m_pPKLengthScale(0), m_pPKSignalVariance(0), m_pSE1KLengthScale(0), m_pSE1KSignalVariance(0)
+      m_pPeriodLengthsPeriodEstimation(0), m_pNumPointsApproximation(0), m_pNumInducingPoints(0), m_pSE0KLengthScale(0),
+      m_pSE0KSignalVariance(0), m_pPKLengthScale(0), m_pPKSignalVariance(0), m_pSE1KLengthScale(0), m_pSE1KSignalVariance(0)
 {
     // create the expert options UI
     wxBoxSizer *vSizer = new wxBoxSizer(wxVERTICAL);
@@ -92,7 +93,7 @@ GuideAlgorithmGaussianProcess::GPExpertDialog::GPExpertDialog(wxWindow *Parent)
     MakeBold(warning);
     vSizer->Add(warning, wxSizerFlags().Center().Border(wxBOTTOM, 10));
 
-    wxFlexGridSizer *flexGrid = new wxFlexGridSizer(10, 2, 5, 5);
+    wxFlexGridSizer *flexGrid = new wxFlexGridSizer(11, 2, 5, 5);
     int width;
 
     width = StringWidth(this, _T("0000"));
@@ -103,6 +104,16 @@ GuideAlgorithmGaussianProcess::GPExpertDialog::GPExpertDialog(wxWindow *Parent)
                                      "as well as runtime rise with the number of datapoints. Default = %d"),
                                    DefaultNumPointsForApproximation));
 
+    width = StringWidth(this, _T("0000"));
+    m_pNumInducingPoints = pFrame->MakeSpinCtrl(this, wxID_ANY, _T(" "), wxDefaultPosition, wxSize(width, -1),
+                                                wxSP_ARROW_KEYS, 0, 500, DefaultNumInducingPoints);
+    AddTableEntry(flexGrid, _("Sparse Inducing Points"), m_pNumInducingPoints,
+                  wxString::Format(_("Number of inducing points spread over the worm period for the sparse approximation. "
+                                     "If set, the last two worm periods of the guiding history are used, averaged over "
+                                     "the spacing of the inducing points, instead of the approximation data points. "
+                                     "0 disables the sparse approximation. Default = %d"),
+                                   DefaultNumInducingPoints));
+
     width = StringWidth(this, _T("0.00"));
     m_pPeriodLengthsInference = pFrame->MakeSpinCtrlDouble(this, wxID_ANY, _T(" "), wxDefaultPosition, wxSize(width, -1),
                                                            wxSP_ARROW_KEYS, 0.0, 10.0, DefaultPeriodLengthsForInference, 0.1);
@@ -198,6 +209,7 @@ void GuideAlgorithmGaussianProcess::GPExpertDialog::LoadExpertValues(GuideAlgori
     m_pPeriodLengthsInference->SetValue(m_pGuideAlgorithm->GetPeriodLengthsInference());
     m_pPeriodLengthsPeriodEstimation->SetValue(m_pGuideAlgorithm->GetPeriodLengthsPeriodEstimation());
     m_pNumPointsApproximation->SetValue(m_pGuideAlgorithm->GetNumPointsForApproximation());
+    m_pNumInducingPoints->SetValue(m_pGuideAlgorithm->GetNumInducingPoints());
 
     m_pSE0KLengthScale->SetValue(hyperParams[SE0KLengthScale]);
     m_pSE0KSignalVariance->SetValue(hyperParams[SE0KSignalVariance]);
@@ -213,6 +225,7 @@ void GuideAlgorithmGaussianProcess::GPExpertDialog::UnloadExpertValues(GuideAlgo
     m_pGuideAlgorithm->SetPeriodLengthsInference(m_pPeriodLengthsInference->GetValue());
     m_pGuideAlgorithm->SetPeriodLengthsPeriodEstimation(m_pPeriodLengthsPeriodEstimation->GetValue());
     m_pGuideAlgorithm->SetNumPointsForApproximation(m_pNumPointsApproximation->GetValue());
+    m_pGuideAlgorithm->SetNumInducingPoints(m_pNumInducingPoints->GetValue());
 
     hyperParams[SE0KLengthScale] = m_pSE0KLengthScale->GetValue();
     hyperParams[SE0KSignalVariance] = m_pSE0KSignalVariance->GetValue();
@@ -437,7 +450,8 @@ public:
 };
 
 GuideAlgorithmGaussianProcess::GuideAlgorithmGaussianProcess(Mount *pMount, GuideAxis axis)
-    : GuideAlgorithm(pMount, axis), GPG(0), dark_tracking_mode_(false)
+    : GuideAlgorithm(pMount, axis), GPG(0), dark_tracking_mode_(false), replay_(false), replay_time_(0.0), replay_snr_(0.0),
+      replay_exposure_(0)
 {
     // create guide parameters, load default values at first
     GaussianProcessGuider::guide_parameters parameters;
@@ -453,6 +467,7 @@ GuideAlgorithmGaussianProcess::GuideAlgorithmGaussianProcess(Mount *pMount, Guid
     parameters.SE1KSignalVariance_ = DefaultSignalVarianceSE1Ker;
     parameters.min_periods_for_period_estimation_ = DefaultPeriodLengthsForPeriodEstimation;
     parameters.points_for_approximation_ = DefaultNumPointsForApproximation;
+    parameters.inducing_points_ = DefaultNumInducingPoints;
     parameters.prediction_gain_ = DefaultPredictionGain;
     parameters.compute_period_ = DefaultComputePeriod;
 
@@ -479,6 +494,9 @@ GuideAlgorithmGaussianProcess::GuideAlgorithmGaussianProcess(Mount *pMount, Guid
         pConfig->Profile.GetInt(configPath + "/gp_points_for_approximation", DefaultNumPointsForApproximation);
     SetNumPointsForApproximation(num_points_approximation);
 
+    int num_inducing_points = pConfig->Profile.GetInt(configPath + "/gp_inducing_points", DefaultNumInducingPoints);
+    SetNumInducingPoints(num_inducing_points);
+
     double prediction_gain = pConfig->Profile.GetDouble(configPath + "/gp_prediction_gain", DefaultPredictionGain);
     SetPredictionGain(prediction_gain);
 
@@ -503,7 +521,7 @@ GuideAlgorithmGaussianProcess::GuideAlgorithmGaussianProcess(Mount *pMount, Guid
     bool compute_period = pConfig->Profile.GetBoolean(configPath + "/gp_compute_period", DefaultComputePeriod);
     SetBoolComputePeriod(compute_period);
     m_expertDialog = NULL;
-    block_updates_ = !(m_pMount->GetGuidingEnabled());
+    block_updates_ = m_pMount && !m_pMount->GetGuidingEnabled();
     guiding_ra_ = math_tools::NaN;
     guiding_pier_side_ = PIER_SIDE_UNKNOWN;
     reset();
@@ -535,6 +553,7 @@ void GuideAlgorithmGaussianProcess::GetParamNames(wxArrayString& names) const
     names.push_back("predictiveWeight");
     names.push_back("reactiveWeight");
     names.push_back("periodLength");
+    names.push_back("optimizeHyperparameters");
 }
 
 bool GuideAlgorithmGaussianProcess::GetParam(const wxString& name, double *val) const
@@ -553,6 +572,8 @@ bool GuideAlgorithmGaussianProcess::GetParam(const wxString& name, double *val)
         assert(hyperparameters.size() == NumParameters);
         *val = hyperparameters[PKPeriodLength];
     }
+    else if (name == "optimizeHyperparameters")
+        *val = GPG->IsOptimizingHyperparameters() ? 1.0 : 0.0;
     else
         ok = false;
 
@@ -571,10 +592,18 @@ bool GuideAlgorithmGaussianProcess::SetParam(const wxString& name, double val)
         err = SetControlGain(val);
     else if (name == "periodLength")
     {
-        std::vector<double> hyperparameters(NumParameters);
+        // keep the other hyperparameters, only the period length changes
+        std::vector<double> hyperparameters = GetGPHyperparameters();
         hyperparameters[PKPeriodLength] = val;
         err = SetGPHyperparameters(hyperparameters);
     }
+    else if (name == "optimizeHyperparameters")
+    {
+        // the result is applied by result() once the background fit is done
+        err = val != 0.0 && GPG->StartHyperparameterOptimization();
+        if (!err && val != 0.0)
+            Debug.Write("PPEC: hyperparameter optimization requested\n");
+    }
     else
         err = true;
 
@@ -706,6 +735,31 @@ bool GuideAlgorithmGaussianProcess::SetNumPointsForApproximation(int num_points)
     return error;
 }
 
+bool GuideAlgorithmGaussianProcess::SetNumInducingPoints(int num_points)
+{
+    bool error = false;
+
+    try
+    {
+        if (num_points < 0)
+        {
+            throw ERROR_INFO("invalid number of inducing points");
+        }
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+        error = true;
+        num_points = DefaultNumInducingPoints;
+    }
+
+    GPG->SetNumInducingPoints(num_points);
+
+    pConfig->Profile.SetInt(GetConfigPath() + "/gp_inducing_points", num_points);
+
+    return error;
+}
+
 bool GuideAlgorithmGaussianProcess::SetGPHyperparameters(const std::vector<double>& _hyperparameters)
 {
     if (_hyperparameters.size() != NumParameters)
@@ -897,6 +951,11 @@ int GuideAlgorithmGaussianProcess::GetNumPointsForApproximation() const
     return GPG->GetNumPointsForApproximation();
 }
 
+int GuideAlgorithmGaussianProcess::GetNumInducingPoints() const
+{
+    return GPG->GetNumInducingPoints();
+}
+
 std::vector<double> GuideAlgorithmGaussianProcess::GetGPHyperparameters() const
 {
     return GPG->GetGPHyperparameters();
@@ -928,6 +987,7 @@ wxString GuideAlgorithmGaussianProcess::GetSettingsSummary() const
     static const char *format = "Control gain = %.3f\n"
                                 "Prediction gain = %.3f\n"
                                 "Minimum move = %.3f\n"
+                                "Sparse inducing points = %d\n"
                                 "Hyperparameters\n"
                                 "\tLength scale long range SE kernel = %.3f\n"
                                 "\tSignal variance long range SE kernel = %.3f\n"
@@ -941,10 +1001,11 @@ wxString GuideAlgorithmGaussianProcess::GetSettingsSummary() const
 
     std::vector<double> hyperparameters = GetGPHyperparameters();
 
-    return wxString::Format(format, GetControlGain(), GetPredictionGain(), GetMinMove(), hyperparameters[SE0KLengthScale],
-                            hyperparameters[SE0KSignalVariance], hyperparameters[PKLengthScale],
-                            hyperparameters[PKSignalVariance], hyperparameters[SE1KLengthScale],
-                            hyperparameters[SE1KSignalVariance], hyperparameters[PKPeriodLength],
+    return wxString::Format(format, GetControlGain(), GetPredictionGain(), GetMinMove(), GetNumInducingPoints(),
+                            hyperparameters[SE0KLengthScale], hyperparameters[SE0KSignalVariance],
+                            hyperparameters[PKLengthScale], hyperparameters[PKSignalVariance],
+                            hyperparameters[SE1KLengthScale], hyperparameters[SE1KSignalVariance],
+                            hyperparameters[PKPeriodLength],
                             GetPeriodLengthsPeriodEstimation(), GetBoolComputePeriod() ? "On" : "Off");
 }
 
@@ -963,26 +1024,58 @@ double GuideAlgorithmGaussianProcess::result(double input)
         return deduceResult();
     }
 
-    // the third parameter of result() is a floating-point in seconds, while RequestedExposureDuration() returns milliseconds
-    const Star& star = pFrame->pGuider->PrimaryStar();
-    double control_signal = GPG->result(input, star.SNR, (double) pFrame->RequestedExposureDuration() / 1000.0);
+    std::vector<double> hyperparameters;
+    if (GPG->TakeOptimizedHyperparameters(&hyperparameters))
+    {
+        Debug.Write(wxString::Format("PPEC: optimized hyperparameters SE0 %.2f/%.2f, PK %.2f/%.2f, SE1 %.2f/%.2f\n",
+                                     hyperparameters[SE0KLengthScale], hyperparameters[SE0KSignalVariance],
+                                     hyperparameters[PKLengthScale], hyperparameters[PKSignalVariance],
+                                     hyperparameters[SE1KLengthScale], hyperparameters[SE1KSignalVariance]));
+        SetGPHyperparameters(hyperparameters);
+    }
 
-    Debug.Write(wxString::Format("PPEC: input: %.2f, control: %.2f, exposure: %d\n", input, control_signal,
-                                 pFrame->RequestedExposureDuration()));
+    // the third parameter of result() is a floating-point in seconds, while ExposureDuration() returns milliseconds
+    double snr = replay_ ? replay_snr_ : pFrame->pGuider->PrimaryStar().SNR;
+    int exposure = ExposureDuration();
+    double control_signal = GPG->result(input, snr, (double) exposure / 1000.0);
+
+    Debug.Write(wxString::Format("PPEC: input: %.2f, control: %.2f, exposure: %d\n", input, control_signal, exposure));
 
     return control_signal;
 }
 
 double GuideAlgorithmGaussianProcess::deduceResult()
 {
-    double control_signal = GPG->deduceResult((double) pFrame->RequestedExposureDuration() / 1000.0);
+    int exposure = ExposureDuration();
+    double control_signal = GPG->deduceResult((double) exposure / 1000.0);
 
-    Debug.Write(
-        wxString::Format("PPEC (deduced): control: %.2f, exposure: %d\n", control_signal, pFrame->RequestedExposureDuration()));
+    Debug.Write(wxString::Format("PPEC (deduced): control: %.2f, exposure: %d\n", control_signal, exposure));
 
     return control_signal;
 }
 
+int GuideAlgorithmGaussianProcess::ExposureDuration() const
+{
+    return replay_ ? replay_exposure_ : pFrame->RequestedExposureDuration();
+}
+
+void GuideAlgorithmGaussianProcess::SetReplayFrame(double time, double snr, int exposure)
+{
+    if (!replay_)
+    {
+        // run the GP guider on the recorded frame times
+        replay_ = true;
+        GPG->SetTimeSource([this]() {
+            return GaussianProcessGuider::clock::time_point(
+                std::chrono::duration_cast<GaussianProcessGuider::clock::duration>(std::chrono::duration<double>(replay_time_)));
+        });
+    }
+
+    replay_time_ = time;
+    replay_snr_ = snr;
+    replay_exposure_ = exposure;
+}
+
 void GuideAlgorithmGaussianProcess::reset()
 {
     Debug.Write("PPEC: reset GP model\n");
@@ -65,6 +65,7 @@ protected:
         wxSpinCtrlDouble *m_pPeriodLengthsInference;
         wxSpinCtrlDouble *m_pPeriodLengthsPeriodEstimation;
         wxSpinCtrl *m_pNumPointsApproximation;
+        wxSpinCtrl *m_pNumInducingPoints;
         wxSpinCtrlDouble *m_pSE0KLengthScale;
         wxSpinCtrlDouble *m_pSE0KSignalVariance;
         wxSpinCtrlDouble *m_pPKLengthScale;
@@ -124,6 +125,13 @@ private:
     PierSide guiding_pier_side_;
     std::chrono::steady_clock::time_point guiding_stopped_time_; // time guiding stopped
 
+    bool replay_; // frame data comes from SetReplayFrame instead of the live guider
+    double replay_time_; // seconds since guiding started
+    double replay_snr_;
+    int replay_exposure_; // ms
+
+    int ExposureDuration() const;
+
 protected:
     double GetControlGain() const;
     bool SetControlGain(double control_gain);
@@ -140,6 +148,9 @@ protected:
     int GetNumPointsForApproximation() const;
     bool SetNumPointsForApproximation(int);
 
+    int GetNumInducingPoints() const;
+    bool SetNumInducingPoints(int);
+
     bool GetBoolComputePeriod() const;
     bool SetBoolComputePeriod(bool);
 
@@ -234,6 +245,14 @@ public:
     void GetParamNames(wxArrayString& names) const override;
     bool GetParam(const wxString& name, double *val) const override;
     bool SetParam(const wxString& name, double val) override;
+
+    /**
+     * Supplies the frame time (seconds since guiding started), star SNR and
+     * exposure duration (ms) for the next call to result() when a recorded
+     * guide log is replayed offline. Once called, the algorithm no longer
+     * reads the live guider or the wall clock.
+     */
+    void SetReplayFrame(double time, double snr, int exposure);
 };
 
 #endif // GUIDE_GAUSSIAN_PROCESS
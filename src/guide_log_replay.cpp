@@ -0,0 +1,623 @@
+/*
+ *  guide_log_replay.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+#include "guide_log_replay.h"
+
+#include <wx/tokenzr.h>
+#include <wx/txtstrm.h>
+#include <wx/wfstream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+// number of candidates listed per axis by RunGuideLogReplay
+static const size_t REPLAY_REPORT_COUNT = 10;
+
+// guide algorithm constructors and setters go through pConfig, which is not thread-safe
+static std::mutex s_configLock;
+
+struct ReplayAlgorithmName
+{
+    const char *name;
+    GUIDE_ALGORITHM algorithm;
+};
+
+static const ReplayAlgorithmName REPLAY_ALGORITHMS[] = {
+    { "Identity", GUIDE_ALGORITHM_IDENTITY },
+    { "None", GUIDE_ALGORITHM_IDENTITY },
+    { "Hysteresis", GUIDE_ALGORITHM_HYSTERESIS },
+    { "Lowpass", GUIDE_ALGORITHM_LOWPASS },
+    { "Lowpass2", GUIDE_ALGORITHM_LOWPASS2 },
+    { "ResistSwitch", GUIDE_ALGORITHM_RESIST_SWITCH },
+    { "PredictivePEC", GUIDE_ALGORITHM_GAUSSIAN_PROCESS },
+    { "GaussianProcess", GUIDE_ALGORITHM_GAUSSIAN_PROCESS },
+    { "ZFilter", GUIDE_ALGORITHM_ZFILTER },
+};
+
+static wxString ReplayAlgorithmLabel(GUIDE_ALGORITHM algorithm)
+{
+    for (const ReplayAlgorithmName& entry : REPLAY_ALGORITHMS)
+        if (entry.algorithm == algorithm)
+            return entry.name;
+    return "?";
+}
+
+// the part of s following key, up to the next comma
+static bool FindValue(const wxString& s, const wxString& key, wxString *val)
+{
+    int pos = s.Find(key);
+    if (pos == wxNOT_FOUND)
+        return false;
+    *val = s.Mid(pos + key.length()).BeforeFirst(',').Trim(true).Trim(false);
+    return true;
+}
+
+// numeric values may be followed by a unit ("2000 ms", "1.23 arc-sec/px")
+static bool FindDouble(const wxString& s, const wxString& key, double *val)
+{
+    wxString str;
+    return FindValue(s, key, &str) && str.BeforeFirst(' ').ToDouble(val);
+}
+
+static bool FindInt(const wxString& s, const wxString& key, int *val)
+{
+    long l;
+    wxString str;
+    if (!FindValue(s, key, &str) || !str.BeforeFirst(' ').ToLong(&l))
+        return false;
+    *val = (int) l;
+    return true;
+}
+
+static DEC_GUIDE_MODE ParseDecGuideMode(const wxString& s)
+{
+    if (s == "Off")
+        return DEC_NONE;
+    else if (s == "North")
+        return DEC_NORTH;
+    else if (s == "South")
+        return DEC_SOUTH;
+    else
+        return DEC_AUTO;
+}
+
+struct ReplayParseState
+{
+    GuideReplaySection header; // settings from the most recent log header, no frames
+    GuideReplaySection section; // section being collected
+    bool open;
+    bool hasAO;
+    double raCorrection; // sum of the corrections issued so far in the section, px
+    double decCorrection;
+
+    ReplayParseState() : open(false), hasAO(false), raCorrection(0.0), decCorrection(0.0)
+    {
+        header.xRate = header.yRate = 0.0;
+        header.maxRaDuration = header.maxDecDuration = 0;
+        header.decGuideMode = DEC_AUTO;
+        header.exposure = 0;
+        header.loggedRaSumSq = header.loggedDecSumSq = 0.0;
+    }
+
+    void Close(GuideReplayLog *log)
+    {
+        if (open && !hasAO && section.xRate > 0.0 && section.yRate > 0.0 && section.time.size() >= 2)
+        {
+            if (section.exposure <= 0)
+            {
+                // auto exposure: use the median frame interval
+                std::vector<double> dt;
+                for (size_t i = 1; i < section.time.size(); i++)
+                    dt.push_back(section.time[i] - section.time[i - 1]);
+                std::nth_element(dt.begin(), dt.begin() + dt.size() / 2, dt.end());
+                section.exposure = std::max(1, ROUND(dt[dt.size() / 2] * 1000.0));
+            }
+            log->sections.push_back(section);
+        }
+        open = false;
+    }
+
+    void Open(GuideReplayLog *log)
+    {
+        Close(log);
+        section = header;
+        open = true;
+        hasAO = false;
+        raCorrection = decCorrection = 0.0;
+    }
+};
+
+bool GuideReplayLog::Load(const wxString& filename, wxString *errorMsg)
+{
+    wxFileInputStream is(filename);
+    if (!is.IsOk())
+    {
+        *errorMsg = wxString::Format("cannot open guide log %s", filename);
+        return true;
+    }
+    wxTextInputStream tis(is);
+
+    sections.clear();
+    pixelScale = 1.0;
+
+    ReplayParseState st;
+
+    while (!is.Eof())
+    {
+        wxString line = tis.ReadLine();
+
+        if (line.empty())
+            continue;
+
+        if (wxIsdigit(line[0]))
+        {
+            if (!st.open)
+                continue;
+
+            wxArrayString f = wxSplit(line, ',', '\0');
+            if (f.size() < 17)
+                continue;
+
+            if (f[2] == "\"AO\"")
+            {
+                st.hasAO = true;
+                continue;
+            }
+            if (f[2] != "\"Mount\"")
+                continue; // dropped frame: no measurement and no correction
+
+            double t, raRaw, decRaw, snr;
+            long raDur = 0, decDur = 0;
+            if (!f[1].ToDouble(&t) || !f[5].ToDouble(&raRaw) || !f[6].ToDouble(&decRaw))
+                continue;
+            if (!f[16].ToDouble(&snr))
+                snr = 0.0;
+            f[9].ToLong(&raDur);
+            f[11].ToLong(&decDur);
+
+            GuideReplaySection& sec = st.section;
+            sec.time.push_back(t);
+            sec.snr.push_back(snr);
+            sec.raMotion.push_back(raRaw + st.raCorrection);
+            sec.decMotion.push_back(decRaw + st.decCorrection);
+            sec.loggedRaSumSq += raRaw * raRaw;
+            sec.loggedDecSumSq += decRaw * decRaw;
+
+            // a WEST (LEFT) pulse moves the star towards -x, SOUTH (DOWN) towards -y
+            st.raCorrection += (f[10] == "W" ? 1.0 : -1.0) * raDur * sec.xRate;
+            st.decCorrection += (f[12] == "S" ? 1.0 : -1.0) * decDur * sec.yRate;
+        }
+        else if (line.StartsWith("Guiding Begins"))
+        {
+            st.Close(this);
+            st.header.xRate = st.header.yRate = 0.0; // a new header follows
+            st.header.exposure = 0;
+            st.header.decGuideMode = DEC_AUTO;
+        }
+        else if (line.StartsWith("Guiding Ends") || line.StartsWith("Calibration Begins"))
+        {
+            st.Close(this);
+        }
+        else if (line.StartsWith("INFO: DITHER") || line.StartsWith("INFO: SET LOCK POSITION"))
+        {
+            // the lock position moved: the raw distances jump, start over from the new lock position
+            if (st.open)
+                st.Open(this);
+        }
+        else if (line.StartsWith("Frame,Time,mount"))
+        {
+            // column headings end the header of a guiding section
+            st.Open(this);
+        }
+        else if (line.StartsWith("Mount = "))
+        {
+            double xRate, yRate;
+            if (FindDouble(line, "xRate = ", &xRate) && FindDouble(line, "yRate = ", &yRate))
+            {
+                st.header.xRate = xRate / 1000.0;
+                st.header.yRate = yRate / 1000.0;
+            }
+        }
+        else if (line.StartsWith("Max RA duration"))
+        {
+            wxString mode;
+            FindInt(line, "Max RA duration = ", &st.header.maxRaDuration);
+            FindInt(line, "Max DEC duration = ", &st.header.maxDecDuration);
+            if (FindValue(line, "DEC guide mode = ", &mode))
+                st.header.decGuideMode = ParseDecGuideMode(mode);
+        }
+        else if (line.StartsWith("Exposure = "))
+        {
+            if (!FindInt(line, "Exposure = ", &st.header.exposure))
+                st.header.exposure = 0; // auto exposure
+        }
+        else if (line.StartsWith("Pixel scale = "))
+        {
+            double scale;
+            if (FindDouble(line, "Pixel scale = ", &scale))
+                pixelScale = scale;
+        }
+    }
+
+    st.Close(this);
+
+    if (sections.empty())
+    {
+        *errorMsg = wxString::Format("no replayable mount guiding found in %s", filename);
+        return true;
+    }
+
+    return false;
+}
+
+size_t GuideReplayLog::FrameCount() const
+{
+    size_t n = 0;
+    for (const GuideReplaySection& sec : sections)
+        n += sec.time.size();
+    return n;
+}
+
+wxString GuideReplayCandidate::Describe() const
+{
+    wxString s = ReplayAlgorithmLabel(algorithm);
+    for (const auto& p : params)
+        s += wxString::Format(" %s=%g", p.first, p.second);
+    return s;
+}
+
+// create the algorithm with default settings and apply the candidate's parameters
+static GuideAlgorithm *CreateReplayAlgorithm(const GuideReplayCandidate& candidate, GuideAxis axis)
+{
+    std::lock_guard<std::mutex> lock(s_configLock);
+
+    // forget the settings left behind by the previous candidate
+    pConfig->Profile.DeleteGroup("/replay");
+
+    GuideAlgorithm *algo;
+    if (Mount::CreateGuideAlgorithm(candidate.algorithm, nullptr, axis, &algo))
+        return nullptr;
+
+    for (const auto& p : candidate.params)
+    {
+        if (!algo->SetParam(p.first, p.second))
+        {
+            delete algo;
+            return nullptr;
+        }
+    }
+
+    return algo;
+}
+
+// Run the algorithm in closed loop against the reconstructed star motion, issuing
+// corrections the way Scope::MoveAxis would, and return the RMS of the simulated
+// guide error in pixels
+static double SimulateAxis(GuideAlgorithm *algo, const GuideReplayLog& log, GuideAxis axis)
+{
+    GuideAlgorithmGaussianProcess *gp = dynamic_cast<GuideAlgorithmGaussianProcess *>(algo);
+
+    double sumSq = 0.0;
+    size_t count = 0;
+
+    for (const GuideReplaySection& sec : log.sections)
+    {
+        const std::vector<double>& motion = axis == GUIDE_RA ? sec.raMotion : sec.decMotion;
+        double rate = axis == GUIDE_RA ? sec.xRate : sec.yRate;
+        int maxDuration = axis == GUIDE_RA ? sec.maxRaDuration : sec.maxDecDuration;
+
+        algo->reset();
+
+        double correction = 0.0; // simulated corrections issued so far, px
+
+        for (size_t i = 0; i < motion.size(); i++)
+        {
+            double input = motion[i] - correction;
+            sumSq += input * input;
+            ++count;
+
+            if (gp)
+                gp->SetReplayFrame(sec.time[i], sec.snr[i], sec.exposure);
+
+            double out = algo->result(input);
+
+            int duration = ROUND(fabs(out / rate));
+            if (maxDuration > 0 && duration > maxDuration)
+                duration = maxDuration;
+
+            if (axis == GUIDE_DEC)
+            {
+                GUIDE_DIRECTION dir = out > 0.0 ? SOUTH : NORTH;
+                if (sec.decGuideMode == DEC_NONE || (dir == SOUTH && sec.decGuideMode == DEC_NORTH) ||
+                    (dir == NORTH && sec.decGuideMode == DEC_SOUTH))
+                {
+                    duration = 0;
+                }
+            }
+
+            correction += (out > 0.0 ? 1.0 : -1.0) * duration * rate;
+        }
+    }
+
+    return count ? sqrt(sumSq / count) : 0.0;
+}
+
+static bool ParseValues(const wxString& spec, std::vector<double> *vals)
+{
+    vals->clear();
+
+    wxArrayString range = wxSplit(spec, ':', '\0');
+    if (range.size() == 3)
+    {
+        double first, last, step;
+        if (!range[0].ToDouble(&first) || !range[1].ToDouble(&last) || !range[2].ToDouble(&step) || step <= 0.0 ||
+            last < first)
+        {
+            return false;
+        }
+        // tolerate rounding in the step so that the last value is included
+        int n = (int) floor((last - first) / step + 1e-6);
+        for (int i = 0; i <= n; i++)
+            vals->push_back(first + i * step);
+        return true;
+    }
+    else if (range.size() != 1)
+        return false;
+
+    wxArrayString list = wxSplit(spec, ',', '\0');
+    for (const wxString& s : list)
+    {
+        double v;
+        if (!s.ToDouble(&v))
+            return false;
+        vals->push_back(v);
+    }
+
+    return !vals->empty();
+}
+
+bool ParseGuideReplaySweep(const wxString& filename, std::vector<GuideReplayCandidate> *raCandidates,
+                           std::vector<GuideReplayCandidate> *decCandidates, wxString *errorMsg)
+{
+    wxFileInputStream is(filename);
+    if (!is.IsOk())
+    {
+        *errorMsg = wxString::Format("cannot open sweep specification %s", filename);
+        return true;
+    }
+    wxTextInputStream tis(is);
+
+    raCandidates->clear();
+    decCandidates->clear();
+
+    int lineNo = 0;
+    while (!is.Eof())
+    {
+        wxString line = tis.ReadLine();
+        ++lineNo;
+
+        line.Trim(true).Trim(false);
+        if (line.empty() || line.StartsWith("#"))
+            continue;
+
+        wxArrayString tok = wxStringTokenize(line, " \t", wxTOKEN_STRTOK);
+        if (tok.size() < 2)
+        {
+            *errorMsg = wxString::Format("%s:%d: expected <axis> <algorithm> [name=values ...]", filename, lineNo);
+            return true;
+        }
+
+        GuideAxis axis;
+        if (tok[0].IsSameAs("RA", false) || tok[0].IsSameAs("X", false))
+            axis = GUIDE_RA;
+        else if (tok[0].IsSameAs("DEC", false) || tok[0].IsSameAs("Y", false))
+            axis = GUIDE_DEC;
+        else
+        {
+            *errorMsg = wxString::Format("%s:%d: unknown axis %s", filename, lineNo, tok[0]);
+            return true;
+        }
+
+        GUIDE_ALGORITHM algorithm = GUIDE_ALGORITHM_NONE;
+        for (const ReplayAlgorithmName& entry : REPLAY_ALGORITHMS)
+            if (tok[1].IsSameAs(entry.name, false))
+                algorithm = entry.algorithm;
+        if (algorithm == GUIDE_ALGORITHM_NONE)
+        {
+            *errorMsg = wxString::Format("%s:%d: unknown guide algorithm %s", filename, lineNo, tok[1]);
+            return true;
+        }
+
+        // validate the parameter names against the algorithm
+        wxArrayString paramNames;
+        {
+            GuideReplayCandidate plain;
+            plain.algorithm = algorithm;
+            GuideAlgorithm *algo = CreateReplayAlgorithm(plain, axis);
+            if (!algo)
+            {
+                *errorMsg = wxString::Format("%s:%d: cannot create guide algorithm %s", filename, lineNo, tok[1]);
+                return true;
+            }
+            algo->GetParamNames(paramNames);
+            delete algo;
+        }
+
+        std::vector<std::pair<wxString, std::vector<double>>> grid;
+        for (size_t i = 2; i < tok.size(); i++)
+        {
+            wxString name = tok[i].BeforeFirst('=');
+            wxString spec = tok[i].AfterFirst('=');
+            std::vector<double> vals;
+            if (paramNames.Index(name) == wxNOT_FOUND)
+            {
+                *errorMsg = wxString::Format("%s:%d: %s has no parameter %s (parameters: %s)", filename, lineNo, tok[1], name,
+                                             wxJoin(paramNames, ' '));
+                return true;
+            }
+            if (!ParseValues(spec, &vals))
+            {
+                *errorMsg = wxString::Format("%s:%d: invalid values for %s: %s", filename, lineNo, name, spec);
+                return true;
+            }
+            grid.push_back(std::make_pair(name, vals));
+        }
+
+        // expand the cartesian product, odometer style
+        std::vector<size_t> idx(grid.size(), 0);
+        std::vector<GuideReplayCandidate> *out = axis == GUIDE_RA ? raCandidates : decCandidates;
+        while (true)
+        {
+            GuideReplayCandidate c;
+            c.algorithm = algorithm;
+            c.rms = 0.0;
+            for (size_t i = 0; i < grid.size(); i++)
+                c.params.push_back(std::make_pair(grid[i].first, grid[i].second[idx[i]]));
+            out->push_back(c);
+
+            size_t k = 0;
+            while (k < grid.size() && ++idx[k] == grid[k].second.size())
+                idx[k++] = 0;
+            if (k == grid.size())
+                break;
+        }
+    }
+
+    if (raCandidates->empty() && decCandidates->empty())
+    {
+        *errorMsg = wxString::Format("%s: no candidates", filename);
+        return true;
+    }
+
+    return false;
+}
+
+void RunGuideReplaySweep(const GuideReplayLog& log, GuideAxis axis, std::vector<GuideReplayCandidate> *candidates)
+{
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next++) < candidates->size())
+        {
+            GuideReplayCandidate& c = (*candidates)[i];
+            GuideAlgorithm *algo = CreateReplayAlgorithm(c, axis);
+            if (!algo)
+            {
+                c.rms = std::numeric_limits<double>::infinity(); // rejected parameter value
+                continue;
+            }
+            c.rms = SimulateAxis(algo, log, axis);
+            delete algo;
+        }
+    };
+
+    unsigned int nthreads = std::max(1U, std::thread::hardware_concurrency());
+    nthreads = std::min<unsigned int>(nthreads, candidates->size());
+
+    std::vector<std::thread> pool;
+    pool.reserve(nthreads);
+    for (unsigned int t = 0; t < nthreads; t++)
+        pool.emplace_back(worker);
+    for (std::thread& th : pool)
+        th.join();
+
+    std::stable_sort(candidates->begin(), candidates->end(),
+                     [](const GuideReplayCandidate& a, const GuideReplayCandidate& b) { return a.rms < b.rms; });
+}
+
+static void ReportAxis(const GuideReplayLog& log, GuideAxis axis, const std::vector<GuideReplayCandidate>& candidates)
+{
+    if (candidates.empty())
+        return;
+
+    double sumSq = 0.0;
+    for (const GuideReplaySection& sec : log.sections)
+        sumSq += axis == GUIDE_RA ? sec.loggedRaSumSq : sec.loggedDecSumSq;
+    double logged = sqrt(sumSq / log.FrameCount());
+
+    const char *name = axis == GUIDE_RA ? "RA" : "Dec";
+    wxPrintf("\n%s: %u candidates, logged RMS %.3f px (%.2f\")\n", name, (unsigned int) candidates.size(), logged,
+             logged * log.pixelScale);
+
+    for (size_t i = 0; i < candidates.size() && i < REPLAY_REPORT_COUNT; i++)
+    {
+        const GuideReplayCandidate& c = candidates[i];
+        if (!std::isfinite(c.rms))
+            break;
+        wxPrintf("%3u  %.3f px (%.2f\")  %s\n", (unsigned int) i + 1, c.rms, c.rms * log.pixelScale, c.Describe());
+    }
+}
+
+int RunGuideLogReplay(const wxString& logFile, const wxString& sweepFile)
+{
+    wxString err;
+
+    GuideReplayLog log;
+    if (log.Load(logFile, &err))
+    {
+        wxFprintf(stderr, "%s\n", err);
+        return 1;
+    }
+
+    // the candidates write their settings to the profile; keep that away from the user's profiles
+    AutoTempProfile profile;
+
+    std::vector<GuideReplayCandidate> ra, dec;
+    if (ParseGuideReplaySweep(sweepFile, &ra, &dec, &err))
+    {
+        wxFprintf(stderr, "%s\n", err);
+        return 1;
+    }
+
+    wxPrintf("%s: %u guiding sections, %u frames\n", logFile, (unsigned int) log.sections.size(),
+             (unsigned int) log.FrameCount());
+
+    wxStopWatch swatch;
+
+    RunGuideReplaySweep(log, GUIDE_RA, &ra);
+    RunGuideReplaySweep(log, GUIDE_DEC, &dec);
+
+    ReportAxis(log, GUIDE_RA, ra);
+    ReportAxis(log, GUIDE_DEC, dec);
+
+    wxPrintf("\n%u candidates in %.1f s\n", (unsigned int) (ra.size() + dec.size()), swatch.Time() / 1000.0);
+
+    return 0;
+}
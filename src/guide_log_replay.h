@@ -0,0 +1,108 @@
+/*
+ *  guide_log_replay.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef GUIDE_LOG_REPLAY_H_INCLUDED
+#define GUIDE_LOG_REPLAY_H_INCLUDED
+
+// One stretch of uninterrupted mount guiding taken from a PHD2 guide log: from
+// "Guiding Begins" (or a dither / lock position change) to the next such event.
+//
+// The star motion is reconstructed from the logged raw distances by adding back the
+// corrections that were actually issued, converted from pulse durations to pixels
+// with the calibration rates in the section header. What remains is the motion the
+// star would have made with guiding disabled, which any guide algorithm can then be
+// run against in closed loop.
+struct GuideReplaySection
+{
+    double xRate; // px/ms, as used for guiding (declination compensated)
+    double yRate; // px/ms
+    int maxRaDuration; // ms, 0 if unlimited
+    int maxDecDuration; // ms, 0 if unlimited
+    DEC_GUIDE_MODE decGuideMode;
+    int exposure; // ms
+    std::vector<double> time; // seconds since guiding started
+    std::vector<double> snr;
+    std::vector<double> raMotion; // uncorrected star position along the mount axes, px
+    std::vector<double> decMotion;
+    double loggedRaSumSq; // sum of squared logged raw distances, for comparison
+    double loggedDecSumSq;
+};
+
+struct GuideReplayLog
+{
+    double pixelScale; // arc-sec/px, 1.0 if unknown
+    std::vector<GuideReplaySection> sections;
+
+    GuideReplayLog() : pixelScale(1.0) { }
+
+    // Load a PHD2 guide log. Sections guided with an AO, without calibration data, or
+    // with fewer than two frames are skipped. Returns true on error.
+    bool Load(const wxString& filename, wxString *errorMsg);
+
+    size_t FrameCount() const;
+};
+
+// One guide algorithm with one set of parameter values for one axis
+struct GuideReplayCandidate
+{
+    GUIDE_ALGORITHM algorithm;
+    std::vector<std::pair<wxString, double>> params;
+    double rms; // simulated closed-loop RMS, px; filled in by RunGuideReplaySweep
+
+    wxString Describe() const;
+};
+
+// Parse a sweep specification. Each non-blank line not starting with '#' describes a
+// grid of candidates for one axis:
+//
+//     RA  Hysteresis    minMove=0.10:0.50:0.05 hysteresis=0,0.1,0.2 aggression=0.5:1:0.1
+//     DEC ResistSwitch  minMove=0.1:0.6:0.05 aggression=0.6:1:0.1
+//
+// Values are a single number, a comma separated list, or an inclusive range
+// first:last:step. Parameter names are those reported by GuideAlgorithm::GetParamNames;
+// algorithm names are the guide algorithm class names with spaces removed
+// ("PredictivePEC", with "GaussianProcess" accepted as well). Every combination on a line
+// becomes one candidate. Returns true on error.
+extern bool ParseGuideReplaySweep(const wxString& filename, std::vector<GuideReplayCandidate> *raCandidates,
+                                  std::vector<GuideReplayCandidate> *decCandidates, wxString *errorMsg);
+
+// Simulate every candidate against the log on all available cores and sort the
+// candidates by simulated RMS, best first
+extern void RunGuideReplaySweep(const GuideReplayLog& log, GuideAxis axis, std::vector<GuideReplayCandidate> *candidates);
+
+// Command-line entry point: replay the guide log through the sweep and print the
+// ranking to stdout. Returns the process exit code.
+extern int RunGuideLogReplay(const wxString& logFile, const wxString& sweepFile);
+
+#endif
@@ -105,6 +105,7 @@ wxBEGIN_EVENT_TABLE(Guider, wxWindow)
 EVT_PAINT(Guider::OnPaint)
 EVT_CLOSE(Guider::OnClose)
 EVT_ERASE_BACKGROUND(Guider::OnErase)
+EVT_TIMER(wxID_ANY, Guider::OnLostStarFlashTimer)
 wxEND_EVENT_TABLE();
 // clang-format on
 
@@ -180,8 +181,10 @@ Guider::Guider(wxWindow *parent, int xSize, int ySize)
     m_ignoreLostStarLooping = false;
     m_forceFullFrame = false;
     m_measurementMode = false;
+    m_learnDefects = false;
     m_searchRegion = 0;
     m_pCurrentImage = new usImage(); // so we always have one
+    m_lostStarFlashTimer.SetOwner(this);
 
     SetOverlayMode(DefaultOverlayMode);
 
@@ -219,6 +222,11 @@ void Guider::LoadProfileSettings()
     bool enableFastRecenter = pConfig->Profile.GetBoolean("/guider/FastRecenter", true);
     EnableFastRecenter(enableFastRecenter);
 
+    bool learnDefects = pConfig->Profile.GetBoolean("/guider/LearnDefects", false);
+    EnableDefectLearning(learnDefects);
+
+    m_frameRing.LoadSettings();
+
     bool scaleImage = pConfig->Profile.GetBoolean("/guider/ScaleImage", DefaultScaleImage);
     SetScaleImage(scaleImage);
 
@@ -407,6 +415,21 @@ void Guider::EnableFastRecenter(bool enable)
     pConfig->Profile.SetInt("/guider/FastRecenter", m_fastRecenterEnabled);
 }
 
+void Guider::EnableDefectLearning(bool enable)
+{
+    if (!enable)
+        m_defectLearner.Reset();
+    m_learnDefects = enable;
+    pConfig->Profile.SetBoolean("/guider/LearnDefects", m_learnDefects);
+}
+
+void Guider::GetFoundStars(std::vector<const Star *>& stars) const
+{
+    stars.clear();
+    if (PrimaryStar().WasFound())
+        stars.push_back(&PrimaryStar());
+}
+
 void Guider::SetPolarAlignCircle(const PHD_Point& pt, double radius)
 {
     m_polarAlignCircleRadius = radius;
@@ -733,7 +756,7 @@ bool Guider::PaintHelper(wxAutoBufferedPaintDCBase& dc, wxMemoryDC& memDC)
     return bError;
 }
 
-void Guider::UpdateImageDisplay(usImage *pImage)
+void Guider::UpdateImageDisplay(usImage *pImage, bool immediate)
 {
     if (!pImage)
     {
@@ -746,7 +769,15 @@ void Guider::UpdateImageDisplay(usImage *pImage)
                          pImage->FiltMax, pFrame->Stretch_gamma));
 
     Refresh();
-    Update();
+    if (immediate)
+        Update();
+}
+
+void Guider::OnLostStarFlashTimer(wxTimerEvent& evt)
+{
+    SetBackgroundColour(m_lostStarFlashPrevColor);
+    // show the latest frame, which may have arrived while the flash was showing
+    UpdateImageDisplay(m_pCurrentImage, false);
 }
 
 void Guider::SetDefectMapPreview(const DefectMap *defectMap)
@@ -1232,9 +1263,78 @@ void Guider::DisplayImage(usImage *img)
 
     ImageLogger::SaveImage(prev);
 
+    m_background.Update(*img);
+
     UpdateImageDisplay();
 }
 
+// Look for hot and cold pixels in a new frame and add any that are confirmed to the bad-pixel
+// map, creating the map if the profile does not have one yet. Nothing is learned while a dark
+// library is in use or a noise reduction filter is on, as both already hide the defects, or
+// while the profile has a bad-pixel map that is not loaded.
+void Guider::LearnDefects(const usImage& img)
+{
+    if (!m_learnDefects || !pCamera || !pCamera->Connected || pCamera->CurrentDarkFrame ||
+        pFrame->GetNoiseReductionMethod() != NR_NONE)
+    {
+        return;
+    }
+
+    int const profileId = pConfig->GetCurrentProfileId();
+    if (!pCamera->CurrentDefectMap && wxFileExists(DefectMap::DefectMapFileName(profileId)))
+        return;
+
+    // mask out the guide stars, at their current and lock positions, and any star windows
+    std::vector<wxRect> masks;
+    GetStarWindows(masks);
+    int const r = GetSearchRegion();
+    if (CurrentPosition().IsValid())
+        masks.push_back(wxRect(ROUND(CurrentPosition().X) - r, ROUND(CurrentPosition().Y) - r, 2 * r + 1, 2 * r + 1));
+    if (LockPosition().IsValid())
+        masks.push_back(wxRect(ROUND(LockPosition().X) - r, ROUND(LockPosition().Y) - r, 2 * r + 1, 2 * r + 1));
+
+    std::vector<wxPoint> defects;
+    m_defectLearner.Update(img, m_background, masks, &defects);
+    if (defects.empty())
+        return;
+
+    for (const wxPoint& pt : defects)
+        Debug.Write(wxString::Format("DefectLearner: learned bad pixel at %d,%d\n", pt.x, pt.y));
+
+    bool haveMap;
+    { // lock around changes to defect map
+        wxCriticalSectionLocker lck(pCamera->DarkFrameLock);
+        DefectMap *defectMap = pCamera->CurrentDefectMap;
+        haveMap = defectMap != nullptr;
+        if (haveMap)
+        {
+            for (const wxPoint& pt : defects)
+                if (!defectMap->FindDefect(pt))
+                    defectMap->AddDefect(pt); // Changes both in-memory instance and disk file
+        }
+    }
+
+    if (!haveMap)
+    {
+        wxSize const frameSize = pCamera->DarkFrameSize();
+
+        wxArrayString info;
+        info.push_back(wxString::Format("Generated: %s", wxDateTime::UNow().FormatISOCombined(' ')));
+        info.push_back(wxString::Format("Camera: %s", pCamera->Name));
+        info.push_back("Learned from guide frames");
+        info.push_back(wxString::Format("Frame Size: %dx%d", frameSize.x, frameSize.y));
+
+        DefectMap defectMap;
+        defectMap.assign(defects.begin(), defects.end());
+        defectMap.Save(info);
+
+        pFrame->SetDarkMenuState();
+        pFrame->LoadDefectMapHandler(true);
+    }
+
+    pFrame->StatusMsg(wxString::Format(_("Bad pixels learned: %u"), (unsigned int) defects.size()));
+}
+
 inline static bool IsLoopingState(GUIDER_STATE state)
 {
     // returns true for looping, but non-guiding states
@@ -1260,8 +1360,11 @@ inline static bool IsLoopingState(GUIDER_STATE state)
 
 void Guider::UpdateGuideState(usImage *pImage, bool bStopping)
 {
+    FRAME_TRACE_SPAN("Guider::UpdateGuideState");
+
     wxString statusMessage;
     bool someException = false;
+    bool const newImage = pImage != nullptr;
 
     try
     {
@@ -1275,6 +1378,9 @@ void Guider::UpdateGuideState(usImage *pImage, bool bStopping)
             m_pCurrentImage = pImage;
 
             ImageLogger::SaveImage(pPrevImage);
+
+            m_background.Update(*pImage);
+            LearnDefects(*pImage);
         }
         else
         {
@@ -1308,8 +1414,15 @@ void Guider::UpdateGuideState(usImage *pImage, bool bStopping)
         GuiderOffset ofs;
         FrameDroppedInfo info;
 
-        if (UpdateCurrentPosition(pImage, &ofs, &info)) // true means error
+        bool lost = UpdateCurrentPosition(pImage, &ofs, &info); // true means error
+
+        Metrics.guiderState.Set(m_state);
+
+        if (lost)
         {
+            if (m_state != STATE_UNINITIALIZED && m_state != STATE_SELECTING)
+                Metrics.framesDropped.Add();
+
             info.frameNumber = pImage->FrameNum;
             info.time = pFrame->TimeSinceGuidingStarted();
             info.avgDist = pFrame->CurrentGuideError();
@@ -1348,13 +1461,18 @@ void Guider::UpdateGuideState(usImage *pImage, bool bStopping)
                 static GuiderOffset ZERO_OFS;
                 pFrame->SchedulePrimaryMove(pMount, ZERO_OFS, MOVEOPTS_DEDUCED_MOVE);
 
-                wxColor prevColor = GetBackgroundColour();
-                SetBackgroundColour(wxColour(64, 0, 0));
-                ClearBackground();
+                // flash the background; the timer restores it, so the next exposure is not held up.
+                // A flash already showing is not extended, so with short exposures the display
+                // still catches up every 100 ms while the star stays lost.
+                if (!m_lostStarFlashTimer.IsRunning())
+                {
+                    m_lostStarFlashPrevColor = GetBackgroundColour();
+                    SetBackgroundColour(wxColour(64, 0, 0));
+                    ClearBackground();
+                    m_lostStarFlashTimer.StartOnce(100);
+                }
                 if (pFrame->GetBeepForLostStar())
                     wxBell();
-                wxMilliSleep(100);
-                SetBackgroundColour(prevColor);
                 break;
             }
 
@@ -1369,6 +1487,11 @@ void Guider::UpdateGuideState(usImage *pImage, bool bStopping)
 
         statusMessage = info.status;
 
+        const Star& star = PrimaryStar();
+        Metrics.starSNR.Set(star.SNR);
+        Metrics.starMass.Set(star.Mass);
+        Metrics.starHFD.Set(star.HFD);
+
         if (IsLoopingState(m_state))
             EvtServer.NotifyLooping(pImage->FrameNum, &PrimaryStar(), nullptr);
 
@@ -1547,7 +1670,18 @@ void Guider::UpdateGuideState(usImage *pImage, bool bStopping)
 
     pFrame->UpdateButtonsStatus();
 
-    UpdateImageDisplay(pImage);
+    if (newImage && m_frameRing.IsEnabled())
+    {
+        std::vector<const Star *> stars;
+        GetFoundStars(stars);
+        m_frameRing.Publish(*pImage, m_state, stars, LockPosition());
+    }
+
+    // Don't paint synchronously: the caller schedules the next exposure as soon as we
+    // return, and the frame is drawn afterwards. While the lost-star flash is showing,
+    // its timer draws the latest frame when the flash ends.
+    if (!m_lostStarFlashTimer.IsRunning())
+        UpdateImageDisplay(pImage, false);
 
     Debug.AddLine("UpdateGuideState exits: " + statusMessage);
 }
@@ -1729,6 +1863,8 @@ void Guider::GuiderConfigDialogPane::LayoutControls(Guider *pGuider, BrainCtrlId
     CondAddCtrl(pSharedSizer, CtrlMap, AD_cbReverseDecOnFlip);
     CondAddCtrl(pSharedSizer, CtrlMap, AD_cbEnableGuiding, wxSizerFlags(0).Border(wxLEFT, 35));
     CondAddCtrl(pSharedSizer, CtrlMap, AD_cbSlewDetection);
+    CondAddCtrl(pSharedSizer, CtrlMap, AD_cbPhaseCorrelation, wxSizerFlags(0).Border(wxLEFT, 35));
+    pSharedSizer->Add(GetSingleCtrl(CtrlMap, AD_cbLearnDefects));
     pShared->Add(pSharedSizer, def_flags);
     pShared->Layout();
 
@@ -1760,18 +1896,45 @@ GuiderConfigDialogCtrlSet::GuiderConfigDialogCtrlSet(wxWindow *pParent, Guider *
     AddCtrl(CtrlMap, AD_cbFastRecenter, m_pEnableFastRecenter,
             _("Speed up calibration and dithering by using larger guide pulses to return the star to the center position. "
               "Un-check to use the old, slower method of recentering after calibration or dither."));
+
+    m_pPhaseCorrelation =
+        new wxCheckBox(GetParentWindow(AD_cbPhaseCorrelation), wxID_ANY, _("Guide on extended target (phase correlation)"));
+    AddCtrl(CtrlMap, AD_cbPhaseCorrelation, m_pPhaseCorrelation,
+            _("Register a whole region around the target against a reference instead of finding a single star. "
+              "Use this to guide on a comet, a planet, the Sun or the Moon, or a very faint crowded field. "
+              "PHD2 must be restarted for a change to take effect."));
+
+    m_pLearnDefects = new wxCheckBox(GetParentWindow(AD_cbLearnDefects), wxID_ANY, _("Learn bad pixels while guiding"));
+    AddCtrl(CtrlMap, AD_cbLearnDefects, m_pLearnDefects,
+            _("Find hot and cold pixels in the guide frames and add them to the bad-pixel map, creating one if the "
+              "profile has none. Not used while a dark library or noise reduction is in use."));
 }
 
 void GuiderConfigDialogCtrlSet::LoadValues()
 {
     m_pEnableFastRecenter->SetValue(m_pGuider->IsFastRecenterEnabled());
     m_pScaleImage->SetValue(m_pGuider->GetScaleImage());
+    m_pPhaseCorrelation->SetValue(pConfig->Profile.GetBoolean("/guider/PhaseCorrelation", false));
+    m_pPhaseCorrelation->Enable(!pFrame->CaptureActive);
+    m_pLearnDefects->SetValue(m_pGuider->IsDefectLearningEnabled());
 }
 
 void GuiderConfigDialogCtrlSet::UnloadValues()
 {
     m_pGuider->EnableFastRecenter(m_pEnableFastRecenter->GetValue());
     m_pGuider->SetScaleImage(m_pScaleImage->GetValue());
+    m_pGuider->EnableDefectLearning(m_pLearnDefects->GetValue());
+
+    bool phaseCorrelation = m_pPhaseCorrelation->GetValue();
+    if (phaseCorrelation != pConfig->Profile.GetBoolean("/guider/PhaseCorrelation", false))
+    {
+        pConfig->Profile.SetBoolean("/guider/PhaseCorrelation", phaseCorrelation);
+        int val = wxMessageBox(_("You must restart PHD2 for the guiding mode change to take effect.\n"
+                                 "Would you like to restart PHD2 now?"),
+                               _("Restart PHD2"), wxYES_NO | wxCENTRE);
+        if (val == wxYES)
+            wxGetApp().RestartApp();
+    }
 }
 
 EXPOSED_STATE Guider::GetExposedState()
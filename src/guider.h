@@ -120,6 +120,8 @@ class GuiderConfigDialogCtrlSet : public ConfigDialogCtrlSet
     Guider *m_pGuider;
     wxCheckBox *m_pEnableFastRecenter;
     wxCheckBox *m_pScaleImage;
+    wxCheckBox *m_pPhaseCorrelation;
+    wxCheckBox *m_pLearnDefects;
 
 public:
     GuiderConfigDialogCtrlSet(wxWindow *pParent, Guider *pGuider, AdvancedDialog *pAdvancedDialog, BrainCtrlIdMap& CtrlMap);
@@ -157,10 +159,16 @@ class Guider : public wxWindow
     bool m_avgDistanceNeedReset;
     GUIDER_STATE m_state;
     usImage *m_pCurrentImage;
+    BackgroundMesh m_background;
+    DefectLearner m_defectLearner;
+    FrameRing m_frameRing;
+    wxTimer m_lostStarFlashTimer;
+    wxColour m_lostStarFlashPrevColor;
     bool m_scaleImage;
     bool m_lockPosIsSticky;
     bool m_ignoreLostStarLooping;
     bool m_fastRecenterEnabled;
+    bool m_learnDefects;
     LockPosShiftParams m_lockPosShift;
     bool m_measurementMode;
     double m_minStarHFD;
@@ -220,7 +228,10 @@ public:
     bool IsGuiding() const;
     void OnClose(wxCloseEvent& evt);
     void OnErase(wxEraseEvent& evt);
-    void UpdateImageDisplay(usImage *pImage = nullptr);
+    void OnLostStarFlashTimer(wxTimerEvent& evt);
+    // immediate=false only invalidates the window, so the repaint happens once the
+    // current event has been handled
+    void UpdateImageDisplay(usImage *pImage = nullptr, bool immediate = true);
 
     bool MoveLockPosition(const PHD_Point& mountDelta);
     virtual bool SetLockPosition(const PHD_Point& position);
@@ -308,6 +319,10 @@ public:
 
     virtual const PHD_Point& CurrentPosition() const = 0;
     virtual wxRect GetBoundingBox() const = 0;
+    // the subframe windows for a multi-ROI capture, empty for a single subframe
+    virtual void GetStarWindows(std::vector<wxRect>& windows) const { windows.clear(); }
+    // the stars found in the current frame, primary star first
+    virtual void GetFoundStars(std::vector<const Star *>& stars) const;
     virtual int GetMaxMovePixels() const = 0;
 
     virtual const Star& PrimaryStar() const = 0;
@@ -317,6 +332,9 @@ public:
     virtual wxString GetStarCount() const { return wxEmptyString; }
 
     usImage *CurrentImage() const;
+    // the background mesh if it was measured on img, for Star::Find
+    const BackgroundMesh *BackgroundFor(const usImage *img) const;
+    const FrameRing& GetFrameRing() const;
     wxImage *DisplayedImage() const;
     double ScaleFactor() const;
 
@@ -324,9 +342,12 @@ public:
 
     bool IsFastRecenterEnabled() const;
     void EnableFastRecenter(bool enable);
+    bool IsDefectLearningEnabled() const;
+    void EnableDefectLearning(bool enable);
 
 private:
     void UpdateLockPosShiftCameraCoords();
+    void LearnDefects(const usImage& img);
     wxDECLARE_EVENT_TABLE();
 };
 
@@ -400,6 +421,22 @@ inline usImage *Guider::CurrentImage() const
     return m_pCurrentImage;
 }
 
+inline bool Guider::IsDefectLearningEnabled() const
+{
+    return m_learnDefects;
+}
+
+inline const BackgroundMesh *Guider::BackgroundFor(const usImage *img) const
+{
+    // the mesh is updated whenever the current image is switched
+    return img && img == m_pCurrentImage && m_background.Covers(*img) ? &m_background : nullptr;
+}
+
+inline const FrameRing& Guider::GetFrameRing() const
+{
+    return m_frameRing;
+}
+
 inline wxImage *Guider::DisplayedImage() const
 {
     return m_displayedImage;
@@ -63,6 +63,7 @@ public:
     wxChoice *m_autoSelDownsample;
     wxCheckBox *m_pBeepForLostStarCtrl;
     wxCheckBox *m_pUseMultiStars;
+    wxCheckBox *m_pPSFFit;
     wxSpinCtrlDouble *m_MinSNR;
     wxSpinCtrlDouble *m_MaxHFD;
 
@@ -76,6 +77,7 @@ class GuiderMultiStar : public Guider
 {
     Star m_primaryStar;
     std::vector<GuideStar> m_guideStars;
+    StarFieldIndex m_fieldIndex;
     DescriptiveStats *m_primaryDistStats;
     MassChecker *m_massChecker;
     double m_lastPrimaryDistance;
@@ -92,6 +94,7 @@ class GuiderMultiStar : public Guider
     double m_tolerateJumpsThreshold;
     unsigned int m_maxStars;
     double m_stabilitySigmaX;
+    bool m_psfFit;
 
 public:
     class GuiderMultiStarConfigDialogPane : public GuiderConfigDialogPane
@@ -111,6 +114,8 @@ public:
     double GetMassChangeThreshold() const;
     bool SetMassChangeThreshold(double starMassChangeThreshold);
     bool SetTolerateJumps(bool enable, double threshold);
+    bool GetPSFFit() const;
+    void SetPSFFit(bool enable);
     bool SetSearchRegion(int searchRegion);
     bool RefineOffset(const usImage *pImage, GuiderOffset *pOffset);
 
@@ -128,6 +133,8 @@ public:
     bool AutoSelect(const wxRect& roi) override;
     const PHD_Point& CurrentPosition() const override;
     wxRect GetBoundingBox() const override;
+    void GetStarWindows(std::vector<wxRect>& windows) const override;
+    void GetFoundStars(std::vector<const Star *>& stars) const override;
     int GetMaxMovePixels() const override;
     const Star& PrimaryStar() const override;
     bool GetMultiStarMode() const override;
@@ -143,12 +150,19 @@ public:
     void LoadProfileSettings() override;
 
 private:
+    wxRect PrimarySubframe(PHD_Point *center) const;
+    bool UsingStarWindows() const;
+    Star::FindMode StarFindMode() const;
+
     bool IsValidLockPosition(const PHD_Point& pt) final;
     bool IsValidSecondaryStarPosition(const PHD_Point& pt) final;
     void InvalidateCurrentPosition(bool fullReset = false) final;
     bool UpdateCurrentPosition(const usImage *pImage, GuiderOffset *ofs, FrameDroppedInfo *errorInfo) final;
     bool SetCurrentPosition(const usImage *pImage, const PHD_Point& position) final;
 
+    void BuildFieldIndex();
+    bool ReacquireField(const usImage *pImage, Star *newStar);
+
     void OnLClick(wxMouseEvent& evt);
 
     void SaveStarFITS();
@@ -0,0 +1,697 @@
+/*
+ *  guider_phasecorr.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "phd.h"
+
+#if ((wxMAJOR_VERSION < 3) && (wxMINOR_VERSION < 9))
+# define wxPENSTYLE_DOT wxDOT
+#endif
+
+static const double DefaultReferenceUpdate = 0.02;
+static const double DefaultMinQuality = 10.0;
+
+enum
+{
+    MIN_REGION_SIZE = 32,
+    DEFAULT_REGION_SIZE = 128,
+    MAX_REGION_SIZE = 512,
+};
+
+static const unsigned int s_regionSizes[] = { 32, 64, 128, 256, 512 };
+
+// clang-format off
+wxBEGIN_EVENT_TABLE(GuiderPhaseCorrelation, Guider)
+    EVT_PAINT(GuiderPhaseCorrelation::OnPaint)
+    EVT_LEFT_DOWN(GuiderPhaseCorrelation::OnLClick)
+wxEND_EVENT_TABLE();
+// clang-format on
+
+GuiderPhaseCorrelation::GuiderPhaseCorrelation(wxWindow *parent)
+    : Guider(parent, XWinSize, YWinSize), m_regionSize(DEFAULT_REGION_SIZE), m_referenceUpdate(DefaultReferenceUpdate),
+      m_minQuality(DefaultMinQuality)
+{
+    SetState(STATE_UNINITIALIZED);
+    m_searchRegion = m_regionSize / 4;
+}
+
+GuiderPhaseCorrelation::~GuiderPhaseCorrelation() { }
+
+void GuiderPhaseCorrelation::LoadProfileSettings()
+{
+    Guider::LoadProfileSettings();
+
+    SetRegionSize(pConfig->Profile.GetInt("/guider/phasecorr/RegionSize", DEFAULT_REGION_SIZE));
+    SetReferenceUpdate(pConfig->Profile.GetDouble("/guider/phasecorr/ReferenceUpdate", DefaultReferenceUpdate));
+    SetMinQuality(pConfig->Profile.GetDouble("/guider/phasecorr/MinQuality", DefaultMinQuality));
+}
+
+bool GuiderPhaseCorrelation::SetRegionSize(unsigned int size)
+{
+    bool bError = false;
+
+    if (size < MIN_REGION_SIZE || size > MAX_REGION_SIZE || (size & (size - 1)) != 0)
+    {
+        size = DEFAULT_REGION_SIZE;
+        bError = true;
+    }
+
+    if (size != m_regionSize && m_target.IsValid())
+    {
+        // the reference no longer matches the region
+        InvalidateCurrentPosition(true);
+    }
+
+    m_regionSize = size;
+    m_searchRegion = size / 4;
+    pConfig->Profile.SetInt("/guider/phasecorr/RegionSize", m_regionSize);
+
+    return bError;
+}
+
+bool GuiderPhaseCorrelation::SetReferenceUpdate(double fraction)
+{
+    bool bError = false;
+
+    if (fraction < 0.0 || fraction > 0.2)
+    {
+        fraction = DefaultReferenceUpdate;
+        bError = true;
+    }
+
+    m_referenceUpdate = fraction;
+    pConfig->Profile.SetDouble("/guider/phasecorr/ReferenceUpdate", m_referenceUpdate);
+
+    return bError;
+}
+
+bool GuiderPhaseCorrelation::SetMinQuality(double quality)
+{
+    bool bError = false;
+
+    if (quality < 3.0)
+    {
+        quality = DefaultMinQuality;
+        bError = true;
+    }
+
+    m_minQuality = quality;
+    pConfig->Profile.SetDouble("/guider/phasecorr/MinQuality", m_minQuality);
+
+    return bError;
+}
+
+// the region size that fits the image: the configured size, or the largest power of two that
+// fits in a smaller image
+unsigned int GuiderPhaseCorrelation::EffectiveRegionSize(const usImage *pImage) const
+{
+    unsigned int size = m_regionSize;
+    unsigned int limit = (unsigned int) wxMin(pImage->Size.GetWidth(), pImage->Size.GetHeight());
+    while (size > limit)
+        size /= 2;
+    return size;
+}
+
+// top-left corner of the region centered on center, kept inside the image
+wxPoint GuiderPhaseCorrelation::RegionOrigin(const usImage *pImage, const PHD_Point& center) const
+{
+    int size = EffectiveRegionSize(pImage);
+    int x = ROUND(center.X) - size / 2;
+    int y = ROUND(center.Y) - size / 2;
+    x = wxMax(0, wxMin(x, pImage->Size.GetWidth() - size));
+    y = wxMax(0, wxMin(y, pImage->Size.GetHeight() - size));
+    return wxPoint(x, y);
+}
+
+// take the region around position as the new reference; returns true on error
+bool GuiderPhaseCorrelation::SelectTarget(const usImage *pImage, const PHD_Point& position)
+{
+    unsigned int size = EffectiveRegionSize(pImage);
+    if (size < MIN_REGION_SIZE || m_correlator.Init(size))
+    {
+        Debug.Write(wxString::Format("PhaseCorr: image too small for a %u px region\n", m_regionSize));
+        return true;
+    }
+
+    wxPoint origin = RegionOrigin(pImage, position);
+    m_correlator.SetReference(*pImage, origin);
+
+    // the tracked position is the center of the reference region
+    m_target.SetXY(origin.x + size / 2, origin.y + size / 2);
+    m_target.SetError(Star::STAR_OK);
+    m_target.Mass = m_correlator.Flux();
+    m_target.SNR = 0.;
+    m_target.HFD = 0.;
+
+    Debug.Write(wxString::Format("PhaseCorr: reference region %u px at (%d, %d)\n", size, origin.x, origin.y));
+
+    return false;
+}
+
+bool GuiderPhaseCorrelation::SetCurrentPosition(const usImage *pImage, const PHD_Point& position)
+{
+    bool bError = true;
+
+    try
+    {
+        if (!position.IsValid())
+        {
+            throw ERROR_INFO("position is invalid");
+        }
+
+        double x = position.X;
+        double y = position.Y;
+
+        Debug.Write(wxString::Format("SetCurrentPosition(%.2f,%.2f)\n", x, y));
+
+        if ((x <= 0) || (x >= pImage->Size.x))
+        {
+            throw ERROR_INFO("invalid x value");
+        }
+
+        if ((y <= 0) || (y >= pImage->Size.y))
+        {
+            throw ERROR_INFO("invalid y value");
+        }
+
+        bError = SelectTarget(pImage, position);
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+    }
+
+    return bError;
+}
+
+// Center of the brightest size/2 square in the search area, found on a coarse grid of block
+// sums. Good enough to pick out a planet, the Moon or a comet head.
+static bool FindBrightestRegion(const usImage& image, const wxRect& roi, unsigned int size, PHD_Point *center)
+{
+    wxRect area = !roi.IsEmpty() ? roi : !image.Subframe.IsEmpty() ? image.Subframe : wxRect(image.Size);
+    area.Intersect(wxRect(image.Size));
+
+    int block = wxMax(4, (int) size / 8);
+    int gw = area.GetWidth() / block;
+    int gh = area.GetHeight() / block;
+    int span = 4; // blocks per side of the size/2 square
+    if (gw < span || gh < span)
+        return false;
+
+    std::vector<double> sums(gw * gh, 0.);
+    int width = image.Size.GetWidth();
+    for (int gy = 0; gy < gh; gy++)
+    {
+        for (int y = 0; y < block; y++)
+        {
+            const unsigned short *p = image.ImageData + (area.GetTop() + gy * block + y) * width + area.GetLeft();
+            for (int gx = 0; gx < gw; gx++)
+            {
+                unsigned int s = 0;
+                for (int x = 0; x < block; x++)
+                    s += *p++;
+                sums[gy * gw + gx] += s;
+            }
+        }
+    }
+
+    double best = -1.;
+    int bestX = 0, bestY = 0;
+    for (int gy = 0; gy + span <= gh; gy++)
+    {
+        for (int gx = 0; gx + span <= gw; gx++)
+        {
+            double s = 0.;
+            for (int j = 0; j < span; j++)
+                for (int i = 0; i < span; i++)
+                    s += sums[(gy + j) * gw + gx + i];
+            if (s > best)
+            {
+                best = s;
+                bestX = gx;
+                bestY = gy;
+            }
+        }
+    }
+
+    center->SetXY(area.GetLeft() + (bestX + span / 2) * block, area.GetTop() + (bestY + span / 2) * block);
+    return true;
+}
+
+bool GuiderPhaseCorrelation::AutoSelect(const wxRect& roi)
+{
+    Debug.Write("GuiderPhaseCorrelation::AutoSelect enter\n");
+
+    bool error = false;
+
+    usImage *image = CurrentImage();
+
+    try
+    {
+        if (!image->ImageData)
+        {
+            throw ERROR_INFO("No Current Image");
+        }
+
+        PHD_Point pos;
+        if (!FindBrightestRegion(*image, roi, EffectiveRegionSize(image), &pos))
+        {
+            throw ERROR_INFO("Unable to find target");
+        }
+
+        if (SelectTarget(image, pos))
+        {
+            throw ERROR_INFO("Unable to set reference");
+        }
+
+        if (SetLockPosition(m_target))
+        {
+            throw ERROR_INFO("Unable to set Lock Position");
+        }
+
+        if (GetState() == STATE_SELECTING)
+        {
+            // advance the state machine now rather than waiting for the next exposure, as
+            // GuiderMultiStar does
+            Debug.Write(wxString::Format("AutoSelect: state = %d, call UpdateGuideState\n", GetState()));
+            UpdateGuideState(NULL, false);
+        }
+
+        UpdateImageDisplay();
+
+        pFrame->StatusMsg(wxString::Format(_("Auto-selected target at (%.1f, %.1f)"), m_target.X, m_target.Y));
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+        error = true;
+    }
+
+    if (image->ImageData)
+    {
+        if (error)
+            Debug.Write("GuiderPhaseCorrelation::AutoSelect failed.\n");
+
+        ImageLogger::LogAutoSelectImage(image, !error);
+    }
+
+    return error;
+}
+
+wxRect GuiderPhaseCorrelation::GetBoundingBox() const
+{
+    GUIDER_STATE state = GetState();
+
+    bool subframe = m_target.WasFound() && !m_forceFullFrame &&
+        (state == STATE_SELECTED || state == STATE_CALIBRATING_PRIMARY || state == STATE_CALIBRATING_SECONDARY ||
+         state == STATE_GUIDING);
+
+    if (!subframe)
+        return wxRect(0, 0, 0, 0);
+
+    // the region plus room for the target to move before the next frame
+    const usImage *pImage = CurrentImage();
+    int size = EffectiveRegionSize(pImage);
+    wxPoint origin = RegionOrigin(pImage, m_target);
+    wxRect box(origin.x, origin.y, size, size);
+    box.Inflate(GetMaxMovePixels());
+    box.Intersect(wxRect(pImage->Size));
+    return box;
+}
+
+void GuiderPhaseCorrelation::InvalidateCurrentPosition(bool fullReset)
+{
+    m_target.Invalidate();
+
+    if (fullReset)
+    {
+        m_target.X = m_target.Y = 0.0;
+        m_correlator.ClearReference();
+    }
+}
+
+bool GuiderPhaseCorrelation::UpdateCurrentPosition(const usImage *pImage, GuiderOffset *ofs, FrameDroppedInfo *errorInfo)
+{
+    if (!m_correlator.HasReference() || (!m_target.IsValid() && m_target.X == 0.0 && m_target.Y == 0.0))
+    {
+        Debug.Write("UpdateCurrentPosition: no target selected\n");
+        errorInfo->starError = Star::STAR_ERROR;
+        errorInfo->starMass = 0.0;
+        errorInfo->starSNR = 0.0;
+        errorInfo->starHFD = 0.0;
+        errorInfo->status = _("No star selected");
+        ImageLogger::LogImageStarDeselected(pImage);
+        return true;
+    }
+
+    bool bError = false;
+
+    try
+    {
+        if (EffectiveRegionSize(pImage) != m_correlator.Size())
+        {
+            // frame size changed under us, e.g. binning
+            errorInfo->starError = Star::STAR_ERROR;
+            errorInfo->starMass = 0.0;
+            errorInfo->starSNR = 0.0;
+            errorInfo->starHFD = 0.0;
+            errorInfo->status = _("No star found");
+            m_target.SetError(Star::STAR_ERROR);
+            ImageLogger::LogImage(pImage, *errorInfo);
+            throw ERROR_INFO("UpdateCurrentPosition: region size does not match the image");
+        }
+
+        wxStopWatch swatch;
+
+        // m_target holds the last good position, also after a lost frame
+        int half = m_correlator.Size() / 2;
+        wxPoint origin = RegionOrigin(pImage, m_target);
+        double dx, dy, quality;
+        m_correlator.Register(*pImage, origin, &dx, &dy, &quality);
+
+        long elapsed = swatch.Time();
+
+        if (quality < m_minQuality)
+        {
+            Debug.Write(
+                wxString::Format("PhaseCorr: correlation quality %.1f < %.1f, %ld ms\n", quality, m_minQuality, elapsed));
+
+            errorInfo->starError = Star::STAR_LOWSNR;
+            errorInfo->starMass = m_correlator.Flux();
+            errorInfo->starSNR = quality;
+            errorInfo->starHFD = 0.0;
+            errorInfo->status = wxString::Format(_("Target lost - correlation %.1f"), quality);
+            m_target.SetError(Star::STAR_LOWSNR);
+
+            ImageLogger::LogImage(pImage, *errorInfo);
+
+            throw THROW_INFO("correlation quality too low");
+        }
+
+        PHD_Point newPos(origin.x + half + dx, origin.y + half + dy);
+
+        Debug.Write(wxString::Format("PhaseCorr: (%.2f, %.2f) quality %.1f, %ld ms\n", newPos.X, newPos.Y, quality, elapsed));
+
+        const PHD_Point& lockPos = LockPosition();
+        double distance = 0.;
+        if (lockPos.IsValid())
+        {
+            if (MyFrame::GuidingRAOnly())
+                distance = fabs(newPos.X - lockPos.X);
+            else
+                distance = newPos.Distance(lockPos);
+        }
+
+        ImageLogger::LogImage(pImage, distance);
+
+        m_target.SetXY(newPos.X, newPos.Y);
+        m_target.SetError(Star::STAR_OK);
+        m_target.Mass = m_correlator.Flux();
+        m_target.SNR = quality;
+
+        if (m_referenceUpdate > 0.0)
+            m_correlator.UpdateReference(m_referenceUpdate, dx, dy);
+
+        if (lockPos.IsValid())
+        {
+            ofs->cameraOfs = m_target - lockPos;
+            if (pMount && pMount->IsCalibrated())
+                pMount->TransformCameraCoordinatesToMountCoordinates(ofs->cameraOfs, ofs->mountOfs, true);
+            double distanceRA = ofs->mountOfs.IsValid() ? fabs(ofs->mountOfs.X) : 0.;
+            UpdateCurrentDistance(distance, distanceRA);
+        }
+
+        pFrame->UpdateStatusBarStarInfo(quality, false);
+        errorInfo->status = wxString::Format(_("Correlation=%.1f"), quality);
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+        bError = true;
+    }
+
+    return bError;
+}
+
+bool GuiderPhaseCorrelation::IsValidLockPosition(const PHD_Point& pt)
+{
+    const usImage *pImage = CurrentImage();
+    return pt.X >= 1 && pt.X + 1 < pImage->Size.GetX() && pt.Y >= 1 && pt.Y + 1 < pImage->Size.GetY();
+}
+
+bool GuiderPhaseCorrelation::IsValidSecondaryStarPosition(const PHD_Point& pt)
+{
+    // there are no secondary stars
+    return false;
+}
+
+void GuiderPhaseCorrelation::OnLClick(wxMouseEvent& mevent)
+{
+    try
+    {
+        if (mevent.GetModifiers() == wxMOD_CONTROL)
+        {
+            double const scaleFactor = ScaleFactor();
+            wxRealPoint pt((double) mevent.m_x / scaleFactor, (double) mevent.m_y / scaleFactor);
+            ToggleBookmark(pt);
+            m_showBookmarks = true;
+            pFrame->bookmarks_menu->Check(MENU_BOOKMARKS_SHOW, GetBookmarksShown());
+            Refresh();
+            Update();
+            return;
+        }
+
+        if (GetState() > STATE_SELECTED)
+        {
+            mevent.Skip();
+            throw THROW_INFO("Skipping event because state > STATE_SELECTED");
+        }
+
+        if (mevent.GetModifiers() == wxMOD_SHIFT)
+        {
+            // Deselect target
+            Debug.Write(wxS("manual deselect\n"));
+            InvalidateCurrentPosition(true);
+        }
+        else
+        {
+            usImage *pImage = CurrentImage();
+
+            if (pImage->NPixels == 0)
+            {
+                mevent.Skip();
+                throw ERROR_INFO("Skipping event m_pCurrentImage->NPixels == 0");
+            }
+
+            double scaleFactor = ScaleFactor();
+            double x = (double) mevent.m_x / scaleFactor;
+            double y = (double) mevent.m_y / scaleFactor;
+
+            if (SetCurrentPosition(pImage, PHD_Point(x, y)))
+            {
+                pFrame->StatusMsg(_("Unable to select target"));
+            }
+            else
+            {
+                SetLockPosition(m_target);
+                pFrame->StatusMsg(wxString::Format(_("Selected target at (%.1f, %.1f)"), m_target.X, m_target.Y));
+                EvtServer.NotifyStarSelected(CurrentPosition());
+                SetState(STATE_SELECTED);
+                pFrame->UpdateButtonsStatus();
+            }
+
+            Refresh();
+            Update();
+        }
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+    }
+}
+
+void GuiderPhaseCorrelation::OnPaint(wxPaintEvent& event)
+{
+    wxAutoBufferedPaintDC dc(this);
+    wxMemoryDC memDC;
+
+    try
+    {
+        if (PaintHelper(dc, memDC))
+        {
+            throw ERROR_INFO("PaintHelper failed");
+        }
+
+        if (m_showBookmarks && m_bookmarks.size() > 0)
+        {
+            dc.SetPen(wxPen(wxColour(0, 255, 255), 1, wxPENSTYLE_SOLID));
+            dc.SetBrush(*wxTRANSPARENT_BRUSH);
+
+            for (std::vector<wxRealPoint>::const_iterator it = m_bookmarks.begin(); it != m_bookmarks.end(); ++it)
+            {
+                wxPoint p((int) (it->x * m_scaleFactor), (int) (it->y * m_scaleFactor));
+                dc.DrawCircle(p, 3);
+                dc.DrawCircle(p, 6);
+                dc.DrawCircle(p, 12);
+            }
+        }
+
+        GUIDER_STATE state = GetState();
+        if (m_correlator.HasReference() && state >= STATE_SELECTED && state <= STATE_GUIDING)
+        {
+            if (!m_target.WasFound())
+                dc.SetPen(wxPen(wxColour(230, 130, 30), 1, wxPENSTYLE_DOT));
+            else if (state == STATE_SELECTED)
+                dc.SetPen(wxPen(wxColour(100, 255, 90), 1, wxPENSTYLE_SOLID));
+            else
+                dc.SetPen(wxPen(wxColour(32, 196, 32), 1, wxPENSTYLE_SOLID));
+            dc.SetBrush(*wxTRANSPARENT_BRUSH);
+
+            // the correlation region and a cross at the tracked position
+            double half = m_correlator.Size() / 2.0;
+            int w = ROUND(2.0 * half * m_scaleFactor);
+            dc.DrawRectangle(int((m_target.X - half) * m_scaleFactor), int((m_target.Y - half) * m_scaleFactor), w, w);
+            wxPoint c(ROUND(m_target.X * m_scaleFactor), ROUND(m_target.Y * m_scaleFactor));
+            dc.DrawLine(c.x - 5, c.y, c.x + 6, c.y);
+            dc.DrawLine(c.x, c.y - 5, c.x, c.y + 6);
+        }
+    }
+    catch (const wxString& Msg)
+    {
+        POSSIBLY_UNUSED(Msg);
+    }
+}
+
+wxString GuiderPhaseCorrelation::GetSettingsSummary() const
+{
+    // return a loggable summary of guider configs
+    return wxString::Format(_T("Phase correlation, region = %u px, reference update = %.1f%%, min quality = %.1f\n"),
+                            m_regionSize, m_referenceUpdate * 100.0, m_minQuality);
+}
+
+Guider::GuiderConfigDialogPane *GuiderPhaseCorrelation::GetConfigDialogPane(wxWindow *pParent)
+{
+    return new GuiderPhaseCorrelationConfigDialogPane(pParent, this);
+}
+
+GuiderPhaseCorrelation::GuiderPhaseCorrelationConfigDialogPane::GuiderPhaseCorrelationConfigDialogPane(
+    wxWindow *pParent, GuiderPhaseCorrelation *pGuider)
+    : GuiderConfigDialogPane(pParent, pGuider)
+{
+}
+
+void GuiderPhaseCorrelation::GuiderPhaseCorrelationConfigDialogPane::LayoutControls(Guider *pGuider,
+                                                                                      BrainCtrlIdMap& CtrlMap)
+{
+    GuiderConfigDialogPane::LayoutControls(pGuider, CtrlMap);
+}
+
+GuiderConfigDialogCtrlSet *GuiderPhaseCorrelation::GetConfigDialogCtrlSet(wxWindow *pParent, Guider *pGuider,
+                                                                          AdvancedDialog *pAdvancedDialog,
+                                                                          BrainCtrlIdMap& CtrlMap)
+{
+    return new GuiderPhaseCorrelationConfigDialogCtrlSet(pParent, pGuider, pAdvancedDialog, CtrlMap);
+}
+
+GuiderPhaseCorrelationConfigDialogCtrlSet::GuiderPhaseCorrelationConfigDialogCtrlSet(wxWindow *pParent, Guider *pGuider,
+                                                                                     AdvancedDialog *pAdvancedDialog,
+                                                                                     BrainCtrlIdMap& CtrlMap)
+    : GuiderConfigDialogCtrlSet(pParent, pGuider, pAdvancedDialog, CtrlMap)
+{
+    assert(pGuider);
+    m_pGuiderPhaseCorrelation = static_cast<GuiderPhaseCorrelation *>(pGuider);
+
+    wxWindow *parent = GetParentWindow(AD_szStarTracking);
+
+    wxArrayString sizes;
+    for (unsigned int size : s_regionSizes)
+        sizes.Add(wxString::Format("%u", size));
+    m_pRegionSize = new wxChoice(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, sizes);
+    wxSizer *pRegionSize = MakeLabeledControl(
+        AD_szStarTracking, _("Region size (pixels)"), m_pRegionSize,
+        _("Size of the square region around the target that is registered against the reference. The region should "
+          "contain the whole target with some margin. Larger regions take longer to process. Default = 128"));
+
+    int width = StringWidth(_T("100.0"));
+    m_pReferenceUpdate = pFrame->MakeSpinCtrlDouble(parent, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(width, -1),
+                                                    wxSP_ARROW_KEYS, 0.0, 20.0, 2.0, 0.5, _T("ReferenceUpdate"));
+    m_pReferenceUpdate->SetDigits(1);
+    wxSizer *pReferenceUpdate = MakeLabeledControl(
+        AD_szStarTracking, _("Reference update (%)"), m_pReferenceUpdate,
+        _("How much of each frame is blended into the reference, so that guiding follows slow changes in the target such as "
+          "a comet's coma or seeing. 0 keeps the reference taken at selection. Default = 2%"));
+
+    m_pMinQuality = pFrame->MakeSpinCtrlDouble(parent, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(width, -1),
+                                               wxSP_ARROW_KEYS, 3.0, 100.0, DefaultMinQuality, 1.0, _T("MinQuality"));
+    m_pMinQuality->SetDigits(0);
+    wxSizer *pMinQuality = MakeLabeledControl(
+        AD_szStarTracking, _("Minimum correlation quality"), m_pMinQuality,
+        _("Frames whose correlation peak stands out from the background of the correlation by less than this many standard "
+          "deviations are treated like a lost star. Default = 10"));
+
+    m_pBeepForLostStarCtrl = new wxCheckBox(GetParentWindow(AD_cbBeepForLostStar), wxID_ANY, _("Beep on lost star"));
+    m_pBeepForLostStarCtrl->SetToolTip(_("Issue an audible alarm any time the guide star is lost"));
+
+    wxFlexGridSizer *pTrackingParams = new wxFlexGridSizer(2, 2, 8, 15);
+    pTrackingParams->Add(pRegionSize, wxSizerFlags(0).Border(wxTOP, 3));
+    pTrackingParams->Add(pReferenceUpdate, wxSizerFlags(0).Border(wxLEFT, 75));
+    pTrackingParams->Add(pMinQuality, wxSizerFlags(0).Border(wxTOP, 3));
+    pTrackingParams->Add(m_pBeepForLostStarCtrl, wxSizerFlags(0).Border(wxLEFT, 75));
+
+    AddGroup(CtrlMap, AD_szStarTracking, pTrackingParams);
+}
+
+GuiderPhaseCorrelationConfigDialogCtrlSet::~GuiderPhaseCorrelationConfigDialogCtrlSet() { }
+
+void GuiderPhaseCorrelationConfigDialogCtrlSet::LoadValues()
+{
+    unsigned int size = m_pGuiderPhaseCorrelation->GetRegionSize();
+    for (unsigned int i = 0; i < WXSIZEOF(s_regionSizes); i++)
+        if (s_regionSizes[i] == size)
+            m_pRegionSize->SetSelection(i);
+    m_pReferenceUpdate->SetValue(100.0 * m_pGuiderPhaseCorrelation->GetReferenceUpdate());
+    m_pMinQuality->SetValue(m_pGuiderPhaseCorrelation->GetMinQuality());
+    m_pBeepForLostStarCtrl->SetValue(pFrame->GetBeepForLostStar());
+    GuiderConfigDialogCtrlSet::LoadValues();
+}
+
+void GuiderPhaseCorrelationConfigDialogCtrlSet::UnloadValues()
+{
+    int sel = m_pRegionSize->GetSelection();
+    if (sel != wxNOT_FOUND)
+        m_pGuiderPhaseCorrelation->SetRegionSize(s_regionSizes[sel]);
+    m_pGuiderPhaseCorrelation->SetReferenceUpdate(m_pReferenceUpdate->GetValue() / 100.0);
+    m_pGuiderPhaseCorrelation->SetMinQuality(m_pMinQuality->GetValue());
+    if (m_pBeepForLostStarCtrl->GetValue() != pFrame->GetBeepForLostStar())
+        pFrame->SetBeepForLostStar(m_pBeepForLostStarCtrl->GetValue());
+    GuiderConfigDialogCtrlSet::UnloadValues();
+}
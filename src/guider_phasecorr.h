@@ -0,0 +1,150 @@
+/*
+ *  guider_phasecorr.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef GUIDER_PHASECORR_H_INCLUDED
+#define GUIDER_PHASECORR_H_INCLUDED
+
+class GuiderPhaseCorrelation;
+
+class GuiderPhaseCorrelationConfigDialogCtrlSet : public GuiderConfigDialogCtrlSet
+{
+public:
+    GuiderPhaseCorrelationConfigDialogCtrlSet(wxWindow *pParent, Guider *pGuider, AdvancedDialog *pAdvancedDialog,
+                                              BrainCtrlIdMap& CtrlMap);
+    virtual ~GuiderPhaseCorrelationConfigDialogCtrlSet();
+
+    GuiderPhaseCorrelation *m_pGuiderPhaseCorrelation;
+    wxChoice *m_pRegionSize;
+    wxSpinCtrlDouble *m_pReferenceUpdate;
+    wxSpinCtrlDouble *m_pMinQuality;
+    wxCheckBox *m_pBeepForLostStarCtrl;
+
+    virtual void LoadValues();
+    virtual void UnloadValues();
+};
+
+// Guides on an extended or faint target -- a comet, a planetary disk, solar detail or a crowded
+// field -- by registering a square region around it against a reference with FFT phase
+// correlation, instead of centroiding a single star.
+//
+// The tracked position is the center of the region when the target was selected; the region
+// follows the target from frame to frame. The reference spectrum is updated a little with every
+// good frame so that it follows slow changes in the target's appearance.
+class GuiderPhaseCorrelation : public Guider
+{
+    Star m_target; // tracked position; SNR holds the correlation quality
+    PhaseCorrelator m_correlator;
+
+    // parameters
+    unsigned int m_regionSize;
+    double m_referenceUpdate;
+    double m_minQuality;
+
+public:
+    class GuiderPhaseCorrelationConfigDialogPane : public GuiderConfigDialogPane
+    {
+    public:
+        GuiderPhaseCorrelationConfigDialogPane(wxWindow *pParent, GuiderPhaseCorrelation *pGuider);
+        ~GuiderPhaseCorrelationConfigDialogPane() {};
+
+        virtual void LoadValues() {};
+        virtual void UnloadValues() {};
+        void LayoutControls(Guider *pGuider, BrainCtrlIdMap& CtrlMap);
+    };
+
+    unsigned int GetRegionSize() const { return m_regionSize; }
+    bool SetRegionSize(unsigned int size);
+    double GetReferenceUpdate() const { return m_referenceUpdate; }
+    bool SetReferenceUpdate(double fraction);
+    double GetMinQuality() const { return m_minQuality; }
+    bool SetMinQuality(double quality);
+
+    friend class GuiderPhaseCorrelationConfigDialogCtrlSet;
+
+public:
+    GuiderPhaseCorrelation(wxWindow *parent);
+    virtual ~GuiderPhaseCorrelation();
+
+    void OnPaint(wxPaintEvent& evt) override;
+
+    bool IsLocked() const override;
+    bool AutoSelect(const wxRect& roi) override;
+    const PHD_Point& CurrentPosition() const override;
+    wxRect GetBoundingBox() const override;
+    int GetMaxMovePixels() const override;
+    const Star& PrimaryStar() const override;
+    wxString GetSettingsSummary() const override;
+
+    Guider::GuiderConfigDialogPane *GetConfigDialogPane(wxWindow *pParent) override;
+    GuiderConfigDialogCtrlSet *GetConfigDialogCtrlSet(wxWindow *pParent, Guider *pGuider, AdvancedDialog *pAdvancedDialog,
+                                                      BrainCtrlIdMap& CtrlMap) override;
+
+    void LoadProfileSettings() override;
+
+private:
+    unsigned int EffectiveRegionSize(const usImage *pImage) const;
+    wxPoint RegionOrigin(const usImage *pImage, const PHD_Point& center) const;
+    bool SelectTarget(const usImage *pImage, const PHD_Point& position);
+
+    bool IsValidLockPosition(const PHD_Point& pt) final;
+    bool IsValidSecondaryStarPosition(const PHD_Point& pt) final;
+    void InvalidateCurrentPosition(bool fullReset = false) final;
+    bool UpdateCurrentPosition(const usImage *pImage, GuiderOffset *ofs, FrameDroppedInfo *errorInfo) final;
+    bool SetCurrentPosition(const usImage *pImage, const PHD_Point& position) final;
+
+    void OnLClick(wxMouseEvent& evt);
+
+    wxDECLARE_EVENT_TABLE();
+};
+
+inline int GuiderPhaseCorrelation::GetMaxMovePixels() const
+{
+    return m_regionSize / 4;
+}
+
+inline const Star& GuiderPhaseCorrelation::PrimaryStar() const
+{
+    return m_target;
+}
+
+inline bool GuiderPhaseCorrelation::IsLocked() const
+{
+    return m_target.WasFound();
+}
+
+inline const PHD_Point& GuiderPhaseCorrelation::CurrentPosition() const
+{
+    return m_target;
+}
+
+#endif /* GUIDER_PHASECORR_H_INCLUDED */
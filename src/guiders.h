@@ -38,5 +38,7 @@
 
 #include "guider.h"
 #include "guider_multistar.h"
+#include "phase_correlator.h"
+#include "guider_phasecorr.h"
 
 #endif /* GUIDERS_H_INCLUDED */
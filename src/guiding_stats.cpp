@@ -33,9 +33,11 @@
  *
  */
 
-#include "phd.h"
+#include <assert.h>
 #include <math.h>
 #include <algorithm>
+#include <limits>
+#include <vector>
 #include "guiding_stats.h"
 
 // Descriptive stats and axial stats classes
@@ -285,11 +287,12 @@ void AxisStats::InitializeScalars()
 {
     axisMoves = 0;
     axisReversals = 0;
-    sumY = 0.;
-    sumYSq = 0.;
-    sumX = 0.;
-    sumXY = 0.;
-    sumXSq = 0.;
+    meanX = 0.;
+    meanY = 0.;
+    devXX = 0.;
+    devYY = 0.;
+    devXY = 0.;
+    removals = 0;
     prevPosition = 0.;
     prevMove = 0.;
     minDisplacement = std::numeric_limits<double>::max();
@@ -318,6 +321,77 @@ StarDisplacement AxisStats::GetEntry(unsigned int inx) const
         return StarDisplacement(0., 0.);
 }
 
+// Update the running moments for a new entry (x, y), before it is added to guidingEntries
+void AxisStats::AddMoments(double x, double y)
+{
+    double const n = guidingEntries.size() + 1;
+    double const dx = x - meanX;
+    double const dy = y - meanY;
+    meanX += dx / n;
+    meanY += dy / n;
+    devXX += dx * (x - meanX);
+    devYY += dy * (y - meanY);
+    devXY += dx * (y - meanY);
+}
+
+// Update the running moments for the removal of entry (x, y), before it is removed from guidingEntries
+void AxisStats::RemoveMoments(double x, double y)
+{
+    size_t const sz = guidingEntries.size();
+
+    if (sz <= 1)
+    {
+        meanX = meanY = devXX = devYY = devXY = 0.;
+        return;
+    }
+
+    double const n = sz - 1;
+    double const dy = y - meanY;
+    double const newMeanX = meanX - (x - meanX) / n;
+    double const newMeanY = meanY - dy / n;
+    devXX -= (x - meanX) * (x - newMeanX);
+    devYY -= dy * (y - newMeanY);
+    devXY -= (x - newMeanX) * dy;
+    meanX = newMeanX;
+    meanY = newMeanY;
+
+    // Rounding errors from removals accumulate, so every time as many entries have been removed as remain in the dataset,
+    // start over from the retained entries. This keeps the cost O(1) per entry on average
+    if (++removals >= sz)
+        RecomputeMoments();
+}
+
+// Recompute the moments from the dataset (two-pass), ignoring the oldest entry if it is about to be removed
+void AxisStats::RecomputeMoments()
+{
+    removals = 0;
+
+    size_t const sz = guidingEntries.size();
+    size_t const first = sz > 0 ? 1 : 0; // called from RemoveMoments, the oldest entry is going away
+    size_t const n = sz - first;
+
+    meanX = meanY = devXX = devYY = devXY = 0.;
+    if (n == 0)
+        return;
+
+    for (size_t i = first; i < sz; i++)
+    {
+        meanX += guidingEntries[i].DeltaTime;
+        meanY += guidingEntries[i].StarPos;
+    }
+    meanX /= n;
+    meanY /= n;
+
+    for (size_t i = first; i < sz; i++)
+    {
+        double const dx = guidingEntries[i].DeltaTime - meanX;
+        double const dy = guidingEntries[i].StarPos - meanY;
+        devXX += dx * dx;
+        devYY += dy * dy;
+        devXY += dx * dy;
+    }
+}
+
 // DeltaT needs to be a small number, on the order of a guide exposure time, not a full time-of-day
 void AxisStats::AddGuideInfo(double DeltaT, double StarPos, double GuideAmt)
 {
@@ -326,11 +400,7 @@ void AxisStats::AddGuideInfo(double DeltaT, double StarPos, double GuideAmt)
     minDisplacement = std::min(StarPos, minDisplacement);
     maxDisplacement = std::max(StarPos, maxDisplacement);
 
-    sumX += DeltaT;
-    sumXY += DeltaT * StarPos;
-    sumXSq += DeltaT * DeltaT;
-    sumYSq += StarPos * StarPos;
-    sumY += StarPos;
+    AddMoments(DeltaT, StarPos);
 
     if (GuideAmt != 0.)
     {
@@ -389,7 +459,7 @@ unsigned int AxisStats::GetCount() const
 // Return sum.
 double AxisStats::GetSum() const
 {
-    return sumY;
+    return meanY * guidingEntries.size();
 }
 
 // Return mean of dataset. Caller should insure count > 0
@@ -398,7 +468,7 @@ double AxisStats::GetMean() const
     size_t sz = guidingEntries.size();
 
     if (sz > 0)
-        return sumY / sz;
+        return meanY;
     else
         return 0.;
 }
@@ -411,8 +481,7 @@ double AxisStats::GetVariance() const
 
     if (sz > 1)
     {
-        double entryCount = sz;
-        rslt = (entryCount * sumYSq - sumY * sumY) / (entryCount * (entryCount - 1.));
+        rslt = devYY / (sz - 1.);
     }
     else
         rslt = 0.;
@@ -428,7 +497,7 @@ double AxisStats::GetSigma() const
 
     if (sz > 1)
     {
-        double variance = (sz * sumYSq - sumY * sumY) / (sz * (sz - 1));
+        double variance = devYY / (sz - 1.);
         if (variance >= 0.)
             rslt = sqrt(variance);
         else
@@ -448,7 +517,7 @@ double AxisStats::GetPopulationSigma() const
 
     if (sz > 1)
     {
-        double variance = (sz * sumYSq - sumY * sumY) / (sz * sz);
+        double variance = devYY / sz;
         if (variance >= 0.)
             rslt = sqrt(variance);
         else
@@ -517,7 +586,7 @@ double AxisStats::GetMaxDisplacement() const
         return 0.;
 }
 
-// Return linear fit results for dataset, windowed or not.  This is inexpensive unless Sigma is needed
+// Return linear fit results for dataset, windowed or not.  This is O(1), computed from the running moments
 // (Optional) Sigma is standard deviation of dataset after linear fit (drift) has been removed
 // Caller should insure count > 1
 // Returns R-Squared, a measure of correlation between the linear fit and the original data set
@@ -534,42 +603,20 @@ double AxisStats::GetLinearFitResults(double *Slope, double *Intercept, double *
         return 0.;
     }
 
-    double currentVariance = 0.;
-    double currentMean = 0.;
+    double slope = devXX > 0. ? devXY / devXX : 0.;
+    double intcpt = meanY - slope * meanX;
 
-    double slope = ((numVals * sumXY) - (sumX * sumY)) / ((numVals * sumXSq) - (sumX * sumX));
-    // double constrainedSlope = sumXY / sumXSq;          // Possible future use, slope value if intercept is constrained to be
-    // zero
-    double intcpt = (sumY - (slope * sumX)) / numVals;
+    // residual sum of squares of the drift-removed data; the residuals have zero mean
+    double SSE = std::max(devYY - slope * devXY, 0.);
 
     if (Sigma)
-    {
-        // Apply the linear fit to the data points and compute their resultant sigma
-        for (size_t inx = 0; inx < numVals; inx++)
-        {
-            double newVal = guidingEntries[inx].StarPos - (guidingEntries[inx].DeltaTime * slope + intcpt);
-            if (inx == 0)
-                currentMean = newVal;
-            else
-            {
-                double delta = newVal - currentMean;
-                double newMean = currentMean + delta / numVals;
-                currentVariance += delta * delta;
-                currentMean = newMean;
-            }
-        }
-        *Sigma = sqrt(currentVariance / (numVals - 1));
-    }
+        *Sigma = sqrt(SSE / (numVals - 1));
 
     *Slope = slope;
     *Intercept = intcpt;
 
     // Compute R-Squared coefficient of determination
-    double Syy = sumYSq - (sumY * sumY) / numVals;
-    double Sxy = sumXY - (sumX * sumY) / numVals;
-    double Sxx = sumXSq - (sumX * sumX) / numVals;
-    double SSE = Syy - (Sxy * Sxy) / Sxx;
-    double rSquared = (Syy - SSE) / Syy;
+    double rSquared = devYY > 0. ? (devYY - SSE) / devYY : 0.;
 
     return rSquared;
 }
@@ -664,13 +711,7 @@ void WindowedAxisStats::RemoveOldestEntry()
     if (sz > 0)
     {
         StarDisplacement target = guidingEntries.front();
-        double val = target.StarPos;
-        double deltaT = target.DeltaTime;
-        sumY -= val;
-        sumYSq -= val * val;
-        sumX -= deltaT;
-        sumXSq -= deltaT * deltaT;
-        sumXY -= deltaT * val;
+        RemoveMoments(target.DeltaTime, target.StarPos);
         if (target.Reversal)
             axisReversals--;
         if (target.Guided)
@@ -128,18 +128,24 @@ protected:
     unsigned int axisReversals; // number of times in window when guide pulse caused a direction reversal
     double prevMove; // value of guide pulse in next-to-last entry
     double prevPosition; // value of guide star location in next-to-last entry
-    // Variables used to compute stats in windowed AxisStats
-    double sumX; // Sum of the x values (deltaT values)
-    double sumY; // Sum of the y values (star position)
-    double sumXY; // Sum of (x * y)
-    double sumXSq; // Sum of (x squared)
-    double sumYSq; // Sum of (y squared)
+    // Running moments used to compute stats and the linear fit in O(1), updated with Welford's method as entries are added
+    // and removed. Deviations are taken from the running means, so large x values (time) don't lose precision the way raw
+    // sums of squares do
+    double meanX; // Mean of the x values (deltaT values)
+    double meanY; // Mean of the y values (star position)
+    double devXX; // Sum of (x - meanX) squared
+    double devYY; // Sum of (y - meanY) squared
+    double devXY; // Sum of (x - meanX) * (y - meanY)
+    unsigned int removals; // entries removed since the moments were last recomputed from the dataset
     // Variables needed for windowed or non-windowed versions
     double maxDisplacement; // maximum star position value in current dataset
     double minDisplacement; // minimum star position value in current dataset
     double maxDelta; // maximum absolute delta of incremental star deltas
     int maxDeltaInx;
     void InitializeScalars();
+    void AddMoments(double x, double y);
+    void RemoveMoments(double x, double y);
+    void RecomputeMoments();
 
 public:
     // Constructor for 3 types of instance: non-windowed, windowed with automatic trimming of size, windowed but with client
@@ -40,6 +40,7 @@
 #include <wx/tokenzr.h>
 
 #include <algorithm>
+#include <thread>
 
 int dbl_sort_func(double *first, double *second)
 {
@@ -504,6 +505,365 @@ void Median3(unsigned short *dst, const unsigned short *src, const wxSize& size,
 #undef IX
 }
 
+// 3x3 median of one row of a region, with the same edge handling as Median3. up and dn
+// point to the rows above and below, or are null at the top or bottom of the region.
+static void median3_row(unsigned short *d, const unsigned short *up, const unsigned short *row, const unsigned short *dn,
+                        int w)
+{
+    unsigned short a[9];
+
+    if (!up || !dn)
+    {
+        // top or bottom row: 2 rows are available
+        const unsigned short *r0 = up ? up : row;
+        const unsigned short *r1 = up ? row : dn;
+
+        a[0] = r0[0];
+        a[1] = r0[1];
+        a[2] = r1[0];
+        a[3] = r1[1];
+        *d++ = median4(a);
+
+        for (int x = 1; x <= w - 2; x++)
+        {
+            a[0] = r0[x - 1];
+            a[1] = r0[x];
+            a[2] = r0[x + 1];
+            a[3] = r1[x - 1];
+            a[4] = r1[x];
+            a[5] = r1[x + 1];
+            *d++ = median6(a);
+        }
+
+        a[0] = r0[w - 2];
+        a[1] = r0[w - 1];
+        a[2] = r1[w - 2];
+        a[3] = r1[w - 1];
+        *d = median4(a);
+        return;
+    }
+
+    a[0] = up[0];
+    a[1] = up[1];
+    a[2] = row[0];
+    a[3] = row[1];
+    a[4] = dn[0];
+    a[5] = dn[1];
+    *d++ = median6(a);
+
+    for (int x = 1; x <= w - 2; x++)
+    {
+        a[0] = up[x - 1];
+        a[1] = up[x];
+        a[2] = up[x + 1];
+        a[3] = row[x - 1];
+        a[4] = row[x];
+        a[5] = row[x + 1];
+        a[6] = dn[x - 1];
+        a[7] = dn[x];
+        a[8] = dn[x + 1];
+        *d++ = median9(a);
+    }
+
+    a[0] = up[w - 2];
+    a[1] = up[w - 1];
+    a[2] = row[w - 2];
+    a[3] = row[w - 1];
+    a[4] = dn[w - 2];
+    a[5] = dn[w - 1];
+    *d = median6(a);
+}
+
+// 2x2 mean of one row of a region, with the same edge handling as QuickLRecon. dn is null
+// for the bottom row of the region.
+static void mean2x2_row(unsigned short *d, const unsigned short *row, const unsigned short *dn, int w)
+{
+    if (dn)
+    {
+        for (int x = 0; x <= w - 2; x++)
+        {
+            unsigned int t = (unsigned int) row[x] + row[x + 1] + dn[x] + dn[x + 1];
+            d[x] = (unsigned short) (t >> 2);
+        }
+        d[w - 1] = (unsigned short) (((unsigned int) row[w - 1] + dn[w - 1]) >> 1);
+    }
+    else
+    {
+        for (int x = 0; x <= w - 2; x++)
+            d[x] = (unsigned short) (((unsigned int) row[x] + row[x + 1]) >> 1);
+        d[w - 1] = row[w - 1];
+    }
+}
+
+struct PreprocBand
+{
+    std::vector<int> histo; // all zero between frames
+    std::vector<unsigned short> rowbuf; // 3 filtered rows plus one median row
+    unsigned short minADU, maxADU;
+    unsigned short filtMin, filtMax;
+};
+
+struct FramePreprocessorImpl
+{
+    usImage scratch;
+    std::vector<PreprocBand> bands;
+};
+
+FramePreprocessor::FramePreprocessor() : m_impl(new FramePreprocessorImpl()) { }
+
+FramePreprocessor::~FramePreprocessor()
+{
+    delete m_impl;
+}
+
+// Filter, histogram and median-filter rows [y0, y1) of region r. Filtered rows are kept in a
+// ring of 3 row buffers so the 3x3 median for the filtered min/max can be taken while the
+// rows are still in cache; the rows just outside the band are filtered again rather than
+// shared with the neighboring bands.
+static void PreprocessBand(PreprocBand& band, const usImage& img, const wxRect& r, int method, unsigned short *dst, int y0,
+                           int y1)
+{
+    int const W = img.Size.GetWidth();
+    int const RW = r.GetWidth();
+    int const RH = r.GetHeight();
+    bool const filter = method == NR_2x2MEAN || method == NR_3x3MEDIAN;
+
+    auto src_row = [&](int y) -> const unsigned short * { return img.ImageData + (r.GetY() + y) * W + r.GetX(); };
+
+    auto filtered_row = [&](int slot, int y) -> const unsigned short *
+    {
+        if (!filter)
+            return src_row(y);
+
+        unsigned short *d = &band.rowbuf[slot * RW];
+        const unsigned short *dn = y + 1 < RH ? src_row(y + 1) : nullptr;
+        if (method == NR_2x2MEAN)
+            mean2x2_row(d, src_row(y), dn, RW);
+        else
+            median3_row(d, y > 0 ? src_row(y - 1) : nullptr, src_row(y), dn, RW);
+        return d;
+    };
+
+    unsigned short *med = &band.rowbuf[3 * RW];
+    int *histo = &band.histo[0];
+    unsigned short minADU = 65535, maxADU = 0;
+    unsigned short filtMin = 65535, filtMax = 0;
+
+    int sp = 0, sc = 1, sn = 2;
+    const unsigned short *prev = y0 > 0 ? filtered_row(sp, y0 - 1) : nullptr;
+    const unsigned short *cur = filtered_row(sc, y0);
+
+    for (int y = y0; y < y1; y++)
+    {
+        const unsigned short *next = y + 1 < RH ? filtered_row(sn, y + 1) : nullptr;
+
+        if (dst)
+            memcpy(dst + (r.GetY() + y) * W + r.GetX(), cur, RW * sizeof(unsigned short));
+
+        for (int x = 0; x < RW; x++)
+        {
+            unsigned short v = cur[x];
+            if (v < minADU)
+                minADU = v;
+            if (v > maxADU)
+                maxADU = v;
+            histo[v]++;
+        }
+
+        median3_row(med, prev, cur, next, RW);
+        for (int x = 0; x < RW; x++)
+        {
+            unsigned short v = med[x];
+            if (v < filtMin)
+                filtMin = v;
+            if (v > filtMax)
+                filtMax = v;
+        }
+
+        int const t = sp;
+        sp = sc;
+        sc = sn;
+        sn = t;
+        prev = cur;
+        cur = next;
+    }
+
+    band.minADU = minADU;
+    band.maxADU = maxADU;
+    band.filtMin = filtMin;
+    band.filtMax = filtMax;
+}
+
+bool FramePreprocessor::Process(usImage& img, int noiseReductionMethod)
+{
+    if (!img.ImageData || !img.NPixels)
+        return false;
+
+    wxRect const r = img.Subframe.IsEmpty() ? wxRect(img.Size) : img.Subframe;
+
+    // with a multi-ROI capture each window is filtered and measured on its own
+    std::vector<wxRect> regions;
+    if (img.ROIs.empty())
+        regions.push_back(r);
+    else
+    {
+        for (const wxRect& roi : img.ROIs)
+        {
+            wxRect w(roi);
+            w.Intersect(r);
+            if (!w.IsEmpty())
+                regions.push_back(w);
+        }
+    }
+
+    int maxWidth = 0;
+    bool small = regions.empty();
+    for (const wxRect& w : regions)
+    {
+        maxWidth = std::max(maxWidth, w.GetWidth());
+        if (w.GetWidth() < 2 || w.GetHeight() < 2)
+            small = true;
+    }
+
+    if (small)
+    {
+        // too small for the banded pass, fall back to the individual steps
+        bool err = false;
+        if (noiseReductionMethod == NR_2x2MEAN)
+            err = QuickLRecon(img);
+        else if (noiseReductionMethod == NR_3x3MEDIAN)
+            err = Median3(img);
+        img.CalcStats();
+        return err;
+    }
+
+    bool const filter = noiseReductionMethod == NR_2x2MEAN || noiseReductionMethod == NR_3x3MEDIAN;
+    unsigned short *dst = nullptr;
+
+    if (filter)
+    {
+        usImage& tmp = m_impl->scratch;
+        if (tmp.Init(img.Size))
+        {
+            pFrame->Alert(_("Memory allocation error"));
+            return true;
+        }
+        dst = tmp.ImageData;
+
+        if (!img.ROIs.empty())
+            tmp.Clear();
+        else if (!img.Subframe.IsEmpty())
+        {
+            // the filters leave zeros outside the subframe
+            int const W = img.Size.GetWidth();
+            int const H = img.Size.GetHeight();
+            int const RW = r.GetWidth();
+            int const RH = r.GetHeight();
+            memset(dst, 0, r.GetY() * W * sizeof(unsigned short));
+            for (int y = r.GetY(); y < r.GetY() + RH; y++)
+            {
+                unsigned short *row = dst + y * W;
+                memset(row, 0, r.GetX() * sizeof(unsigned short));
+                memset(row + r.GetX() + RW, 0, (W - r.GetX() - RW) * sizeof(unsigned short));
+            }
+            memset(dst + (r.GetY() + RH) * W, 0, (H - r.GetY() - RH) * W * sizeof(unsigned short));
+        }
+    }
+
+    std::vector<PreprocBand>& bands = m_impl->bands;
+    if (bands.empty())
+        bands.resize(1);
+
+    // the band histograms are merged into the first band's, leaving the others zeroed
+
+    int *histo = nullptr;
+    unsigned short minADU = 65535, maxADU = 0;
+    unsigned short filtMin = 65535, filtMax = 0;
+    int pixcnt = 0;
+
+    for (const wxRect& w : regions)
+    {
+        int const RW = w.GetWidth();
+        int const RH = w.GetHeight();
+
+        // one band per core on large frames; a guide star subframe is done in a single band
+        unsigned int nbands = std::max(1U, std::thread::hardware_concurrency());
+        nbands = std::min<unsigned int>(nbands, std::max(1, RW * RH / (256 * 1024)));
+        nbands = std::min<unsigned int>(nbands, RH);
+
+        if (bands.size() < nbands)
+            bands.resize(nbands);
+        for (unsigned int i = 0; i < nbands; i++)
+        {
+            if (bands[i].histo.empty())
+                bands[i].histo.resize(65536);
+            bands[i].rowbuf.resize(4 * maxWidth);
+        }
+        histo = &bands[0].histo[0];
+
+        if (nbands == 1)
+            PreprocessBand(bands[0], img, w, noiseReductionMethod, dst, 0, RH);
+        else
+        {
+            std::vector<std::thread> pool;
+            pool.reserve(nbands);
+            for (unsigned int i = 0; i < nbands; i++)
+            {
+                int y0 = (int) ((long long) RH * i / nbands);
+                int y1 = (int) ((long long) RH * (i + 1) / nbands);
+                pool.emplace_back([&, i, y0, y1]() { PreprocessBand(bands[i], img, w, noiseReductionMethod, dst, y0, y1); });
+            }
+            for (std::thread& th : pool)
+                th.join();
+        }
+
+        for (unsigned int i = 0; i < nbands; i++)
+        {
+            PreprocBand& b = bands[i];
+            if (i > 0)
+            {
+                int *h = &b.histo[0];
+                for (int v = b.minADU; v <= b.maxADU; v++)
+                {
+                    histo[v] += h[v];
+                    h[v] = 0;
+                }
+            }
+            minADU = std::min(minADU, b.minADU);
+            maxADU = std::max(maxADU, b.maxADU);
+            filtMin = std::min(filtMin, b.filtMin);
+            filtMax = std::max(filtMax, b.filtMax);
+        }
+
+        pixcnt += RW * RH;
+    }
+
+    unsigned short median = maxADU;
+    int pixelLeft = pixcnt / 2;
+    for (int v = minADU; v < maxADU; v++)
+    {
+        if (histo[v] > pixelLeft)
+        {
+            median = v;
+            break;
+        }
+        pixelLeft -= histo[v];
+    }
+
+    std::fill(histo + minADU, histo + maxADU + 1, 0);
+
+    if (filter)
+        img.SwapImageData(m_impl->scratch);
+
+    img.MinADU = minADU;
+    img.MaxADU = maxADU;
+    img.MedianADU = median;
+    img.FiltMin = filtMin;
+    img.FiltMax = filtMax;
+
+    return false;
+}
+
 static unsigned short MedianBorderingPixels(const usImage& img, int x, int y)
 {
     unsigned short array[8];
@@ -731,21 +1091,57 @@ bool Subtract(usImage& light, const usImage& dark)
     const unsigned int height = light_roi.height;
     const unsigned int width = light_roi.width;
     for (unsigned int r = 0; r < height; r++, pl0 += light.Size.GetWidth(), pd0 += dark.Size.GetWidth())
+        SubtractDarkRow(pl0, pd0, width, light.Pedestal);
+
+    return false;
+}
+
+static const SimdKernels& Kernels()
+{
+    static const SimdKernels s_kernels = [] {
+        SimdKernels k = AvailableSimdKernels().back();
+        Debug.Write(wxString::Format("Image kernels: %s\n", k.name));
+        return k;
+    }();
+    return s_kernels;
+}
+
+void SubtractDarkRow(unsigned short *light, const unsigned short *dark, unsigned int count, unsigned short pedestal)
+{
+    Kernels().subtract_row(light, dark, count, pedestal);
+}
+
+void AccumulatePSFNormals(const float *dx, const float *dy, const float *val, const float *weight, unsigned int count,
+                          const float params[5], double sums[PSF_NORMAL_SUMS])
+{
+    Kernels().psf_normals(dx, dy, val, weight, count, params, sums);
+}
+
+bool BinPixelsInPlace(usImage& img, unsigned int binning)
+{
+    if (binning < 2 || !img.ImageData)
+        return true;
+
+    unsigned int const srcw = img.Size.GetWidth();
+    unsigned int const dw = srcw / binning;
+    unsigned int const dh = img.Size.GetHeight() / binning;
+    unsigned int const tw = dw * binning;
+
+    const SimdKernels& k = Kernels();
+    std::vector<unsigned int> acc(tw + 1);
+
+    unsigned short *dst = img.ImageData;
+    for (unsigned int y = 0; y < dh; y++)
     {
-        unsigned short *const endl = pl0 + width;
-        unsigned short *pl;
-        const unsigned short *pd;
-        for (pl = pl0, pd = pd0; pl < endl; pl++, pd++)
-        {
-            int newval = (int) *pl + light.Pedestal - (int) *pd;
-            if (newval < 0)
-                newval = 0; // hot pixel in dark frame isn't present in light frame
-            else if (newval > 65535)
-                newval = 65535;
-            *pl = (unsigned short) newval;
-        }
+        k.column_sums(&acc[0], img.ImageData + y * binning * srcw, srcw, tw, binning);
+        k.bin_row(dst, &acc[0], dw, binning);
+        dst += dw;
     }
 
+    // the binned frame fits in the buffer's capacity, so the next full frame Init() reuses it
+    img.Size = wxSize(dw, dh);
+    img.NPixels = dw * dh;
+
     return false;
 }
 
@@ -947,12 +1343,44 @@ struct BadPx
     unsigned short y;
     int v;
 
-    BadPx();
+    BadPx() { }
     BadPx(int x_, int y_, int v_) : x(x_), y(y_), v(v_) { }
-    bool operator<(const BadPx& rhs) const { return v < rhs.v; }
 };
 
-typedef std::set<BadPx> BadPxSet;
+// Candidate defects of one polarity in a flat array sorted by ascending deviation, together
+// with the cumulative histogram of the deviations: first[v] is the index of the first pixel
+// whose deviation is >= v, so the pixels selected by a threshold are the array slice
+// [first[thresh], end) and are counted in constant time.
+struct BadPxList
+{
+    std::vector<BadPx> px;
+    std::vector<unsigned int> first; // 65537 entries
+
+    void Build(const std::vector<std::vector<BadPx>>& slices);
+    unsigned int Begin(int thresh) const
+    {
+        if (px.empty() || thresh <= 0)
+            return 0;
+        return first[std::min(thresh, 65536)];
+    }
+};
+
+void BadPxList::Build(const std::vector<std::vector<BadPx>>& slices)
+{
+    // counting sort on the deviation; stable, so equal deviations stay in raster order
+    first.assign(65537, 0);
+    for (const auto& slice : slices)
+        for (const BadPx& p : slice)
+            ++first[p.v + 1];
+    for (unsigned int v = 1; v < first.size(); v++)
+        first[v] += first[v - 1];
+
+    px.resize(first.back());
+    std::vector<unsigned int> next(first.begin(), first.end() - 1);
+    for (const auto& slice : slices)
+        for (const BadPx& p : slice)
+            px[next[p.v]++] = p;
+}
 
 struct DefectMapBuilderImpl
 {
@@ -961,10 +1389,10 @@ struct DefectMapBuilderImpl
     wxArrayString mapInfo;
     int aggrCold;
     int aggrHot;
-    BadPxSet coldPx;
-    BadPxSet hotPx;
-    BadPxSet::const_iterator coldPxThresh;
-    BadPxSet::const_iterator hotPxThresh;
+    BadPxList coldPx;
+    BadPxList hotPx;
+    unsigned int coldPxThresh;
+    unsigned int hotPxThresh;
     unsigned int coldPxSelected;
     unsigned int hotPxSelected;
     bool threshValid;
@@ -1005,31 +1433,59 @@ void DefectMapBuilder::Init(DefectMapDarks& darks)
 
     Debug.Write(wxString::Format("DefectMapBuilder: load potential defects thresh = %d\n", thresh));
 
-    usImage& dark = m_impl->darks->masterDark;
-    usImage& medianFilt = m_impl->darks->filteredDark;
+    const usImage& dark = m_impl->darks->masterDark;
+    const usImage& medianFilt = m_impl->darks->filteredDark;
 
-    m_impl->coldPx.clear();
-    m_impl->hotPx.clear();
+    int const W = dark.Size.GetWidth();
+    int const H = dark.Size.GetHeight();
 
-    for (int y = 0; y < dark.Size.GetHeight(); y++)
-    {
-        for (int x = 0; x < dark.Size.GetWidth(); x++)
+    // gather the candidates of each band of rows on its own thread
+    unsigned int nbands = std::max(1U, std::thread::hardware_concurrency());
+    nbands = std::min<unsigned int>(nbands, std::max(1, W * H / (256 * 1024)));
+    nbands = std::min<unsigned int>(nbands, std::max(1, H));
+
+    std::vector<std::vector<BadPx>> hot(nbands), cold(nbands);
+
+    auto scan = [&](unsigned int band, int y0, int y1) {
+        std::vector<BadPx>& h = hot[band];
+        std::vector<BadPx>& c = cold[band];
+        for (int y = y0; y < y1; y++)
         {
-            int filt = (int) medianFilt.Pixel(x, y);
-            int val = (int) dark.Pixel(x, y);
-            int v = val - filt;
-            if (v > thresh)
+            const unsigned short *d = dark.ImageData + (size_t) y * W;
+            const unsigned short *f = medianFilt.ImageData + (size_t) y * W;
+            for (int x = 0; x < W; x++)
             {
-                m_impl->hotPx.insert(BadPx(x, y, v));
-            }
-            else if (-v > thresh)
-            {
-                m_impl->coldPx.insert(BadPx(x, y, -v));
+                int v = (int) d[x] - (int) f[x];
+                if (v > thresh)
+                    h.push_back(BadPx(x, y, v));
+                else if (-v > thresh)
+                    c.push_back(BadPx(x, y, -v));
             }
         }
+    };
+
+    if (nbands == 1)
+        scan(0, 0, H);
+    else
+    {
+        std::vector<std::thread> pool;
+        pool.reserve(nbands);
+        for (unsigned int i = 0; i < nbands; i++)
+        {
+            int y0 = (int) ((long long) H * i / nbands);
+            int y1 = (int) ((long long) H * (i + 1) / nbands);
+            pool.emplace_back(scan, i, y0, y1);
+        }
+        for (std::thread& th : pool)
+            th.join();
     }
 
-    Debug.Write(wxString::Format("DefectMapBuilder: Loaded %d cold %d hot\n", m_impl->coldPx.size(), m_impl->hotPx.size()));
+    m_impl->hotPx.Build(hot);
+    m_impl->coldPx.Build(cold);
+    m_impl->threshValid = false;
+
+    Debug.Write(wxString::Format("DefectMapBuilder: Loaded %u cold %u hot\n", (unsigned int) m_impl->coldPx.px.size(),
+                                 (unsigned int) m_impl->hotPx.px.size()));
 }
 
 const ImageStats& DefectMapBuilder::GetImageStats() const
@@ -1058,11 +1514,11 @@ static void FindThresh(DefectMapBuilderImpl *impl)
     Debug.Write(wxString::Format("DefectMap: find thresholds aggr:(%d,%d) sigma:(%.1f,%.1f) px:(%+d,%+d)\n", impl->aggrCold,
                                  impl->aggrHot, multCold, multHot, -coldThresh, hotThresh));
 
-    impl->coldPxThresh = impl->coldPx.lower_bound(BadPx(0, 0, coldThresh));
-    impl->hotPxThresh = impl->hotPx.lower_bound(BadPx(0, 0, hotThresh));
+    impl->coldPxThresh = impl->coldPx.Begin(coldThresh);
+    impl->hotPxThresh = impl->hotPx.Begin(hotThresh);
 
-    impl->coldPxSelected = std::distance(impl->coldPxThresh, impl->coldPx.end());
-    impl->hotPxSelected = std::distance(impl->hotPxThresh, impl->hotPx.end());
+    impl->coldPxSelected = impl->coldPx.px.size() - impl->coldPxThresh;
+    impl->hotPxSelected = impl->hotPx.px.size() - impl->hotPxThresh;
 
     Debug.Write(wxString::Format("DefectMap: find thresholds found (%d,%d)\n", impl->coldPxSelected, impl->hotPxSelected));
 
@@ -1081,21 +1537,22 @@ int DefectMapBuilder::GetHotPixelCnt() const
     return m_impl->hotPxSelected;
 }
 
-inline static unsigned int emit_defects(DefectMap& defectMap, BadPxSet::const_iterator p0, BadPxSet::const_iterator p1,
-                                        double stdev, int sign, bool verbose)
+inline static unsigned int emit_defects(DefectMap& defectMap, const BadPxList& list, unsigned int begin, double stdev, int sign,
+                                        bool verbose)
 {
-    unsigned int cnt = 0;
-    for (BadPxSet::const_iterator it = p0; it != p1; ++it, ++cnt)
+    const BadPx *p0 = list.px.data() + begin;
+    const BadPx *p1 = list.px.data() + list.px.size();
+    for (const BadPx *p = p0; p != p1; ++p)
     {
         if (verbose)
         {
-            int v = sign * it->v;
-            Debug.Write(wxString::Format("DefectMap: defect @ (%d, %d) val = %d (%+.1f sigma)\n", it->x, it->y, v,
+            int v = sign * p->v;
+            Debug.Write(wxString::Format("DefectMap: defect @ (%d, %d) val = %d (%+.1f sigma)\n", p->x, p->y, v,
                                          stdev > 0.1 ? (double) v / stdev : 0.0));
         }
-        defectMap.push_back(wxPoint(it->x, it->y));
+        defectMap.push_back(wxPoint(p->x, p->y));
     }
-    return cnt;
+    return p1 - p0;
 }
 
 void DefectMapBuilder::BuildDefectMap(DefectMap& defectMap, bool verbose) const
@@ -1132,8 +1589,9 @@ void DefectMapBuilder::BuildDefectMap(DefectMap& defectMap, bool verbose) const
     FindThresh(m_impl);
 
     defectMap.clear();
-    unsigned int nr_cold = emit_defects(defectMap, m_impl->coldPxThresh, m_impl->coldPx.end(), stats.stdev, -1, verbose);
-    unsigned int nr_hot = emit_defects(defectMap, m_impl->hotPxThresh, m_impl->hotPx.end(), stats.stdev, +1, verbose);
+    defectMap.reserve(m_impl->coldPxSelected + m_impl->hotPxSelected);
+    unsigned int nr_cold = emit_defects(defectMap, m_impl->coldPx, m_impl->coldPxThresh, stats.stdev, -1, verbose);
+    unsigned int nr_hot = emit_defects(defectMap, m_impl->hotPx, m_impl->hotPxThresh, stats.stdev, +1, verbose);
 
     if (verbose)
         Debug.Write(
@@ -1230,6 +1688,33 @@ bool DefectMap::ImportFromProfile(int srcId, int destId)
     return true;
 }
 
+// A map learned from guide frames has no master dark to check the camera geometry against;
+// its header records the frame size instead. Returns UNDEFINED_FRAME_SIZE if there is none.
+static wxSize LearnedMapFrameSize(const wxString& filename)
+{
+    wxFileInputStream iStream(filename);
+    if (!iStream.IsOk())
+        return UNDEFINED_FRAME_SIZE;
+
+    wxTextInputStream inText(iStream);
+    while (!iStream.Eof())
+    {
+        wxString line = inText.ReadLine();
+        if (!line.StartsWith("#"))
+            break;
+
+        wxString rest;
+        long w, h;
+        if (line.StartsWith("# Frame Size: ", &rest) && rest.BeforeFirst('x').ToLong(&w) &&
+            rest.AfterFirst('x').ToLong(&h))
+        {
+            return wxSize(w, h);
+        }
+    }
+
+    return UNDEFINED_FRAME_SIZE;
+}
+
 bool DefectMap::DefectMapExists(int profileId, bool showAlert)
 {
     bool bOk = false;
@@ -1243,6 +1728,22 @@ bool DefectMap::DefectMapExists(int profileId, bool showAlert)
             bOk = true;
             Debug.AddLine("BPM check: undefined frame size for current camera");
         }
+        else if (!wxFileExists(fName))
+        {
+            // no master dark: the map was learned from guide frames
+            wxSize mapSize = LearnedMapFrameSize(DefectMapFileName(profileId));
+            if (mapSize == sensorSize)
+                bOk = true;
+            else if (mapSize == UNDEFINED_FRAME_SIZE)
+                Debug.AddLine("BPM check: no master dark and no frame size in map");
+            else
+            {
+                Debug.AddLine(wxString::Format("BPM check: learned map dimensions = {%d,%d}, cam dimensions = {%d,%d}",
+                                               mapSize.x, mapSize.y, sensorSize.x, sensorSize.y));
+                if (showAlert)
+                    pFrame->Alert(_("Bad-pixel map does not match the camera in this profile - it needs to be replaced."));
+            }
+        }
         else
         {
             fitsfile *fptr;
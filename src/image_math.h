@@ -62,6 +62,44 @@ extern bool Subtract(usImage& light, const usImage& dark);
 extern double CalcSlope(const ArrayOfDbl& y);
 extern bool RemoveDefects(usImage& light, const DefectMap& defectMap);
 
+// vectorized kernels (image_math_simd.cpp), selected at run time for the host CPU
+
+// light = min(max(light + pedestal - dark, 0), 65535) for count pixels
+extern void SubtractDarkRow(unsigned short *light, const unsigned short *dark, unsigned int count, unsigned short pedestal);
+// Bin img by averaging binning x binning blocks, truncating any partial blocks at the right
+// and bottom edges. The binned pixels are written into img's own buffer. Returns true on
+// error.
+extern bool BinPixelsInPlace(usImage& img, unsigned int binning);
+
+// Normal equations of a least-squares fit of b + a exp(-((x - x0)^2 + (y - y0)^2) / (2 s^2)),
+// params = { b, a, x0, y0, s }, over count pixels (a multiple of 4) at offsets (dx, dy) with
+// values val and weights weight. sums[0..14] receives the upper triangle of J'WJ row by row,
+// sums[15..19] J'Wr and sums[20] the weighted sum of squared residuals r.
+extern void AccumulatePSFNormals(const float *dx, const float *dy, const float *val, const float *weight, unsigned int count,
+                                 const float params[5], double sums[PSF_NORMAL_SUMS]);
+
+struct FramePreprocessorImpl;
+
+// Applies the noise reduction filter (a NOISE_REDUCTION_METHOD) to a captured frame and
+// computes its statistics. The result is the same as QuickLRecon() or Median3() followed by
+// usImage::CalcStats(), but the frame is swept once, in row bands that stay in cache, and
+// large frames are split across threads. The working buffers are kept between frames.
+// For a multi-ROI capture only the ROI windows are filtered and measured.
+class FramePreprocessor
+{
+    FramePreprocessorImpl *m_impl;
+
+    FramePreprocessor(const FramePreprocessor&) = delete;
+    FramePreprocessor& operator=(const FramePreprocessor&) = delete;
+
+public:
+    FramePreprocessor();
+    ~FramePreprocessor();
+
+    // returns true on error
+    bool Process(usImage& img, int noiseReductionMethod);
+};
+
 struct DefectMapBuilderImpl;
 
 struct DefectMapDarks
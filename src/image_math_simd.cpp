@@ -0,0 +1,588 @@
+/*
+ *  image_math_simd.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "image_math_simd.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+# define SIMD_X86
+# include <immintrin.h>
+# if defined(_MSC_VER) && !defined(__clang__)
+#  include <intrin.h>
+#  define TARGET_SSE2
+#  define TARGET_AVX2
+# else
+#  define TARGET_SSE2 __attribute__((target("sse2")))
+#  define TARGET_AVX2 __attribute__((target("avx2")))
+# endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+# define SIMD_NEON
+# include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+// Each kernel has a scalar reference version; the vector versions must produce
+// identical results (tests/image_math_simd_test.cpp).
+//
+// Dark subtraction computes min(max(light + pedestal - dark, 0), 65535) using 16-bit
+// lanes only. With r = light + pedestal (mod 65536):
+//   no carry out of r:  result = saturating r - dark
+//   carry out of r:     the true sum is 65536 + r, so the result is r - dark (mod 65536)
+//                       when dark > r, and saturates to 65535 otherwise
+//
+// Binning sums each group of binning rows into a row of 32-bit column sums, then adds
+// up groups of binning columns and divides. Output row y only overwrites pixels of input
+// rows before y * binning, so the image can be binned in place.
+//
+// The PSF normal equations kernel is the exception: it sums in float, one partial sum per
+// lane, so the vector versions agree with the scalar one to float rounding only. The Gaussian
+// is evaluated with a Cephes-style expf (range reduction by ln 2, degree-5 polynomial) that
+// maps directly onto vector instructions.
+
+static void subtract_row_scalar(unsigned short *light, const unsigned short *dark, unsigned int n, unsigned short pedestal)
+{
+    for (unsigned int i = 0; i < n; i++)
+    {
+        int newval = (int) light[i] + pedestal - (int) dark[i];
+        if (newval < 0)
+            newval = 0; // hot pixel in dark frame isn't present in light frame
+        else if (newval > 65535)
+            newval = 65535;
+        light[i] = (unsigned short) newval;
+    }
+}
+
+static void column_sums_scalar(unsigned int *acc, const unsigned short *src, unsigned int stride, unsigned int w,
+                               unsigned int binning)
+{
+    for (unsigned int x = 0; x < w; x++)
+        acc[x] = src[x];
+    for (unsigned int k = 1; k < binning; k++)
+    {
+        const unsigned short *row = src + k * stride;
+        for (unsigned int x = 0; x < w; x++)
+            acc[x] += row[x];
+    }
+}
+
+static void bin_row_scalar(unsigned short *dst, const unsigned int *acc, unsigned int dw, unsigned int binning)
+{
+    unsigned int const div = binning * binning;
+    for (unsigned int i = 0; i < dw; i++)
+    {
+        unsigned int t = 0;
+        for (unsigned int k = 0; k < binning; k++)
+            t += acc[i * binning + k];
+        dst[i] = (unsigned short) (t / div);
+    }
+}
+
+// Cephes expf constants
+static const float EXP_LOG2E = 1.44269504088896341f;
+static const float EXP_C1 = 0.693359375f;
+static const float EXP_C2 = -2.12194440e-4f;
+static const float EXP_P0 = 1.9875691500e-4f;
+static const float EXP_P1 = 1.3981999507e-3f;
+static const float EXP_P2 = 8.3334519073e-3f;
+static const float EXP_P3 = 4.1665795894e-2f;
+static const float EXP_P4 = 1.6666665459e-1f;
+static const float EXP_P5 = 5.0000001201e-1f;
+
+// exp(x) for x <= 0
+static inline float exp_scalar(float x)
+{
+    x = std::max(x, -87.0f);
+    float t = x * EXP_LOG2E + 0.5f;
+    float fx = floorf(t);
+    x = x - fx * EXP_C1;
+    x = x - fx * EXP_C2;
+    float z = x * x;
+    float y = EXP_P0;
+    y = y * x + EXP_P1;
+    y = y * x + EXP_P2;
+    y = y * x + EXP_P3;
+    y = y * x + EXP_P4;
+    y = y * x + EXP_P5;
+    y = y * z + x + 1.0f;
+    int bits = ((int) fx + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return y * scale;
+}
+
+static void psf_normals_scalar(const float *dx, const float *dy, const float *val, const float *weight, unsigned int n,
+                               const float p[5], double sums[PSF_NORMAL_SUMS])
+{
+    float acc[PSF_NORMAL_SUMS][4] = {};
+    float const b = p[0], a = p[1], x0 = p[2], y0 = p[3];
+    float const inv = 1.0f / (p[4] * p[4]);
+    float const inv3 = inv / p[4];
+    float const c = -0.5f * inv;
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+        unsigned int const lane = i & 3;
+        float ddx = dx[i] - x0;
+        float ddy = dy[i] - y0;
+        float r2 = ddx * ddx + ddy * ddy;
+        float e = exp_scalar(c * r2);
+        float ae = a * e;
+        float res = val[i] - (b + ae);
+        float const j[5] = { 1.0f, e, ae * ddx * inv, ae * ddy * inv, ae * r2 * inv3 };
+        float const w = weight[i];
+        unsigned int k = 0;
+        for (unsigned int r = 0; r < 5; r++)
+        {
+            float wj = w * j[r];
+            for (unsigned int col = r; col < 5; col++)
+                acc[k++][lane] += wj * j[col];
+            acc[15 + r][lane] += wj * res;
+        }
+        acc[20][lane] += w * res * res;
+    }
+
+    for (unsigned int k = 0; k < PSF_NORMAL_SUMS; k++)
+        sums[k] = ((double) acc[k][0] + acc[k][1]) + ((double) acc[k][2] + acc[k][3]);
+}
+
+#ifdef SIMD_X86
+
+TARGET_SSE2 static void subtract_row_sse2(unsigned short *light, const unsigned short *dark, unsigned int n,
+                                          unsigned short pedestal)
+{
+    __m128i const ped = _mm_set1_epi16((short) pedestal);
+    __m128i const ones = _mm_set1_epi16(-1);
+    __m128i const zero = _mm_setzero_si128();
+
+    unsigned int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i l = _mm_loadu_si128((const __m128i *) (light + i));
+        __m128i d = _mm_loadu_si128((const __m128i *) (dark + i));
+        __m128i r = _mm_add_epi16(l, ped);
+        __m128i carry = _mm_xor_si128(_mm_cmpeq_epi16(r, _mm_adds_epu16(l, ped)), ones);
+        __m128i lo = _mm_subs_epu16(r, d);
+        __m128i dle = _mm_cmpeq_epi16(_mm_subs_epu16(d, r), zero); // d <= r
+        __m128i hi = _mm_or_si128(_mm_sub_epi16(r, d), dle);
+        __m128i res = _mm_or_si128(_mm_and_si128(carry, hi), _mm_andnot_si128(carry, lo));
+        _mm_storeu_si128((__m128i *) (light + i), res);
+    }
+
+    subtract_row_scalar(light + i, dark + i, n - i, pedestal);
+}
+
+TARGET_SSE2 static void column_sums_sse2(unsigned int *acc, const unsigned short *src, unsigned int stride, unsigned int w,
+                                         unsigned int binning)
+{
+    __m128i const zero = _mm_setzero_si128();
+
+    unsigned int x = 0;
+    for (; x + 8 <= w; x += 8)
+    {
+        __m128i a0 = zero, a1 = zero;
+        for (unsigned int k = 0; k < binning; k++)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *) (src + k * stride + x));
+            a0 = _mm_add_epi32(a0, _mm_unpacklo_epi16(v, zero));
+            a1 = _mm_add_epi32(a1, _mm_unpackhi_epi16(v, zero));
+        }
+        _mm_storeu_si128((__m128i *) (acc + x), a0);
+        _mm_storeu_si128((__m128i *) (acc + x + 4), a1);
+    }
+
+    if (x < w)
+        column_sums_scalar(acc + x, src + x, stride, w - x, binning);
+}
+
+// pack two vectors of 32-bit values in [0, 65535] into 16-bit lanes
+TARGET_SSE2 static inline __m128i pack_u32_sse2(__m128i a, __m128i b)
+{
+    __m128i const bias32 = _mm_set1_epi32(32768);
+    __m128i const bias16 = _mm_set1_epi16(-32768);
+    return _mm_add_epi16(_mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32)), bias16);
+}
+
+TARGET_SSE2 static void bin_row_sse2(unsigned short *dst, const unsigned int *acc, unsigned int dw, unsigned int binning)
+{
+    unsigned int i = 0;
+
+    if (binning == 2)
+    {
+        for (; i + 8 <= dw; i += 8)
+        {
+            __m128 v0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (acc + 2 * i)));
+            __m128 v1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (acc + 2 * i + 4)));
+            __m128 v2 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (acc + 2 * i + 8)));
+            __m128 v3 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (acc + 2 * i + 12)));
+            __m128i s0 = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0))),
+                                       _mm_castps_si128(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1))));
+            __m128i s1 = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(v2, v3, _MM_SHUFFLE(2, 0, 2, 0))),
+                                       _mm_castps_si128(_mm_shuffle_ps(v2, v3, _MM_SHUFFLE(3, 1, 3, 1))));
+            _mm_storeu_si128((__m128i *) (dst + i), pack_u32_sse2(_mm_srli_epi32(s0, 2), _mm_srli_epi32(s1, 2)));
+        }
+    }
+    else if (binning == 4)
+    {
+        for (; i + 8 <= dw; i += 8)
+        {
+            __m128i s[2];
+            for (int h = 0; h < 2; h++)
+            {
+                const unsigned int *a = acc + 4 * (i + 4 * h);
+                __m128 v0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (a)));
+                __m128 v1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (a + 4)));
+                __m128 v2 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (a + 8)));
+                __m128 v3 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (a + 12)));
+                _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+                __m128i t = _mm_add_epi32(_mm_add_epi32(_mm_castps_si128(v0), _mm_castps_si128(v1)),
+                                          _mm_add_epi32(_mm_castps_si128(v2), _mm_castps_si128(v3)));
+                s[h] = _mm_srli_epi32(t, 4);
+            }
+            _mm_storeu_si128((__m128i *) (dst + i), pack_u32_sse2(s[0], s[1]));
+        }
+    }
+
+    bin_row_scalar(dst + i, acc + i * binning, dw - i, binning);
+}
+
+TARGET_SSE2 static inline __m128 exp_sse2(__m128 x)
+{
+    x = _mm_max_ps(x, _mm_set1_ps(-87.0f));
+    __m128 t = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(EXP_LOG2E)), _mm_set1_ps(0.5f));
+    __m128 fx = _mm_cvtepi32_ps(_mm_cvttps_epi32(t));
+    fx = _mm_sub_ps(fx, _mm_and_ps(_mm_cmpgt_ps(fx, t), _mm_set1_ps(1.0f))); // floor
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(EXP_C1)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(EXP_C2)));
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 y = _mm_set1_ps(EXP_P0);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P1));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P2));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P3));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P4));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P5));
+    y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, z), x), _mm_set1_ps(1.0f));
+    __m128i bits = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(y, _mm_castsi128_ps(bits));
+}
+
+TARGET_SSE2 static void psf_normals_sse2(const float *dx, const float *dy, const float *val, const float *weight,
+                                         unsigned int n, const float p[5], double sums[PSF_NORMAL_SUMS])
+{
+    __m128 acc[PSF_NORMAL_SUMS];
+    for (unsigned int k = 0; k < PSF_NORMAL_SUMS; k++)
+        acc[k] = _mm_setzero_ps();
+
+    float const inv = 1.0f / (p[4] * p[4]);
+    __m128 const b = _mm_set1_ps(p[0]), a = _mm_set1_ps(p[1]), x0 = _mm_set1_ps(p[2]), y0 = _mm_set1_ps(p[3]);
+    __m128 const vinv = _mm_set1_ps(inv);
+    __m128 const vinv3 = _mm_set1_ps(inv / p[4]);
+    __m128 const c = _mm_set1_ps(-0.5f * inv);
+
+    for (unsigned int i = 0; i < n; i += 4)
+    {
+        __m128 ddx = _mm_sub_ps(_mm_loadu_ps(dx + i), x0);
+        __m128 ddy = _mm_sub_ps(_mm_loadu_ps(dy + i), y0);
+        __m128 r2 = _mm_add_ps(_mm_mul_ps(ddx, ddx), _mm_mul_ps(ddy, ddy));
+        __m128 e = exp_sse2(_mm_mul_ps(c, r2));
+        __m128 ae = _mm_mul_ps(a, e);
+        __m128 res = _mm_sub_ps(_mm_loadu_ps(val + i), _mm_add_ps(b, ae));
+        __m128 const j[5] = { _mm_set1_ps(1.0f), e, _mm_mul_ps(_mm_mul_ps(ae, ddx), vinv),
+                              _mm_mul_ps(_mm_mul_ps(ae, ddy), vinv), _mm_mul_ps(_mm_mul_ps(ae, r2), vinv3) };
+        __m128 const w = _mm_loadu_ps(weight + i);
+        unsigned int k = 0;
+        for (unsigned int r = 0; r < 5; r++)
+        {
+            __m128 wj = _mm_mul_ps(w, j[r]);
+            for (unsigned int col = r; col < 5; col++, k++)
+                acc[k] = _mm_add_ps(acc[k], _mm_mul_ps(wj, j[col]));
+            acc[15 + r] = _mm_add_ps(acc[15 + r], _mm_mul_ps(wj, res));
+        }
+        acc[20] = _mm_add_ps(acc[20], _mm_mul_ps(_mm_mul_ps(w, res), res));
+    }
+
+    for (unsigned int k = 0; k < PSF_NORMAL_SUMS; k++)
+    {
+        float l[4];
+        _mm_storeu_ps(l, acc[k]);
+        sums[k] = ((double) l[0] + l[1]) + ((double) l[2] + l[3]);
+    }
+}
+
+TARGET_AVX2 static void subtract_row_avx2(unsigned short *light, const unsigned short *dark, unsigned int n,
+                                          unsigned short pedestal)
+{
+    __m256i const ped = _mm256_set1_epi16((short) pedestal);
+    __m256i const ones = _mm256_set1_epi16(-1);
+    __m256i const zero = _mm256_setzero_si256();
+
+    unsigned int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i l = _mm256_loadu_si256((const __m256i *) (light + i));
+        __m256i d = _mm256_loadu_si256((const __m256i *) (dark + i));
+        __m256i r = _mm256_add_epi16(l, ped);
+        __m256i carry = _mm256_xor_si256(_mm256_cmpeq_epi16(r, _mm256_adds_epu16(l, ped)), ones);
+        __m256i lo = _mm256_subs_epu16(r, d);
+        __m256i dle = _mm256_cmpeq_epi16(_mm256_subs_epu16(d, r), zero); // d <= r
+        __m256i hi = _mm256_or_si256(_mm256_sub_epi16(r, d), dle);
+        _mm256_storeu_si256((__m256i *) (light + i), _mm256_blendv_epi8(lo, hi, carry));
+    }
+
+    subtract_row_sse2(light + i, dark + i, n - i, pedestal);
+}
+
+TARGET_AVX2 static void column_sums_avx2(unsigned int *acc, const unsigned short *src, unsigned int stride, unsigned int w,
+                                         unsigned int binning)
+{
+    unsigned int x = 0;
+    for (; x + 16 <= w; x += 16)
+    {
+        __m256i a0 = _mm256_setzero_si256(), a1 = _mm256_setzero_si256();
+        for (unsigned int k = 0; k < binning; k++)
+        {
+            const unsigned short *p = src + k * stride + x;
+            a0 = _mm256_add_epi32(a0, _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) p)));
+            a1 = _mm256_add_epi32(a1, _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) (p + 8))));
+        }
+        _mm256_storeu_si256((__m256i *) (acc + x), a0);
+        _mm256_storeu_si256((__m256i *) (acc + x + 8), a1);
+    }
+
+    if (x < w)
+        column_sums_sse2(acc + x, src + x, stride, w - x, binning);
+}
+
+static bool cpu_has_sse2()
+{
+# if defined(__x86_64__) || defined(_M_X64) || defined(_MSC_VER)
+    return true;
+# else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+# endif
+}
+
+static bool cpu_has_avx2()
+{
+# if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7)
+        return false;
+    __cpuid(r, 1);
+    bool const osxsave = (r[2] & (1 << 27)) != 0;
+    bool const avx = (r[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) // OS must save the ymm registers
+        return false;
+    __cpuidex(r, 7, 0);
+    return (r[1] & (1 << 5)) != 0;
+# else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+# endif
+}
+
+#endif // SIMD_X86
+
+#ifdef SIMD_NEON
+
+static void subtract_row_neon(unsigned short *light, const unsigned short *dark, unsigned int n, unsigned short pedestal)
+{
+    uint16x8_t const ped = vdupq_n_u16(pedestal);
+
+    unsigned int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint16x8_t l = vld1q_u16(light + i);
+        uint16x8_t d = vld1q_u16(dark + i);
+        uint16x8_t r = vaddq_u16(l, ped);
+        uint16x8_t carry = vmvnq_u16(vceqq_u16(r, vqaddq_u16(l, ped)));
+        uint16x8_t lo = vqsubq_u16(r, d);
+        uint16x8_t hi = vorrq_u16(vsubq_u16(r, d), vcleq_u16(d, r));
+        vst1q_u16(light + i, vbslq_u16(carry, hi, lo));
+    }
+
+    subtract_row_scalar(light + i, dark + i, n - i, pedestal);
+}
+
+static void column_sums_neon(unsigned int *acc, const unsigned short *src, unsigned int stride, unsigned int w,
+                             unsigned int binning)
+{
+    unsigned int x = 0;
+    for (; x + 8 <= w; x += 8)
+    {
+        uint32x4_t a0 = vdupq_n_u32(0), a1 = vdupq_n_u32(0);
+        for (unsigned int k = 0; k < binning; k++)
+        {
+            uint16x8_t v = vld1q_u16(src + k * stride + x);
+            a0 = vaddw_u16(a0, vget_low_u16(v));
+            a1 = vaddw_u16(a1, vget_high_u16(v));
+        }
+        vst1q_u32(acc + x, a0);
+        vst1q_u32(acc + x + 4, a1);
+    }
+
+    if (x < w)
+        column_sums_scalar(acc + x, src + x, stride, w - x, binning);
+}
+
+static void bin_row_neon(unsigned short *dst, const unsigned int *acc, unsigned int dw, unsigned int binning)
+{
+    unsigned int i = 0;
+
+    if (binning == 2)
+    {
+        for (; i + 4 <= dw; i += 4)
+        {
+            uint32x4x2_t v = vld2q_u32(acc + 2 * i);
+            vst1_u16(dst + i, vmovn_u32(vshrq_n_u32(vaddq_u32(v.val[0], v.val[1]), 2)));
+        }
+    }
+    else if (binning == 4)
+    {
+        for (; i + 4 <= dw; i += 4)
+        {
+            uint32x4x4_t v = vld4q_u32(acc + 4 * i);
+            uint32x4_t s = vaddq_u32(vaddq_u32(v.val[0], v.val[1]), vaddq_u32(v.val[2], v.val[3]));
+            vst1_u16(dst + i, vmovn_u32(vshrq_n_u32(s, 4)));
+        }
+    }
+
+    bin_row_scalar(dst + i, acc + i * binning, dw - i, binning);
+}
+
+static inline float32x4_t exp_neon(float32x4_t x)
+{
+    x = vmaxq_f32(x, vdupq_n_f32(-87.0f));
+    float32x4_t t = vaddq_f32(vmulq_f32(x, vdupq_n_f32(EXP_LOG2E)), vdupq_n_f32(0.5f));
+    float32x4_t fx = vcvtq_f32_s32(vcvtq_s32_f32(t));
+    uint32x4_t gt = vcgtq_f32(fx, t);
+    fx = vsubq_f32(fx, vreinterpretq_f32_u32(vandq_u32(gt, vreinterpretq_u32_f32(vdupq_n_f32(1.0f))))); // floor
+    x = vsubq_f32(x, vmulq_f32(fx, vdupq_n_f32(EXP_C1)));
+    x = vsubq_f32(x, vmulq_f32(fx, vdupq_n_f32(EXP_C2)));
+    float32x4_t z = vmulq_f32(x, x);
+    float32x4_t y = vdupq_n_f32(EXP_P0);
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(EXP_P1));
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(EXP_P2));
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(EXP_P3));
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(EXP_P4));
+    y = vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(EXP_P5));
+    y = vaddq_f32(vaddq_f32(vmulq_f32(y, z), x), vdupq_n_f32(1.0f));
+    int32x4_t bits = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(fx), vdupq_n_s32(127)), 23);
+    return vmulq_f32(y, vreinterpretq_f32_s32(bits));
+}
+
+static void psf_normals_neon(const float *dx, const float *dy, const float *val, const float *weight, unsigned int n,
+                             const float p[5], double sums[PSF_NORMAL_SUMS])
+{
+    float32x4_t acc[PSF_NORMAL_SUMS];
+    for (unsigned int k = 0; k < PSF_NORMAL_SUMS; k++)
+        acc[k] = vdupq_n_f32(0.0f);
+
+    float const inv = 1.0f / (p[4] * p[4]);
+    float32x4_t const b = vdupq_n_f32(p[0]), a = vdupq_n_f32(p[1]), x0 = vdupq_n_f32(p[2]), y0 = vdupq_n_f32(p[3]);
+    float32x4_t const vinv = vdupq_n_f32(inv);
+    float32x4_t const vinv3 = vdupq_n_f32(inv / p[4]);
+    float32x4_t const c = vdupq_n_f32(-0.5f * inv);
+
+    for (unsigned int i = 0; i < n; i += 4)
+    {
+        float32x4_t ddx = vsubq_f32(vld1q_f32(dx + i), x0);
+        float32x4_t ddy = vsubq_f32(vld1q_f32(dy + i), y0);
+        float32x4_t r2 = vaddq_f32(vmulq_f32(ddx, ddx), vmulq_f32(ddy, ddy));
+        float32x4_t e = exp_neon(vmulq_f32(c, r2));
+        float32x4_t ae = vmulq_f32(a, e);
+        float32x4_t res = vsubq_f32(vld1q_f32(val + i), vaddq_f32(b, ae));
+        float32x4_t const j[5] = { vdupq_n_f32(1.0f), e, vmulq_f32(vmulq_f32(ae, ddx), vinv),
+                                   vmulq_f32(vmulq_f32(ae, ddy), vinv), vmulq_f32(vmulq_f32(ae, r2), vinv3) };
+        float32x4_t const w = vld1q_f32(weight + i);
+        unsigned int k = 0;
+        for (unsigned int r = 0; r < 5; r++)
+        {
+            float32x4_t wj = vmulq_f32(w, j[r]);
+            for (unsigned int col = r; col < 5; col++, k++)
+                acc[k] = vaddq_f32(acc[k], vmulq_f32(wj, j[col]));
+            acc[15 + r] = vaddq_f32(acc[15 + r], vmulq_f32(wj, res));
+        }
+        acc[20] = vaddq_f32(acc[20], vmulq_f32(vmulq_f32(w, res), res));
+    }
+
+    for (unsigned int k = 0; k < PSF_NORMAL_SUMS; k++)
+    {
+        float l[4];
+        vst1q_f32(l, acc[k]);
+        sums[k] = ((double) l[0] + l[1]) + ((double) l[2] + l[3]);
+    }
+}
+
+#endif // SIMD_NEON
+
+std::vector<SimdKernels> AvailableSimdKernels()
+{
+    std::vector<SimdKernels> sets;
+
+    SimdKernels k = { "scalar", subtract_row_scalar, column_sums_scalar, bin_row_scalar, psf_normals_scalar };
+    sets.push_back(k);
+
+#if defined(SIMD_X86)
+    if (cpu_has_sse2())
+    {
+        k.name = "SSE2";
+        k.subtract_row = subtract_row_sse2;
+        k.column_sums = column_sums_sse2;
+        k.bin_row = bin_row_sse2;
+        k.psf_normals = psf_normals_sse2;
+        sets.push_back(k);
+
+        if (cpu_has_avx2())
+        {
+            k.name = "AVX2";
+            k.subtract_row = subtract_row_avx2;
+            k.column_sums = column_sums_avx2;
+            sets.push_back(k);
+        }
+    }
+#elif defined(SIMD_NEON)
+    k.name = "NEON";
+    k.subtract_row = subtract_row_neon;
+    k.column_sums = column_sums_neon;
+    k.bin_row = bin_row_neon;
+    k.psf_normals = psf_normals_neon;
+    sets.push_back(k);
+#endif
+
+    return sets;
+}
@@ -0,0 +1,61 @@
+/*
+ *  image_math_simd.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef IMAGE_MATH_SIMD_H_INCLUDED
+#define IMAGE_MATH_SIMD_H_INCLUDED
+
+#include <vector>
+
+enum
+{
+    PSF_NORMAL_SUMS = 21
+};
+
+// One set of the image kernels behind the functions declared in image_math.h. Each kernel
+// has a scalar reference version and vector versions for SSE2, AVX2 and NEON; the vector
+// versions produce the same results as the scalar ones (see image_math_simd.cpp).
+struct SimdKernels
+{
+    const char *name;
+    void (*subtract_row)(unsigned short *light, const unsigned short *dark, unsigned int n, unsigned short pedestal);
+    void (*column_sums)(unsigned int *acc, const unsigned short *src, unsigned int stride, unsigned int w,
+                        unsigned int binning);
+    void (*bin_row)(unsigned short *dst, const unsigned int *acc, unsigned int dw, unsigned int binning);
+    void (*psf_normals)(const float *dx, const float *dy, const float *val, const float *weight, unsigned int n,
+                        const float p[5], double sums[PSF_NORMAL_SUMS]);
+};
+
+// the kernel sets the host CPU can run, the scalar reference set first and the fastest last
+extern std::vector<SimdKernels> AvailableSimdKernels();
+
+#endif // IMAGE_MATH_SIMD_H_INCLUDED
@@ -0,0 +1,150 @@
+/*
+ *  metrics.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+
+#include <algorithm>
+
+MetricsRegistry Metrics;
+
+static const double SECONDS_BUCKETS[] = { 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1., 2.5, 5., 10., 30. };
+static const double PULSE_MS_BUCKETS[] = { 10., 25., 50., 100., 250., 500., 1000., 2500., 5000. };
+
+void MetricSum::Add(double v)
+{
+    double cur = m_value.load(std::memory_order_relaxed);
+    while (!m_value.compare_exchange_weak(cur, cur + v, std::memory_order_relaxed))
+    {
+    }
+}
+
+MetricHistogram::MetricHistogram(const double *bounds, unsigned int nrBounds)
+    : m_bounds(bounds), m_nrBounds(nrBounds), m_buckets(new std::atomic<unsigned long long>[nrBounds + 1])
+{
+    for (unsigned int i = 0; i <= m_nrBounds; i++)
+        m_buckets[i] = 0;
+}
+
+void MetricHistogram::Observe(double v)
+{
+    unsigned int i = std::lower_bound(m_bounds, m_bounds + m_nrBounds, v) - m_bounds;
+    m_buckets[i].fetch_add(1, std::memory_order_relaxed);
+    m_sum.Add(v);
+    m_count.Add();
+}
+
+void MetricHistogram::Format(wxString& out, const char *name, const char *labels) const
+{
+    wxString sep = *labels ? wxString(labels) + "," : wxString();
+    wxString braces = *labels ? wxString::Format("{%s}", labels) : wxString();
+
+    // the samples are read one at a time, so a concurrent Observe() can make _count differ
+    // slightly from the +Inf bucket; scrapers tolerate that
+    unsigned long long cumulative = 0;
+    for (unsigned int i = 0; i < m_nrBounds; i++)
+    {
+        cumulative += m_buckets[i].load(std::memory_order_relaxed);
+        out += wxString::Format("%s_bucket{%sle=\"%g\"} %llu\n", name, sep, m_bounds[i], cumulative);
+    }
+    cumulative += m_buckets[m_nrBounds].load(std::memory_order_relaxed);
+    out += wxString::Format("%s_bucket{%sle=\"+Inf\"} %llu\n", name, sep, cumulative);
+    out += wxString::Format("%s_sum%s %g\n", name, braces, m_sum.Value());
+    out += wxString::Format("%s_count%s %llu\n", name, braces, m_count.Value());
+}
+
+MetricsRegistry::MetricsRegistry()
+    : exposeRequestSeconds(SECONDS_BUCKETS, WXSIZEOF(SECONDS_BUCKETS)),
+      captureSeconds(SECONDS_BUCKETS, WXSIZEOF(SECONDS_BUCKETS)),
+      downloadSeconds(SECONDS_BUCKETS, WXSIZEOF(SECONDS_BUCKETS)),
+      moveSeconds(SECONDS_BUCKETS, WXSIZEOF(SECONDS_BUCKETS)),
+      pulseMsRA(PULSE_MS_BUCKETS, WXSIZEOF(PULSE_MS_BUCKETS)),
+      pulseMsDec(PULSE_MS_BUCKETS, WXSIZEOF(PULSE_MS_BUCKETS))
+{
+}
+
+static void Header(wxString& out, const char *name, const char *type, const char *help)
+{
+    out += wxString::Format("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void Counter(wxString& out, const char *name, const char *help, unsigned long long value)
+{
+    Header(out, name, "counter", help);
+    out += wxString::Format("%s %llu\n", name, value);
+}
+
+static void Gauge(wxString& out, const char *name, const char *help, double value)
+{
+    Header(out, name, "gauge", help);
+    out += wxString::Format("%s %g\n", name, value);
+}
+
+wxString MetricsRegistry::FormatPrometheus() const
+{
+    wxString out;
+
+    Counter(out, "phd2_frames_total", "Frames captured.", framesCaptured.Value());
+    Counter(out, "phd2_capture_errors_total", "Failed or interrupted captures.", captureErrors.Value());
+    Header(out, "phd2_expose_request_seconds", "histogram", "Time to service an expose request, including waits.");
+    exposeRequestSeconds.Format(out, "phd2_expose_request_seconds");
+    Header(out, "phd2_capture_seconds", "histogram", "Camera capture time, exposure plus download.");
+    captureSeconds.Format(out, "phd2_capture_seconds");
+    Header(out, "phd2_download_seconds", "histogram", "Capture time in excess of the exposure duration.");
+    downloadSeconds.Format(out, "phd2_download_seconds");
+    Gauge(out, "phd2_exposure_seconds", "Duration of the last exposure.", exposureSeconds.Value());
+    Counter(out, "phd2_stream_frames_dropped_total", "Frames a streaming camera's driver reported lost.",
+            streamFramesDropped.Value());
+    Counter(out, "phd2_stream_frames_skipped_total", "Stream frames discarded to deliver a fresh frame.",
+            streamFramesSkipped.Value());
+
+    Counter(out, "phd2_frames_dropped_total", "Frames where the guide star could not be found.", framesDropped.Value());
+    Gauge(out, "phd2_guider_state", "Guider state (see GUIDER_STATE).", guiderState.Value());
+    Gauge(out, "phd2_star_snr", "SNR of the guide star.", starSNR.Value());
+    Gauge(out, "phd2_star_mass", "Mass of the guide star.", starMass.Value());
+    Gauge(out, "phd2_star_hfd_pixels", "HFD of the guide star.", starHFD.Value());
+
+    Counter(out, "phd2_guide_steps_total", "Guide steps sent to the mount.", guideSteps.Value());
+    Counter(out, "phd2_move_errors_total", "Failed mount moves.", moveErrors.Value());
+    Header(out, "phd2_move_seconds", "histogram", "Time to carry out a mount move.");
+    moveSeconds.Format(out, "phd2_move_seconds");
+    Header(out, "phd2_guide_pulse_milliseconds", "histogram", "Guide pulse durations.");
+    pulseMsRA.Format(out, "phd2_guide_pulse_milliseconds", "axis=\"ra\"");
+    pulseMsDec.Format(out, "phd2_guide_pulse_milliseconds", "axis=\"dec\"");
+    Header(out, "phd2_guide_error_squared_pixels_total", "counter", "Sum of squared raw guide errors in mount axis pixels.");
+    out += wxString::Format("phd2_guide_error_squared_pixels_total{axis=\"ra\"} %g\n", errorSquaredRA.Value());
+    out += wxString::Format("phd2_guide_error_squared_pixels_total{axis=\"dec\"} %g\n", errorSquaredDec.Value());
+    Gauge(out, "phd2_pixel_scale_arcsec", "Guide camera pixel scale.", pFrame ? pFrame->GetCameraPixelScale() : 0.);
+
+    return out;
+}
@@ -0,0 +1,132 @@
+/*
+ *  metrics.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef METRICS_H_INCLUDED
+#define METRICS_H_INCLUDED
+
+#include <atomic>
+#include <memory>
+
+// Guiding and capture health metrics.
+//
+// Counters, gauges and fixed-bucket histograms are atomics updated with relaxed ordering
+// where the event happens (camera worker thread, mount worker threads, guider). Nothing is
+// formatted or allocated until the metrics are read, so an unscraped registry costs a few
+// atomic adds per frame. FormatPrometheus() renders the registry in the Prometheus text
+// exposition format; it is served by the event server get_metrics method and, when the
+// /MetricsServerPort setting is non-zero, over HTTP on localhost.
+
+class MetricCounter
+{
+    std::atomic<unsigned long long> m_value;
+
+public:
+    MetricCounter() : m_value(0) { }
+    void Add(unsigned long long n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    unsigned long long Value() const { return m_value.load(std::memory_order_relaxed); }
+};
+
+// a counter with a floating point value, e.g. a sum of squares
+class MetricSum
+{
+    std::atomic<double> m_value;
+
+public:
+    MetricSum() : m_value(0.) { }
+    void Add(double v);
+    double Value() const { return m_value.load(std::memory_order_relaxed); }
+};
+
+class MetricGauge
+{
+    std::atomic<double> m_value;
+
+public:
+    MetricGauge() : m_value(0.) { }
+    void Set(double v) { m_value.store(v, std::memory_order_relaxed); }
+    double Value() const { return m_value.load(std::memory_order_relaxed); }
+};
+
+class MetricHistogram
+{
+    const double *m_bounds;
+    unsigned int m_nrBounds;
+    std::unique_ptr<std::atomic<unsigned long long>[]> m_buckets; // per bucket, not cumulative
+    MetricSum m_sum;
+    MetricCounter m_count;
+
+public:
+    // bounds are the ascending bucket upper limits; the +Inf bucket is implied
+    MetricHistogram(const double *bounds, unsigned int nrBounds);
+    void Observe(double v);
+    // append the _bucket, _sum and _count samples; labels is empty or a label list without braces
+    void Format(wxString& out, const char *name, const char *labels = "") const;
+};
+
+struct MetricsRegistry
+{
+    // camera worker thread
+    MetricCounter framesCaptured;
+    MetricCounter captureErrors;
+    MetricHistogram exposeRequestSeconds; // the whole expose request, including waits
+    MetricHistogram captureSeconds;
+    MetricHistogram downloadSeconds; // capture time beyond the exposure duration
+    MetricGauge exposureSeconds;
+    MetricCounter streamFramesDropped; // frames a streaming camera's driver reports it lost
+    MetricCounter streamFramesSkipped; // buffered stream frames discarded to deliver a fresh one
+
+    // guider
+    MetricCounter framesDropped;
+    MetricGauge guiderState;
+    MetricGauge starSNR;
+    MetricGauge starMass;
+    MetricGauge starHFD;
+
+    // mount moves
+    MetricCounter guideSteps;
+    MetricCounter moveErrors;
+    MetricHistogram moveSeconds;
+    MetricHistogram pulseMsRA;
+    MetricHistogram pulseMsDec;
+    MetricSum errorSquaredRA; // mount axis pixels^2; RMS = sqrt(rate(sum) / rate(steps))
+    MetricSum errorSquaredDec;
+
+    MetricsRegistry();
+
+    wxString FormatPrometheus() const;
+};
+
+extern MetricsRegistry Metrics;
+
+#endif
@@ -977,6 +977,8 @@ void Mount::LogGuideStepInfo()
 
 Mount::MOVE_RESULT Mount::MoveOffset(GuiderOffset *ofs, unsigned int moveOptions)
 {
+    FRAME_TRACE_SPAN("Mount::MoveOffset");
+
     MOVE_RESULT result = MOVE_OK;
 
     try
@@ -1017,6 +1019,8 @@ Mount::MOVE_RESULT Mount::MoveOffset(GuiderOffset *ofs, unsigned int moveOptions
 
             if (moveOptions & MOVEOPT_ALGO_RESULT)
             {
+                FRAME_TRACE_SPAN("GuideAlgorithm::result");
+
                 // Feed the raw distances to the guide algorithms
                 if (m_pXGuideAlgorithm)
                 {
@@ -1075,6 +1079,18 @@ Mount::MOVE_RESULT Mount::MoveOffset(GuiderOffset *ofs, unsigned int moveOptions
         info.starHFD = star.HFD;
         info.avgDist = pFrame->CurrentGuideError();
         info.starError = star.GetError();
+
+        if (moveOptions & MOVEOPT_ALGO_RESULT)
+        {
+            Metrics.guideSteps.Add();
+            if (!IsStepGuider()) // AO moves are in steps, not milliseconds
+            {
+                Metrics.pulseMsRA.Observe(xMoveResult.amountMoved);
+                Metrics.pulseMsDec.Observe(yMoveResult.amountMoved);
+            }
+            Metrics.errorSquaredRA.Add(ofs->mountOfs.X * ofs->mountOfs.X);
+            Metrics.errorSquaredDec.Add(ofs->mountOfs.Y * ofs->mountOfs.Y);
+        }
     }
     catch (const wxString& errMsg)
     {
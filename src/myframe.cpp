@@ -39,6 +39,7 @@
 #include "aui_controls.h"
 #include "comet_tool.h"
 #include "config_indi.h"
+#include "dark_library.h"
 #include "guiding_assistant.h"
 #include "phdupdate.h"
 #include "pierflip_tool.h"
@@ -216,6 +217,8 @@ MyFrame::MyFrame()
     m_mgr.SetManagedWindow(this);
 
     m_frameCounter = 0;
+    m_pCameraWorkerThread = nullptr;
+    StartWorkerThread(m_pCameraWorkerThread);
     m_pPrimaryWorkerThread = nullptr;
     StartWorkerThread(m_pPrimaryWorkerThread);
     m_pSecondaryWorkerThread = nullptr;
@@ -262,7 +265,10 @@ MyFrame::MyFrame()
 
     sizer->Add(m_infoBar, wxSizerFlags().Expand());
 
-    pGuider = new GuiderMultiStar(guiderWin);
+    if (pConfig->Profile.GetBoolean("/guider/PhaseCorrelation", false))
+        pGuider = new GuiderPhaseCorrelation(guiderWin);
+    else
+        pGuider = new GuiderMultiStar(guiderWin);
     sizer->Add(pGuider, wxSizerFlags().Proportion(1).Expand());
 
     guiderWin->SetSizer(sizer);
@@ -1712,7 +1718,16 @@ void MyFrame::ScheduleExposure()
 {
     CaptureParams captureParams;
     captureParams.duration = RequestedExposureDuration();
-    captureParams.subframe = m_singleExposure.enabled ? m_singleExposure.subframe : pGuider->GetBoundingBox();
+    if (m_singleExposure.enabled)
+        captureParams.subframe = m_singleExposure.subframe;
+    else
+    {
+        captureParams.subframe = pGuider->GetBoundingBox();
+        // a camera without multi-window readout reads the bounding box, and cropping it
+        // to the windows afterwards would save no readout time
+        if (pCamera->HasMultiROIReadout)
+            pGuider->GetStarWindows(captureParams.rois);
+    }
     captureParams.hwBinning = pCamera->HwBinning;
     captureParams.swBinning = pCamera->SwBinning;
     captureParams.bpp = pCamera->BitsPerPixel();
@@ -1732,8 +1747,17 @@ void MyFrame::ScheduleExposure()
 
     wxCriticalSectionLocker lock(m_CSpWorkerThread);
 
-    if (m_pPrimaryWorkerThread) // can be null when app is shutting down (unlikely but possible)
-        m_pPrimaryWorkerThread->EnqueueWorkerThreadExposeRequest(img, captureParams);
+    // the exposure must not start until the moves scheduled so far on the primary mount,
+    // in particular the correction for the previous frame, have completed
+    if (m_pCameraWorkerThread) // can be null when app is shutting down (unlikely but possible)
+        m_pCameraWorkerThread->EnqueueWorkerThreadExposeRequest(
+            img, captureParams, m_pPrimaryWorkerThread, m_pPrimaryWorkerThread ? m_pPrimaryWorkerThread->GetMoveToken() : 0);
+}
+
+WorkerThread *MyFrame::PrimaryMoveThread(Mount *mount) const
+{
+    // mounts that cannot move while the camera is exposing share the camera thread
+    return mount->SynchronousOnly() ? m_pCameraWorkerThread : m_pPrimaryWorkerThread;
 }
 
 void MyFrame::SchedulePrimaryMove(Mount *mount, const GuiderOffset& ofs, unsigned int moveOptions)
@@ -1749,8 +1773,9 @@ void MyFrame::SchedulePrimaryMove(Mount *mount, const GuiderOffset& ofs, unsigne
     if ((moveOptions & MOVEOPT_MANUAL) == 0)
         mount->IncrementRequestCount();
 
-    assert(m_pPrimaryWorkerThread);
-    m_pPrimaryWorkerThread->EnqueueWorkerThreadMoveRequest(mount, ofs, moveOptions);
+    WorkerThread *thread = PrimaryMoveThread(mount);
+    assert(thread);
+    thread->EnqueueWorkerThreadMoveRequest(mount, ofs, moveOptions);
 }
 
 void MyFrame::ScheduleSecondaryMove(Mount *mount, const GuiderOffset& ofs, unsigned int moveOptions)
@@ -1787,8 +1812,9 @@ void MyFrame::ScheduleAxisMove(Mount *mount, const GUIDE_DIRECTION direction, in
     if ((moveOptions & MOVEOPT_MANUAL) == 0)
         mount->IncrementRequestCount();
 
-    assert(m_pPrimaryWorkerThread);
-    m_pPrimaryWorkerThread->EnqueueWorkerThreadAxisMove(mount, direction, duration, moveOptions);
+    WorkerThread *thread = PrimaryMoveThread(mount);
+    assert(thread);
+    thread->EnqueueWorkerThreadAxisMove(mount, direction, duration, moveOptions);
 }
 
 void MyFrame::ScheduleManualMove(Mount *mount, const GUIDE_DIRECTION direction, int duration)
@@ -1906,6 +1932,8 @@ bool MyFrame::StopCapturing()
 
         if (m_exposurePending)
         {
+            // also interrupt a guide pulse the exposure may be waiting on
+            m_pCameraWorkerThread->RequestStop();
             m_pPrimaryWorkerThread->RequestStop();
             finished = false;
         }
@@ -2169,7 +2197,9 @@ void MyFrame::OnClose(wxCloseEvent& event)
 
     StopCapturing();
 
-    bool killed = StopWorkerThread(m_pPrimaryWorkerThread);
+    bool killed = StopWorkerThread(m_pCameraWorkerThread);
+    if (StopWorkerThread(m_pPrimaryWorkerThread))
+        killed = true;
     if (StopWorkerThread(m_pSecondaryWorkerThread))
         killed = true;
 
@@ -2455,6 +2485,13 @@ static bool load_multi_darks(GuideCamera *camera, const wxString& fname)
             throw ERROR_INFO("File does not exist");
         }
 
+        // Prefer mapping the file so that only the dark frame in use becomes resident
+        if (!camera->MapDarkLibrary(fname))
+        {
+            Debug.Write(wxString::Format("mapped dark library %s\n", fname));
+            return false;
+        }
+
         if (PHD_fits_open_diskfile(&fptr, fname, READONLY, &status) == 0)
         {
             int nhdus = 0;
@@ -2507,33 +2544,7 @@ static bool load_multi_darks(GuideCamera *camera, const wxString& fname)
                     throw ERROR_INFO("Error reading");
                 }
 
-                char keyname[] = "EXPOSURE";
-                float exposure;
-                if (fits_read_key(fptr, TFLOAT, keyname, &exposure, nullptr, &status))
-                {
-                    exposure = (float) pFrame->RequestedExposureDuration() / 1000.0;
-                    Debug.Write(wxString::Format("missing EXPOSURE value, assume %.3f\n", exposure));
-                    status = 0;
-                }
-                img->ImgExpDur = ROUNDF(exposure * 1000.0);
-
-                char binning_key[] = "XBINNING";
-                int binning = 1;
-                fits_read_key(fptr, TINT, binning_key, &binning, nullptr, &status);
-                img->Binning = wxMax(binning, 1);
-                status = 0;
-
-                char saturate_key[] = "SATURATE";
-                int saturate = 65535;
-                fits_read_key(fptr, TINT, saturate_key, &saturate, nullptr, &status);
-                img->BitsPerPixel = saturate >= 256 ? 16 : 8;
-                status = 0;
-
-                char gain_key[] = "GAIN";
-                int gain = 0;
-                fits_read_key(fptr, TINT, gain_key, &gain, nullptr, &status);
-                img->Gain = gain;
-                status = 0;
+                ReadDarkFrameKeys(fptr, img.get());
 
                 img->CalcStats();
 
@@ -2725,6 +2736,13 @@ void MyFrame::SaveDarkLibrary(const wxString& note)
 
     Debug.Write("saving dark library\n");
 
+    // the library file may be mapped, and it is about to be overwritten
+    if (pCamera->DetachDarkLibrary())
+    {
+        Alert(wxString::Format(_("Error reading darks FITS file %s"), filename));
+        return;
+    }
+
     if (save_multi_darks(pCamera->Darks, filename, note))
     {
         Alert(wxString::Format(_("Error saving darks FITS file %s"), filename));
@@ -2738,6 +2756,11 @@ void MyFrame::DeleteDarkLibraryFiles(int profileId)
 
     if (wxFileExists(filename))
     {
+        // the camera may have the current profile's library mapped; a mapped file cannot be
+        // removed on Windows
+        if (pCamera && profileId == pConfig->GetCurrentProfileId() && pCamera->DetachDarkLibrary())
+            Debug.Write("could not read all mapped darks before removing the dark library\n");
+
         Debug.Write(wxString::Format("Removing dark library file: %s\n", filename));
         wxRemoveFile(filename);
     }
@@ -489,6 +489,7 @@ public:
 
 private:
     wxCriticalSection m_CSpWorkerThread;
+    WorkerThread *m_pCameraWorkerThread;
     WorkerThread *m_pPrimaryWorkerThread;
     WorkerThread *m_pSecondaryWorkerThread;
 
@@ -506,6 +507,7 @@ private:
 
     bool StartWorkerThread(WorkerThread *& pWorkerThread);
     bool StopWorkerThread(WorkerThread *& pWorkerThread);
+    WorkerThread *PrimaryMoveThread(Mount *mount) const;
     void OnStatusMsg(wxThreadEvent& event);
     void DoAlert(const alert_params& params);
     void OnAlertButton(wxCommandEvent& evt);
@@ -713,6 +715,8 @@ enum
     SOCK_SERVER_CLIENT_ID,
     EVENT_SERVER_ID,
     EVENT_SERVER_CLIENT_ID,
+    METRICS_SERVER_ID,
+    METRICS_SERVER_CLIENT_ID,
 };
 
 wxDECLARE_EVENT(APPSTATE_NOTIFY_EVENT, wxCommandEvent);
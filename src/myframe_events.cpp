@@ -406,6 +406,15 @@ void MyFrame::FinishStop(void)
     // when looping resumes, start with at least one full frame. This enables applications
     // controlling PHD to auto-select a new star if the star is lost while looping was stopped.
     pGuider->ForceFullFrame();
+    // don't leave the camera exposing continuously while idle. Stopping the stream can block
+    // in the camera SDK, so it happens on the camera thread like the exposures
+    if (pCamera && pCamera->IsStreaming())
+    {
+        if (pCamera->HasNonGuiCapture() && m_pCameraWorkerThread)
+            m_pCameraWorkerThread->EnqueueWorkerThreadStopStreamRequest();
+        else
+            pCamera->StopStream();
+    }
     ResetAutoExposure();
     UpdateButtonsStatus();
     StatusMsg(_("Stopped."));
@@ -0,0 +1,375 @@
+/*
+ *  phase_correlator.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "phd.h"
+
+#include <algorithm>
+#include <thread>
+
+// width of the Gaussian applied to the cross-power spectrum, as the sigma of the resulting
+// correlation peak in pixels
+static const double PEAK_SIGMA = 0.8;
+
+// the correlation surface within this distance of the peak is excluded from the sidelobe
+// statistics
+enum
+{
+    PEAK_EXCLUDE = 5
+};
+
+PhaseCorrelator::PhaseCorrelator() : m_size(0), m_threads(1), m_haveReference(false), m_flux(0.) { }
+
+bool PhaseCorrelator::Init(unsigned int size)
+{
+    if (size < 8 || size > 4096 || (size & (size - 1)) != 0)
+        return true;
+
+    if (size == m_size)
+        return false;
+
+    m_size = size;
+    m_haveReference = false;
+
+    // a thread per 32 rows at most; small windows are not worth the thread start-up
+    m_threads = std::max(1U, std::min(std::thread::hardware_concurrency(), size / 32));
+
+    unsigned int log2n = 0;
+    while ((1U << log2n) < size)
+        ++log2n;
+
+    m_plan.n = size;
+    m_plan.bitrev.resize(size);
+    for (unsigned int i = 0; i < size; i++)
+    {
+        unsigned int r = 0;
+        for (unsigned int b = 0; b < log2n; b++)
+            if (i & (1U << b))
+                r |= 1U << (log2n - 1 - b);
+        m_plan.bitrev[i] = r;
+    }
+
+    m_plan.twiddle.resize(size / 2);
+    for (unsigned int k = 0; k < size / 2; k++)
+    {
+        double a = -2.0 * M_PI * k / size;
+        m_plan.twiddle[k] = Complex((float) cos(a), (float) sin(a));
+    }
+
+    m_window.resize(size);
+    for (unsigned int i = 0; i < size; i++)
+        m_window[i] = (float) (0.5 - 0.5 * cos(2.0 * M_PI * (i + 0.5) / size));
+
+    // multiplying the spectrum by exp(-2 pi^2 sigma^2 f^2) convolves the correlation surface
+    // with a Gaussian of width sigma
+    m_lowpass.resize(size);
+    for (unsigned int i = 0; i < size; i++)
+    {
+        double f = (double) (i < size / 2 ? (int) i : (int) i - (int) size) / size;
+        m_lowpass[i] = (float) exp(-2.0 * M_PI * M_PI * PEAK_SIGMA * PEAK_SIGMA * f * f);
+    }
+
+    m_reference.assign(size * size, Complex());
+    m_frame.assign(size * size, Complex());
+    m_work.assign(size * size, Complex());
+
+    return false;
+}
+
+void PhaseCorrelator::ClearReference()
+{
+    m_haveReference = false;
+}
+
+// run fn(begin, end) over bands of rows, one band per thread
+void PhaseCorrelator::ParallelRows(const std::function<void(unsigned int, unsigned int)>& fn) const
+{
+    if (m_threads <= 1)
+    {
+        fn(0, m_size);
+        return;
+    }
+
+    unsigned int band = (m_size + m_threads - 1) / m_threads;
+
+    std::vector<std::thread> pool;
+    pool.reserve(m_threads - 1);
+    for (unsigned int t = 1; t < m_threads; t++)
+    {
+        unsigned int begin = t * band;
+        unsigned int end = std::min(m_size, begin + band);
+        if (begin < end)
+            pool.emplace_back(fn, begin, end);
+    }
+    fn(0, std::min(m_size, band));
+    for (std::thread& th : pool)
+        th.join();
+}
+
+// in-place radix-2 forward transform of n points
+static void FFT1D(PhaseCorrelator::Complex *a, unsigned int n, const unsigned int *bitrev,
+                  const PhaseCorrelator::Complex *twiddle)
+{
+    for (unsigned int i = 0; i < n; i++)
+    {
+        unsigned int j = bitrev[i];
+        if (i < j)
+            std::swap(a[i], a[j]);
+    }
+
+    for (unsigned int len = 2; len <= n; len <<= 1)
+    {
+        unsigned int half = len / 2;
+        unsigned int step = n / len;
+        for (unsigned int i = 0; i < n; i += len)
+        {
+            for (unsigned int k = 0; k < half; k++)
+            {
+                // spelled out; std::complex multiplication checks for NaN/Inf
+                const PhaseCorrelator::Complex& w = twiddle[k * step];
+                const PhaseCorrelator::Complex& b = a[i + k + half];
+                float vr = b.real() * w.real() - b.imag() * w.imag();
+                float vi = b.real() * w.imag() + b.imag() * w.real();
+                PhaseCorrelator::Complex u = a[i + k];
+                a[i + k] = PhaseCorrelator::Complex(u.real() + vr, u.imag() + vi);
+                a[i + k + half] = PhaseCorrelator::Complex(u.real() - vr, u.imag() - vi);
+            }
+        }
+    }
+}
+
+// 2-D transform, rows then columns. The inverse is computed as conj(FFT(conj(x))) and is not
+// scaled by 1/n^2, which does not matter for locating the correlation peak.
+void PhaseCorrelator::Transform(std::vector<Complex> *data, bool inverse) const
+{
+    unsigned int n = m_size;
+    Complex *d = data->data();
+    const unsigned int *bitrev = m_plan.bitrev.data();
+    const Complex *twiddle = m_plan.twiddle.data();
+
+    ParallelRows([=](unsigned int begin, unsigned int end) {
+        for (unsigned int y = begin; y < end; y++)
+        {
+            Complex *row = d + y * n;
+            if (inverse)
+                for (unsigned int x = 0; x < n; x++)
+                    row[x] = std::conj(row[x]);
+            FFT1D(row, n, bitrev, twiddle);
+        }
+    });
+
+    ParallelRows([=](unsigned int begin, unsigned int end) {
+        std::vector<Complex> col(n);
+        for (unsigned int x = begin; x < end; x++)
+        {
+            for (unsigned int y = 0; y < n; y++)
+                col[y] = d[y * n + x];
+            FFT1D(col.data(), n, bitrev, twiddle);
+            if (inverse)
+                for (unsigned int y = 0; y < n; y++)
+                    d[y * n + x] = std::conj(col[y]);
+            else
+                for (unsigned int y = 0; y < n; y++)
+                    d[y * n + x] = col[y];
+        }
+    });
+}
+
+void PhaseCorrelator::Load(const usImage& img, const wxPoint& origin, std::vector<Complex> *dst)
+{
+    unsigned int n = m_size;
+    int width = img.Size.GetWidth();
+
+    // only the part of the window inside the valid image data is read
+    wxRect valid = img.Subframe.IsEmpty() ? wxRect(img.Size) : img.Subframe;
+    wxRect inside = wxRect(origin.x, origin.y, n, n).Intersect(valid);
+
+    double sum = 0.;
+    unsigned int count = 0;
+    for (int y = inside.GetTop(); y <= inside.GetBottom(); y++)
+    {
+        const unsigned short *p = img.ImageData + y * width + inside.GetLeft();
+        for (int x = 0; x < inside.GetWidth(); x++)
+            sum += p[x];
+        count += inside.GetWidth();
+    }
+    float mean = count ? (float) (sum / count) : 0.f;
+
+    // flux above the median level of the whole frame
+    m_flux = count ? sum - (double) count * img.MedianADU : 0.;
+
+    Complex *d = dst->data();
+    std::fill(dst->begin(), dst->end(), Complex());
+    for (int y = inside.GetTop(); y <= inside.GetBottom(); y++)
+    {
+        unsigned int wy = y - origin.y;
+        const unsigned short *p = img.ImageData + y * width + inside.GetLeft();
+        Complex *row = d + wy * n + (inside.GetLeft() - origin.x);
+        const float *wx = m_window.data() + (inside.GetLeft() - origin.x);
+        float w = m_window[wy];
+        for (int x = 0; x < inside.GetWidth(); x++)
+            row[x] = Complex(((float) p[x] - mean) * wx[x] * w, 0.f);
+    }
+}
+
+void PhaseCorrelator::SetReference(const usImage& img, const wxPoint& origin)
+{
+    Load(img, origin, &m_reference);
+    Transform(&m_reference, false);
+    m_haveReference = true;
+}
+
+// sub-pixel offset of a peak from its three samples along one axis, fitting a Gaussian
+// (a parabola through the logs) when the samples allow it and a parabola otherwise
+static double PeakOffset(double left, double center, double right)
+{
+    if (left > 0. && center > 0. && right > 0.)
+    {
+        double l = log(left), c = log(center), r = log(right);
+        double den = l - 2. * c + r;
+        if (den < 0.)
+            return std::max(-0.5, std::min(0.5, 0.5 * (l - r) / den));
+    }
+    double den = left - 2. * center + right;
+    if (den < 0.)
+        return std::max(-0.5, std::min(0.5, 0.5 * (left - right) / den));
+    return 0.;
+}
+
+void PhaseCorrelator::Register(const usImage& img, const wxPoint& origin, double *dx, double *dy, double *quality)
+{
+    unsigned int n = m_size;
+
+    Load(img, origin, &m_frame);
+    Transform(&m_frame, false);
+
+    // normalized cross-power spectrum frame * conj(reference), low-pass filtered
+    const Complex *f = m_frame.data();
+    const Complex *r = m_reference.data();
+    Complex *w = m_work.data();
+    const float *lp = m_lowpass.data();
+    ParallelRows([=](unsigned int begin, unsigned int end) {
+        for (unsigned int v = begin; v < end; v++)
+        {
+            for (unsigned int u = 0; u < n; u++)
+            {
+                unsigned int i = v * n + u;
+                float re = f[i].real() * r[i].real() + f[i].imag() * r[i].imag();
+                float im = f[i].imag() * r[i].real() - f[i].real() * r[i].imag();
+                float mag = sqrtf(re * re + im * im);
+                float scale = mag > 1e-20f ? lp[u] * lp[v] / mag : 0.f;
+                w[i] = Complex(re * scale, im * scale);
+            }
+        }
+    });
+
+    Transform(&m_work, true);
+
+    unsigned int peak = 0;
+    float peakVal = w[0].real();
+    for (unsigned int i = 1; i < n * n; i++)
+    {
+        if (w[i].real() > peakVal)
+        {
+            peakVal = w[i].real();
+            peak = i;
+        }
+    }
+
+    int px = peak % n;
+    int py = peak / n;
+    auto at = [=](int x, int y) { return (double) w[((y + n) % n) * n + (x + n) % n].real(); };
+
+    double sx = px + PeakOffset(at(px - 1, py), peakVal, at(px + 1, py));
+    double sy = py + PeakOffset(at(px, py - 1), peakVal, at(px, py + 1));
+
+    // the surface wraps around; shifts past half the window are negative
+    if (sx >= n / 2)
+        sx -= n;
+    if (sy >= n / 2)
+        sy -= n;
+    *dx = sx;
+    *dy = sy;
+
+    // peak-to-sidelobe ratio
+    double sum = 0., sum2 = 0.;
+    unsigned int count = 0;
+    for (unsigned int y = 0; y < n; y++)
+    {
+        int ddy = std::abs((int) y - py);
+        ddy = std::min(ddy, (int) n - ddy);
+        for (unsigned int x = 0; x < n; x++)
+        {
+            int ddx = std::abs((int) x - px);
+            ddx = std::min(ddx, (int) n - ddx);
+            if (ddx <= PEAK_EXCLUDE && ddy <= PEAK_EXCLUDE)
+                continue;
+            double val = w[y * n + x].real();
+            sum += val;
+            sum2 += val * val;
+            ++count;
+        }
+    }
+    double mean = sum / count;
+    double sigma = sqrt(std::max(0., sum2 / count - mean * mean));
+    *quality = sigma > 0. ? (peakVal - mean) / sigma : 0.;
+}
+
+void PhaseCorrelator::UpdateReference(double alpha, double dx, double dy)
+{
+    unsigned int n = m_size;
+
+    // shifting the frame back by (dx, dy) multiplies its spectrum by exp(2 pi i (u dx + v dy) / n)
+    std::vector<Complex> rampX(n), rampY(n);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        double f = (double) (i < n / 2 ? (int) i : (int) i - (int) n) / n;
+        rampX[i] = std::polar(1.f, (float) (2.0 * M_PI * f * dx));
+        rampY[i] = std::polar(1.f, (float) (2.0 * M_PI * f * dy));
+    }
+
+    float a = (float) alpha;
+    const Complex *f = m_frame.data();
+    Complex *r = m_reference.data();
+    const Complex *rx = rampX.data();
+    const Complex *ry = rampY.data();
+    ParallelRows([=](unsigned int begin, unsigned int end) {
+        for (unsigned int v = begin; v < end; v++)
+        {
+            for (unsigned int u = 0; u < n; u++)
+            {
+                unsigned int i = v * n + u;
+                r[i] = (1.f - a) * r[i] + a * (f[i] * rx[u] * ry[v]);
+            }
+        }
+    });
+}
@@ -0,0 +1,102 @@
+/*
+ *  phase_correlator.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PHASE_CORRELATOR_H_INCLUDED
+#define PHASE_CORRELATOR_H_INCLUDED
+
+#include <complex>
+
+// Measures the shift of an image window against a reference window by FFT phase correlation.
+//
+// The window is square with a power-of-two side. Pixels are mean-subtracted and multiplied by
+// a Hann window before the transform; the normalized cross-power spectrum of the frame and the
+// reference is smoothed with a narrow Gaussian so that the correlation peak has a Gaussian
+// profile, which makes a log-parabola fit through the peak and its neighbors a near-unbiased
+// sub-pixel estimate. The FFT tables, window and scratch buffers are kept between frames and
+// only rebuilt when the size changes, and the row and column passes of the 2-D transforms are
+// spread over the available cores.
+class PhaseCorrelator
+{
+public:
+    typedef std::complex<float> Complex;
+
+private:
+    struct FFTPlan
+    {
+        unsigned int n;
+        std::vector<unsigned int> bitrev;
+        std::vector<Complex> twiddle; // exp(-2 pi i k / n), k < n/2
+    };
+
+    unsigned int m_size;
+    unsigned int m_threads;
+    FFTPlan m_plan;
+    std::vector<float> m_window; // 1-D Hann window, applied separably
+    std::vector<float> m_lowpass; // 1-D Gaussian weights for the cross-power spectrum
+    std::vector<Complex> m_reference; // reference spectrum
+    std::vector<Complex> m_frame; // spectrum of the last registered frame
+    std::vector<Complex> m_work; // cross-power spectrum, then correlation surface
+    bool m_haveReference;
+    double m_flux;
+
+    void Load(const usImage& img, const wxPoint& origin, std::vector<Complex> *dst);
+    void Transform(std::vector<Complex> *data, bool inverse) const;
+    void ParallelRows(const std::function<void(unsigned int, unsigned int)>& fn) const;
+
+public:
+    PhaseCorrelator();
+
+    // size must be a power of two between 8 and 4096; returns true on error
+    bool Init(unsigned int size);
+    unsigned int Size() const { return m_size; }
+
+    // the window is the size x size square with top-left corner at origin; pixels outside the
+    // image, or outside its subframe, are treated as background
+    void SetReference(const usImage& img, const wxPoint& origin);
+    void ClearReference();
+    bool HasReference() const { return m_haveReference; }
+
+    // Measure the shift of the window contents against the reference. On return (dx, dy) is
+    // where the reference content now sits relative to where it was in the reference window,
+    // and quality is the peak-to-sidelobe ratio of the correlation peak.
+    void Register(const usImage& img, const wxPoint& origin, double *dx, double *dy, double *quality);
+
+    // blend the last registered frame, shifted back by (dx, dy), into the reference spectrum
+    // with weight alpha, so the reference follows slow changes of the target's appearance
+    void UpdateReference(double alpha, double dx, double dy);
+
+    // background-subtracted sum of the pixels in the last loaded window
+    double Flux() const { return m_flux; }
+};
+
+#endif
@@ -34,6 +34,7 @@
 
 #include "phd.h"
 
+#include "guide_log_replay.h"
 #include "phdupdate.h"
 
 #include <curl/curl.h>
@@ -69,8 +70,12 @@ static const wxCmdLineEntryDesc cmdLineDesc[] = {
       wxCMD_LINE_PARAM_OPTIONAL },
     { wxCMD_LINE_OPTION, "l", "load", "load settings from file and exit", wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
     { wxCMD_LINE_SWITCH, "R", "Reset", "Reset all PHD2 settings to default values" },
+    { wxCMD_LINE_OPTION, "r", "replay", "replay a guide log through the guide algorithms of --sweep, print the ranking and exit",
+      wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
     { wxCMD_LINE_OPTION, "s", "save", "save settings to file and exit", wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
     { wxCMD_LINE_SWITCH, "v", "version", "print the program version and exit" },
+    { wxCMD_LINE_OPTION, "w", "sweep", "guide algorithm parameter sweep specification for --replay", wxCMD_LINE_VAL_STRING,
+      wxCMD_LINE_PARAM_OPTIONAL },
     { wxCMD_LINE_NONE }
 };
 
@@ -82,6 +87,8 @@ enum ConfigOp
 };
 static ConfigOp s_configOp = CONFIG_OP_NONE;
 static wxString s_configPath;
+static wxString s_replayLog;
+static wxString s_replaySweep;
 
 wxIMPLEMENT_APP(PhdApp);
 
@@ -552,6 +559,13 @@ bool PhdApp::OnInit()
         return false;
     }
 
+    if (!s_replayLog.empty())
+    {
+        int rc = RunGuideLogReplay(s_replayLog, s_replaySweep);
+        ::exit(rc);
+        return false;
+    }
+
     m_logFileTime = DebugLog::GetLogFileTime(); // GetLogFileTime implements grouping by imaging-day, the 24-hour period
                                                 // starting at 09:00 am local time
     OpenLogs(false /* not for rollover */);
@@ -634,6 +648,8 @@ int PhdApp::OnExit()
     assert(!pSecondaryMount);
     assert(!pCamera);
 
+    DeviceEnumerator::Shutdown();
+
     ImageLogger::Destroy();
 
     PhdController::OnAppExit();
@@ -677,6 +693,12 @@ bool PhdApp::OnCmdLineParsed(wxCmdLineParser& parser)
 
     m_resetConfig = parser.Found("R");
 
+    if (parser.Found("r", &s_replayLog) && !parser.Found("w", &s_replaySweep))
+    {
+        wxFprintf(stderr, "--replay requires a --sweep specification\n");
+        ::exit(1);
+    }
+
     return true;
 }
 
@@ -157,6 +157,10 @@ WX_DEFINE_ARRAY_DOUBLE(double, ArrayOfDbl);
 #include "usImage.h"
 #include "point.h"
 #include "star.h"
+#include "star_field_index.h"
+#include "background_mesh.h"
+#include "defect_learner.h"
+#include "frame_ring.h"
 #include "circbuf.h"
 #include "guidinglog.h"
 #include "graph.h"
@@ -176,12 +180,16 @@ WX_DEFINE_ARRAY_DOUBLE(double, ArrayOfDbl);
 #include "scopes.h"
 #include "stepguiders.h"
 #include "rotators.h"
+#include "image_math_simd.h"
 #include "image_math.h"
 #include "testguide.h"
 #include "advanced_dialog.h"
 #include "gear_dialog.h"
 #include "myframe.h"
 #include "debuglog.h"
+#include "device_enum.h"
+#include "frame_trace.h"
+#include "metrics.h"
 #include "worker_thread.h"
 #include "event_server.h"
 #include "confirm_dialog.h"
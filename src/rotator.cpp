@@ -55,7 +55,7 @@ wxArrayString Rotator::RotatorList()
 
     rotatorList.Add(_("None"));
 #ifdef ROTATOR_ASCOM
-    wxArrayString ascomRotators = RotatorAscom::EnumAscomRotators();
+    wxArrayString ascomRotators = DeviceEnumerator::List(DeviceEnumerator::ASCOM_ROTATORS);
     for (unsigned int i = 0; i < ascomRotators.Count(); i++)
         rotatorList.Add(ascomRotators[i]);
 #endif
@@ -64,10 +64,8 @@ static wxString displayName(const wxString& ascomName)
     return ascomName + _T(" (ASCOM)");
 }
 
-// map descriptive name to progid
-static std::map<wxString, wxString> s_progid;
-
-wxArrayString RotatorAscom::EnumAscomRotators(void)
+// progids are keyed by descriptive name
+wxArrayString RotatorAscom::EnumAscomRotators(std::map<wxString, wxString> *progids)
 {
     wxArrayString list;
 
@@ -104,7 +102,7 @@ wxArrayString RotatorAscom::EnumAscomRotators(void)
                     wxString ascomName = vval.bstrVal;
                     wxString displName = displayName(ascomName);
                     wxString progid = vkey.bstrVal;
-                    s_progid[displName] = progid;
+                    (*progids)[displName] = progid;
                     list.Add(displName);
                 }
             }
@@ -127,9 +125,16 @@ bool AscomRotatorImpl::Create(DispatchObj *obj, DispatchClass *cls)
         return true;
     }
 
-    Debug.Write(wxString::Format("Create ASCOM Rotator: choice '%s' progid %s\n", m_choice, s_progid[m_choice]));
+    wxString id;
+    if (DeviceEnumerator::GetId(DeviceEnumerator::ASCOM_ROTATORS, m_choice, &id))
+    {
+        Debug.AddLine("ASCOM Rotator: could not find the progid for rotator " + m_choice);
+        return false;
+    }
+
+    Debug.Write(wxString::Format("Create ASCOM Rotator: choice '%s' progid %s\n", m_choice, id));
 
-    wxBasicString progid(s_progid[m_choice]);
+    wxBasicString progid(id);
 
     if (!obj->Create(progid))
     {
@@ -47,7 +47,7 @@ public:
     RotatorAscom(const wxString& name);
     virtual ~RotatorAscom();
 
-    static wxArrayString EnumAscomRotators();
+    static wxArrayString EnumAscomRotators(std::map<wxString, wxString> *progids);
 
     bool Connect() override;
     bool Disconnect() override;
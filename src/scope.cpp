@@ -351,7 +351,7 @@ wxArrayString Scope::MountList()
 
     ScopeList.Add(_("None"));
 #ifdef GUIDE_ASCOM
-    wxArrayString ascomScopes = ScopeASCOM::EnumAscomScopes();
+    wxArrayString ascomScopes = DeviceEnumerator::List(DeviceEnumerator::ASCOM_SCOPES);
     for (unsigned int i = 0; i < ascomScopes.Count(); i++)
         ScopeList.Add(ascomScopes[i]);
 #endif
@@ -397,7 +397,7 @@ wxArrayString Scope::AuxMountList()
     scopeList.Add(_("None")); // Keep this at the top of the list
 
 #ifdef GUIDE_ASCOM
-    wxArrayString positionAwareScopes = ScopeASCOM::EnumAscomScopes();
+    wxArrayString positionAwareScopes = DeviceEnumerator::List(DeviceEnumerator::ASCOM_SCOPES);
     positionAwareScopes.Sort(&CompareNoCase);
     for (unsigned int i = 0; i < positionAwareScopes.Count(); i++)
         scopeList.Add(positionAwareScopes[i]);
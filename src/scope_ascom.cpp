@@ -83,10 +83,8 @@ static wxString displayName(const wxString& ascomName)
     return ascomName + _T(" (ASCOM)");
 }
 
-// map descriptive name to progid
-static std::map<wxString, wxString> s_progid;
-
-wxArrayString ScopeASCOM::EnumAscomScopes()
+// progids are keyed by descriptive name
+wxArrayString ScopeASCOM::EnumAscomScopes(std::map<wxString, wxString> *progids)
 {
     wxArrayString list;
 
@@ -123,7 +121,7 @@ wxArrayString ScopeASCOM::EnumAscomScopes()
                     wxString ascomName = vval.bstrVal;
                     wxString displName = displayName(ascomName);
                     wxString progid = vkey.bstrVal;
-                    s_progid[displName] = progid;
+                    (*progids)[displName] = progid;
                     list.Add(displName);
                 }
             }
@@ -149,9 +147,13 @@ bool ScopeASCOM::Create(DispatchObj& obj)
             return true;
         }
 
-        Debug.Write(wxString::Format("Create ASCOM Scope: choice '%s' progid %s\n", m_choice, s_progid[m_choice]));
+        wxString id;
+        if (DeviceEnumerator::GetId(DeviceEnumerator::ASCOM_SCOPES, m_choice, &id))
+            throw ERROR_INFO("ASCOM Scope: could not find the progid for " + m_choice);
+
+        Debug.Write(wxString::Format("Create ASCOM Scope: choice '%s' progid %s\n", m_choice, id));
 
-        wxBasicString progid(s_progid[m_choice]);
+        wxBasicString progid(id);
 
         if (!obj.Create(progid))
         {
@@ -88,7 +88,7 @@ class ScopeASCOM : public Scope
 public:
     ScopeASCOM(const wxString& choice);
     virtual ~ScopeASCOM();
-    static wxArrayString EnumAscomScopes();
+    static wxArrayString EnumAscomScopes(std::map<wxString, wxString> *progids);
 
     bool Connect() override;
     bool Disconnect() override;
@@ -123,9 +123,165 @@ static double hfr(std::vector<R2M>& vec, double cx, double cy, double mass)
     return hfr;
 }
 
+enum
+{
+    // the PSF fit uses the same 15x15 box as the centroid aperture, padded to a multiple of 4
+    PSF_STAMP_RADIUS = 7,
+    PSF_STAMP_PIXELS = (2 * PSF_STAMP_RADIUS + 1) * (2 * PSF_STAMP_RADIUS + 1),
+    PSF_STAMP_SIZE = (PSF_STAMP_PIXELS + 3) & ~3,
+    PSF_MAX_ITERATIONS = 12,
+};
+
+// solve the 5x5 system m x = v by Gaussian elimination with partial pivoting; returns true if
+// m is singular
+static bool Solve5(double m[5][6], double x[5])
+{
+    for (int c = 0; c < 5; c++)
+    {
+        int pivot = c;
+        for (int r = c + 1; r < 5; r++)
+            if (fabs(m[r][c]) > fabs(m[pivot][c]))
+                pivot = r;
+        if (fabs(m[pivot][c]) < 1e-12)
+            return true;
+        if (pivot != c)
+            for (int k = c; k < 6; k++)
+                std::swap(m[c][k], m[pivot][k]);
+        for (int r = c + 1; r < 5; r++)
+        {
+            double f = m[r][c] / m[c][c];
+            for (int k = c; k < 6; k++)
+                m[r][k] -= f * m[c][k];
+        }
+    }
+    for (int r = 4; r >= 0; r--)
+    {
+        double s = m[r][5];
+        for (int k = r + 1; k < 5; k++)
+            s -= m[r][k] * x[k];
+        x[r] = s / m[r][r];
+    }
+    return false;
+}
+
+// electrons per ADU, nominal
+static const double NOMINAL_GAIN = 0.5;
+
+// Refine the moment centroid (*x, *y) with a Levenberg-Marquardt fit of a circular Gaussian
+// plus background to the pixels around it, seeded with the background and HFD measured by the
+// centroid. Each pixel is weighted by the inverse of its expected variance: the shot noise of
+// its signal above background at the nominal gain, plus the background variance measured by
+// the centroid, which covers sky and read noise. Saturated pixels (>= satADU, if non-zero) are
+// left out. The iteration count is bounded; returns true if the fit fails or lands implausibly
+// far from the centroid, in which case the centroid is left alone.
+static bool FitGaussianPSF(const usImage *pImg, int minx, int miny, int maxx, int maxy, double *x, double *y,
+                           double background, double bgVariance, double hfd, unsigned int satADU)
+{
+    int const cx = ROUND(*x);
+    int const cy = ROUND(*y);
+    if (cx - PSF_STAMP_RADIUS < minx || cx + PSF_STAMP_RADIUS > maxx || cy - PSF_STAMP_RADIUS < miny ||
+        cy + PSF_STAMP_RADIUS > maxy)
+    {
+        return true;
+    }
+
+    float dx[PSF_STAMP_SIZE], dy[PSF_STAMP_SIZE], val[PSF_STAMP_SIZE], weight[PSF_STAMP_SIZE];
+    unsigned int n = 0;
+    unsigned short peak = 0;
+    int const rowsize = pImg->Size.GetWidth();
+    // a perfectly flat background (simulator, clipped sky) must not give infinite weights
+    double const floorVariance = wxMax(bgVariance, 1.0);
+    for (int j = -PSF_STAMP_RADIUS; j <= PSF_STAMP_RADIUS; j++)
+    {
+        const unsigned short *row = pImg->ImageData + (cy + j) * rowsize + cx;
+        for (int i = -PSF_STAMP_RADIUS; i <= PSF_STAMP_RADIUS; i++, n++)
+        {
+            unsigned short v = row[i];
+            dx[n] = (float) i;
+            dy[n] = (float) j;
+            val[n] = (float) v;
+            if (satADU && v >= satADU)
+                weight[n] = 0.f;
+            else
+                weight[n] = (float) (1.0 / (wxMax(v - background, 0.0) / NOMINAL_GAIN + floorVariance));
+            if (v > peak)
+                peak = v;
+        }
+    }
+    for (; n < PSF_STAMP_SIZE; n++)
+        dx[n] = dy[n] = val[n] = weight[n] = 0.f;
+
+    // b, a, x0, y0, sigma; for a Gaussian HFD = 2 sqrt(2 ln 2) sigma
+    double p[5] = { background, wxMax(1.0, peak - background), *x - cx, *y - cy, wxMax(0.5, hfd / 2.3548) };
+
+    auto evaluate = [&](const double *q, double *sums) {
+        float const fq[5] = { (float) q[0], (float) q[1], (float) q[2], (float) q[3], (float) q[4] };
+        AccumulatePSFNormals(dx, dy, val, weight, PSF_STAMP_SIZE, fq, sums);
+    };
+
+    double best[PSF_NORMAL_SUMS];
+    evaluate(p, best);
+
+    double lambda = 1e-3;
+    bool converged = false;
+
+    for (unsigned int iter = 0; iter < PSF_MAX_ITERATIONS && !converged; iter++)
+    {
+        double m[5][6];
+        unsigned int k = 0;
+        for (int r = 0; r < 5; r++)
+        {
+            for (int c = r; c < 5; c++, k++)
+                m[r][c] = m[c][r] = best[k];
+            m[r][5] = best[15 + r];
+        }
+        for (int r = 0; r < 5; r++)
+            m[r][r] *= 1.0 + lambda;
+
+        double delta[5];
+        if (Solve5(m, delta))
+            return true;
+
+        bool small = fabs(delta[2]) < 1e-3 && fabs(delta[3]) < 1e-3;
+
+        double q[5];
+        for (int i = 0; i < 5; i++)
+            q[i] = p[i] + delta[i];
+
+        double trial[PSF_NORMAL_SUMS];
+        bool accept = q[1] > 0. && q[4] >= 0.3 && q[4] <= PSF_STAMP_RADIUS;
+        if (accept)
+        {
+            evaluate(q, trial);
+            accept = trial[20] <= best[20];
+        }
+
+        if (accept)
+        {
+            memcpy(p, q, sizeof(p));
+            memcpy(best, trial, sizeof(best));
+            lambda *= 0.1;
+        }
+        else
+            lambda *= 10.0;
+
+        // a step too small to matter ends the fit whether or not it was taken
+        converged = small;
+    }
+
+    if (!converged || hypot(cx + p[2] - *x, cy + p[3] - *y) > 1.5)
+        return true;
+
+    *x = cx + p[2];
+    *y = cy + p[3];
+    return false;
+}
+
 bool Star::Find(const usImage *pImg, int searchRegion, int base_x, int base_y, FindMode mode, double minHFD, double maxHFD,
-                unsigned short maxADU, StarFindLogType loggingControl)
+                unsigned short maxADU, StarFindLogType loggingControl, const BackgroundMesh *background)
 {
+    FRAME_TRACE_SPAN("Star::Find");
+
     FindResult Result = STAR_OK;
     double newX = base_x;
     double newY = base_y;
@@ -232,12 +388,6 @@ bool Star::Find(const usImage *pImg, int searchRegion, int base_x, int base_y, F
         int const A2 = A * A;
         int const B2 = B * B;
 
-        // center window around peak value
-        start_x = wxMax(peak_x - B, minx);
-        end_x = wxMin(peak_x + B, maxx);
-        start_y = wxMax(peak_y - B, miny);
-        end_y = wxMin(peak_y + B, maxy);
-
         // find the mean and stdev of the background
 
         unsigned int nbg;
@@ -245,55 +395,71 @@ bool Star::Find(const usImage *pImg, int searchRegion, int base_x, int base_y, F
         double sigma2_bg = 0.;
         double sigma_bg = 0.;
 
-        for (int iter = 0; iter < 9; iter++)
+        // use the caller's background mesh if it has one for this frame, otherwise estimate the
+        // background from the annulus
+        if (background && background->Lookup(peak_x, peak_y, &mean_bg, &sigma_bg))
         {
-            double sum = 0.0;
-            double a = 0.0;
-            double q = 0.0;
-            nbg = 0;
+            sigma2_bg = sigma_bg * sigma_bg;
+            nbg = background->SamplesPerBox();
+        }
+        else
+        {
+            // center window around peak value
+            start_x = wxMax(peak_x - B, minx);
+            end_x = wxMin(peak_x + B, maxx);
+            start_y = wxMax(peak_y - B, miny);
+            end_y = wxMin(peak_y + B, maxy);
 
-            const unsigned short *row = imgdata + rowsize * start_y;
-            for (int y = start_y; y <= end_y; y++, row += rowsize)
+            for (int iter = 0; iter < 9; iter++)
             {
-                int dy = y - peak_y;
-                int dy2 = dy * dy;
-                for (int x = start_x; x <= end_x; x++)
+                double sum = 0.0;
+                double a = 0.0;
+                double q = 0.0;
+                nbg = 0;
+
+                const unsigned short *row = imgdata + rowsize * start_y;
+                for (int y = start_y; y <= end_y; y++, row += rowsize)
                 {
-                    int dx = x - peak_x;
-                    int r2 = dx * dx + dy2;
+                    int dy = y - peak_y;
+                    int dy2 = dy * dy;
+                    for (int x = start_x; x <= end_x; x++)
+                    {
+                        int dx = x - peak_x;
+                        int r2 = dx * dx + dy2;
 
-                    // exclude points not in annulus
-                    if (r2 <= A2 || r2 > B2)
-                        continue;
+                        // exclude points not in annulus
+                        if (r2 <= A2 || r2 > B2)
+                            continue;
 
-                    double const val = (double) row[x];
+                        double const val = (double) row[x];
 
-                    if (iter > 0 && (val < mean_bg - 2.0 * sigma_bg || val > mean_bg + 2.0 * sigma_bg))
-                        continue;
+                        if (iter > 0 && (val < mean_bg - 2.0 * sigma_bg || val > mean_bg + 2.0 * sigma_bg))
+                            continue;
 
-                    sum += val;
-                    ++nbg;
-                    double const k = (double) nbg;
-                    double const a0 = a;
-                    a += (val - a) / k;
-                    q += (val - a0) * (val - a);
+                        sum += val;
+                        ++nbg;
+                        double const k = (double) nbg;
+                        double const a0 = a;
+                        a += (val - a) / k;
+                        q += (val - a0) * (val - a);
+                    }
                 }
-            }
 
-            if (nbg < 10) // only possible after the first iteration
-            {
-                Debug.Write(wxString::Format("Star::Find: too few background points! nbg=%u mean=%.1f sigma=%.1f\n", nbg,
-                                             mean_bg, sigma_bg));
-                break;
-            }
+                if (nbg < 10) // only possible after the first iteration
+                {
+                    Debug.Write(wxString::Format("Star::Find: too few background points! nbg=%u mean=%.1f sigma=%.1f\n", nbg,
+                                                 mean_bg, sigma_bg));
+                    break;
+                }
 
-            prev_mean_bg = mean_bg;
-            mean_bg = sum / (double) nbg;
-            sigma2_bg = q / (double) (nbg - 1);
-            sigma_bg = sqrt(sigma2_bg);
+                prev_mean_bg = mean_bg;
+                mean_bg = sum / (double) nbg;
+                sigma2_bg = q / (double) (nbg - 1);
+                sigma_bg = sqrt(sigma2_bg);
 
-            if (iter > 0 && fabs(mean_bg - prev_mean_bg) < 0.5)
-                break;
+                if (iter > 0 && fabs(mean_bg - prev_mean_bg) < 0.5)
+                    break;
+            }
         }
 
         unsigned short thresh;
@@ -362,8 +528,7 @@ bool Star::Find(const usImage *pImg, int searchRegion, int base_x, int base_y, F
         // SNR estimate from: Measuring the Signal-to-Noise Ratio S/N of the CCD Image of a Star or Nebula, J.H.Simonetti, 2004
         // January 8
         //     http://www.phys.vt.edu/~jhs/phys3154/snr20040108.pdf
-        double const gain = .5; // electrons per ADU, nominal
-        SNR = n > 0 ? mass / sqrt(mass / gain + sigma2_bg * (double) n * (1.0 + 1.0 / (double) nbg)) : 0.0;
+        SNR = n > 0 ? mass / sqrt(mass / NOMINAL_GAIN + sigma2_bg * (double) n * (1.0 + 1.0 / (double) nbg)) : 0.0;
 
         double const LOW_SNR = 3.0;
 
@@ -409,6 +574,16 @@ bool Star::Find(const usImage *pImg, int searchRegion, int base_x, int base_y, F
             }
         }
 
+        if (mode == FIND_PSF)
+        {
+            unsigned int satADU = maxADU > 0 ? (unsigned int) maxADU + pImg->Pedestal : 0;
+            if (FitGaussianPSF(pImg, minx, miny, maxx, maxy, &newX, &newY, mean_bg, sigma2_bg, HFD, satADU) &&
+                loggingControl == FIND_LOGGING_VERBOSE)
+            {
+                Debug.Write("Star::Find: PSF fit failed, using centroid\n");
+            }
+        }
+
         // check for saturation
 
         unsigned int mx = (unsigned int) max3[0];
@@ -477,9 +652,9 @@ done:
 }
 
 bool Star::Find(const usImage *pImg, int searchRegion, FindMode mode, double minHFD, double maxHFD, unsigned short saturation,
-                StarFindLogType loggingControl)
+                StarFindLogType loggingControl, const BackgroundMesh *background)
 {
-    return Find(pImg, searchRegion, X, Y, mode, minHFD, maxHFD, saturation, loggingControl);
+    return Find(pImg, searchRegion, X, Y, mode, minHFD, maxHFD, saturation, loggingControl, background);
 }
 
 struct FloatImg
@@ -716,7 +891,7 @@ static bool CloseToReference(const GuideStar& referencePoint, const GuideStar& o
 
 // Multi-star version of AutoFind.
 bool GuideStar::AutoFind(const usImage& image, int extraEdgeAllowance, int searchRegion, const wxRect& roi,
-                         std::vector<GuideStar>& foundStars, int maxStars)
+                         std::vector<GuideStar>& foundStars, int maxStars, const BackgroundMesh *background)
 {
     if (!image.Subframe.IsEmpty())
     {
@@ -804,8 +979,18 @@ bool GuideStar::AutoFind(const usImage& image, int extraEdgeAllowance, int searc
 
     Debug.Write(wxString::Format("AutoFind: global mean = %.1f, stdev %.1f\n", global_mean, global_stdev));
 
-    const double threshold = 0.1;
-    Debug.Write(wxString::Format("AutoFind: using threshold = %.1f\n", threshold));
+    // measure peaks against the local background and noise of the filtered image, so that
+    // gradients from moonlight or amp glow do not swamp or fake stars
+    wxRect meshRect(convRect);
+    if (!roi.IsEmpty())
+        meshRect.Intersect(wxRect(smoothed.Subframe.x / downsample, smoothed.Subframe.y / downsample,
+                                  smoothed.Subframe.width / downsample, smoothed.Subframe.height / downsample));
+    BackgroundMesh mesh;
+    bool useMesh = !mesh.Build(conv.px, conv.Size, meshRect);
+
+    const double threshold = 0.1; // in units of the global stdev
+    const double meshThreshold = 3.0; // in units of the local background RMS
+    Debug.Write(wxString::Format("AutoFind: using threshold = %.1f\n", useMesh ? meshThreshold : threshold));
 
     // find each local maximum
     int srch = 4;
@@ -835,15 +1020,26 @@ bool GuideStar::AutoFind(const usImage& image, int extraEdgeAllowance, int searc
             if (!ismax)
                 continue;
 
-            // compare local maximum to mean value of surrounding pixels
-            const int local = 7;
+            // this is our measure of star intensity
+            double h;
             double local_mean, local_stdev;
-            wxRect localRect(x - local, y - local, 2 * local + 1, 2 * local + 1);
-            localRect.Intersect(convRect);
-            GetStats(&local_mean, &local_stdev, conv, localRect);
 
-            // this is our measure of star intensity
-            double h = (val - local_mean) / global_stdev;
+            if (useMesh && mesh.Lookup(x, y, &local_mean, &local_stdev) && local_stdev > 0.0)
+            {
+                h = (val - local_mean) / local_stdev;
+                if (h < meshThreshold)
+                    continue;
+            }
+            else
+            {
+                // compare local maximum to mean value of surrounding pixels
+                const int local = 7;
+                wxRect localRect(x - local, y - local, 2 * local + 1, 2 * local + 1);
+                localRect.Intersect(convRect);
+                GetStats(&local_mean, &local_stdev, conv, localRect);
+
+                h = (val - local_mean) / global_stdev;
+            }
 
             if (h < threshold)
             {
@@ -984,7 +1180,7 @@ bool GuideStar::AutoFind(const usImage& image, int extraEdgeAllowance, int searc
         {
             Star tmp;
             tmp.Find(&image, searchRegion, it->x, it->y, FIND_CENTROID, pFrame->pGuider->GetMinStarHFD(),
-                     pFrame->pGuider->GetMaxStarHFD(), pCamera->GetSaturationADU(), FIND_LOGGING_VERBOSE);
+                     pFrame->pGuider->GetMaxStarHFD(), pCamera->GetSaturationADU(), FIND_LOGGING_VERBOSE, background);
             if (tmp.WasFound() && tmp.GetError() == STAR_SATURATED)
             {
                 if ((maxVal - tmp.PeakVal) * 255U > maxVal)
@@ -1039,7 +1235,7 @@ bool GuideStar::AutoFind(const usImage& image, int extraEdgeAllowance, int searc
         {
             GuideStar tmp;
             tmp.Find(&image, searchRegion, it->x, it->y, FIND_CENTROID, pFrame->pGuider->GetMinStarHFD(), maxHFD,
-                     pCamera->GetSaturationADU(), FIND_LOGGING_VERBOSE);
+                     pCamera->GetSaturationADU(), FIND_LOGGING_VERBOSE, background);
             // We're repeating the find, so we're vulnerable to hot pixels and creation of unwanted duplicates
             if (tmp.WasFound() && tmp.SNR >= minSNR)
             {
@@ -1070,7 +1266,7 @@ bool GuideStar::AutoFind(const usImage& image, int extraEdgeAllowance, int searc
         {
             GuideStar tmp;
             tmp.Find(&image, searchRegion, it->x, it->y, FIND_CENTROID, pFrame->pGuider->GetMinStarHFD(), maxHFD,
-                     pCamera->GetSaturationADU(), FIND_LOGGING_VERBOSE);
+                     pCamera->GetSaturationADU(), FIND_LOGGING_VERBOSE, background);
             if (tmp.WasFound())
             {
                 if (pass == 1)
@@ -40,6 +40,8 @@
 
 #include "point.h"
 
+class BackgroundMesh;
+
 class Star : public PHD_Point
 {
 public:
@@ -47,6 +49,7 @@ public:
     {
         FIND_CENTROID,
         FIND_PEAK,
+        FIND_PSF, // centroid refined by a Gaussian PSF fit
     };
 
     enum FindResult
@@ -80,10 +83,12 @@ public:
      *       a boolean indicating success instead of a boolean indicating an
      *       error
      */
+    // background, if given, is a mesh measured on pImg; the background around the star is
+    // estimated from an annulus otherwise
     bool Find(const usImage *pImg, int searchRegion, FindMode mode, double min_hfd, double max_hfd, unsigned short saturation,
-              StarFindLogType loggingControl);
+              StarFindLogType loggingControl, const BackgroundMesh *background = nullptr);
     bool Find(const usImage *pImg, int searchRegion, int X, int Y, FindMode mode, double min_hfd, double max_hfd,
-              unsigned short saturation, StarFindLogType loggingControl);
+              unsigned short saturation, StarFindLogType loggingControl, const BackgroundMesh *background = nullptr);
 
     static bool WasFound(FindResult result);
     bool WasFound() const;
@@ -117,7 +122,7 @@ public:
     }
 
     bool AutoFind(const usImage& image, int extraEdgeAllowance, int searchRegion, const wxRect& roi,
-                  std::vector<GuideStar>& foundStars, int maxStars);
+                  std::vector<GuideStar>& foundStars, int maxStars, const BackgroundMesh *background = nullptr);
 };
 
 #endif /* STAR_H_INCLUDED */
@@ -0,0 +1,238 @@
+/*
+ *  star_field_index.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "phd.h"
+
+#include <algorithm>
+
+// triangles with a shorter longest side are too sensitive to centroid errors to be useful
+static const double MIN_TRIANGLE_SIDE = 20.0;
+
+struct TriangleSide
+{
+    double len;
+    unsigned char opposite; // the vertex opposite this side
+};
+
+static void MakeTriangles(const std::vector<PHD_Point>& stars, std::vector<StarFieldIndex::Triangle> *triangles)
+{
+    unsigned int const n = stars.size();
+    triangles->clear();
+    triangles->reserve(n * (n - 1) * (n - 2) / 6);
+
+    for (unsigned int i = 0; i < n; i++)
+        for (unsigned int j = i + 1; j < n; j++)
+            for (unsigned int k = j + 1; k < n; k++)
+            {
+                TriangleSide side[3] = {
+                    { stars[j].Distance(stars[k]), (unsigned char) i },
+                    { stars[i].Distance(stars[k]), (unsigned char) j },
+                    { stars[i].Distance(stars[j]), (unsigned char) k },
+                };
+                std::sort(side, side + 3, [](const TriangleSide& l, const TriangleSide& r) { return l.len < r.len; });
+
+                if (side[2].len < MIN_TRIANGLE_SIDE)
+                    continue;
+
+                StarFieldIndex::Triangle t;
+                t.shape1 = side[1].len / side[2].len;
+                t.shape2 = side[0].len / side[2].len;
+                t.longest = side[2].len;
+                t.a = side[0].opposite;
+                t.b = side[1].opposite;
+                t.c = side[2].opposite;
+                triangles->push_back(t);
+            }
+}
+
+PHD_Point StarFieldIndex::RotatePoint(const PHD_Point& p, double angle)
+{
+    double c = cos(angle);
+    double s = sin(angle);
+    return PHD_Point(c * p.X - s * p.Y, s * p.X + c * p.Y);
+}
+
+void StarFieldIndex::Build(const std::vector<PHD_Point>& stars)
+{
+    m_stars.assign(stars.begin(), stars.begin() + std::min(stars.size(), (size_t) MAX_STARS));
+
+    if (m_stars.size() < MIN_STARS)
+    {
+        Clear();
+        return;
+    }
+
+    MakeTriangles(m_stars, &m_triangles);
+    std::sort(m_triangles.begin(), m_triangles.end(),
+              [](const Triangle& l, const Triangle& r) { return l.shape1 < r.shape1; });
+
+    Debug.Write(wxString::Format("StarFieldIndex: %u stars, %u triangles\n", (unsigned int) m_stars.size(),
+                                 (unsigned int) m_triangles.size()));
+}
+
+void StarFieldIndex::Clear()
+{
+    m_stars.clear();
+    m_triangles.clear();
+}
+
+void StarFieldIndex::Rotate(double angle)
+{
+    std::vector<PHD_Point> stars;
+    stars.reserve(m_stars.size());
+    for (const PHD_Point& p : m_stars)
+        stars.push_back(RotatePoint(p, angle));
+    Build(stars);
+}
+
+static double NormalizeAngle(double angle)
+{
+    angle = fmod(angle, 2. * M_PI);
+    if (angle > M_PI)
+        angle -= 2. * M_PI;
+    else if (angle <= -M_PI)
+        angle += 2. * M_PI;
+    return angle;
+}
+
+bool StarFieldIndex::Match(const std::vector<PHD_Point>& stars, double tolerance, PHD_Point *origin, double *angle,
+                           unsigned int *matched) const
+{
+    if (m_triangles.empty())
+        return false;
+
+    std::vector<PHD_Point> frame(stars.begin(), stars.begin() + std::min(stars.size(), (size_t) (MAX_STARS + 4)));
+    if (frame.size() < MIN_STARS)
+        return false;
+
+    std::vector<Triangle> triangles;
+    MakeTriangles(frame, &triangles);
+
+    double const tol2 = tolerance * tolerance;
+    unsigned int bestCount = 0;
+    double bestAngle = 0.;
+    PHD_Point bestOrigin;
+    std::vector<int> pairs(m_stars.size());
+    std::vector<int> bestPairs;
+
+    for (const Triangle& t : triangles)
+    {
+        // a position error of tolerance changes a shape ratio by up to about 2 * tolerance / longest
+        double const shapeTol = 2. * tolerance / t.longest;
+
+        auto it = std::lower_bound(m_triangles.begin(), m_triangles.end(), t.shape1 - shapeTol,
+                                   [](const Triangle& r, double v) { return r.shape1 < v; });
+
+        for (; it != m_triangles.end() && it->shape1 <= t.shape1 + shapeTol; ++it)
+        {
+            const Triangle& r = *it;
+            if (fabs(r.shape2 - t.shape2) > shapeTol || fabs(r.longest - t.longest) > 2. * tolerance)
+                continue;
+
+            // the rotation and shift that carry reference vertices a, b onto the frame vertices
+            const PHD_Point& ra = m_stars[r.a];
+            const PHD_Point& rb = m_stars[r.b];
+            const PHD_Point& fa = frame[t.a];
+            const PHD_Point& fb = frame[t.b];
+            double rot = atan2(fb.Y - fa.Y, fb.X - fa.X) - atan2(rb.Y - ra.Y, rb.X - ra.X);
+            double c = cos(rot);
+            double s = sin(rot);
+            double ox = fa.X - (c * ra.X - s * ra.Y);
+            double oy = fa.Y - (s * ra.X + c * ra.Y);
+
+            // count the reference stars that land on a frame star
+            unsigned int count = 0;
+            for (unsigned int i = 0; i < m_stars.size(); i++)
+            {
+                double px = ox + c * m_stars[i].X - s * m_stars[i].Y;
+                double py = oy + s * m_stars[i].X + c * m_stars[i].Y;
+                pairs[i] = -1;
+                for (unsigned int j = 0; j < frame.size(); j++)
+                {
+                    double dx = frame[j].X - px;
+                    double dy = frame[j].Y - py;
+                    if (dx * dx + dy * dy <= tol2)
+                    {
+                        pairs[i] = j;
+                        ++count;
+                        break;
+                    }
+                }
+            }
+
+            if (count > bestCount)
+            {
+                bestCount = count;
+                bestPairs = pairs;
+            }
+        }
+    }
+
+    // with the three vertices matched by construction, require at least one more star
+    if (bestCount < MIN_STARS)
+        return false;
+
+    // least-squares rotation and shift over all the matched stars
+    double rx = 0., ry = 0., fx = 0., fy = 0.;
+    for (unsigned int i = 0; i < m_stars.size(); i++)
+        if (bestPairs[i] >= 0)
+        {
+            rx += m_stars[i].X;
+            ry += m_stars[i].Y;
+            fx += frame[bestPairs[i]].X;
+            fy += frame[bestPairs[i]].Y;
+        }
+    rx /= bestCount;
+    ry /= bestCount;
+    fx /= bestCount;
+    fy /= bestCount;
+
+    double sxx = 0., sxy = 0.;
+    for (unsigned int i = 0; i < m_stars.size(); i++)
+        if (bestPairs[i] >= 0)
+        {
+            double ax = m_stars[i].X - rx, ay = m_stars[i].Y - ry;
+            double bx = frame[bestPairs[i]].X - fx, by = frame[bestPairs[i]].Y - fy;
+            sxx += ax * bx + ay * by;
+            sxy += ax * by - ay * bx;
+        }
+    bestAngle = atan2(sxy, sxx);
+    PHD_Point rotated = RotatePoint(PHD_Point(rx, ry), bestAngle);
+    bestOrigin.SetXY(fx - rotated.X, fy - rotated.Y);
+
+    *origin = bestOrigin;
+    *angle = NormalizeAngle(bestAngle);
+    *matched = bestCount;
+    return true;
+}
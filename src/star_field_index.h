@@ -0,0 +1,88 @@
+/*
+ *  star_field_index.h
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef STAR_FIELD_INDEX_H_INCLUDED
+#define STAR_FIELD_INDEX_H_INCLUDED
+
+// Geometric index of a reference star field, used to find the field again after the guide
+// star is lost.
+//
+// Every triangle of reference stars is keyed by the ratios of its two shorter sides to its
+// longest side, which do not change when the field shifts or rotates. Match() builds the
+// triangles of the stars found in a new frame, looks up reference triangles with the same
+// shape and size, and keeps the shift and rotation that brings the most reference stars
+// onto detected stars. Only a dozen or so of the brightest stars are indexed, so a match
+// takes well under a millisecond; finding the stars in the frame is the expensive part.
+class StarFieldIndex
+{
+public:
+    struct Triangle
+    {
+        double shape1; // middle side / longest side
+        double shape2; // shortest side / longest side
+        double longest;
+        // vertex opposite the shortest, middle and longest side
+        unsigned char a, b, c;
+    };
+
+private:
+    std::vector<PHD_Point> m_stars; // reference star positions relative to the primary star
+    std::vector<Triangle> m_triangles; // sorted by shape1
+
+public:
+    enum
+    {
+        MIN_STARS = 4,
+        MAX_STARS = 16,
+    };
+
+    // stars are the reference star positions relative to the primary star, brightest first
+    void Build(const std::vector<PHD_Point>& stars);
+    void Clear();
+    bool IsEmpty() const { return m_triangles.empty(); }
+
+    // turn the reference field by angle radians around the primary star, after the field
+    // was found rotated
+    void Rotate(double angle);
+
+    // Find the reference field among stars (brightest first). On success returns true and
+    // the transform that maps a reference position p to the frame: origin + R(angle) p.
+    // tolerance is the largest position error in pixels for a star to count as matched.
+    bool Match(const std::vector<PHD_Point>& stars, double tolerance, PHD_Point *origin, double *angle,
+               unsigned int *matched) const;
+
+    static PHD_Point RotatePoint(const PHD_Point& p, double angle);
+};
+
+#endif
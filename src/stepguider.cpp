@@ -1036,6 +1036,8 @@ inline static void UpdateAOGraphPos(const wxPoint& pos, const PHD_Point& avgpos)
 
 Mount::MOVE_RESULT StepGuider::MoveOffset(GuiderOffset *ofs, unsigned int moveOptions)
 {
+    FRAME_TRACE_SPAN("StepGuider::MoveOffset");
+
     MOVE_RESULT result = MOVE_OK;
 
     try
@@ -110,16 +110,20 @@ bool usImage::Init(const wxSize& size)
 {
     // Allocates space for image and sets params up
     // returns true on error
+    // The pixel buffer is only reallocated when it is too small, so a camera that
+    // alternates between full and binned or cropped frames keeps reusing one buffer.
 
-    unsigned int prev = NPixels;
     NPixels = size.GetWidth() * size.GetHeight();
     Size = size;
     Subframe = wxRect(0, 0, 0, 0);
+    ROIs.clear();
     MinADU = MaxADU = MedianADU = 0;
 
-    if (NPixels != prev)
+    if (NPixels > Capacity || !NPixels)
     {
         delete[] ImageData;
+        ImageData = nullptr;
+        Capacity = 0;
 
         if (NPixels)
         {
@@ -129,9 +133,8 @@ bool usImage::Init(const wxSize& size)
                 NPixels = 0;
                 return true;
             }
+            Capacity = NPixels;
         }
-        else
-            ImageData = nullptr;
     }
 
     return false;
@@ -142,6 +145,7 @@ void usImage::SwapImageData(usImage& other)
     unsigned short *t = ImageData;
     ImageData = other.ImageData;
     other.ImageData = t;
+    std::swap(Capacity, other.Capacity);
 }
 
 void usImage::CalcStats()
@@ -41,8 +41,10 @@ public:
     unsigned short *ImageData; // Pointer to raw data
     wxSize Size; // Dimensions of image
     wxRect Subframe; // where the valid data is
+    std::vector<wxRect> ROIs; // with a multi-ROI capture, the windows within Subframe holding valid data
     wxRect LimitFrame; // associated frame limit, empty rect when no frame limit
     unsigned int NPixels;
+    unsigned int Capacity; // number of pixels ImageData has room for, at least NPixels
     unsigned short MinADU;
     unsigned short MaxADU;
     unsigned short MedianADU;
@@ -58,7 +60,7 @@ public:
     unsigned int FrameNum;
 
     usImage()
-        : ImageData(nullptr), NPixels(0), MinADU(0), MaxADU(0), MedianADU(0), FiltMin(0), FiltMax(0), ImgExpDur(0),
+        : ImageData(nullptr), NPixels(0), Capacity(0), MinADU(0), MaxADU(0), MedianADU(0), FiltMin(0), FiltMax(0), ImgExpDur(0),
           ImgStackCnt(1), Binning(0), BitsPerPixel(0), Gain(0), Pedestal(0), FrameNum(0)
     {
     }
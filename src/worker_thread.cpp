@@ -35,10 +35,22 @@
 
 #include "phd.h"
 
+#if defined(__linux__)
+# include <sys/resource.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#elif !defined(__WINDOWS__)
+# include <pthread.h>
+# include <sched.h>
+#endif
+
 WorkerThread::WorkerThread(MyFrame *pFrame)
-    : wxThread(wxTHREAD_JOINABLE), m_interruptRequested(0), m_killable(true), m_skipSendExposeComplete(false)
+    : wxThread(wxTHREAD_JOINABLE), m_interruptRequested(0), m_killable(true), m_skipSendExposeComplete(false),
+      m_moveCond(m_moveMutex), m_movesEnqueued(0), m_movesCompleted(0)
 {
     m_pFrame = pFrame;
+    // read here, the config is not accessed from the worker thread
+    m_highPriority = pConfig->Global.GetBoolean("/HighPriorityWorkerThreads", false);
     Debug.Write("WorkerThread constructor called\n");
 }
 
@@ -51,12 +63,18 @@ void WorkerThread::EnqueueMessage(const WORKER_THREAD_REQUEST& message)
 {
     wxMessageQueueError queueError;
 
-    if (message.request == REQUEST_EXPOSE)
+    if (message.request == REQUEST_EXPOSE || message.request == REQUEST_STOP_STREAM)
     {
         queueError = m_lowPriorityQueue.Post(message);
     }
     else
     {
+        if (message.request == REQUEST_MOVE)
+        {
+            wxMutexLocker lock(m_moveMutex);
+            ++m_movesEnqueued;
+        }
+
         queueError = m_highPriorityQueue.Post(message);
     }
 
@@ -82,7 +100,8 @@ void WorkerThread::EnqueueWorkerThreadTerminateRequest(void)
 
 /*************      Expose      **************************/
 
-void WorkerThread::EnqueueWorkerThreadExposeRequest(usImage *pImage, const CaptureParams& captureParams)
+void WorkerThread::EnqueueWorkerThreadExposeRequest(usImage *pImage, const CaptureParams& captureParams,
+                                                    WorkerThread *moveThread, MoveToken moveToken)
 {
     m_interruptRequested &= ~INT_STOP;
 
@@ -95,6 +114,8 @@ void WorkerThread::EnqueueWorkerThreadExposeRequest(usImage *pImage, const Captu
     message.args.expose.pImage = pImage;
     message.args.expose.captureParams = captureParams;
     message.args.expose.pSemaphore = 0;
+    message.args.expose.moveThread = moveThread;
+    message.args.expose.moveToken = moveToken;
 
     EnqueueMessage(message);
 }
@@ -172,10 +193,19 @@ static void CameraROITest(usImage *img)
 
 bool WorkerThread::HandleExpose(EXPOSE_REQUEST *req)
 {
+    FRAME_TRACE_NEW_FRAME();
+    FRAME_TRACE_SPAN("WorkerThread::HandleExpose");
+
+    wxStopWatch swatch;
     bool bError = false;
 
     try
     {
+        if (req->moveThread && req->moveThread->WaitForMoves(req->moveToken, INT_ANY))
+        {
+            throw ERROR_INFO("Wait for mount moves interrupted");
+        }
+
         if (WorkerThread::MilliSleep(m_pFrame->GetExposureDelay(), INT_ANY))
         {
             throw ERROR_INFO("Time lapse interrupted");
@@ -221,19 +251,9 @@ bool WorkerThread::HandleExpose(EXPOSE_REQUEST *req)
         {
             CameraROITest(req->pImage);
 
-            switch (m_pFrame->GetNoiseReductionMethod())
-            {
-            case NR_NONE:
-                break;
-            case NR_2x2MEAN:
-                QuickLRecon(*req->pImage);
-                break;
-            case NR_3x3MEDIAN:
-                Median3(*req->pImage);
-                break;
-            }
-
-            req->pImage->CalcStats();
+            // noise reduction and image statistics
+            FRAME_TRACE_SPAN("FramePreprocessor::Process");
+            m_preprocessor.Process(*req->pImage, m_pFrame->GetNoiseReductionMethod());
         }
     }
     catch (const wxString& Msg)
@@ -242,6 +262,12 @@ bool WorkerThread::HandleExpose(EXPOSE_REQUEST *req)
         bError = true;
     }
 
+    Metrics.exposeRequestSeconds.Observe(swatch.Time() / 1000.);
+    if (bError)
+        Metrics.captureErrors.Add();
+    else
+        Metrics.framesCaptured.Add();
+
     return bError;
 }
 
@@ -253,6 +279,27 @@ void WorkerThread::SendWorkerThreadExposeComplete(usImage *pImage, bool bError)
     wxQueueEvent(m_pFrame, event);
 }
 
+/*************      Stop stream      **************************/
+
+void WorkerThread::EnqueueWorkerThreadStopStreamRequest()
+{
+    WORKER_THREAD_REQUEST message;
+    memset(&message, 0, sizeof(message));
+
+    Debug.Write("Enqueuing StopStream request\n");
+
+    message.request = REQUEST_STOP_STREAM;
+    EnqueueMessage(message);
+}
+
+void WorkerThread::HandleStopStream()
+{
+    // exposures share the low priority queue, so if looping restarts right away the next
+    // exposure comes after this and starts a new stream
+    if (pCamera && pCamera->IsStreaming())
+        pCamera->StopStream();
+}
+
 /*************      Move       **************************/
 
 void WorkerThread::EnqueueWorkerThreadMoveRequest(Mount *mount, const GuiderOffset& ofs, unsigned int moveOptions)
@@ -298,6 +345,9 @@ void WorkerThread::EnqueueWorkerThreadAxisMove(Mount *mount, const GUIDE_DIRECTI
 
 void WorkerThread::HandleMove(MOVE_REQUEST *req)
 {
+    FRAME_TRACE_SPAN("WorkerThread::HandleMove");
+
+    wxStopWatch swatch;
     Mount::MOVE_RESULT result = Mount::MOVE_OK;
 
     try
@@ -364,6 +414,10 @@ void WorkerThread::HandleMove(MOVE_REQUEST *req)
 
     Debug.Write(wxString::Format("move complete, result=%d\n", result));
 
+    Metrics.moveSeconds.Observe(swatch.Time() / 1000.);
+    if (result != Mount::MOVE_OK)
+        Metrics.moveErrors.Add();
+
     req->moveResult = result;
 }
 
@@ -378,6 +432,76 @@ void WorkerThread::SendWorkerThreadMoveComplete(const MOVE_REQUEST& move)
     wxQueueEvent(m_pFrame, new MoveCompleteEvent(move));
 }
 
+MoveToken WorkerThread::GetMoveToken()
+{
+    wxMutexLocker lock(m_moveMutex);
+    return m_movesEnqueued;
+}
+
+// called after the move complete event has been queued, so the frame sees the move
+// complete before the exposure that was waiting on it
+void WorkerThread::MoveCompleted()
+{
+    wxMutexLocker lock(m_moveMutex);
+    ++m_movesCompleted;
+    m_moveCond.Broadcast();
+}
+
+unsigned int WorkerThread::WaitForMoves(MoveToken token, unsigned int checkInterrupts)
+{
+    enum
+    {
+        POLL_INTERVAL = 100
+    };
+
+    FRAME_TRACE_SPAN("WorkerThread::WaitForMoves");
+
+    wxMutexLocker lock(m_moveMutex);
+
+    // the counters may wrap
+    while (static_cast<int>(m_movesCompleted - token) < 0)
+    {
+        unsigned int val = WorkerThread::InterruptRequested() & checkInterrupts;
+        if (val)
+            return val;
+        m_moveCond.WaitTimeout(POLL_INTERVAL);
+    }
+
+    return 0;
+}
+
+// The worker threads carry the exposures and mount moves. Raising their priority keeps guide
+// timing from being stretched by UI activity (repaints, dialogs, resizing) competing for the
+// CPU. The threads stay under the normal time-sharing policy: some camera drivers busy-poll
+// (e.g. ZWO's ASIGetVideoData loop), and under a real-time policy that would starve the rest
+// of the process. Lowering the nice value on Linux needs CAP_SYS_NICE or an RLIMIT_NICE
+// allowance, otherwise the thread stays at the default priority.
+static void RaiseWorkerThreadPriority()
+{
+    enum
+    {
+        WORKER_THREAD_NICE = -5,
+    };
+
+#if defined(__WINDOWS__)
+    bool ok = ::SetThreadPriority(::GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL) != 0;
+#elif defined(__linux__)
+    // nice values apply to single threads on Linux
+    bool ok = setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), WORKER_THREAD_NICE) == 0;
+#else
+    int policy;
+    struct sched_param param;
+    bool ok = pthread_getschedparam(pthread_self(), &policy, &param) == 0;
+    if (ok)
+    {
+        param.sched_priority = std::min(param.sched_priority - WORKER_THREAD_NICE, sched_get_priority_max(policy));
+        ok = pthread_setschedparam(pthread_self(), policy, &param) == 0;
+    }
+#endif
+
+    Debug.Write(wxString::Format("worker thread priority %s\n", ok ? "raised" : "unchanged"));
+}
+
 /*
  * entry point for the background thread
  */
@@ -392,6 +516,9 @@ wxThread::ExitCode WorkerThread::Entry()
     Debug.Write(wxString::Format("worker thread CoInitializeEx returns %x\n", hr));
 #endif
 
+    if (m_highPriority)
+        RaiseWorkerThreadPriority();
+
     while (!bDone)
     {
         bool dummy;
@@ -451,9 +578,15 @@ wxThread::ExitCode WorkerThread::Entry()
 
             HandleMove(&message.args.move);
             SendWorkerThreadMoveComplete(message.args.move);
+            MoveCompleted();
             break;
         }
 
+        case REQUEST_STOP_STREAM:
+            Debug.Write("worker thread servicing REQUEST_STOP_STREAM\n");
+            HandleStopStream();
+            break;
+
         default:
             Debug.Write(wxString::Format("worker thread servicing unknown request %d\n", message.request));
             break;
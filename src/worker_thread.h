@@ -39,10 +39,18 @@
 class MyFrame;
 
 /*
- * There are two worker threads in PHD.  The primary thread handles all exposure requests,
- * and move requests for the first mount.  The secondary thread handles move requests for the
- * second mount, so that on systems with two mounts (probably an AO and a telescope), the
- * second mount can be moving while we image and guide with the first mount.
+ * There are three worker threads in PHD, one per device.  The camera thread handles all
+ * exposure requests.  The primary thread handles move requests for the first mount and the
+ * secondary thread handles move requests for the second mount, so that on systems with two
+ * mounts (probably an AO and a telescope), the second mount can be moving while we image and
+ * guide with the first mount.  Mounts that cannot move while the camera is exposing (an
+ * on-camera ST4 port that is SynchronousOnly) have their moves handled on the camera thread.
+ *
+ * Ordering between the threads is explicit: an exposure request carries a move token taken
+ * from the primary thread when the exposure was scheduled, and the camera thread waits for
+ * the moves covered by the token to complete before starting the exposure.  This keeps the
+ * guide loop ordering (the correction for frame N lands before frame N+1 is exposed) while
+ * moves issued while an exposure is running do not have to wait for it to finish.
  *
  * The worker threads have three queues, one for move requests (higher priority)
  * and one for exposure requests (lower priority) and one "wakeup queue". The wx queue
@@ -56,12 +64,19 @@ class MyFrame;
  *
  */
 
+class WorkerThread;
+
+// identifies the moves enqueued on a worker thread up to some point in time
+typedef unsigned int MoveToken;
+
 struct EXPOSE_REQUEST
 {
     usImage *pImage;
     CaptureParams captureParams;
     bool error;
     wxSemaphore *pSemaphore;
+    WorkerThread *moveThread; // thread whose moves must complete before the exposure starts
+    MoveToken moveToken;
 };
 
 struct MOVE_REQUEST
@@ -94,6 +109,7 @@ class WorkerThread : public wxThread
         REQUEST_TERMINATE,
         REQUEST_EXPOSE,
         REQUEST_MOVE,
+        REQUEST_STOP_STREAM,
     };
 
     /*
@@ -117,6 +133,12 @@ class WorkerThread : public wxThread
     wxMessageQueue<WORKER_THREAD_REQUEST> m_highPriorityQueue;
     wxMessageQueue<WORKER_THREAD_REQUEST> m_lowPriorityQueue;
     bool m_skipSendExposeComplete;
+    bool m_highPriority;
+    FramePreprocessor m_preprocessor;
+    wxMutex m_moveMutex;
+    wxCondition m_moveCond;
+    MoveToken m_movesEnqueued;
+    MoveToken m_movesCompleted;
 
 public:
     enum InterruptBits
@@ -178,7 +200,8 @@ protected:
 
     /*************      Expose      **************************/
 public:
-    void EnqueueWorkerThreadExposeRequest(usImage *pImage, const CaptureParams& captureParams);
+    void EnqueueWorkerThreadExposeRequest(usImage *pImage, const CaptureParams& captureParams,
+                                          WorkerThread *moveThread = nullptr, MoveToken moveToken = 0);
     void SetSkipExposeComplete();
 
 protected:
@@ -186,13 +209,29 @@ protected:
     void SendWorkerThreadExposeComplete(usImage *pImage, bool bError);
     // in the frame class: void MyFrame::OnWorkerThreadExposeComplete(wxThreadEvent& event);
 
+    /*************      Stop stream      **************************/
+public:
+    // stop a streaming capture once the exposures already queued are done
+    void EnqueueWorkerThreadStopStreamRequest();
+
+protected:
+    void HandleStopStream();
+    // there is no completion event
+
     /*************      Guide       **************************/
 public:
     void EnqueueWorkerThreadMoveRequest(Mount *mount, const GuiderOffset& ofs, unsigned int moveOptions);
     void EnqueueWorkerThreadAxisMove(Mount *mount, const GUIDE_DIRECTION direction, int duration, unsigned int moveOptions);
 
+    // token covering all the moves enqueued on this thread so far
+    MoveToken GetMoveToken();
+    // wait (on another thread) until the moves covered by token have completed; returns the
+    // interrupt bits of the calling thread if the wait was interrupted
+    unsigned int WaitForMoves(MoveToken token, unsigned int checkInterrupts = INT_TERMINATE);
+
 protected:
     void HandleMove(MOVE_REQUEST *args);
+    void MoveCompleted();
     void SendWorkerThreadMoveComplete(const MOVE_REQUEST& move);
     // in the frame class: void MyFrame::OnMoveComplete(wxThreadEvent& event);
 
@@ -0,0 +1,178 @@
+/*
+ *  guiding_stats_test.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Checks the running regression moments of WindowedAxisStats against a two-pass batch fit of
+// the entries in the window.
+
+#include <gtest/gtest.h>
+#include "guiding_stats.h"
+
+#include <math.h>
+#include <random>
+
+namespace
+{
+struct BatchFit
+{
+    double slope;
+    double intercept;
+    double rSquared;
+    double sigma;
+    double scale; // size of the terms that cancel in the intercept, for its tolerance
+};
+}
+
+// two-pass least squares fit of the entries in stats
+static BatchFit FitEntries(const AxisStats& stats)
+{
+    unsigned int const n = stats.GetCount();
+
+    double meanX = 0., meanY = 0.;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        meanX += stats.GetEntry(i).DeltaTime;
+        meanY += stats.GetEntry(i).StarPos;
+    }
+    meanX /= n;
+    meanY /= n;
+
+    double sxx = 0., syy = 0., sxy = 0.;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        double dx = stats.GetEntry(i).DeltaTime - meanX;
+        double dy = stats.GetEntry(i).StarPos - meanY;
+        sxx += dx * dx;
+        syy += dy * dy;
+        sxy += dx * dy;
+    }
+
+    BatchFit fit;
+    fit.slope = sxy / sxx;
+    fit.intercept = meanY - fit.slope * meanX;
+    fit.scale = fabs(meanY) + fabs(fit.slope * meanX);
+
+    double sse = 0.;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        double r = stats.GetEntry(i).StarPos - (fit.intercept + fit.slope * stats.GetEntry(i).DeltaTime);
+        sse += r * r;
+    }
+    fit.rSquared = (syy - sse) / syy;
+    fit.sigma = sqrt(sse / (n - 1));
+
+    return fit;
+}
+
+// relative tolerance of the running fit against the batch fit
+static const double TOLERANCE = 1e-8;
+
+static void ExpectMatchesBatchFit(const AxisStats& stats, unsigned int step)
+{
+    BatchFit expected = FitEntries(stats);
+
+    double slope, intercept, sigma;
+    double rSquared = stats.GetLinearFitResults(&slope, &intercept, &sigma);
+
+    EXPECT_NEAR(slope, expected.slope, TOLERANCE * fabs(expected.slope)) << "step " << step;
+    EXPECT_NEAR(intercept, expected.intercept, TOLERANCE * expected.scale) << "step " << step;
+    EXPECT_NEAR(rSquared, expected.rSquared, TOLERANCE) << "step " << step;
+    EXPECT_NEAR(sigma, expected.sigma, TOLERANCE * expected.sigma) << "step " << step;
+}
+
+// A long session: times far from zero, positions with a large offset, drift and noise, the
+// window resized and trimmed by hand along the way
+TEST(GuidingStatsTest, WindowedFitMatchesBatchFit)
+{
+    std::mt19937 rng(3);
+    std::normal_distribution<double> noise(0., 0.4);
+
+    unsigned int const STEPS = 200000;
+    double const T0 = 1e6; // seconds
+    double const Y0 = 2000.; // pixels
+
+    WindowedAxisStats stats(100);
+
+    for (unsigned int i = 0; i < STEPS; i++)
+    {
+        double t = T0 + 2.0 * i;
+        double y = Y0 + 0.003 * (t - T0) + 1.5 * sin(i / 40.) + noise(rng);
+        stats.AddGuideInfo(t, y, (i & 1) ? 0.2 : -0.2);
+
+        if (i == 50000)
+            stats.ChangeWindowSize(37);
+        else if (i == 100000)
+            stats.ChangeWindowSize(500);
+        else if (i % 997 == 0 && stats.GetCount() > 10)
+        {
+            for (int k = 0; k < 5; k++)
+                stats.RemoveOldestEntry();
+        }
+
+        if (stats.GetCount() > 2 && i % 101 == 0)
+            ExpectMatchesBatchFit(stats, i);
+    }
+
+    EXPECT_EQ(stats.GetCount(), 500u);
+    ExpectMatchesBatchFit(stats, STEPS);
+}
+
+// Emptying the window and starting over must not leave anything behind in the moments
+TEST(GuidingStatsTest, RefillAfterEmptyWindow)
+{
+    WindowedAxisStats stats(0);
+
+    for (int cycle = 0; cycle < 50; cycle++)
+    {
+        for (int i = 0; i < 30; i++)
+            stats.AddGuideInfo(1e5 * cycle + i, 500. + 0.1 * i + (i % 3) * 0.05, 0.);
+        while (stats.GetCount() > 0)
+            stats.RemoveOldestEntry();
+    }
+
+    double sum = 0.;
+    for (int i = 0; i < 30; i++)
+    {
+        double y = -800. - 0.25 * i + (i % 4) * 0.1;
+        stats.AddGuideInfo(3e6 + i, y, 0.);
+        sum += y;
+    }
+
+    ExpectMatchesBatchFit(stats, 0);
+    EXPECT_NEAR(stats.GetMean(), sum / 30, 1e-9);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,287 @@
+/*
+ *  image_math_simd_test.cpp
+ *  PHD Guiding
+ *
+ *  Copyright (c) 2026 PHD2 Developers
+ *  All rights reserved.
+ *
+ *  This source code is distributed under the following "BSD" license
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *    Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *    Neither the name of openphdguiding.org nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Checks each vector kernel set the host CPU supports against the scalar reference kernels.
+
+#include <gtest/gtest.h>
+#include "image_math_simd.h"
+
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <vector>
+
+static std::vector<SimdKernels> VectorKernels()
+{
+    std::vector<SimdKernels> sets = AvailableSimdKernels();
+    sets.erase(sets.begin());
+    return sets;
+}
+
+static const SimdKernels& ScalarKernels()
+{
+    static const SimdKernels s_scalar = AvailableSimdKernels().front();
+    return s_scalar;
+}
+
+// random pixels with a share of the extreme values that exercise the saturation paths
+static std::vector<unsigned short> RandomPixels(std::mt19937& rng, size_t n)
+{
+    std::uniform_int_distribution<int> pick(0, 9);
+    std::uniform_int_distribution<int> any(0, 65535);
+    std::vector<unsigned short> v(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        int k = pick(rng);
+        v[i] = (unsigned short) (k == 0 ? 0 : k == 1 ? 65535 : k == 2 ? 65535 - (any(rng) & 255) : any(rng));
+    }
+    return v;
+}
+
+// bins a width x height frame in place the way BinPixelsInPlace does
+static std::vector<unsigned short> BinFrame(const SimdKernels& k, std::vector<unsigned short> frame, unsigned int width,
+                                            unsigned int height, unsigned int binning)
+{
+    unsigned int const dw = width / binning;
+    unsigned int const dh = height / binning;
+    unsigned int const tw = dw * binning;
+    std::vector<unsigned int> acc(tw + 1);
+
+    for (unsigned int y = 0; y < dh; y++)
+    {
+        k.column_sums(&acc[0], &frame[y * binning * width], width, tw, binning);
+        k.bin_row(&frame[y * dw], &acc[0], dw, binning);
+    }
+
+    frame.resize(dw * dh);
+    return frame;
+}
+
+TEST(ImageMathSimdTest, ScalarKernelsComeFirst)
+{
+    std::vector<SimdKernels> sets = AvailableSimdKernels();
+    ASSERT_FALSE(sets.empty());
+    EXPECT_STREQ(sets.front().name, "scalar");
+}
+
+TEST(ImageMathSimdTest, SubtractDarkRowMatchesScalar)
+{
+    std::mt19937 rng(1);
+    unsigned short const pedestals[] = { 0, 1, 100, 32768, 65535 };
+
+    for (const SimdKernels& k : VectorKernels())
+    {
+        // every tail length, and offsets that leave the rows unaligned
+        for (unsigned int n = 0; n < 80; n++)
+        {
+            for (unsigned short pedestal : pedestals)
+            {
+                std::vector<unsigned short> light = RandomPixels(rng, n + 3);
+                std::vector<unsigned short> dark = RandomPixels(rng, n + 3);
+                std::vector<unsigned short> expected(light);
+                std::vector<unsigned short> actual(light);
+
+                ScalarKernels().subtract_row(&expected[1], &dark[2], n, pedestal);
+                k.subtract_row(&actual[1], &dark[2], n, pedestal);
+
+                ASSERT_EQ(expected, actual) << k.name << " n=" << n << " pedestal=" << pedestal;
+            }
+        }
+    }
+}
+
+TEST(ImageMathSimdTest, ScalarSubtractClamps)
+{
+    unsigned short light[] = { 10, 10, 65535, 65000, 0 };
+    unsigned short const dark[] = { 20, 5, 0, 100, 0 };
+    ScalarKernels().subtract_row(light, dark, 5, 1000);
+
+    EXPECT_EQ(light[0], 990);
+    EXPECT_EQ(light[1], 1005);
+    EXPECT_EQ(light[2], 65535);
+    EXPECT_EQ(light[3], 65535);
+    EXPECT_EQ(light[4], 1000);
+}
+
+TEST(ImageMathSimdTest, BinningMatchesScalar)
+{
+    std::mt19937 rng(2);
+
+    for (unsigned int binning = 2; binning <= 4; binning++)
+    {
+        for (unsigned int width = binning; width < 75; width += 7)
+        {
+            unsigned int const height = 3 * binning + 1;
+            std::vector<unsigned short> frame = RandomPixels(rng, width * height);
+            std::vector<unsigned short> expected = BinFrame(ScalarKernels(), frame, width, height, binning);
+
+            // the scalar kernels average each binning x binning block, rounding down
+            unsigned int const dw = width / binning;
+            for (unsigned int y = 0; y < height / binning; y++)
+            {
+                for (unsigned int x = 0; x < dw; x++)
+                {
+                    unsigned int sum = 0;
+                    for (unsigned int j = 0; j < binning; j++)
+                        for (unsigned int i = 0; i < binning; i++)
+                            sum += frame[(y * binning + j) * width + x * binning + i];
+                    ASSERT_EQ(expected[y * dw + x], sum / (binning * binning));
+                }
+            }
+
+            for (const SimdKernels& k : VectorKernels())
+            {
+                ASSERT_EQ(expected, BinFrame(k, frame, width, height, binning))
+                    << k.name << " binning=" << binning << " width=" << width;
+            }
+        }
+    }
+}
+
+TEST(ImageMathSimdTest, BinningSaturatedFrame)
+{
+    unsigned int const width = 64, height = 12;
+    std::vector<unsigned short> frame(width * height, 65535);
+
+    for (const SimdKernels& k : AvailableSimdKernels())
+    {
+        for (unsigned int binning = 2; binning <= 4; binning++)
+        {
+            std::vector<unsigned short> binned = BinFrame(k, frame, width, height, binning);
+            for (unsigned short v : binned)
+                ASSERT_EQ(v, 65535) << k.name << " binning=" << binning;
+        }
+    }
+}
+
+// a 15x15 star stamp padded to a multiple of 4 the way FitGaussianPSF builds it, with
+// Poisson-like weights and a few saturated (zero weight) pixels
+struct PsfStamp
+{
+    std::vector<float> dx, dy, val, weight;
+};
+
+static PsfStamp MakeStamp(std::mt19937& rng)
+{
+    unsigned int const size = 228;
+    PsfStamp s;
+    s.dx.assign(size, 0.f);
+    s.dy.assign(size, 0.f);
+    s.val.assign(size, 0.f);
+    s.weight.assign(size, 0.f);
+
+    std::normal_distribution<double> noise(0., 1.);
+    unsigned int n = 0;
+    for (int j = -7; j <= 7; j++)
+    {
+        for (int i = -7; i <= 7; i++, n++)
+        {
+            double const signal = 2000. * exp(-(i * i + j * j) / (2. * 1.8 * 1.8));
+            double const v = 400. + signal + sqrt(signal / 0.5 + 100.) * noise(rng);
+            s.dx[n] = (float) i;
+            s.dy[n] = (float) j;
+            s.val[n] = (float) v;
+            s.weight[n] = i == 0 && j == 0 ? 0.f : (float) (1. / (std::max(v - 400., 0.) / 0.5 + 100.));
+        }
+    }
+    return s;
+}
+
+// the normal equations in double precision with std::exp
+static void ReferenceNormals(const PsfStamp& s, const float p[5], double sums[PSF_NORMAL_SUMS])
+{
+    for (unsigned int k = 0; k < PSF_NORMAL_SUMS; k++)
+        sums[k] = 0.;
+    for (size_t i = 0; i < s.val.size(); i++)
+    {
+        double const ddx = s.dx[i] - p[2], ddy = s.dy[i] - p[3];
+        double const r2 = ddx * ddx + ddy * ddy;
+        double const e = exp(-0.5 * r2 / (p[4] * p[4]));
+        double const ae = p[1] * e;
+        double const res = s.val[i] - (p[0] + ae);
+        double const j[5] = { 1., e, ae * ddx / (p[4] * p[4]), ae * ddy / (p[4] * p[4]), ae * r2 / (p[4] * p[4] * p[4]) };
+        unsigned int k = 0;
+        for (unsigned int r = 0; r < 5; r++)
+        {
+            for (unsigned int c = r; c < 5; c++)
+                sums[k++] += s.weight[i] * j[r] * j[c];
+            sums[15 + r] += s.weight[i] * j[r] * res;
+        }
+        sums[20] += s.weight[i] * res * res;
+    }
+}
+
+// The kernels sum in float, so they agree to float rounding only. The residual sums cancel,
+// so each sum is compared relative to the largest sum of its kind.
+static void ExpectNormalsNear(const double *expected, const double *actual, double tol, const char *name)
+{
+    double scale[PSF_NORMAL_SUMS];
+    double const matrixScale = *std::max_element(expected, expected + 15, [](double a, double b) { return fabs(a) < fabs(b); });
+    double const gradScale = *std::max_element(expected + 15, expected + 20, [](double a, double b) { return fabs(a) < fabs(b); });
+    for (unsigned int k = 0; k < PSF_NORMAL_SUMS; k++)
+        scale[k] = k < 15 ? fabs(matrixScale) : k < 20 ? fabs(gradScale) : fabs(expected[20]);
+
+    for (unsigned int k = 0; k < PSF_NORMAL_SUMS; k++)
+        EXPECT_NEAR(expected[k], actual[k], tol * scale[k]) << name << " sum " << k;
+}
+
+TEST(ImageMathSimdTest, PsfNormalsMatchScalar)
+{
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> offset(-1.f, 1.f);
+
+    for (unsigned int trial = 0; trial < 20; trial++)
+    {
+        PsfStamp s = MakeStamp(rng);
+        float const p[5] = { 400.f + 20.f * offset(rng), 2000.f + 200.f * offset(rng), 0.5f * offset(rng),
+                             0.5f * offset(rng), 1.8f + 0.4f * offset(rng) };
+
+        double reference[PSF_NORMAL_SUMS], expected[PSF_NORMAL_SUMS];
+        ReferenceNormals(s, p, reference);
+        ScalarKernels().psf_normals(&s.dx[0], &s.dy[0], &s.val[0], &s.weight[0], (unsigned int) s.val.size(), p, expected);
+        ExpectNormalsNear(reference, expected, 1e-4, "scalar");
+
+        for (const SimdKernels& k : VectorKernels())
+        {
+            double actual[PSF_NORMAL_SUMS];
+            k.psf_normals(&s.dx[0], &s.dy[0], &s.val[0], &s.weight[0], (unsigned int) s.val.size(), p, actual);
+            ExpectNormalsNear(expected, actual, 1e-5, k.name);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}